@@ -0,0 +1,283 @@
+/**
+ * @file admission.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the per-peer admission control (token buckets per message class and bounded inbound queues) protecting a node from peers flooding it with expensive requests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include "monitor.hpp"
+
+// Transactions each peer may send per second, and how many they may send in a burst
+#define ADMISSION_TRANSACTION_RATE 100
+#define ADMISSION_TRANSACTION_BURST 200
+// Tangle/snapshot downloads each peer may request per second, and in a burst (a joining node asks each source for a few parts)
+#define ADMISSION_SYNC_RATE 0.2
+#define ADMISSION_SYNC_BURST 8
+// Queries (genesis votes, snapshot attestations, tips, and proofs) each peer may send per second, and in a burst
+#define ADMISSION_QUERY_RATE 2
+#define ADMISSION_QUERY_BURST 16
+// Number of each peer's transactions which may wait in the network queue (so one peer can't fill it)
+#define ADMISSION_PEER_QUEUE_SIZE 128
+// Largest (compressed) transaction message accepted, and the most parents and inputs + outputs a transaction may have
+#define ADMISSION_MAX_TRANSACTION_BYTES (16 * 1024)
+#define ADMISSION_MAX_PARENTS 8
+#define ADMISSION_MAX_TRANSACTION_IO 32
+// Largest a transaction message may decompress to, a sync chunk (a full chunk of the largest transactions), and a state snapshot or genesis (which hold every account's balance)
+#define ADMISSION_MAX_UNPACKED_TRANSACTION_BYTES (64 * 1024)
+#define ADMISSION_MAX_UNPACKED_CHUNK_BYTES (SYNC_CHUNK_SIZE * ADMISSION_MAX_UNPACKED_TRANSACTION_BYTES)
+#define ADMISSION_MAX_UNPACKED_STATE_BYTES (64 * 1024 * 1024)
+// Minimum time (in milliseconds) between slow down signals sent to the same peer about the same class of message
+#define ADMISSION_SLOW_DOWN_INTERVAL 1000
+// Longest (in milliseconds) we will hold off sending when a peer tells us to slow down
+#define ADMISSION_MAX_BACKOFF 5000
+// Time (in milliseconds) a peer's state is kept after their last message (longer than any bucket takes to refill, so reconnecting never resets a limit early)
+#define ADMISSION_IDLE_EXPIRY 60000
+
+/**
+ * @brief Admission control, deciding (cheaply, before any expensive work is done) if a peer's message should be processed
+ * @note Every peer has a token bucket for each class of message, a message is only admitted if the bucket has a token to spend
+ * @note Peers which exceed their limits are told to slow down (at most once every ADMISSION_SLOW_DOWN_INTERVAL milliseconds per class) and told how long to wait
+ * @note A peer's state outlives their connection, it is only forgotten once they have been idle for ADMISSION_IDLE_EXPIRY milliseconds (and have nothing queued)
+ */
+class AdmissionControl {
+public:
+	using PeerID = boost::uuids::uuid;
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief The classes of (expensive) message which are limited separately
+	 */
+	enum class Class : uint8_t {
+		// Transactions (decompressed, hashed, signature verified, and added to the tangle)
+		Transaction,
+		// Requests for a part of the tangle or a state snapshot (a full tangle send)
+		Sync,
+		// Small signed queries (genesis votes, snapshot attestations, tips, and proofs)
+		Query,
+	};
+	// Number of classes of message
+	static constexpr size_t CLASS_COUNT = 3;
+
+	// Function which gets the name of a class of message
+	static const char* name(Class type) {
+		switch(type){
+		case Class::Transaction: return "transaction";
+		case Class::Sync: return "sync";
+		case Class::Query: return "query";
+		}
+		return "unknown";
+	}
+
+	/**
+	 * @brief The rate (per second) and burst a class of message is limited to
+	 */
+	struct Limit {
+		double rate, burst;
+	};
+	// The default limits of each class of message
+	static constexpr std::array<Limit, CLASS_COUNT> DEFAULT_LIMITS = {{
+		{ADMISSION_TRANSACTION_RATE, ADMISSION_TRANSACTION_BURST},
+		{ADMISSION_SYNC_RATE, ADMISSION_SYNC_BURST},
+		{ADMISSION_QUERY_RATE, ADMISSION_QUERY_BURST},
+	}};
+
+	/**
+	 * @brief Bucket which refills at a constant rate (up to a limit), messages spend a token each
+	 */
+	struct TokenBucket {
+		double rate = 0, burst = 0, tokens = 0;
+		Clock::time_point last;
+
+		TokenBucket() = default;
+		TokenBucket(Limit limit, Clock::time_point now) : rate(limit.rate), burst(limit.burst), tokens(limit.burst), last(now) {}
+
+		// Function which adds the tokens which have accumulated since the bucket was last used
+		void refill(Clock::time_point now) {
+			if(now <= last) return;
+			tokens = std::min(burst, tokens + rate * std::chrono::duration<double>(now - last).count());
+			last = now;
+		}
+
+		// Function which spends a token (if one is available)
+		bool take(Clock::time_point now) {
+			refill(now);
+			if(tokens < 1) return false;
+			tokens -= 1;
+			return true;
+		}
+
+		// Function which calculates how long until a token will be available
+		std::chrono::milliseconds wait() const {
+			if(tokens >= 1) return std::chrono::milliseconds(0);
+			if(rate <= 0) return std::chrono::milliseconds::max();
+			return std::chrono::milliseconds(int64_t(std::ceil((1 - tokens) / rate * 1000)));
+		}
+	};
+
+	/**
+	 * @brief The outcome of asking to admit a message
+	 */
+	struct Verdict {
+		// Whether the message should be processed
+		bool admitted;
+		// Whether the peer should be sent a slow down signal, and how long they should wait before sending another message of the class
+		bool slowDown;
+		std::chrono::milliseconds retryAfter;
+	};
+
+	/**
+	 * @brief Counters describing what was admitted and what wasn't
+	 */
+	struct Stats {
+		// Messages admitted, refused by the rate limits, refused by the cheap checks, and transactions refused a place in the network queue
+		size_t admitted = 0, limited = 0, rejected = 0, queueFull = 0;
+		// Slow down signals sent
+		size_t slowDowns = 0;
+		// Peers currently being tracked
+		size_t peers = 0;
+	};
+
+	AdmissionControl(std::array<Limit, CLASS_COUNT> limits = DEFAULT_LIMITS, size_t queueLimit = ADMISSION_PEER_QUEUE_SIZE) : limits(limits), queueLimit(queueLimit) {}
+
+	/**
+	 * @brief Function which decides if a message from a peer should be processed (spending one of the peer's tokens if so)
+	 *
+	 * @param peer - The peer who sent the message
+	 * @param type - The class of the message
+	 * @param now - The current time
+	 * @return Verdict - Whether the message is admitted, and if not whether the peer should be told to slow down
+	 */
+	Verdict admit(const PeerID& peer, Class type, Clock::time_point now = Clock::now()) {
+		auto lock = peers.write_lock();
+		auto& state = find(*lock, peer, now);
+		auto& bucket = state.buckets[size_t(type)];
+		if(bucket.take(now)){
+			state.stats.admitted++;
+			return {true, false, std::chrono::milliseconds(0)};
+		}
+
+		state.stats.limited++;
+		auto& notified = state.notified[size_t(type)];
+		bool slowDown = now - notified >= std::chrono::milliseconds(ADMISSION_SLOW_DOWN_INTERVAL);
+		if(slowDown){
+			notified = now;
+			state.stats.slowDowns++;
+		}
+		return {false, slowDown, bucket.wait()};
+	}
+
+	// Function which records that a peer's message failed one of the cheap checks
+	void reject(const PeerID& peer) {
+		auto lock = peers.write_lock();
+		find(*lock, peer, Clock::now()).stats.rejected++;
+	}
+
+	/**
+	 * @brief Function which reserves a place in the network queue for one of a peer's transactions
+	 *
+	 * @param peer - The peer who sent the transaction
+	 * @return bool - True if the peer has room left in the queue, false otherwise
+	 */
+	bool enqueue(const PeerID& peer) {
+		auto lock = peers.write_lock();
+		auto& state = find(*lock, peer, Clock::now());
+		if(state.queued >= queueLimit){
+			state.stats.queueFull++;
+			return false;
+		}
+		state.queued++;
+		return true;
+	}
+
+	// Function which releases the place one of a peer's transactions held in the network queue
+	void dequeue(const PeerID& peer) {
+		auto lock = peers.write_lock();
+		if(auto state = lock->find(peer); state != lock->end() && state->second.queued > 0)
+			state->second.queued--;
+	}
+
+	// Function which totals the counters of every peer (including those which have been forgotten)
+	Stats stats() const {
+		auto lock = peers.read_lock();
+		Stats out = forgotten;
+		for(auto& [id, state]: *lock){
+			out.admitted += state.stats.admitted;
+			out.limited += state.stats.limited;
+			out.rejected += state.stats.rejected;
+			out.queueFull += state.stats.queueFull;
+			out.slowDowns += state.stats.slowDowns;
+		}
+		out.peers = lock->size();
+		return out;
+	}
+
+protected:
+	/**
+	 * @brief The admission state of a single peer
+	 */
+	struct Peer {
+		std::array<TokenBucket, CLASS_COUNT> buckets;
+		// When the peer was last told to slow down about each class of message
+		std::array<Clock::time_point, CLASS_COUNT> notified = {};
+		// Number of the peer's transactions waiting in the network queue
+		size_t queued = 0;
+		// When we last heard from the peer
+		Clock::time_point seen;
+		Stats stats;
+	};
+
+	// The limits of each class of message, and the number of transactions each peer may have waiting
+	const std::array<Limit, CLASS_COUNT> limits;
+	const size_t queueLimit;
+	// The state of every peer we have heard from recently, and when idle peers were last looked for (the table is protected by the peers lock)
+	monitor<std::unordered_map<PeerID, Peer, boost::hash<PeerID>>> peers;
+	Clock::time_point swept;
+	// The totaled counters of the peers which have been forgotten
+	Stats forgotten;
+
+	// Function which finds the state of a peer (creating it, with full buckets, if we haven't heard from them recently)
+	Peer& find(std::unordered_map<PeerID, Peer, boost::hash<PeerID>>& table, const PeerID& peer, Clock::time_point now) {
+		expire(table, now);
+		auto [state, created] = table.try_emplace(peer);
+		if(created)
+			for(size_t i = 0; i < CLASS_COUNT; i++)
+				state->second.buckets[i] = TokenBucket(limits[i], now);
+		state->second.seen = std::max(state->second.seen, now);
+		return state->second;
+	}
+
+	// Function which forgets the peers who have been idle for ADMISSION_IDLE_EXPIRY milliseconds (looked for at most once per expiry period)
+	void expire(std::unordered_map<PeerID, Peer, boost::hash<PeerID>>& table, Clock::time_point now) {
+		constexpr auto expiry = std::chrono::milliseconds(ADMISSION_IDLE_EXPIRY);
+		if(now - swept < expiry) return;
+		swept = now;
+
+		std::erase_if(table, [&](auto& entry) {
+			auto& [id, state] = entry;
+			if(state.queued > 0 || now - state.seen < expiry) return false;
+			forgotten.admitted += state.stats.admitted;
+			forgotten.limited += state.stats.limited;
+			forgotten.rejected += state.stats.rejected;
+			forgotten.queueFull += state.stats.queueFull;
+			forgotten.slowDowns += state.stats.slowDowns;
+			return true;
+		});
+	}
+};
+
+#endif /* end of include guard: ADMISSION_HPP */
@@ -0,0 +1,169 @@
+/**
+ * @file amount.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides an exact fixed-point type used to represent amounts of money
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef AMOUNT_HPP
+#define AMOUNT_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <breep/util/serialization.hpp>
+
+// Integer types which can count whole units of money (bool and the character types are excluded, so flags and characters don't silently become amounts)
+template<typename T>
+concept WholeUnits = std::integral<T> && !std::same_as<std::remove_cv_t<T>, bool> && !std::same_as<std::remove_cv_t<T>, char> && !std::same_as<std::remove_cv_t<T>, wchar_t>
+	&& !std::same_as<std::remove_cv_t<T>, char8_t> && !std::same_as<std::remove_cv_t<T>, char16_t> && !std::same_as<std::remove_cv_t<T>, char32_t>;
+
+/**
+ * @brief Exact fixed-point amount of money, stored as an integer number of the smallest representable unit
+ * @note Integers convert to whole units (Amount(5) is five money), use Amount::fromRaw to specify the smallest units directly
+ */
+struct Amount {
+	// Integer type backing the amount
+	using Raw = int64_t;
+	// How many decimal places an amount can represent
+	static constexpr int DECIMALS = 8;
+	// How many raw units make up a single whole unit
+	static constexpr Raw SCALE = 100'000'000;
+
+	/**
+	 * @brief Exception thrown when an operation would overflow the range an amount can represent
+	 */
+	struct Overflow : public std::overflow_error { Overflow() : std::overflow_error("Amount overflowed its representable range") {} };
+	/**
+	 * @brief Exception thrown when a string can't be parsed into an amount
+	 */
+	struct InvalidFormat : public std::invalid_argument { InvalidFormat(std::string_view str) : std::invalid_argument("`" + std::string(str) + "` is not a valid amount (at most " + std::to_string(DECIMALS) + " decimal places)") {} };
+
+	// The amount, measured in raw units
+	Raw raw = 0;
+
+	constexpr Amount() = default;
+	// Construct an amount from a whole number of units
+	template<WholeUnits Integer>
+	constexpr Amount(Integer whole) { if(__builtin_mul_overflow(whole, SCALE, &raw)) throw Overflow(); }
+
+	// Construct an amount from a number of raw units
+	static constexpr Amount fromRaw(Raw raw) { Amount out; out.raw = raw; return out; }
+	// The largest amount which can be represented
+	static constexpr Amount max() { return fromRaw(std::numeric_limits<Raw>::max()); }
+	// The total money a network's genesis grants (far enough below max that no balance, running sum, or total of the supply can overflow)
+	static constexpr Amount supply() { return fromRaw(std::numeric_limits<Raw>::max() / 4); }
+
+	/**
+	 * @brief Function which converts a decimal string (ex. "-12.005") into an amount, without passing through floating point
+	 *
+	 * @param str - The string to parse
+	 * @return Amount - The parsed amount
+	 */
+	static Amount parse(std::string_view str) {
+		std::string_view original = str;
+		auto isDigits = [](std::string_view s) { return std::all_of(s.begin(), s.end(), [](char c){ return c >= '0' && c <= '9'; }); };
+
+		// Strip the sign
+		bool negative = false;
+		if(!str.empty() && (str.front() == '-' || str.front() == '+')){
+			negative = str.front() == '-';
+			str.remove_prefix(1);
+		}
+
+		// Split the string into its whole and fractional parts
+		size_t point = str.find('.');
+		std::string_view whole = str.substr(0, point);
+		std::string_view fraction = point == std::string_view::npos ? std::string_view() : str.substr(point + 1);
+		if((whole.empty() && fraction.empty()) || fraction.size() > DECIMALS || !isDigits(whole) || !isDigits(fraction))
+			throw InvalidFormat(original);
+
+		// Convert both halves to integers
+		Raw wholeRaw = 0, fractionRaw = 0;
+		if(!whole.empty())
+			if(auto [_, ec] = std::from_chars(whole.data(), whole.data() + whole.size(), wholeRaw); ec != std::errc())
+				throw Overflow();
+		if(!fraction.empty()){
+			std::from_chars(fraction.data(), fraction.data() + fraction.size(), fractionRaw);
+			for(size_t i = fraction.size(); i < DECIMALS; i++)
+				fractionRaw *= 10;
+		}
+
+		// Combine them
+		Raw raw;
+		if(__builtin_mul_overflow(wholeRaw, SCALE, &raw) || __builtin_add_overflow(raw, fractionRaw, &raw))
+			throw Overflow();
+		return fromRaw(negative ? -raw : raw);
+	}
+
+	/**
+	 * @brief Function which converts the amount into a decimal string (trailing zeros in the fraction are removed)
+	 *
+	 * @return std::string - The decimal representation of the amount
+	 */
+	std::string toString() const {
+		// Work with the magnitude as unsigned so that the most negative value can still be printed
+		uint64_t magnitude = raw < 0 ? uint64_t(0) - uint64_t(raw) : uint64_t(raw);
+		std::string out = (raw < 0 ? "-" : "") + std::to_string(magnitude / SCALE);
+
+		// Append the fraction (if there is one)
+		if(uint64_t fraction = magnitude % SCALE; fraction){
+			std::string digits = std::to_string(fraction);
+			digits.insert(0, DECIMALS - digits.size(), '0');
+			digits.erase(digits.find_last_not_of('0') + 1);
+			out += "." + digits;
+		}
+		return out;
+	}
+
+
+	// -- Overflow Checked Arithmetic --
+
+
+	constexpr Amount operator+(Amount other) const { Amount out; if(__builtin_add_overflow(raw, other.raw, &out.raw)) throw Overflow(); return out; }
+	constexpr Amount operator-(Amount other) const { Amount out; if(__builtin_sub_overflow(raw, other.raw, &out.raw)) throw Overflow(); return out; }
+	constexpr Amount operator-() const { return Amount() - *this; }
+	constexpr Amount& operator+=(Amount other) { return *this = *this + other; }
+	constexpr Amount& operator-=(Amount other) { return *this = *this - other; }
+
+	// Comparisons are exact integer comparisons
+	constexpr auto operator<=>(const Amount&) const = default;
+	constexpr bool operator==(const Amount&) const = default;
+};
+
+// Stream output (human readable decimal)
+inline std::ostream& operator<<(std::ostream& s, const Amount& a) { return s << a.toString(); }
+// Stream input (reads a decimal token, marking the stream as failed if it isn't a valid amount)
+inline std::istream& operator>>(std::istream& s, Amount& a) {
+	std::string token;
+	if(s >> token)
+		try {
+			a = Amount::parse(token);
+		} catch (std::exception&) { s.setstate(std::ios::failbit); }
+	return s;
+}
+
+// De/serialization (amounts are sent as their raw integer representation)
+inline breep::serializer& operator<<(breep::serializer& s, const Amount& a) {
+	s << a.raw;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, Amount& a) {
+	d >> a.raw;
+	return d;
+}
+
+#endif /* end of include guard: AMOUNT_HPP */
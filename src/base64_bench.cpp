@@ -0,0 +1,133 @@
+/**
+ * @file base64_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Base 64 throughput benchmark, comparing CryptoPP's encoder and decoder against the vectorized codec (see kernels.hpp) on every supported instruction set
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "kernels.hpp"
+#include "utility.hpp"
+
+/**
+ * @brief Function which runs <f> until at least <seconds> have passed and prints the throughput
+ *
+ * @param name - The name of the operation (printed)
+ * @param seconds - How long to run for
+ * @param f - The operation to run, returns the number of bytes it processed
+ */
+template<typename F>
+void measure(const std::string& name, double seconds, F f) {
+	size_t bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0;
+	while(elapsed < seconds){
+		bytes += f();
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::cout << name << ": " << (bytes / elapsed / 1e6) << " MB/s" << std::endl;
+}
+
+// Function which encodes data using CryptoPP's pipeline (without its line breaks)
+std::string cryptoppEncode(const std::string& in) {
+	std::string out;
+	CryptoPP::StringSource(in, true, new CryptoPP::Base64Encoder(new CryptoPP::StringSink(out), /*insertLineBreaks*/ false));
+	return out;
+}
+
+// Function which decodes data using CryptoPP's pipeline
+std::string cryptoppDecode(const std::string& in) {
+	std::string out;
+	CryptoPP::StringSource(in, true, new CryptoPP::Base64Decoder(new CryptoPP::StringSink(out)));
+	return out;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 2){
+		std::cout << "Usage: " << argv[0] << " [<seconds per measurement> = 1]" << std::endl;
+		return 1;
+	}
+
+	double seconds = argc > 1 ? std::stod(argv[1]) : 1;
+	std::mt19937 rng(0);
+	auto random = [&rng](size_t size) {
+		std::string out(size, '\0');
+		for(auto& c: out) c = char(rng());
+		return out;
+	};
+
+	// Every instruction set must produce byte-identical output to CryptoPP (data of every length up to a few vectors)
+	std::vector<std::string> checks;
+	for(size_t length = 0; length <= 100; length++)
+		checks.push_back(random(length));
+	std::vector<std::string> expected;
+	for(auto& check: checks)
+		expected.push_back(cryptoppEncode(check));
+
+	bool identical = true;
+	for(kernels::ISA isa: {kernels::ISA::Scalar, kernels::ISA::SSE2, kernels::ISA::AVX2, kernels::ISA::AVX512}){
+		if(kernels::setActive(isa) != isa) continue;
+		for(size_t i = 0; i < checks.size() && identical; i++){
+			std::string encoded(kernels::base64EncodedSize(checks[i].size()), '\0');
+			kernels::base64Encode((const uint8_t*) checks[i].data(), checks[i].size(), encoded.data());
+			// Decoding must also skip the line breaks CryptoPP inserts (which saved keys contain)
+			std::string broken = util::base64Encode((const uint8_t*) checks[i].data(), checks[i].size(), /*lineBreaks*/ true);
+			std::string decoded(kernels::base64DecodedSize(broken.size()), '\0');
+			decoded.resize(kernels::base64Decode(broken.data(), broken.size(), (uint8_t*) decoded.data()));
+
+			if(encoded != expected[i] || decoded != checks[i]){
+				std::cout << kernels::name(isa) << " codec doesn't match CryptoPP on " << checks[i].size() << " bytes!" << std::endl;
+				identical = false;
+			}
+		}
+	}
+
+	// Hash sized (32 bytes), key sized (33 bytes), signature sized (64 bytes), and bulk (4 KB) data
+	for(size_t size: {32, 33, 64, 4096}){
+		std::vector<std::string> data(64);
+		for(auto& d: data) d = random(size);
+		std::vector<std::string> encoded;
+		for(auto& d: data) encoded.push_back(cryptoppEncode(d));
+		std::string encodeBuffer(kernels::base64EncodedSize(size), '\0'), decodeBuffer(kernels::base64DecodedSize(encoded[0].size()), '\0');
+
+		std::cout << size << " byte inputs" << std::endl;
+		kernels::setActive(kernels::detected());
+		measure("CryptoPP encode", seconds, [&]{
+			for(auto& d: data)
+				if(cryptoppEncode(d).empty()) return size_t(0);
+			return data.size() * size;
+		});
+		measure("CryptoPP decode", seconds, [&]{
+			for(auto& e: encoded)
+				if(cryptoppDecode(e).empty()) return size_t(0);
+			return data.size() * size;
+		});
+
+		for(kernels::ISA isa: {kernels::ISA::Scalar, kernels::ISA::SSE2, kernels::ISA::AVX2, kernels::ISA::AVX512}){
+			if(kernels::setActive(isa) != isa) continue;
+			measure(std::string(kernels::name(isa)) + " encode", seconds, [&]{
+				for(auto& d: data)
+					kernels::base64Encode((const uint8_t*) d.data(), d.size(), encodeBuffer.data());
+				return data.size() * size;
+			});
+			measure(std::string(kernels::name(isa)) + " decode", seconds, [&]{
+				for(auto& e: encoded)
+					kernels::base64Decode(e.data(), e.size(), (uint8_t*) decodeBuffer.data());
+				return data.size() * size;
+			});
+		}
+	}
+	kernels::setActive(kernels::detected());
+
+	std::cout << (identical ? "Every instruction set matches CryptoPP" : "MISMATCH") << std::endl;
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file bench.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the fixtures shared by the tangle benchmarks: a tangle which doesn't update weights in the background (and can be filled with a synthetic graph), and pass/fail checks
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tangle.hpp"
+
+/**
+ * @brief Tangle which doesn't update weights in the background, exposes the weight updates, and can be filled with a synthetic graph
+ */
+struct BenchTangle : public Tangle {
+	using Tangle::updateCumulativeWeights;
+
+	// Every node grow added, in the order they were added (starting with the genesis)
+	std::vector<TransactionNode::const_ptr> all;
+
+	BenchTangle() { updateWeights = false; }
+
+	/**
+	 * @brief Function which grows the graph by <nodes> nodes, each approving two random nodes out of the last <width> added
+	 *
+	 * @param nodes - The number of nodes to add
+	 * @param width - How many of the latest nodes new nodes can approve (roughly the number of tips)
+	 */
+	void grow(size_t nodes, size_t width) {
+		std::mt19937 rng(0);
+		std::vector<TransactionNode::ptr> added = {genesis};
+		for(size_t i = 0; i < nodes; i++){
+			size_t window = std::min(added.size(), width);
+			std::uniform_int_distribution<size_t> pick(added.size() - window, added.size() - 1);
+			auto node = TransactionNode::create({added[pick(rng)], added[pick(rng)]}, {}, {}, 0);
+			for(auto& parent: node->parents)
+				find(parent->hash)->children->push_back(node);
+			added.push_back(node);
+		}
+		all.assign(added.begin(), added.end());
+		// Rebuild the snapshot (which refreshes every node's height)
+		republish();
+	}
+
+	// Function which gets the <count> nodes grow added last (stand ins for the tips)
+	std::vector<TransactionNode::const_ptr> latest(size_t count) const {
+		return {all.end() - std::min(all.size(), count), all.end()};
+	}
+};
+
+// Whether every check passed
+inline bool passed = true;
+
+// Function which records the outcome of a check
+inline void check(bool condition, const std::string& description) {
+	std::cout << (condition ? "pass: " : "FAIL: ") << description << std::endl;
+	passed &= condition;
+}
+
+// Function which reports if every check passed, returning the exit code
+inline int finish() {
+	std::cout << (passed ? "Every check passed" : "CHECKS FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
+
+#endif /* end of include guard: BENCH_HPP */
@@ -0,0 +1,112 @@
+/**
+ * @file bloom.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the Bloom filter light nodes use to subscribe to the transactions touching their accounts
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef BLOOM_HPP
+#define BLOOM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Probabilistic set of strings, which never misses a string that was inserted but may (rarely) claim to hold one which wasn't
+ * @note The k bit positions of a string are derived from two independent 64 bit hashes (Kirsch-Mitzenmacher double hashing, with each probe remixed so small filters don't repeat the same progressions)
+ * @note A filter without any bits is empty, and is treated by the network as "no filter" (matching everything)
+ */
+struct BloomFilter {
+	// The bits of the filter
+	std::vector<uint8_t> bits;
+	// The number of bits set for each string
+	uint8_t hashes = 0;
+
+	BloomFilter() = default;
+	/**
+	 * @brief Creates a filter sized to hold <items> strings with the given false positive rate
+	 *
+	 * @param items - The number of strings the filter is expected to hold
+	 * @param falsePositiveRate - The acceptable chance of a string which wasn't inserted matching
+	 */
+	BloomFilter(size_t items, double falsePositiveRate) {
+		items = std::max<size_t>(items, 1);
+		double ln2 = std::log(2.0);
+		size_t bitCount = std::max<size_t>(std::ceil(-double(items) * std::log(falsePositiveRate) / (ln2 * ln2)), 64);
+		bits.resize((bitCount + 7) / 8, 0);
+		hashes = std::clamp<size_t>(std::round(double(bits.size() * 8) / items * ln2), 1, 32);
+	}
+
+	// Function which checks if the filter is empty (has no bits, so it can't hold anything)
+	bool empty() const { return bits.empty(); }
+	// The size of the filter (in bytes)
+	size_t size() const { return bits.size(); }
+
+	/**
+	 * @brief Function which adds a string to the filter
+	 *
+	 * @param item - The string to add
+	 */
+	void insert(const std::string& item) {
+		if(empty()) return;
+		auto [a, b] = hash(item);
+		for(size_t i = 0; i < hashes; i++){
+			size_t position = probe(a, b, i);
+			bits[position / 8] |= 1 << (position % 8);
+		}
+	}
+
+	/**
+	 * @brief Function which checks if a string might be in the filter
+	 *
+	 * @param item - The string to check for
+	 * @return bool - False if the string was definitely never inserted, true if it probably was
+	 */
+	bool mayContain(const std::string& item) const {
+		if(empty()) return false;
+		auto [a, b] = hash(item);
+		for(size_t i = 0; i < hashes; i++){
+			size_t position = probe(a, b, i);
+			if(!(bits[position / 8] & (1 << (position % 8)))) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Function which estimates the filter's false positive rate once it holds <items> strings
+	 *
+	 * @param items - The number of strings inserted
+	 * @return double - The chance a string which wasn't inserted matches
+	 */
+	double falsePositiveRate(size_t items) const {
+		if(empty()) return 1;
+		return std::pow(1 - std::exp(-double(hashes) * items / (bits.size() * 8)), hashes);
+	}
+
+protected:
+	// Function which calculates the two (FNV-1a) hashes the bit positions are derived from (the second is forced odd so the positions don't repeat early)
+	static std::pair<uint64_t, uint64_t> hash(const std::string& item) {
+		uint64_t a = 14695981039346656037ull, b = 0x84222325cbf29ce4ull;
+		for(unsigned char c: item){
+			a = (a ^ c) * 1099511628211ull;
+			b = (b ^ c) * 0x100000001b3ull ^ (b >> 29);
+		}
+		return {a, b | 1};
+	}
+
+	// Function which calculates the bit position of the <i>th probe of a string with hashes <a> and <b> (the combined hash is remixed with the splitmix64 finalizer)
+	size_t probe(uint64_t a, uint64_t b, size_t i) const {
+		uint64_t x = a + i * b;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return (x ^ (x >> 31)) % (bits.size() * 8);
+	}
+};
+
+#endif /* end of include guard: BLOOM_HPP */
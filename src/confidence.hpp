@@ -0,0 +1,144 @@
+/**
+ * @file confidence.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the sequential (anytime) estimate of a transaction's confirmation confidence, which stops walking as soon as the walks have decided how the confidence compares to a threshold (up to an indifference margin)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef CONFIDENCE_HPP
+#define CONFIDENCE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Probability that a confidence interval (at any point during the walks) doesn't contain the true confidence, and that a threshold check decides wrongly
+#define CONFIDENCE_ERROR 0.01
+// Width of the indifference margin below a threshold: a confidence at least the threshold is decided above it, one at most the threshold minus the margin below it (either may be decided in between)
+#define CONFIDENCE_INDIFFERENCE 0.1
+// Width of the margin used where wrongly deciding a threshold is reached is costly (applying confirmed balances, choosing a genesis to prune to): too narrow for a
+// 	threshold to be decided reached within CONFIDENCE_MAX_WALKS, so it is only reached if the estimate from every walk is at least the threshold (ex. every walk for 100%)
+#define CONFIDENCE_STRICT_INDIFFERENCE 0.01
+// Most random walks performed when measuring a transaction's confidence (the estimate is used as is if the walks haven't decided by then)
+#define CONFIDENCE_MAX_WALKS 100
+
+/**
+ * @brief A measured confirmation confidence, and the interval the true confidence lies in
+ */
+struct ConfidenceEstimate {
+	// The fraction of walks which approved the transaction
+	float estimate = 0;
+	// The interval the true confidence lies in (with probability at least 1 - the error)
+	float lower = 0, upper = 1;
+	// The number of random walks performed
+	size_t walks = 0;
+	// Whether the confidence is at least the threshold it was measured against (up to the indifference margin, if the walks decided)
+	bool reached = false;
+	// Whether the walks decided how the confidence compares to the threshold (otherwise <reached> compares the estimate to it)
+	bool decided = false;
+};
+
+/**
+ * @brief Sequential test of the probability a random walk approves a transaction
+ * @note The interval is a Chernoff (binomial KL divergence) confidence sequence: after n walks it is every p with n * KL(estimate || p) <= log(2n(n+1) / error), so the error
+ * 	is spent across every n and the interval holds at every point during the walks at once
+ * @note Threshold checks are Wald's sequential probability ratio test of the threshold against the threshold minus the indifference margin: the walks stop once the likelihood
+ * 	ratio leaves [error / (1 - error), (1 - error) / error]. The interval can't decide thresholds near 1 within CONFIDENCE_MAX_WALKS (it never excludes the threshold itself),
+ * 	the test decides them from a few dozen approving walks (ex. every walk approving decides 1 after 44 walks, and .95 after 42)
+ */
+class SequentialConfidence {
+public:
+	/**
+	 * @brief How the walks so far compare the confidence to a threshold
+	 */
+	enum class Decision : uint8_t {
+		// The walks can't yet tell the confidence is at least the threshold, or at most the threshold minus the margin
+		Undecided,
+		// The confidence is above the threshold minus the margin (it was more likely the threshold than below the margin)
+		Above,
+		// The confidence is below the threshold (it was more likely below the margin than the threshold)
+		Below,
+	};
+
+	SequentialConfidence(double error = CONFIDENCE_ERROR, double indifference = CONFIDENCE_INDIFFERENCE) : error(error), indifference(indifference) {}
+
+	// Function which records the outcome of a random walk
+	void add(bool approved) {
+		walks++;
+		approvals += approved;
+	}
+
+	// The number of walks recorded
+	size_t samples() const { return walks; }
+	// The fraction of walks which approved the transaction
+	double estimate() const { return walks ? double(approvals) / walks : 0; }
+
+	/**
+	 * @brief Function which determines if the walks so far have decided how the confidence compares to <threshold>
+	 *
+	 * @param threshold - The confidence to compare against
+	 * @return Decision - Above or below once the likelihood ratio of the threshold against the threshold minus the margin crosses the test's bounds, undecided otherwise
+	 */
+	Decision decide(double threshold) const {
+		if(threshold <= 0) return Decision::Above;
+		if(threshold > 1) return Decision::Below;
+		if(walks == 0) return Decision::Undecided;
+
+		// Log likelihood ratio of the walks if the confidence were the threshold, against if it were at the bottom of the margin
+		// NOTE: an approving walk is impossible below a margin reaching 0, and a disapproving walk is impossible at a threshold of 1
+		double margin = threshold - indifference, ratio = 0;
+		if(approvals) ratio += margin <= 0 ? std::numeric_limits<double>::infinity() : approvals * std::log(threshold / margin);
+		if(walks > approvals) ratio += threshold >= 1 ? -std::numeric_limits<double>::infinity() : (walks - approvals) * std::log((1 - threshold) / (1 - margin));
+
+		double bound = std::log((1 - error) / error);
+		if(ratio >= bound) return Decision::Above;
+		if(ratio <= -bound) return Decision::Below;
+		return Decision::Undecided;
+	}
+
+	// The lowest confidence still inside the interval
+	double lower() const {
+		if(walks == 0) return 0;
+		return invert(estimate(), 0);
+	}
+
+	// The highest confidence still inside the interval
+	double upper() const {
+		if(walks == 0) return 1;
+		return invert(estimate(), 1);
+	}
+
+protected:
+	double error, indifference;
+	size_t walks = 0, approvals = 0;
+
+	// The largest (walk scaled) divergence still inside the interval, after the current number of walks
+	double bound() const { return std::log(2.0 * walks * (walks + 1) / error); }
+
+	// Function which calculates the KL divergence between Bernoulli distributions with success probabilities <q> and <p>
+	static double divergence(double q, double p) {
+		auto term = [](double a, double b) {
+			if(a <= 0) return 0.0;
+			if(b <= 0) return std::numeric_limits<double>::infinity();
+			return a * std::log(a / b);
+		};
+		return term(q, p) + term(1 - q, 1 - p);
+	}
+
+	// Function which finds (by bisection) the edge of the interval lying between the <estimate> and the <limit> (0 or 1)
+	double invert(double estimate, double limit) const {
+		double inside = estimate, outside = limit, bound = this->bound();
+		if(walks * divergence(estimate, limit) <= bound) return limit;
+		for(size_t i = 0; i < 32; i++){
+			double middle = (inside + outside) / 2;
+			(walks * divergence(estimate, middle) <= bound ? inside : outside) = middle;
+		}
+		return inside;
+	}
+};
+
+#endif /* end of include guard: CONFIDENCE_HPP */
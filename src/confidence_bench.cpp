@@ -0,0 +1,107 @@
+/**
+ * @file confidence_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark comparing threshold checks made with every confirmation confidence walk against ones which stop as soon as the walks decide (see confidence.hpp), and checking that
+ * 	clear cases are decided early
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <tuple>
+
+#include "bench.hpp"
+
+/**
+ * @brief Function which feeds a sequential test walks with the same outcome until it decides <threshold> (or runs out of walks)
+ *
+ * @param threshold - The threshold to decide
+ * @param approved - Whether every walk approves the transaction
+ * @param indifference - Width of the margin below the threshold
+ * @return std::pair<size_t, SequentialConfidence::Decision> - The number of walks taken, and the decision
+ */
+std::pair<size_t, SequentialConfidence::Decision> decideUniform(double threshold, bool approved, double indifference = CONFIDENCE_INDIFFERENCE) {
+	SequentialConfidence walks(CONFIDENCE_ERROR, indifference);
+	auto decision = SequentialConfidence::Decision::Undecided;
+	while(walks.samples() < CONFIDENCE_MAX_WALKS && (decision = walks.decide(threshold)) == SequentialConfidence::Decision::Undecided)
+		walks.add(approved);
+	return {walks.samples(), decision};
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<nodes> = 500] [<tips> = 8]" << std::endl;
+		return 1;
+	}
+
+	size_t nodes = argc > 1 ? std::stoul(argv[1]) : 500;
+	size_t tips = argc > 2 ? std::stoul(argv[2]) : 8;
+
+	// -- Early Decisions --
+
+	// Transactions every walk approves should be decided confirmed well before the walks run out, even at the strictest thresholds
+	for(double threshold: {.5, .95, 1.}){
+		auto [walks, decision] = decideUniform(threshold, true);
+		check(decision == SequentialConfidence::Decision::Above && walks < CONFIDENCE_MAX_WALKS, "every walk approving decides " + std::to_string(int(threshold * 100)) + "% is reached after " + std::to_string(walks) + " walks");
+	}
+	// And transactions no walk approves should be decided unconfirmed
+	for(double threshold: {.5, .95, 1.}){
+		auto [walks, decision] = decideUniform(threshold, false);
+		check(decision == SequentialConfidence::Decision::Below && walks < CONFIDENCE_MAX_WALKS, "no walk approving decides " + std::to_string(int(threshold * 100)) + "% isn't reached after " + std::to_string(walks) + " walks");
+	}
+	// The strict margin never decides a threshold is reached early (every walk is needed, so confidence just short of the threshold can't count), but still decides it isn't
+	for(double threshold: {.95, 1.}){
+		auto [walks, decision] = decideUniform(threshold, true, CONFIDENCE_STRICT_INDIFFERENCE);
+		check(decision == SequentialConfidence::Decision::Undecided && walks == CONFIDENCE_MAX_WALKS, "with the strict margin every walk approving leaves " + std::to_string(int(threshold * 100)) + "% undecided after " + std::to_string(walks) + " walks");
+		std::tie(walks, decision) = decideUniform(threshold, false, CONFIDENCE_STRICT_INDIFFERENCE);
+		check(decision == SequentialConfidence::Decision::Below && walks < CONFIDENCE_MAX_WALKS, "with the strict margin no walk approving decides " + std::to_string(int(threshold * 100)) + "% isn't reached after " + std::to_string(walks) + " walks");
+	}
+
+	// -- Early Stopping --
+
+	BenchTangle t;
+	t.grow(nodes, tips);
+	// Weigh every node (so the walks are biased like they are on a live tangle)
+	t.updateCumulativeWeights(t.latest(tips));
+	std::cout << nodes << " nodes, " << tips << " tips, at most " << CONFIDENCE_MAX_WALKS << " walks with " << (CONFIDENCE_ERROR * 100) << "% error" << std::endl;
+
+	// Deep transactions (confirmed), ones a few tip generations old (contested), and the newest (unconfirmed)
+	std::vector<std::pair<std::string, std::vector<TransactionNode::const_ptr>>> groups = {
+		{"deep", {t.all.begin() + 1, t.all.begin() + 1 + 20}},
+		{"middle", {t.all.end() - 3 * tips, t.all.end() - 2 * tips}},
+		{"fresh", {t.all.end() - tips, t.all.end()}},
+	};
+
+	for(float threshold: {.5f, .95f, 1.f})
+		for(auto& [name, group]: groups){
+			size_t fixedWalks = 0, sequentialWalks = 0, fixedReached = 0, sequentialReached = 0, decided = 0;
+			double fixedTime = 0, sequentialTime = 0;
+			for(auto& node: group){
+				// Every walk, then compare the estimate (how thresholds were checked before)
+				auto start = std::chrono::steady_clock::now();
+				auto fixed = node->measureConfidence();
+				fixedTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				fixedWalks += fixed.walks;
+				fixedReached += fixed.estimate >= threshold;
+
+				// Stopping as soon as the walks decide
+				start = std::chrono::steady_clock::now();
+				auto sequential = node->measureConfidence(threshold);
+				sequentialTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				sequentialWalks += sequential.walks;
+				sequentialReached += sequential.reached;
+				decided += sequential.decided;
+			}
+
+			std::cout << "threshold " << threshold << ", " << name << " transactions: every walk " << (double(fixedWalks) / group.size()) << " walks (" << (fixedTime / group.size() * 1e3) << "ms) "
+				<< fixedReached << "/" << group.size() << " reached; sequential " << (double(sequentialWalks) / group.size()) << " walks (" << (sequentialTime / group.size() * 1e3) << "ms) "
+				<< sequentialReached << "/" << group.size() << " reached, " << decided << " decided by the walks" << std::endl;
+		}
+
+	return finish();
+}
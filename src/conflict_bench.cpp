@@ -0,0 +1,118 @@
+/**
+ * @file conflict_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark showing how much mining work is wasted on transactions approving both sides of a double spend under conflicting load, with tips picked blindly and with conflict aware tip selection (see TransactionNode::createAndMine)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <iostream>
+
+#include "bench.hpp"
+
+/**
+ * @brief Counters describing what happened to the honest transactions
+ */
+struct Result {
+	size_t mined = 0, added = 0, rejected = 0, conflicts = 0;
+	// Seconds spent selecting tips, mining, and adding honest transactions
+	double seconds = 0;
+};
+
+// Function which creates (and mines) a transaction approving two tips picked by random walks, without considering conflicts (how tips were selected before)
+TransactionNode::ptr createAndMineBlindly(const Tangle& t, const std::vector<Transaction::Input>& inputs, const std::vector<Transaction::Output>& outputs, uint8_t difficulty) {
+	std::vector<TransactionNode::const_ptr> parents = {t.biasedRandomWalk(), t.biasedRandomWalk()};
+	util::removeDuplicates(parents);
+	auto node = TransactionNode::create(parents, inputs, outputs, difficulty);
+	node->mineTransaction();
+	return node;
+}
+
+/**
+ * @brief Function which runs honest peers' transactions alongside an attacker double spending every <conflictEvery> transactions
+ *
+ * @param aware - Whether honest transactions use conflict aware tip selection
+ * @param transactions - The number of honest transactions to send
+ * @param conflictEvery - How many honest transactions are sent between each of the attacker's double spends
+ * @param difficulty - The mining difficulty of every transaction
+ * @return Result - What happened to the honest transactions
+ */
+Result simulate(bool aware, size_t transactions, size_t conflictEvery, uint8_t difficulty) {
+	auto attacker = key::generateKeyPair(), bob = key::generateKeyPair(), carol = key::generateKeyPair();
+	std::vector<key::KeyPair> honest;
+	for(size_t i = 0; i < 4; i++) honest.push_back(key::generateKeyPair());
+
+	BenchTangle t;
+	std::vector<Transaction::Output> grants = {{attacker.pub, Amount(1'000'000)}};
+	for(auto& pair: honest) grants.push_back({pair.pub, Amount(1'000'000)});
+	t.setGenesis(TransactionNode::create({}, {}, grants));
+
+	Result out;
+	for(size_t i = 0; i < transactions; i++){
+		// The attacker sends the same sequence number to two different accounts at once (both sides picking tips before either is added, so neither approves the other)
+		if(i % conflictEvery == 0){
+			uint64_t sequence = t.reserveSequence(attacker);
+			std::vector<TransactionNode::ptr> sides;
+			for(auto& to: {bob, carol}){
+				std::vector<Transaction::Output> outputs = {{to.pub, Amount(1)}};
+				sides.push_back(createAndMineBlindly(t, {{attacker, 1, sequence, outputs}}, outputs, difficulty));
+			}
+			size_t added = 0;
+			for(auto& side: sides)
+				try {
+					t.add(side);
+					added++;
+				} catch (std::exception&) {}
+			out.conflicts += added == 2;
+		}
+
+		// An honest peer pays someone
+		auto& from = honest[i % honest.size()];
+		std::vector<Transaction::Output> outputs = {{honest[(i + 1) % honest.size()].pub, Amount(1)}};
+		std::vector<Transaction::Input> inputs = {{from, 1, t.reserveSequence(from), outputs}};
+		auto start = std::chrono::steady_clock::now();
+		try {
+			auto node = aware ? TransactionNode::createAndMine(t, inputs, outputs, difficulty) : createAndMineBlindly(t, inputs, outputs, difficulty);
+			out.mined++;
+			t.add(node);
+			out.added++;
+		} catch (std::exception&) {
+			out.rejected++;
+		}
+		out.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return out;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 4){
+		std::cout << "Usage: " << argv[0] << " [<honest transactions> = 300] [<honest transactions per double spend> = 4] [<difficulty> = 2]" << std::endl;
+		return 1;
+	}
+
+	size_t transactions = argc > 1 ? std::stoul(argv[1]) : 300;
+	size_t conflictEvery = argc > 2 ? std::max<size_t>(std::stoul(argv[2]), 1) : 4;
+	uint8_t difficulty = argc > 3 ? std::stoul(argv[3]) : 2;
+
+	std::cout << transactions << " honest transactions, a double spend every " << conflictEvery << ", difficulty " << int(difficulty) << std::endl;
+	Result blind = simulate(false, transactions, conflictEvery, difficulty);
+	Result aware = simulate(true, transactions, conflictEvery, difficulty);
+
+	auto print = [](const std::string& name, const Result& r) {
+		std::cout << name << ": " << r.conflicts << " double spends in the tangle, " << r.added << "/" << r.mined << " mined transactions added, " << (100.0 * (r.mined - r.added) / std::max<size_t>(r.mined, 1)) << "% of mining wasted, "
+			<< (r.added / r.seconds) << " transactions/s" << std::endl;
+	};
+	print("Blind tip selection", blind);
+	print("Conflict aware tip selection", aware);
+	std::cout << "Throughput gain: " << ((aware.added / aware.seconds) / (blind.added / blind.seconds)) << "x" << std::endl;
+
+	// Conflict aware tip selection should never waste mining on a transaction the tangle rejects
+	check(aware.added == aware.mined, "no conflict aware transaction was rejected after mining");
+	return finish();
+}
@@ -0,0 +1,367 @@
+/**
+ * @file daemon.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Implementation of the command line/config file options, and the load generator
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "daemon.hpp"
+
+#include <fstream>
+#include <random>
+
+
+// -- Options --
+
+
+/**
+ * @brief Function which parses an unsigned integer option
+ *
+ * @param name - The name of the option (used in errors)
+ * @param value - The value to parse
+ * @param max - The largest acceptable value
+ * @return size_t - The parsed value
+ */
+static size_t parseUnsigned(const std::string& name, const std::string& value, size_t max = std::numeric_limits<size_t>::max()) {
+	size_t end = 0, out;
+	try {
+		out = std::stoull(value, &end);
+	} catch (std::exception&) { throw Options::InvalidOption(name, "`" + value + "` is not a number"); }
+	if(end != value.size() || value.front() == '-') throw Options::InvalidOption(name, "`" + value + "` is not a positive integer");
+	if(out > max) throw Options::InvalidOption(name, "`" + value + "` must be at most " + std::to_string(max));
+	return out;
+}
+
+/**
+ * @brief Function which parses a true/false option
+ *
+ * @param name - The name of the option (used in errors)
+ * @param value - The value to parse
+ * @return bool - The parsed value
+ */
+static bool parseBool(const std::string& name, const std::string& value) {
+	if(value == "true" || value == "yes" || value == "on" || value == "1") return true;
+	if(value == "false" || value == "no" || value == "off" || value == "0") return false;
+	throw Options::InvalidOption(name, "`" + value + "` is not true or false");
+}
+
+/**
+ * @brief Function which sets a single option
+ *
+ * @param name - The name of the option (without leading dashes)
+ * @param value - The value of the option
+ * @exception InvalidOption - Thrown if the option is unknown, or its value is invalid
+ */
+void Options::set(const std::string& name, const std::string& value) {
+	if(name == "daemon") daemon = parseBool(name, value);
+	else if(name == "key") keyPath = value;
+	else if(name == "scheme") {
+		try {
+			scheme = key::parseScheme(value);
+		} catch (std::invalid_argument&) { throw InvalidOption(name, "`" + value + "` is not ecdsa or ed25519"); }
+	}
+	else if(name == "handshake-port") handshakePort = parseUnsigned(name, value, 65535);
+	else if(name == "network-port") networkPort = parseUnsigned(name, value, 65535);
+	else if(name == "rpc-port") rpcPort = parseUnsigned(name, value, 65535);
+	else if(name == "peer") peer = value;
+	else if(name == "peer-port") peerPort = parseUnsigned(name, value, 65535);
+	else if(name == "light") light = parseBool(name, value);
+	else if(name == "prune-interval") pruneInterval = parseUnsigned(name, value);
+	else if(name == "data-dir") dataDir = value;
+	else if(name == "rpc-threads") rpcThreads = std::max<size_t>(parseUnsigned(name, value), 1);
+	else if(name == "load-tps") {
+		try {
+			size_t end;
+			loadTPS = std::stod(value, &end);
+			if(end != value.size() || loadTPS < 0) throw std::invalid_argument(value);
+		} catch (std::exception&) { throw InvalidOption(name, "`" + value + "` is not a positive number"); }
+	} else if(name == "load-accounts") {
+		loadAccounts = parseUnsigned(name, value);
+		if(loadAccounts < 2) throw InvalidOption(name, "at least two accounts are needed");
+	} else if(name == "load-threads") loadThreads = std::max<size_t>(parseUnsigned(name, value), 1);
+	else if(name == "load-duration") loadDuration = parseUnsigned(name, value);
+	else if(name == "load-difficulty") {
+		// Comma separated list of difficulty:weight pairs (ex. 1:70,2:20,3:10), a missing weight counts as 1
+		loadDifficulties.clear();
+		std::stringstream list(value);
+		std::string entry;
+		while(std::getline(list, entry, ',')){
+			size_t colon = entry.find(':');
+			uint8_t difficulty = parseUnsigned(name, entry.substr(0, colon), 5);
+			if(difficulty < 1) throw InvalidOption(name, "difficulties must be between 1 and 5");
+			double weight = 1;
+			if(colon != std::string::npos)
+				try {
+					weight = std::stod(entry.substr(colon + 1));
+				} catch (std::exception&) { throw InvalidOption(name, "`" + entry + "` has an invalid weight"); }
+			if(weight < 0) throw InvalidOption(name, "`" + entry + "` has a negative weight");
+			loadDifficulties.emplace_back(difficulty, weight);
+		}
+		if(loadDifficulties.empty()) throw InvalidOption(name, "at least one difficulty is needed");
+	} else if(name == "config") {
+		std::ifstream fin(value);
+		if(!fin) throw InvalidOption(name, "failed to open `" + value + "`");
+		load(fin);
+	} else throw InvalidOption(name, "unknown option");
+}
+
+/**
+ * @brief Function which loads options from a config file
+ * @note Each line is a `name = value` pair, blank lines and anything after a # are ignored
+ *
+ * @param config - Stream to read the config from
+ * @exception InvalidOption - Thrown if a line is malformed, or any option is invalid
+ */
+void Options::load(std::istream& config) {
+	auto trim = [](std::string str) {
+		str.erase(0, str.find_first_not_of(" \t\r"));
+		str.erase(str.find_last_not_of(" \t\r") + 1);
+		return str;
+	};
+
+	std::string line;
+	while(std::getline(config, line)){
+		line = trim(line.substr(0, line.find('#')));
+		if(line.empty()) continue;
+
+		size_t equals = line.find('=');
+		if(equals == std::string::npos) throw InvalidOption(line, "expected `name = value`");
+		set(trim(line.substr(0, equals)), trim(line.substr(equals + 1)));
+	}
+}
+
+/**
+ * @brief Function which parses the command line
+ * @note Options can be provided as `--name value` or `--name=value`, `--daemon` and `--light` don't need a value, and a lone argument is the peer to connect to
+ * @note Options are applied in order, so options after a --config override the config file
+ *
+ * @param argc - Number of arguments
+ * @param argv - The arguments
+ * @return Options - The parsed options
+ * @exception InvalidOption - Thrown if any argument is invalid
+ */
+Options Options::parse(int argc, char* argv[]) {
+	Options out;
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+
+		// A lone argument is the address of the peer to connect to
+		if(!arg.starts_with("--")){
+			if(!out.peer.empty()) throw InvalidOption(arg, "only one peer may be provided");
+			out.peer = arg;
+			continue;
+		}
+
+		std::string name = arg.substr(2), value;
+		if(size_t equals = name.find('='); equals != std::string::npos){
+			value = name.substr(equals + 1);
+			name = name.substr(0, equals);
+		} else if(name == "daemon" || name == "light") value = "true";
+		else if(name == "help") throw InvalidOption(name, "help requested");
+		else if(i + 1 < argc) value = argv[++i];
+		else throw InvalidOption(name, "missing value");
+
+		out.set(name, value);
+	}
+
+	// Light nodes can't create a network (or generate load), since they don't keep the tangle
+	if(out.light && out.peer.empty()) throw InvalidOption("light", "light nodes need a peer to connect to");
+	if(out.light && out.loadTPS > 0) throw InvalidOption("light", "the load generator needs a full node");
+	return out;
+}
+
+/**
+ * @brief Function which creates a message describing the program's arguments
+ *
+ * @param program - Name of the program (argv[0])
+ * @return std::string - The usage message
+ */
+std::string Options::usage(const char* program) {
+	std::stringstream out;
+	out << "Usage: " << program << " [<target ip>] [--<option> <value>]..." << std::endl
+		<< "Options (may also be provided in a config file as `<option> = <value>` lines):" << std::endl
+		<< "	--config <path>				- Loads options from a config file" << std::endl
+		<< "	--daemon					- Runs without the interactive menu or prompts" << std::endl
+		<< "	--key <path>				- Key file to load (generated and saved there if missing)" << std::endl
+		<< "	--scheme <ecdsa|ed25519>		- Signature scheme of generated accounts (default: ed25519)" << std::endl
+		<< "	--handshake-port <port>			- Port to accept handshakes on (default: first free)" << std::endl
+		<< "	--network-port <port>			- Port the peer-to-peer network listens on (default: first free)" << std::endl
+		<< "	--rpc-port <port>			- Port the RPC server listens on (default: first free)" << std::endl
+		<< "	--peer <ip>				- Peer to connect to (default: establish a new network)" << std::endl
+		<< "	--peer-port <port>			- Network port of the peer (default: discovered with a handshake)" << std::endl
+		<< "	--light					- Runs as a light node, tracking only our account (requires a peer)" << std::endl
+		<< "	--prune-interval <seconds>		- How often the tangle is pruned (default: never)" << std::endl
+		<< "	--rpc-threads <count>			- Threads handling RPC requests" << std::endl
+		<< "	--data-dir <path>			- Directory the RPC server saves and loads tangles in (default: none, disabled)" << std::endl
+		<< "	--load-tps <rate>			- Transactions per second to generate (default: 0, off)" << std::endl
+		<< "	--load-accounts <count>			- Accounts load is spread over (default: 16)" << std::endl
+		<< "	--load-threads <count>			- Threads mining generated transactions" << std::endl
+		<< "	--load-duration <seconds>		- How long to generate load for (default: until shutdown)" << std::endl
+		<< "	--load-difficulty <d:w,...>		- Weighted mix of mining difficulties (default: 1)" << std::endl;
+	return out.str();
+}
+
+
+// -- Load Generator --
+
+
+/**
+ * @brief Function which creates the load generator's accounts, funds them, and starts the worker threads
+ * @note Funding waits for our account to have money, so this returns immediately and funds the accounts in the background
+ */
+void LoadGenerator::start() {
+	if(running) return;
+	running = true;
+
+	controller = std::thread([this](){
+		if(!fund()) return;
+
+		// Schedule the first transaction and start the workers
+		startTime = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for(size_t i = 0; i < options.loadThreads; i++)
+			workers.emplace_back(&LoadGenerator::work, this);
+		for(auto& worker: workers)
+			worker.join();
+		stopTime = std::chrono::steady_clock::now();
+	});
+}
+
+/**
+ * @brief Function which stops the worker threads (transactions being mined are finished first)
+ */
+void LoadGenerator::stop() {
+	{
+		std::scoped_lock lock(sleepMutex);
+		running = false;
+	}
+	wake.notify_all();
+
+	if(controller.joinable()) controller.join();
+}
+
+/**
+ * @brief Function which generates the load generator's accounts, and sends each of them an equal share of our money
+ *
+ * @return bool - True if the accounts were funded, false if the generator was stopped first
+ */
+bool LoadGenerator::fund() {
+	for(size_t i = 0; i < options.loadAccounts; i++)
+		accounts.push_back(key::generateKeyPair(options.scheme));
+
+	// Wait for our account to receive money
+	Amount balance;
+	while((balance = t.queryBalance(*t.personalKeys)) <= 0){
+		std::unique_lock lock(sleepMutex);
+		if(wake.wait_for(lock, std::chrono::milliseconds(250), [this]{ return !running; }))
+			return false;
+	}
+
+	// Send every account an equal share (keeping a share for ourselves) in a single transaction
+	funding = Amount::fromRaw(balance.raw / (accounts.size() + 1));
+	std::vector<Transaction::Output> outputs;
+	for(auto& account: accounts)
+		outputs.emplace_back(account.pub, funding);
+	std::vector<Transaction::Input> inputs;
+	inputs.emplace_back(*t.personalKeys, Amount::fromRaw(funding.raw * accounts.size()), t.reserveSequence(*t.personalKeys), outputs);
+
+	try {
+		t.add(TransactionNode::createAndMine(t, inputs, outputs, t.miningDifficulty(inputs, 1)));
+	} catch (std::exception& e) {
+		std::cerr << "Failed to fund the load generator's accounts: " << e.what() << std::endl;
+		done = true;
+		return false;
+	}
+	std::cout << "Load generator funded " << accounts.size() << " accounts with " << funding << " money each" << std::endl;
+	return true;
+}
+
+/**
+ * @brief Function run by each worker thread, repeatedly takes the next scheduled transaction, waits until it is due, then creates, mines, and adds it
+ */
+void LoadGenerator::work() {
+	std::mt19937_64 random(std::random_device{}());
+	std::uniform_int_distribution<size_t> pickAccount(0, accounts.size() - 1);
+	// Transfers are small relative to the funding so accounts rarely run dry
+	std::uniform_int_distribution<Amount::Raw> pickAmount(1, std::max<Amount::Raw>(funding.raw / 1000, 1));
+	std::vector<double> weights;
+	for(auto& [difficulty, weight]: options.loadDifficulties)
+		weights.push_back(weight);
+	std::discrete_distribution<size_t> pickDifficulty(weights.begin(), weights.end());
+
+	auto interval = std::chrono::duration<double>(1 / options.loadTPS);
+	auto start = startTime.load(), end = start + std::chrono::seconds(options.loadDuration);
+
+	while(running){
+		// Take the next ticket and wait until it is scheduled
+		auto scheduled = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * double(nextTicket++));
+		if(options.loadDuration && scheduled >= end){
+			done = true;
+			break;
+		}
+		{
+			std::unique_lock lock(sleepMutex);
+			if(wake.wait_until(lock, scheduled, [this]{ return !running; }))
+				break;
+		}
+
+		// If a peer told us to slow down... hold off (pushing the schedule back) until it will accept transactions again
+		if(auto wait = t.backoff(AdmissionControl::Class::Transaction); wait.count() > 0){
+			throttled++;
+			std::unique_lock lock(sleepMutex);
+			if(wake.wait_for(lock, wait, [this]{ return !running; }))
+				break;
+		}
+
+		// Pick two different accounts, an amount, and a difficulty
+		size_t from = pickAccount(random), to = pickAccount(random);
+		if(to == from) to = (to + 1) % accounts.size();
+		Amount amount = Amount::fromRaw(pickAmount(random));
+		uint8_t difficulty = options.loadDifficulties[pickDifficulty(random)].first;
+
+		try {
+			std::vector<Transaction::Output> outputs;
+			outputs.emplace_back(accounts[to].pub, amount);
+			std::vector<Transaction::Input> inputs;
+			inputs.emplace_back(accounts[from], amount, t.reserveSequence(accounts[from]), outputs);
+			t.add(TransactionNode::createAndMine(t, inputs, outputs, t.miningDifficulty(inputs, difficulty)));
+
+			succeeded++;
+			latencies.write_lock()->push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scheduled).count());
+		} catch (Tangle::InvalidBalance&) {
+			rejectedBalance++;
+		} catch (Tangle::InvalidSequence&) {
+			rejectedSequence++;
+		} catch (std::exception&) {
+			failed++;
+		}
+	}
+}
+
+/**
+ * @brief Function which prints a summary of the load generator's throughput and latency
+ *
+ * @param out - Stream to print the summary to
+ */
+void LoadGenerator::printSummary(std::ostream& out) const {
+	auto start = startTime.load(), stop = stopTime.load();
+	if(start == std::chrono::steady_clock::time_point{}){
+		out << "Load generator never started (our account was never funded)" << std::endl;
+		return;
+	}
+
+	auto sorted = *latencies.read_lock();
+	std::sort(sorted.begin(), sorted.end());
+	auto percentile = [&sorted](double p) { return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))]; };
+	double elapsed = std::chrono::duration<double>((stop > start ? stop : std::chrono::steady_clock::now()) - start).count();
+
+	out << "Load generator summary (" << accounts.size() << " accounts, " << options.loadThreads << " threads, target " << options.loadTPS << " tps):" << std::endl
+		<< "	Ran for " << elapsed << "s: " << succeeded << " added, " << rejectedBalance << " rejected (balance), " << rejectedSequence << " rejected (sequence), " << failed << " failed" << std::endl
+		<< "	Throughput: " << (elapsed > 0 ? succeeded / elapsed : 0) << " tps" << std::endl
+		<< "	Latency (ms): p50 " << percentile(.5) << ", p90 " << percentile(.9) << ", p99 " << percentile(.99) << ", max " << (sorted.empty() ? 0 : sorted.back()) << std::endl
+		<< "	Held off " << throttled << " times because a peer told us to slow down" << std::endl
+		<< "	Tangle: " << t.discardedBeforeMining << " discarded before mining, " << t.rejectedAfterMining << " rejected after mining" << std::endl;
+}
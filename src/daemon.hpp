@@ -0,0 +1,124 @@
+/**
+ * @file daemon.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the command line/config file options, and the load generator used to run a node unattended
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <condition_variable>
+
+#include "networking.hpp"
+
+/**
+ * @brief Options controlling how a node runs, from the command line and/or a config file
+ * @note Config files contain one `name = value` option per line (the same names as the command line flags, without the leading dashes), # starts a comment
+ */
+struct Options {
+	/**
+	 * @brief Exception thrown when an option is unknown or has an invalid value
+	 */
+	struct InvalidOption : public std::runtime_error { InvalidOption(const std::string& option, const std::string& reason) : std::runtime_error("Invalid option `" + option + "`: " + reason) {} };
+
+	// Run without the interactive menu (or any other prompts)
+	bool daemon = false;
+	// Path to the key file (loaded if it exists, otherwise a new account is generated and saved there), empty prompts (or generates without saving in daemon mode)
+	std::string keyPath;
+	// Signature scheme used by newly generated accounts
+	key::Scheme scheme = key::DEFAULT_SCHEME;
+
+	// Ports to listen on (0 picks the first free port)
+	unsigned short handshakePort = 0, networkPort = 0, rpcPort = 0;
+	// Address of a peer to connect to (empty creates a new network)
+	std::string peer;
+	// Network port of the peer (0 discovers it with a handshake)
+	unsigned short peerPort = 0;
+	// Run as a light node (only our own account's transactions are kept, balances are confirmed with proofs from peers)
+	bool light = false;
+
+	// How often (in seconds) the tangle is pruned (0 never automatically prunes)
+	size_t pruneInterval = 0;
+	// Directory the RPC server's /save and /load endpoints are confined to (empty disables them)
+	std::string dataDir;
+	// Number of threads handling RPC requests
+	size_t rpcThreads = std::max(std::thread::hardware_concurrency(), 2u);
+
+	// Transactions per second the load generator targets (0 disables the load generator)
+	double loadTPS = 0;
+	// Number of accounts the load generator moves money between
+	size_t loadAccounts = 16;
+	// Number of threads the load generator creates and mines transactions on
+	size_t loadThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	// How long (in seconds) the load generator runs for (0 runs until shutdown)
+	size_t loadDuration = 0;
+	// Weighted mix of mining difficulties the load generator uses (list of difficulty, weight pairs)
+	std::vector<std::pair<uint8_t, double>> loadDifficulties = {{1, 1}};
+
+	void set(const std::string& name, const std::string& value);
+	void load(std::istream& config);
+
+	static Options parse(int argc, char* argv[]);
+	static std::string usage(const char* program);
+};
+
+/**
+ * @brief Built in load generator, which moves money between a set of generated accounts at a target rate (open loop)
+ * @note Each transaction is scheduled at a fixed time, latency is measured from that time so falling behind shows up in the latency
+ */
+struct LoadGenerator {
+	LoadGenerator(NetworkedTangle& t, const Options& options) : t(t), options(options) {}
+	~LoadGenerator() { stop(); }
+
+	void start();
+	void stop();
+
+	/**
+	 * @brief Function which determines if the load generator has run for its full duration
+	 *
+	 * @return True if the generator has finished, false otherwise (always false if running until shutdown)
+	 */
+	bool finished() const { return done; }
+
+	void printSummary(std::ostream& out) const;
+
+protected:
+	// The tangle transactions are added to
+	NetworkedTangle& t;
+	// The options the generator was created with
+	const Options options;
+
+	// The accounts money is moved between
+	std::vector<key::KeyPair> accounts;
+	// The amount each account was funded with
+	Amount funding;
+
+	// Thread which funds the accounts, then runs (and waits for) the workers
+	std::thread controller;
+	// Flag marking that the workers should keep running, and flag marking that the generator has finished
+	std::atomic<bool> running = false, done = false;
+	// Mutex and condition used to wake sleeping workers when stopping
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	// The time the first transaction was scheduled at, and the time the generator stopped (atomic since the summary may be printed while the generator is running)
+	std::atomic<std::chrono::steady_clock::time_point> startTime = {}, stopTime = {};
+	// The next transaction to be scheduled
+	std::atomic<size_t> nextTicket = 0;
+
+	// Counts of the outcomes of each transaction
+	std::atomic<size_t> succeeded = 0, rejectedBalance = 0, rejectedSequence = 0, failed = 0;
+	// Number of times a worker held off because a peer told us to slow down
+	std::atomic<size_t> throttled = 0;
+	// Latencies (in milliseconds) of each successful transaction
+	monitor<std::vector<double>> latencies;
+
+	bool fund();
+	void work();
+};
+
+#endif /* end of include guard: DAEMON_HPP */
@@ -0,0 +1,219 @@
+/**
+ * @file difficulty.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the load adaptive minimum mining difficulty, which rises with the rate transactions are arriving at, the number of tips, and how often an account has recently spent
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef DIFFICULTY_HPP
+#define DIFFICULTY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "monitor.hpp"
+
+// Lowest and highest minimum difficulty (each step of difficulty takes 64 times as much work to mine)
+#define DIFFICULTY_MINIMUM 1
+#define DIFFICULTY_MAXIMUM 5
+// Time (in seconds) it takes the measured rates to decay by half once transactions stop arriving
+#define DIFFICULTY_HALF_LIFE 10
+// Rate (transactions per second) beyond which the minimum rises by one, and the factor the rate must grow by to raise it again
+#define DIFFICULTY_TARGET_RATE 500
+#define DIFFICULTY_RATE_STEP 8
+// Number of tips beyond which the minimum rises by one (transactions are arriving faster than they are being approved)
+#define DIFFICULTY_TIP_TARGET 128
+// Rate (spends per second) beyond which a single account's transactions need one more step of difficulty (rising again with every DIFFICULTY_RATE_STEP)
+#define DIFFICULTY_ACCOUNT_RATE 2
+// Time (in milliseconds) after the minimum rises that transactions mined at the old minimum are still accepted (so transactions mined before a peer noticed the change aren't lost)
+#define DIFFICULTY_GRACE 5000
+// Number of accounts whose spending rate is tracked before the idle ones are forgotten
+#define DIFFICULTY_ACCOUNT_LIMIT 8192
+// Time (in milliseconds) between checks for the minimum falling while transactions aren't arriving
+#define DIFFICULTY_REFRESH_INTERVAL 1000
+
+/**
+ * @brief Policy which determines the minimum difficulty transactions must be mined at, adapting to the load on the network
+ * @note Rates are exponentially decaying counts, so bursts raise the minimum quickly and it falls back gradually once they pass
+ * @note The minimum is recalculated (against the time elapsed since the last transaction) whenever it is looked up, so it falls even while nothing arrives
+ */
+class DifficultyPolicy {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief An exponentially decaying count of events, which estimates the rate they are happening at
+	 */
+	struct Rate {
+		double count = 0;
+		Clock::time_point last;
+
+		// Function which decays the count to the given time
+		double decayed(Clock::time_point now) const {
+			if(now <= last) return count;
+			return count * std::exp2(-std::chrono::duration<double>(now - last).count() / DIFFICULTY_HALF_LIFE);
+		}
+		// Function which records an event
+		void add(Clock::time_point now) {
+			count = decayed(now) + 1;
+			last = std::max(last, now);
+		}
+		// Function which estimates the rate (events per second)
+		double perSecond(Clock::time_point now) const { return decayed(now) * std::log(2.0) / DIFFICULTY_HALF_LIFE; }
+	};
+
+	/**
+	 * @brief Counters describing the policy
+	 */
+	struct Stats {
+		// The current minimum, and the minimum still accepted during the grace period
+		uint8_t minimum, accepted;
+		// The measured rate transactions are arriving at, the number of tips when the last transaction arrived, and the number of accounts whose spending is tracked
+		double ingestRate;
+		size_t tips, accounts;
+	};
+
+	/**
+	 * @brief Function which records an accepted transaction
+	 *
+	 * @param spenders - The (base 64) accounts the transaction spends from
+	 * @param tips - The number of tips after the transaction was added
+	 * @param now - The current time
+	 * @return bool - True if the minimum difficulty changed since it was last advertised (and so should be advertised), false otherwise
+	 */
+	bool record(const std::vector<std::string>& spenders, size_t tips, Clock::time_point now = Clock::now()) {
+		auto lock = state.write_lock();
+		lock->ingest.add(now);
+		lock->tips = tips;
+		for(auto& account: spenders)
+			lock->accounts[account].add(now);
+
+		// Forget the accounts which have gone quiet (if too many are being tracked)
+		if(lock->accounts.size() > DIFFICULTY_ACCOUNT_LIMIT)
+			std::erase_if(lock->accounts, [now](auto& account) { return account.second.perSecond(now) < DIFFICULTY_ACCOUNT_RATE / 2.0; });
+
+		update(*lock, now);
+		return advertise(*lock);
+	}
+
+	/**
+	 * @brief Function which recalculates the minimum difficulty while transactions aren't arriving (called periodically)
+	 *
+	 * @param tips - The current number of tips
+	 * @param now - The current time
+	 * @return bool - True if the minimum difficulty changed since it was last advertised (and so should be advertised), false otherwise
+	 */
+	bool refresh(size_t tips, Clock::time_point now = Clock::now()) {
+		auto lock = state.write_lock();
+		lock->tips = tips;
+		update(*lock, now);
+		return advertise(*lock);
+	}
+
+	// The current minimum difficulty
+	uint8_t minimum(Clock::time_point now = Clock::now()) const {
+		auto lock = state.write_lock();
+		update(*lock, now);
+		return lock->minimum;
+	}
+
+	/**
+	 * @brief Function which determines the difficulty a transaction spending from the given accounts must be mined at
+	 *
+	 * @param spenders - The (base 64) accounts the transaction spends from
+	 * @param now - The current time
+	 * @return uint8_t - The required difficulty (the minimum plus a step for each account spending too often)
+	 */
+	uint8_t required(const std::vector<std::string>& spenders, Clock::time_point now = Clock::now()) const {
+		auto lock = state.write_lock();
+		update(*lock, now);
+		return std::min<uint8_t>(lock->minimum + surcharge(*lock, spenders, now), DIFFICULTY_MAXIMUM);
+	}
+
+	/**
+	 * @brief Function which determines the lowest difficulty a transaction spending from the given accounts is accepted at
+	 * @note The same as required, except the previous minimum is still accepted for DIFFICULTY_GRACE milliseconds after the minimum rises
+	 *
+	 * @param spenders - The (base 64) accounts the transaction spends from
+	 * @param now - The current time
+	 * @return uint8_t - The lowest accepted difficulty
+	 */
+	uint8_t accepted(const std::vector<std::string>& spenders, Clock::time_point now = Clock::now()) const {
+		auto lock = state.write_lock();
+		update(*lock, now);
+		return std::min<uint8_t>(floor(*lock, now) + surcharge(*lock, spenders, now), DIFFICULTY_MAXIMUM);
+	}
+
+	// Function which gets a snapshot of the policy's counters
+	Stats stats(Clock::time_point now = Clock::now()) const {
+		auto lock = state.write_lock();
+		update(*lock, now);
+		return { lock->minimum, floor(*lock, now), lock->ingest.perSecond(now), lock->tips, lock->accounts.size() };
+	}
+
+protected:
+	/**
+	 * @brief The measured load, and the minimum it produced
+	 */
+	struct State {
+		Rate ingest;
+		size_t tips = 0;
+		std::unordered_map<std::string, Rate> accounts;
+		// The current minimum, the minimum before it, when it changed, and the minimum last advertised to our peers
+		uint8_t minimum = DIFFICULTY_MINIMUM, previous = DIFFICULTY_MINIMUM, advertised = DIFFICULTY_MINIMUM;
+		Clock::time_point changed;
+	};
+	// NOTE: mutable since lookups bring the minimum up to date
+	mutable monitor<State> state;
+
+	// Function which recalculates the minimum from the ingest rate (decayed to <now>) and the number of tips
+	static void update(State& state, Clock::time_point now) {
+		uint8_t minimum = level(state.ingest.perSecond(now), DIFFICULTY_TARGET_RATE, DIFFICULTY_MINIMUM) + (state.tips > DIFFICULTY_TIP_TARGET);
+		minimum = std::min<uint8_t>(minimum, DIFFICULTY_MAXIMUM);
+		if(minimum == state.minimum) return;
+
+		state.previous = state.minimum;
+		state.minimum = minimum;
+		state.changed = now;
+	}
+
+	// Function which checks if the minimum changed since it was last advertised (marking it as advertised)
+	static bool advertise(State& state) {
+		if(state.minimum == state.advertised) return false;
+		state.advertised = state.minimum;
+		return true;
+	}
+
+	// Function which calculates the level a <rate> reaches: <base> at or below the <target>, plus one for every DIFFICULTY_RATE_STEP it grows by beyond it
+	static uint8_t level(double rate, double target, uint8_t base) {
+		uint8_t out = base;
+		for(double threshold = target; rate > threshold && out < DIFFICULTY_MAXIMUM; threshold *= DIFFICULTY_RATE_STEP)
+			out++;
+		return out;
+	}
+
+	// Function which calculates the extra difficulty needed because of how often the <spenders> have recently spent
+	static uint8_t surcharge(const State& state, const std::vector<std::string>& spenders, Clock::time_point now) {
+		uint8_t out = 0;
+		for(auto& account: spenders)
+			if(auto rate = state.accounts.find(account); rate != state.accounts.end())
+				out = std::max(out, level(rate->second.perSecond(now), DIFFICULTY_ACCOUNT_RATE, 0));
+		return out;
+	}
+
+	// Function which calculates the lowest minimum still accepted (the previous minimum during the grace period after a rise)
+	static uint8_t floor(const State& state, Clock::time_point now) {
+		if(state.previous < state.minimum && now - state.changed < std::chrono::milliseconds(DIFFICULTY_GRACE))
+			return state.previous;
+		return state.minimum;
+	}
+};
+
+#endif /* end of include guard: DIFFICULTY_HPP */
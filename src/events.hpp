@@ -0,0 +1,293 @@
+/**
+ * @file events.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the event stream clients subscribe to (instead of polling balances) to hear about transactions being committed, confirmed, or pruned
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef EVENTS_HPP
+#define EVENTS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "monitor.hpp"
+
+// Number of events each subscriber can have waiting before the oldest are dropped
+#define EVENT_QUEUE_CAPACITY 1024
+// Minimum time (in milliseconds) between checks of the confidence of the transactions subscribers are waiting to see confirmed
+#define EVENT_CONFIRMATION_INTERVAL 250
+// Maximum number of transactions whose confidence is tracked at once (the oldest stop being tracked first)
+#define EVENT_WATCH_LIMIT 4096
+
+namespace events {
+	/**
+	 * @brief The kinds of event (flags, so a filter can select several)
+	 */
+	enum class Type : uint8_t {
+		// A transaction was added to the tangle
+		Committed = 1 << 0,
+		// A transaction's confirmation confidence crossed one of the subscriber's thresholds
+		Confirmed = 1 << 1,
+		// A transaction was removed from the tangle (collapsed into a new genesis)
+		Pruned = 1 << 2,
+	};
+	// Every type of event
+	constexpr uint8_t ALL_TYPES = uint8_t(Type::Committed) | uint8_t(Type::Confirmed) | uint8_t(Type::Pruned);
+
+	// Function which gets the name of an event type
+	inline std::string name(Type type) {
+		switch(type){
+		case Type::Committed: return "committed";
+		case Type::Confirmed: return "confirmed";
+		case Type::Pruned: return "pruned";
+		}
+		return "unknown";
+	}
+
+	// Function which finds the event type with the given name
+	inline std::optional<Type> parse(const std::string& name) {
+		for(Type type: {Type::Committed, Type::Confirmed, Type::Pruned})
+			if(events::name(type) == name) return type;
+		return {};
+	}
+
+	/**
+	 * @brief Something which happened to a transaction
+	 */
+	struct Event {
+		// Position of the event in the stream (assigned when published, increases by one with each event)
+		uint64_t id = 0;
+		Type type = Type::Committed;
+		// The hash of the transaction
+		std::string hash;
+		// The base 64 representations of the accounts the transaction's inputs and outputs belong to
+		std::vector<std::string> accounts;
+		// For confirmed events: the threshold crossed, and the confidence that was measured
+		float threshold = 0, confidence = 0;
+	};
+
+	/**
+	 * @brief Description of the events a subscriber is interested in
+	 */
+	struct Filter {
+		// The (base 64) accounts whose transactions are wanted (empty wants every account)
+		std::unordered_set<std::string> accounts;
+		// The types of event wanted
+		uint8_t types = ALL_TYPES;
+		// The confidences which produce a confirmed event when a transaction crosses them
+		std::vector<float> thresholds = {.5, .95};
+
+		// Function which checks if the filter wants events of the given type
+		bool wants(Type type) const { return types & uint8_t(type); }
+
+		// Function which checks if the filter wants events about a transaction touching the given accounts
+		bool wants(const std::vector<std::string>& touched) const {
+			return accounts.empty() || std::any_of(touched.begin(), touched.end(), [this](const std::string& account) { return accounts.contains(account); });
+		}
+
+		// Function which checks if the filter wants an event
+		bool matches(const Event& event) const {
+			if(!wants(event.type) || !wants(event.accounts)) return false;
+			return event.type != Type::Confirmed || std::find(thresholds.begin(), thresholds.end(), event.threshold) != thresholds.end();
+		}
+	};
+
+	/**
+	 * @brief A subscriber's bounded queue of events
+	 * @note Publishing never blocks: if the subscriber falls behind the oldest waiting events are dropped (and counted) to make room
+	 */
+	class Subscription {
+	public:
+		/**
+		 * @brief Counters describing a subscription
+		 */
+		struct Stats {
+			// Events handed to the subscriber, dropped because it fell behind, currently waiting, and how many can wait
+			size_t delivered, dropped, queued, capacity;
+		};
+
+		// Identifier of the subscription
+		const uint64_t id;
+		// The events the subscriber is interested in
+		const Filter filter;
+
+		Subscription(uint64_t id, Filter filter, size_t capacity = EVENT_QUEUE_CAPACITY) : id(id), filter(std::move(filter)), ring(std::max<size_t>(capacity, 1)) {}
+
+		/**
+		 * @brief Function which takes the waiting events (oldest first)
+		 *
+		 * @param max - The maximum number of events to take
+		 * @param wait - How long to wait for an event if none are waiting
+		 * @return std::vector<Event> - The events (empty if none arrived in time, or the subscription was closed)
+		 */
+		std::vector<Event> poll(size_t max = std::numeric_limits<size_t>::max(), std::chrono::milliseconds wait = std::chrono::milliseconds(0)) {
+			std::unique_lock lock(mutex);
+			if(count == 0 && wait.count() > 0)
+				arrived.wait_for(lock, wait, [this] { return count > 0 || closed; });
+
+			std::vector<Event> out;
+			while(count > 0 && out.size() < max){
+				out.push_back(std::move(ring[head]));
+				head = (head + 1) % ring.size();
+				count--;
+			}
+			delivered += out.size();
+			return out;
+		}
+
+		// Function which gets a snapshot of the subscription's counters
+		Stats stats() const {
+			std::scoped_lock lock(mutex);
+			return { delivered, dropped, count, ring.size() };
+		}
+
+		// Function which checks if the subscription has been closed (no more events will arrive)
+		bool isClosed() const {
+			std::scoped_lock lock(mutex);
+			return closed;
+		}
+
+	protected:
+		friend class Hub;
+
+		// Mutex protecting the queue, and the condition waiting pollers sleep on
+		mutable std::mutex mutex;
+		std::condition_variable arrived;
+		// The ring of events, the position of the oldest waiting event, and how many are waiting
+		std::vector<Event> ring;
+		size_t head = 0, count = 0;
+		// Counters
+		size_t delivered = 0, dropped = 0;
+		// Whether the subscription has been closed
+		bool closed = false;
+
+		// Function which queues an event (dropping the oldest waiting event if the queue is full)
+		void push(const Event& event) {
+			{
+				std::scoped_lock lock(mutex);
+				if(closed) return;
+				if(count == ring.size()){
+					head = (head + 1) % ring.size();
+					count--;
+					dropped++;
+				}
+				ring[(head + count) % ring.size()] = event;
+				count++;
+			}
+			arrived.notify_one();
+		}
+
+		// Function which closes the subscription (waking any waiting pollers)
+		void close() {
+			{
+				std::scoped_lock lock(mutex);
+				closed = true;
+			}
+			arrived.notify_all();
+		}
+	};
+
+	/**
+	 * @brief Hub which hands published events to every interested subscriber
+	 * @note The list of subscribers is read-copy-update, so publishing (which happens far more often than subscribing) never takes a lock on it
+	 */
+	class Hub {
+	public:
+		/**
+		 * @brief Function which creates a new subscription
+		 *
+		 * @param filter - The events the subscriber is interested in
+		 * @param capacity - The number of events which can wait before the oldest are dropped
+		 * @return std::shared_ptr<Subscription> - The subscription (call unsubscribe when done with it)
+		 */
+		std::shared_ptr<Subscription> subscribe(Filter filter, size_t capacity = EVENT_QUEUE_CAPACITY) {
+			std::sort(filter.thresholds.begin(), filter.thresholds.end());
+			auto subscription = std::make_shared<Subscription>(nextSubscription++, std::move(filter), capacity);
+			subscribers.write_lock()->push_back(subscription);
+			return subscription;
+		}
+
+		/**
+		 * @brief Function which removes (and closes) a subscription
+		 *
+		 * @param id - The identifier of the subscription
+		 * @return bool - True if the subscription existed, false otherwise
+		 */
+		bool unsubscribe(uint64_t id) {
+			std::shared_ptr<Subscription> removed;
+			{
+				auto lock = subscribers.write_lock();
+				auto found = std::find_if(lock->begin(), lock->end(), [id](auto& subscription) { return subscription->id == id; });
+				if(found == lock->end()) return false;
+				removed = *found;
+				lock->erase(found);
+			}
+			removed->close();
+			return true;
+		}
+
+		// Function which finds a subscription given its identifier (nullptr if it doesn't exist)
+		std::shared_ptr<Subscription> find(uint64_t id) const {
+			auto lock = subscribers.read_lock();
+			auto found = std::find_if(lock->begin(), lock->end(), [id](auto& subscription) { return subscription->id == id; });
+			return found == lock->end() ? nullptr : *found;
+		}
+
+		// The number of subscribers
+		size_t size() const { return subscribers.read_lock()->size(); }
+
+		/**
+		 * @brief Function which checks if anyone wants events of a type about a transaction touching the given accounts (so events nobody wants are never built)
+		 *
+		 * @param type - The type of event
+		 * @param accounts - The accounts the transaction touches (nullptr checks the type alone)
+		 * @return bool - True if at least one subscriber is interested
+		 */
+		bool wants(Type type, const std::vector<std::string>* accounts = nullptr) const {
+			auto lock = subscribers.read_lock();
+			return std::any_of(lock->begin(), lock->end(), [&](auto& subscription) { return subscription->filter.wants(type) && (!accounts || subscription->filter.wants(*accounts)); });
+		}
+
+		// Function which gets every threshold a subscriber wants confirmed events for (sorted, without duplicates)
+		std::vector<float> thresholds() const {
+			std::vector<float> out;
+			for(auto& subscription: *subscribers.read_lock())
+				if(subscription->filter.wants(Type::Confirmed))
+					out.insert(out.end(), subscription->filter.thresholds.begin(), subscription->filter.thresholds.end());
+			std::sort(out.begin(), out.end());
+			out.erase(std::unique(out.begin(), out.end()), out.end());
+			return out;
+		}
+
+		/**
+		 * @brief Function which hands an event to every subscriber whose filter matches it
+		 *
+		 * @param event - The event (its id is assigned here)
+		 */
+		void publish(Event event) {
+			event.id = nextEvent++;
+			for(auto& subscription: *subscribers.read_lock())
+				if(subscription->filter.matches(event))
+					subscription->push(event);
+		}
+
+	protected:
+		// The subscribers
+		monitor<std::vector<std::shared_ptr<Subscription>>, monitor_policy::RCU> subscribers;
+		// The identifiers given to the next subscription and event
+		std::atomic<uint64_t> nextSubscription = 1, nextEvent = 1;
+	};
+}
+
+#endif /* end of include guard: EVENTS_HPP */
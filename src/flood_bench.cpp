@@ -0,0 +1,168 @@
+/**
+ * @file flood_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark showing how a single peer flooding transactions degrades ingest for every honest peer, with and without admission control (see admission.hpp)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <deque>
+#include <iostream>
+#include <random>
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "admission.hpp"
+
+// Number of transactions the network queue can hold (mirrors NETWORK_QUEUE_SIZE in networking.hpp)
+constexpr size_t NETWORK_QUEUE_SIZE = 1024;
+
+/**
+ * @brief Parameters of the simulated network and of the (single, like the network's listener thread) thread processing transactions
+ */
+struct Network {
+	// Number of honest peers and the rate (transactions per second) each sends at
+	size_t honestPeers;
+	double honestRate;
+	// The rate the flooding peer sends at (0 = no flooder)
+	double floodRate;
+	// How long to simulate (seconds)
+	double duration;
+	// Time (seconds) it takes to check a peer's token bucket, to decompress and hash a transaction, and to verify and add a transaction
+	double bucketCost, unpackCost, addCost;
+};
+
+/**
+ * @brief Counters describing what happened to the honest and flooding peers' transactions
+ */
+struct Result {
+	size_t honestSent = 0, honestAdded = 0, honestLimited = 0, honestDropped = 0;
+	size_t floodSent = 0, floodAdded = 0, floodLimited = 0, floodDropped = 0;
+	size_t slowDowns = 0;
+	// Honest transactions' latency (milliseconds from arriving to being added)
+	std::vector<double> latencies;
+};
+
+/**
+ * @brief Function which simulates a node receiving transactions from the honest peers and the flooder
+ * @note Transactions arrive as independent Poisson streams, every step of processing them runs on one thread (arrivals are only looked at once the thread is free)
+ *
+ * @param net - The network to simulate
+ * @param admission - Whether admission control is enabled
+ * @param seed - Seed for the random arrivals
+ * @return Result - What happened to the transactions
+ */
+Result simulate(const Network& net, bool admission, unsigned seed) {
+	std::mt19937 rng(seed);
+	boost::uuids::random_generator generate;
+
+	// The peers (the flooder is last)
+	struct Peer { AdmissionControl::PeerID id; double rate; bool flooder; };
+	std::vector<Peer> peers;
+	for(size_t i = 0; i < net.honestPeers; i++)
+		peers.push_back({generate(), net.honestRate, false});
+	if(net.floodRate > 0) peers.push_back({generate(), net.floodRate, true});
+
+	// Generate every arrival (time, peer) and sort them by time
+	std::vector<std::pair<double, size_t>> arrivals;
+	for(size_t p = 0; p < peers.size(); p++){
+		std::exponential_distribution<double> gap(peers[p].rate);
+		for(double time = gap(rng); time < net.duration; time += gap(rng))
+			arrivals.emplace_back(time, p);
+	}
+	std::sort(arrivals.begin(), arrivals.end());
+
+	AdmissionControl control;
+	auto start = AdmissionControl::Clock::now();
+	auto at = [start](double time) { return start + std::chrono::duration_cast<AdmissionControl::Clock::duration>(std::chrono::duration<double>(time)); };
+
+	Result result;
+	std::deque<std::pair<double, size_t>> queue;
+	double free = 0; // When the thread finishes what it is currently doing
+
+	// Function which adds the transactions waiting in the queue, until the thread would start on one after <until>
+	auto drain = [&](double until) {
+		while(!queue.empty() && free <= until){
+			auto [arrived, p] = queue.front();
+			queue.pop_front();
+			free = std::max(free, arrived) + net.addCost;
+			if(admission) control.dequeue(peers[p].id);
+			if(peers[p].flooder) result.floodAdded++;
+			else {
+				result.honestAdded++;
+				result.latencies.push_back((free - arrived) * 1000);
+			}
+		}
+	};
+
+	for(auto [time, p]: arrivals){
+		drain(time);
+		auto& peer = peers[p];
+		(peer.flooder ? result.floodSent : result.honestSent)++;
+
+		// Without admission control every transaction is decompressed and hashed as it is received
+		free = std::max(free, time);
+		if(!admission)
+			free += net.unpackCost;
+		// With admission control the sender's bucket is checked first, and only admitted transactions are decompressed and hashed
+		else {
+			free += net.bucketCost;
+			auto verdict = control.admit(peer.id, AdmissionControl::Class::Transaction, at(time));
+			result.slowDowns += verdict.slowDown;
+			if(!verdict.admitted){
+				(peer.flooder ? result.floodLimited : result.honestLimited)++;
+				continue;
+			}
+			free += net.unpackCost;
+			if(!control.enqueue(peer.id)){
+				(peer.flooder ? result.floodDropped : result.honestDropped)++;
+				continue;
+			}
+		}
+
+		// Transactions which don't fit in the network queue are dropped
+		if(queue.size() >= NETWORK_QUEUE_SIZE){
+			if(admission) control.dequeue(peer.id);
+			(peer.flooder ? result.floodDropped : result.honestDropped)++;
+			continue;
+		}
+		queue.emplace_back(time, p);
+	}
+	drain(std::numeric_limits<double>::infinity());
+	return result;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<flood tps> = 20000] [<seconds> = 10]" << std::endl;
+		return 1;
+	}
+
+	double floodRate = argc > 1 ? std::stod(argv[1]) : 20000;
+	double duration = argc > 2 ? std::stod(argv[2]) : 10;
+	// 10 honest peers sending 20 tps each, decompressing and hashing takes 20us, verifying and adding takes 500us (so the node can add about 2000 tps)
+	Network base{10, 20, 0, duration, 1e-6, 20e-6, 500e-6};
+
+	std::cout << base.honestPeers << " honest peers at " << base.honestRate << " tps each for " << duration << "s (node adds at most " << 1 / base.addCost << " tps)" << std::endl;
+	for(double flood: {0.0, floodRate}){
+		Network net = base;
+		net.floodRate = flood;
+		for(bool admission: {false, true}){
+			auto result = simulate(net, admission, 0);
+			std::sort(result.latencies.begin(), result.latencies.end());
+			auto percentile = [&](double p) { return result.latencies.empty() ? 0 : result.latencies[std::min(result.latencies.size() - 1, size_t(p * result.latencies.size()))]; };
+
+			std::cout << (flood > 0 ? "flooder at " + std::to_string(size_t(flood)) + " tps" : std::string("no flooder")) << (admission ? ", admission control: " : ", no admission control: ")
+				<< "honest added " << result.honestAdded << "/" << result.honestSent << " (" << 100.0 * result.honestAdded / std::max<size_t>(result.honestSent, 1) << "%, "
+				<< result.honestLimited << " limited, " << result.honestDropped << " dropped, latency p50 " << percentile(.5) << "ms p99 " << percentile(.99) << "ms)";
+			if(flood > 0)
+				std::cout << "; flooder added " << result.floodAdded << "/" << result.floodSent << " (" << result.floodLimited << " limited, " << result.floodDropped << " dropped, " << result.slowDowns << " slow downs sent)";
+			std::cout << std::endl;
+		}
+	}
+}
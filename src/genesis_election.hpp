@@ -0,0 +1,195 @@
+/**
+ * @file genesis_election.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides the vote tally used by joining nodes to agree on a genesis with a random sample of the network
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef GENESIS_ELECTION_HPP
+#define GENESIS_ELECTION_HPP
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+
+// Number of peers a joining node asks to vote on the genesis
+#define GENESIS_VOTE_SAMPLE_SIZE 16
+// Number of threads verifying the signatures on votes
+#define GENESIS_VOTE_VERIFIERS 4
+// How long (in milliseconds) a joining node waits for votes before settling with the votes it has
+#define GENESIS_VOTE_DEADLINE 3000
+// Maximum number of (agreeing) peers the tangle is downloaded from in parallel once the election is decided
+#define GENESIS_SYNC_SOURCES 4
+
+/**
+ * @brief Election which decides what genesis a joining node should sync, based on the votes of a random sample of its peers
+ * @note Votes are verified in parallel (on a small thread pool) and only count once verified
+ * @note A genesis wins as soon as a majority of the sample has voted for it, otherwise the plurality wins once every sampled peer has voted (or the election is closed)
+ */
+class GenesisElection {
+public:
+	using PeerID = boost::uuids::uuid;
+	// The hashes a genesis represents (the genesis' own hash last)
+	using Ballot = std::vector<std::string>;
+
+	/**
+	 * @brief The outcome of an election
+	 */
+	struct Result {
+		// The winning genesis
+		Ballot ballot;
+		// The (verified) peers which voted for it, in the order their votes were verified
+		std::vector<PeerID> voters;
+	};
+	// Function called (once) with the outcome of the election
+	using Callback = std::function<void(const Result&)>;
+
+	/**
+	 * @brief Counters describing the election
+	 */
+	struct Stats {
+		size_t sampled, received, verified, rejected;
+	};
+
+	/**
+	 * @brief Creates an election among the given <sample> of peers
+	 *
+	 * @param sample - The peers allowed to vote
+	 * @param onDecided - Function called with the outcome (on one of the verifying threads, or the thread which closes the election)
+	 * @param verifiers - The number of threads verifying votes
+	 */
+	GenesisElection(std::vector<PeerID> sample, Callback onDecided, size_t verifiers = GENESIS_VOTE_VERIFIERS)
+		: sample(sample.begin(), sample.end()), onDecided(std::move(onDecided)), pool(std::max<size_t>(verifiers, 1)) {}
+	~GenesisElection() { pool.join(); }
+
+	/**
+	 * @brief Function which picks a random sample of peers
+	 *
+	 * @param peers - The peers to choose from (a map from peer ID to anything, or a list of IDs)
+	 * @param size - The maximum number of peers to choose
+	 * @return std::vector<PeerID> - The chosen peers
+	 */
+	template<typename Peers>
+	static std::vector<PeerID> choose(const Peers& peers, size_t size = GENESIS_VOTE_SAMPLE_SIZE) {
+		std::vector<PeerID> ids;
+		for(auto& peer: peers)
+			if constexpr (std::is_same_v<std::decay_t<decltype(peer)>, PeerID>) ids.push_back(peer);
+			else ids.push_back(peer.first);
+
+		std::vector<PeerID> out;
+		std::sample(ids.begin(), ids.end(), std::back_inserter(out), size, std::mt19937(std::random_device{}()));
+		return out;
+	}
+
+	// Function which checks if a peer was sampled (is allowed to vote)
+	bool sampled(const PeerID& peer) const { return sample.contains(peer); }
+
+	// Function which checks if the election has been decided
+	bool decided() const {
+		std::scoped_lock lock(mutex);
+		return done;
+	}
+
+	/**
+	 * @brief Function which verifies (in the background) and then counts a vote
+	 * @note Votes from peers which weren't sampled, or which already voted, are ignored
+	 *
+	 * @param voter - The peer voting
+	 * @param ballot - The genesis they voted for
+	 * @param verify - Function which verifies the vote's signature (run on a verifying thread)
+	 */
+	void submit(const PeerID& voter, Ballot ballot, std::function<bool()> verify) {
+		{
+			std::scoped_lock lock(mutex);
+			if(done || !sample.contains(voter) || !voted.insert(voter).second) return;
+			received++;
+		}
+
+		boost::asio::post(pool, [this, voter, ballot = std::move(ballot), verify = std::move(verify)]() mutable {
+			bool valid = verify();
+
+			std::unique_lock lock(mutex);
+			if(done) return;
+			if(!valid) rejected++;
+			else {
+				verified++;
+				auto& voters = tally[ballot];
+				voters.push_back(voter);
+
+				// A majority of the sample agrees... no need to wait for the rest
+				if(voters.size() > sample.size() / 2)
+					return decide(lock, {std::move(ballot), voters});
+			}
+
+			// Everyone has voted... go with the plurality
+			if(verified + rejected == sample.size())
+				decidePlurality(lock);
+		});
+	}
+
+	/**
+	 * @brief Function which stops waiting for votes, deciding with the (verified) votes received so far
+	 * @note Votes still being verified are discarded, if there are no verified votes the election is abandoned without calling back
+	 */
+	void close() {
+		std::unique_lock lock(mutex);
+		if(!done) decidePlurality(lock);
+	}
+
+	// Function which gets a snapshot of the election's counters
+	Stats stats() const {
+		std::scoped_lock lock(mutex);
+		return { sample.size(), received, verified, rejected };
+	}
+
+protected:
+	// The peers allowed to vote
+	const std::unordered_set<PeerID, boost::hash<PeerID>> sample;
+	// Function called with the outcome
+	const Callback onDecided;
+
+	// Mutex protecting the tally
+	mutable std::mutex mutex;
+	// The peers which have voted (whether or not their vote has been verified yet)
+	std::unordered_set<PeerID, boost::hash<PeerID>> voted;
+	// The verified voters for each ballot
+	std::map<Ballot, std::vector<PeerID>> tally;
+	// Counters
+	size_t received = 0, verified = 0, rejected = 0;
+	// Whether or not the election has been decided
+	bool done = false;
+
+	// Thread pool verifying votes
+	boost::asio::thread_pool pool;
+
+	// Function which marks the election as decided and reports the <result> (the callback is made without holding the lock)
+	void decide(std::unique_lock<std::mutex>& lock, Result result) {
+		done = true;
+		lock.unlock();
+		onDecided(result);
+	}
+
+	// Function which decides in favor of the ballot with the most verified votes (ties go to the smallest ballot, since the tally is ordered and max_element keeps the first maximum)
+	void decidePlurality(std::unique_lock<std::mutex>& lock) {
+		done = true;
+		if(tally.empty()) return;
+
+		auto best = std::max_element(tally.begin(), tally.end(), [](const auto& a, const auto& b) { return a.second.size() < b.second.size(); });
+		decide(lock, {best->first, best->second});
+	}
+};
+
+#endif /* end of include guard: GENESIS_ELECTION_HPP */
@@ -0,0 +1,96 @@
+/**
+ * @file handshake_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Multi-node startup benchmark, measures how long joining peers take to discover a network's port (see handshake::probeRemotePort)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "networking.hpp"
+
+/**
+ * @brief Function which discovers a port the way handshakes used to: trying one port at a time, waiting up to 500ms for each to answer
+ * @note Kept as a baseline to compare the parallel probe against
+ *
+ * @param address - IP Address to probe
+ * @param start - The first port to probe
+ * @param range - How many ports to probe
+ * @return std::optional<unsigned short> - The network port the remote reported, or nothing if no handshake was received
+ */
+std::optional<unsigned short> sequentialProbe(const boost::asio::ip::address& address, unsigned short start, unsigned short range) {
+	for(unsigned short port = start; port < start + range; port++){
+		// Each port gets its own 500ms deadline
+		auto result = handshake::probeRemotePort(address, port, 1, std::chrono::milliseconds(500));
+		if(result) return result;
+	}
+	return {};
+}
+
+/**
+ * @brief Function which runs a set of joiners concurrently and prints how long they took to discover the network
+ *
+ * @param name - The name of the strategy (printed)
+ * @param joiners - The number of concurrent joiners
+ * @param discover - The function each joiner uses to discover the network
+ */
+template<typename F>
+void measure(const std::string& name, size_t joiners, F discover) {
+	std::vector<double> times(joiners);
+	std::atomic<size_t> failures = 0;
+
+	std::vector<std::thread> threads;
+	for(size_t j = 0; j < joiners; j++)
+		threads.emplace_back([&, j](){
+			auto start = std::chrono::steady_clock::now();
+			if(!discover()) failures++;
+			times[j] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		});
+	for(auto& thread: threads)
+		thread.join();
+
+	std::sort(times.begin(), times.end());
+	double mean = 0;
+	for(double time: times) mean += time / times.size();
+	std::cout << name << ": " << joiners << " joiners (" << failures << " failed), join time (ms): mean " << mean
+		<< ", p50 " << times[times.size() / 2] << ", max " << times.back() << std::endl;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 4){
+		std::cout << "Usage: " << argv[0] << " [<nodes> = 8] [<joiners> = 32] [<unresponsive ports> = 2]" << std::endl;
+		return 1;
+	}
+
+	size_t nodes = argc > 1 ? std::stoul(argv[1]) : 8;
+	size_t joiners = argc > 2 ? std::stoul(argv[2]) : 32;
+	size_t unresponsive = argc > 3 ? std::stoul(argv[3]) : 2;
+
+	boost::asio::io_context io;
+	auto address = boost::asio::ip::address_v4::loopback();
+	unsigned short start = determineLocalPort(DEFAULT_PORT_NUMBER + 1000);
+
+	// Ports at the start of the range which accept connections but never answer (like a network port or a stalled node)
+	std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> silent;
+	unsigned short port = start;
+	for(size_t i = 0; i < unresponsive; i++, port++){
+		port = determineLocalPort(port);
+		silent.push_back(std::make_unique<boost::asio::ip::tcp::acceptor>(io, boost::asio::ip::tcp::endpoint(address, port)));
+	}
+
+	// Start each node's handshake server (with a made up network port)
+	std::vector<std::unique_ptr<handshake::Server>> servers;
+	for(size_t i = 0; i < nodes; i++, port++){
+		port = determineLocalPort(port);
+		servers.push_back(std::make_unique<handshake::Server>(port, port + 1));
+	}
+	unsigned short range = port - start;
+	std::cout << "Started " << nodes << " nodes behind " << unresponsive << " unresponsive ports (" << start << "-" << (port - 1) << ")" << std::endl;
+
+	measure("Sequential", joiners, [&]{ return sequentialProbe(address, start, range).has_value(); });
+	measure("Parallel", joiners, [&]{ return handshake::probeRemotePort(address, start, range).has_value(); });
+}
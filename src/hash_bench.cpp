@@ -0,0 +1,119 @@
+/**
+ * @file hash_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Hashing throughput benchmark, comparing the CryptoPP pipeline against the multi-buffer SHA3-256 kernel (see kernels.hpp) on every supported instruction set
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "kernels.hpp"
+#include "utility.hpp"
+
+/**
+ * @brief Function which hashes a message using the CryptoPP pipeline (how util::hash was calculated before the kernels)
+ *
+ * @param in - The message to hash
+ * @return std::string - The base 64 encoded SHA3-256 digest of the message
+ */
+std::string cryptoppHash(const std::string& in) {
+	std::string digest;
+	CryptoPP::SHA3_256 hash;
+	CryptoPP::StringSource(in, true, new CryptoPP::HashFilter(hash, new CryptoPP::Base64Encoder(new CryptoPP::StringSink(digest))));
+	digest = util::replace(digest, "\n", "");
+	return digest;
+}
+
+/**
+ * @brief Function which runs <f> until at least <seconds> have passed and prints the throughput
+ *
+ * @param name - The name of the operation (printed)
+ * @param seconds - How long to run for
+ * @param f - The operation to run, returns the number of hashes it calculated
+ */
+template<typename F>
+void measure(const std::string& name, double seconds, F f) {
+	size_t hashes = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0;
+	while(elapsed < seconds){
+		hashes += f();
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::cout << name << ": " << (hashes / elapsed) << " hashes/s" << std::endl;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<message bytes> = 300] [<seconds per measurement> = 1]" << std::endl;
+		return 1;
+	}
+
+	size_t size = argc > 1 ? std::stoul(argv[1]) : 300; // About the size of a transaction's hashing message (one input, one output, two parents)
+	double seconds = argc > 2 ? std::stod(argv[2]) : 1;
+
+	// Random messages of the requested size (like mining, which hashes messages differing only in their nonce)
+	std::mt19937 rng(0);
+	std::vector<std::string> messages(64, std::string(size, '\0'));
+	for(auto& message: messages)
+		for(auto& c: message)
+			c = char(rng());
+	std::vector<std::string_view> views(messages.begin(), messages.end());
+	std::vector<kernels::Digest> digests(messages.size());
+
+	// Every instruction set must produce byte-identical digests to CryptoPP (messages of every length around the block boundaries)
+	std::vector<std::string> checks;
+	for(size_t length = 0; length <= 3 * 136 + 1; length++){
+		checks.emplace_back(length, '\0');
+		for(auto& c: checks.back())
+			c = char(rng());
+	}
+	std::vector<std::string> expected;
+	for(auto& check: checks)
+		expected.push_back(cryptoppHash(check));
+
+	std::cout << size << " byte messages" << std::endl;
+	measure("CryptoPP pipeline", seconds, [&]{
+		for(auto& message: messages)
+			if(cryptoppHash(message).empty()) return size_t(0);
+		return messages.size();
+	});
+
+	bool identical = true;
+	for(kernels::ISA isa: {kernels::ISA::Scalar, kernels::ISA::SSE2, kernels::ISA::AVX2, kernels::ISA::AVX512}){
+		if(kernels::setActive(isa) != isa) continue;
+
+		std::vector<std::string_view> checkViews(checks.begin(), checks.end());
+		std::vector<kernels::Digest> checkDigests(checks.size());
+		kernels::sha3_256(checkViews.data(), checkDigests.data(), checkViews.size());
+		for(size_t i = 0; i < checks.size(); i++)
+			if(util::base64Encode(checkDigests[i].data(), checkDigests[i].size()) != expected[i]){
+				std::cout << kernels::name(isa) << " digest of a " << checks[i].size() << " byte message doesn't match CryptoPP!" << std::endl;
+				identical = false;
+				break;
+			}
+
+		std::string name = std::string(kernels::name(isa)) + " kernel (" + std::to_string(kernels::hashLanes()) + " lanes)";
+		measure(name + " one at a time", seconds, [&]{
+			for(auto& view: views)
+				digests[0] = kernels::sha3_256(view);
+			return views.size();
+		});
+		measure(name + " batched", seconds, [&]{
+			kernels::sha3_256(views.data(), digests.data(), views.size());
+			return views.size();
+		});
+	}
+	kernels::setActive(kernels::detected());
+
+	std::cout << (identical ? "Every instruction set matches CryptoPP" : "MISMATCH") << std::endl;
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file ingest_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark measuring how long adding transactions takes (p50/p99) while readers walk large snapshots of the tangle, and checking that the balance table
+ * 	(see Tangle::balances) matches balances walked from the snapshots as nodes are added and removed
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "bench.hpp"
+
+// Function which gets the given <percentile> (0-1) of a list of latencies
+double percentile(std::vector<double> latencies, double percentile) {
+	if(latencies.empty()) return 0;
+	std::sort(latencies.begin(), latencies.end());
+	return latencies[std::min<size_t>(latencies.size() * percentile, latencies.size() - 1)];
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 4){
+		std::cout << "Usage: " << argv[0] << " [<initial transactions> = 1000] [<measured transactions> = 200] [<readers> = 2]" << std::endl;
+		return 1;
+	}
+
+	size_t initial = argc > 1 ? std::stoul(argv[1]) : 1000;
+	size_t measured = argc > 2 ? std::stoul(argv[2]) : 200;
+	size_t readers = argc > 3 ? std::stoul(argv[3]) : 2;
+
+	std::vector<key::KeyPair> accounts;
+	for(size_t i = 0; i < 8; i++) accounts.push_back(key::generateKeyPair());
+	std::vector<Transaction::Output> grants;
+	for(auto& pair: accounts) grants.push_back({pair.pub, Amount(1'000'000)});
+
+	BenchTangle t;
+	t.setGenesis(TransactionNode::create({}, {}, grants));
+
+	// Function which creates (and mines) the <i>th transaction, moving money around the accounts
+	auto next = [&](size_t i) {
+		auto& from = accounts[i % accounts.size()];
+		std::vector<Transaction::Output> outputs = {{accounts[(i * 3 + 1) % accounts.size()].pub, Amount(1)}};
+		std::vector<Transaction::Input> inputs = {{from, 1, t.reserveSequence(from), outputs}};
+		return TransactionNode::createAndMine(t, inputs, outputs, 1);
+	};
+
+	// Function which checks that the balance table matches balances walked from the latest snapshot
+	auto balancesMatch = [&]() {
+		auto snapshot = t.snapshot();
+		for(auto& pair: accounts)
+			if(t.queryBalance(pair) != t.queryBalance(*snapshot, account::intern(pair.pub)))
+				return false;
+		return true;
+	};
+
+	size_t i = 0;
+	for(; i < initial; i++)
+		t.add(next(i));
+	check(balancesMatch(), "the balance table matches the snapshot after adding transactions");
+
+	// Function which adds the next <measured> transactions, timing only the add (not the mining)
+	auto ingest = [&]() {
+		std::vector<double> latencies;
+		for(size_t end = i + measured; i < end; i++){
+			auto node = next(i);
+			auto start = std::chrono::steady_clock::now();
+			t.add(node);
+			latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3);
+		}
+		return latencies;
+	};
+
+	// -- Ingest With and Without Large Reads --
+
+	auto alone = ingest();
+
+	// Readers repeatedly list every transaction and walk every account's balance from a snapshot (like saves, sync transfers, and RPC queries)
+	std::atomic<bool> reading = true;
+	std::atomic<size_t> reads = 0;
+	std::vector<std::thread> threads;
+	for(size_t r = 0; r < readers; r++)
+		threads.emplace_back([&, r]() {
+			while(reading){
+				auto snapshot = t.snapshot();
+				if(snapshot->transactions().size() != snapshot->size) reading = false;
+				t.queryBalance(*snapshot, account::intern(accounts[r % accounts.size()].pub));
+				reads++;
+			}
+		});
+	auto during = ingest();
+	reading = false;
+	for(auto& thread: threads) thread.join();
+
+	std::cout << t.snapshot()->size << " transactions, " << readers << " readers (" << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+	std::cout << "Add latency alone: p50 " << percentile(alone, .5) << "ms, p99 " << percentile(alone, .99) << "ms" << std::endl;
+	std::cout << "Add latency during " << reads << " full reads: p50 " << percentile(during, .5) << "ms, p99 " << percentile(during, .99) << "ms" << std::endl;
+
+	// -- Removal --
+
+	// Remove the tips one by one (timing the removal), the table must still match the snapshot
+	std::vector<double> removals;
+	for(size_t r = 0; r < 16 && !t.tips.read_lock()->empty(); r++){
+		auto tip = t.tips.read_lock()[0];
+		if(tip == t.genesis) break;
+		auto start = std::chrono::steady_clock::now();
+		t.removeTip(tip);
+		removals.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3);
+	}
+	std::cout << "Tip removal: p50 " << percentile(removals, .5) << "ms, p99 " << percentile(removals, .99) << "ms" << std::endl;
+	check(t.snapshot()->transactions().size() == t.snapshot()->size && t.snapshot()->size == initial + 2 * measured + 1 - removals.size(), "removing tips publishes a snapshot without them");
+	check(balancesMatch(), "the balance table matches the snapshot after removing tips");
+
+	return finish();
+}
@@ -0,0 +1,155 @@
+/**
+ * @file join_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark of the time it takes to join a simulated network, comparing the original protocol (everyone votes, one sync source) against the sampled election (see genesis_election.hpp) with parallel syncing
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <thread>
+
+#include <boost/uuid/random_generator.hpp>
+
+#include "genesis_election.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Parameters of a join protocol
+ */
+struct Protocol {
+	const char* name;
+	// Number of peers asked to vote (0 = every peer)
+	size_t sample;
+	// Number of threads verifying votes
+	size_t verifiers;
+	// Number of peers the tangle is downloaded from
+	size_t sources;
+};
+
+/**
+ * @brief Parameters of the simulated network
+ */
+struct Network {
+	// Number of peers
+	size_t peers;
+	// Fraction of the peers voting for a different genesis
+	double dissent;
+	// Mean one way latency (the actual latency of each peer is exponentially distributed around this)
+	std::chrono::microseconds latency;
+	// Time it takes to verify the signature on a vote
+	std::chrono::microseconds verifyCost;
+	// Number of transactions in the tangle, and the time it takes a peer to sign and send one
+	size_t transactions;
+	std::chrono::microseconds sendCost;
+};
+
+// Function which busy waits for <duration> (simulates the CPU cost of verifying a signature)
+void spin(std::chrono::microseconds duration) {
+	auto end = Clock::now() + duration;
+	while(Clock::now() < end);
+}
+
+/**
+ * @brief Function which simulates a node joining <net> using <protocol>
+ * @note Votes are delivered one at a time on a single thread (like the network's listener thread), at the time each peer's response would arrive
+ *
+ * @param protocol - The join protocol to simulate
+ * @param net - The network to simulate
+ * @param seed - Seed for the random latencies and votes
+ * @return std::pair<double, bool> - The time (in milliseconds) until the tangle is downloaded, and whether the honest genesis won
+ */
+std::pair<double, bool> simulate(const Protocol& protocol, const Network& net, unsigned seed) {
+	std::mt19937 rng(seed);
+	boost::uuids::random_generator generate;
+	std::exponential_distribution<double> latency(1.0 / net.latency.count());
+	std::bernoulli_distribution dissents(net.dissent);
+
+	const GenesisElection::Ballot honest = {"genesis"}, dissent = {"fork"};
+	struct Peer { GenesisElection::PeerID id; const GenesisElection::Ballot* ballot; std::chrono::microseconds rtt; };
+	std::vector<Peer> peers;
+	for(size_t i = 0; i < net.peers; i++)
+		peers.push_back({generate(), dissents(rng) ? &dissent : &honest, std::chrono::microseconds(int64_t(latency(rng) + latency(rng)))});
+
+	std::vector<GenesisElection::PeerID> ids;
+	for(auto& peer: peers) ids.push_back(peer.id);
+	auto sample = GenesisElection::choose(ids, protocol.sample ? protocol.sample : ids.size());
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::optional<GenesisElection::Result> result;
+	auto start = Clock::now();
+	Clock::time_point decidedAt;
+
+	{
+		GenesisElection election(sample, [&](const GenesisElection::Result& r) {
+			std::scoped_lock lock(mutex);
+			result = r;
+			decidedAt = Clock::now();
+			cv.notify_all();
+		}, protocol.verifiers);
+
+		// Deliver the votes of the sampled peers in the order they arrive
+		std::vector<const Peer*> voters;
+		for(auto& peer: peers)
+			if(election.sampled(peer.id)) voters.push_back(&peer);
+		std::sort(voters.begin(), voters.end(), [](auto a, auto b) { return a->rtt < b->rtt; });
+		for(auto voter: voters) {
+			if(election.decided()) break;
+			std::this_thread::sleep_until(start + voter->rtt);
+			election.submit(voter->id, *voter->ballot, [&net] { spin(net.verifyCost); return true; });
+		}
+
+		std::unique_lock lock(mutex);
+		cv.wait(lock, [&] { return result.has_value(); });
+	}
+
+	// The download is split evenly between the sources, which send in parallel (modeled rather than slept)
+	size_t sources = std::min(protocol.sources, result->voters.size());
+	auto download = net.sendCost * ((net.transactions + sources - 1) / sources) + net.latency * 2;
+	double elapsed = std::chrono::duration<double, std::milli>(decidedAt - start + download).count();
+	return {elapsed, result->ballot == honest};
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<transactions> = 20000] [<trials> = 5]" << std::endl;
+		return 1;
+	}
+
+	size_t transactions = argc > 1 ? std::stoul(argv[1]) : 20000;
+	size_t trials = argc > 2 ? std::stoul(argv[2]) : 5;
+
+	const Protocol protocols[] = {
+		{"broadcast", 0, 1, 1},
+		{"sampled", GENESIS_VOTE_SAMPLE_SIZE, GENESIS_VOTE_VERIFIERS, GENESIS_SYNC_SOURCES},
+	};
+
+	std::cout << transactions << " transactions, " << trials << " trials (mean join time in ms, honest genesis wins / trials)" << std::endl;
+	for(size_t peers: {5, 50, 500}){
+		Network net{peers, 0.2, std::chrono::microseconds(2000), std::chrono::microseconds(300), transactions, std::chrono::microseconds(20)};
+
+		std::cout << peers << " peers:";
+		for(auto& protocol: protocols){
+			double total = 0;
+			size_t honest = 0;
+			for(size_t trial = 0; trial < trials; trial++){
+				auto [elapsed, correct] = simulate(protocol, net, trial);
+				total += elapsed;
+				honest += correct;
+			}
+			std::cout << " " << protocol.name << " " << total / trials << " (" << honest << "/" << trials << ")";
+		}
+		std::cout << std::endl;
+	}
+}
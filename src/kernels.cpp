@@ -0,0 +1,933 @@
+/**
+ * @file kernels.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Code backing kernels.hpp, contains a scalar, SSE2, AVX2, and AVX-512 version of each kernel
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define KERNELS_X86
+	#include <immintrin.h>
+#endif
+
+namespace kernels {
+
+	namespace {
+		/**
+		 * @brief Result of a wrapping (unchecked) vector sum, paired with the bitwise or of the magnitude of every value summed
+		 * @note The magnitudes let us prove that the wrapping sum never overflowed without checking every addition
+		 */
+		struct WrappingSum {
+			uint64_t sum = 0;
+			uint64_t magnitudes = 0;
+
+			// Adds a single value to the sum
+			inline void add(int64_t value) {
+				sum += uint64_t(value);
+				magnitudes |= uint64_t(value < 0 ? ~value : value);
+			}
+		};
+
+		/**
+		 * @brief Function which converts a wrapping sum of <n> values into an amount
+		 *
+		 * @param s - The wrapping sum
+		 * @param n - How many values went into the sum
+		 * @return std::optional<Amount> - The sum, or nothing if the sum might have overflowed (and needs to be recalculated with checks)
+		 */
+		std::optional<Amount> toAmount(WrappingSum s, size_t n) {
+			// Every value is smaller than 2^valueBits, and there are less than 2^countBits values... so the sum (and every partial sum) is smaller than 2^(valueBits + countBits)
+			int valueBits = 64 - std::countl_zero(s.magnitudes);
+			int countBits = 64 - std::countl_zero(uint64_t(n));
+			if(valueBits + countBits > 63) return {};
+			return Amount::fromRaw(int64_t(s.sum));
+		}
+
+		/**
+		 * @brief Function which converts a wrapping sum of <n> gathered weights into a weight
+		 *
+		 * @param s - The wrapping sum (its magnitudes are the bitwise or of every weight)
+		 * @param n - How many weights went into the sum
+		 * @return std::optional<uint64_t> - The sum, or nothing if the sum might have overflowed (and needs to be recalculated with saturation)
+		 */
+		std::optional<uint64_t> toWeight(WrappingSum s, size_t n) {
+			int valueBits = 64 - std::countl_zero(s.magnitudes);
+			int countBits = 64 - std::countl_zero(uint64_t(n));
+			if(valueBits + countBits > 64) return {};
+			return s.sum;
+		}
+
+
+		// -- Scalar --
+
+
+		// Sum with an overflow check on every addition, every other instruction set falls back to this if its sum might have overflowed
+		template<bool Filter>
+		Amount sumChecked(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account) {
+			Amount out = 0;
+			for(size_t i = 0; i < n; i++)
+				if(!Filter || accounts[i] == account)
+					out += Amount::fromRaw(amounts[i]);
+			return out;
+		}
+
+		// Finishes a wrapping sum starting at index <i>
+		template<bool Filter>
+		WrappingSum sumTail(WrappingSum s, const uint32_t* accounts, const Amount::Raw* amounts, size_t i, size_t n, uint32_t account) {
+			for(; i < n; i++)
+				if(!Filter || accounts[i] == account)
+					s.add(amounts[i]);
+			return s;
+		}
+
+		// Gathered sum which saturates at the largest weight, every instruction set falls back to this if its sum might have overflowed
+		uint64_t gatherSaturating(const uint64_t* const* values, size_t n) {
+			uint64_t out = 0;
+			for(size_t i = 0; i < n; i++)
+				out = *values[i] > std::numeric_limits<uint64_t>::max() - out ? std::numeric_limits<uint64_t>::max() : out + *values[i];
+			return out;
+		}
+
+		// Finishes a wrapping gathered sum starting at index <i>
+		inline WrappingSum gatherTail(WrappingSum s, const uint64_t* const* values, size_t i, size_t n) {
+			for(; i < n; i++){
+				s.sum += *values[i];
+				s.magnitudes |= *values[i];
+			}
+			return s;
+		}
+
+		size_t findTail(const uint32_t* accounts, size_t i, size_t n, uint32_t account) {
+			for(; i < n; i++)
+				if(accounts[i] == account)
+					return i;
+			return n;
+		}
+
+
+#ifdef KERNELS_X86
+		// -- SSE2 --
+
+
+		// Adds a pair of values to an SSE2 sum (and the bitwise or of their magnitudes)
+		__attribute__((target("sse2"))) inline void addSSE2(__m128i& sum, __m128i& magnitudes, __m128i values) {
+			sum = _mm_add_epi64(sum, values);
+			// SSE2 has no 64 bit arithmetic shift, so broadcast the sign from the high half of each value instead
+			__m128i sign = _mm_shuffle_epi32(_mm_srai_epi32(values, 31), _MM_SHUFFLE(3, 3, 1, 1));
+			magnitudes = _mm_or_si128(magnitudes, _mm_xor_si128(values, sign));
+		}
+
+		template<bool Filter>
+		__attribute__((target("sse2"))) WrappingSum sumSSE2(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account) {
+			__m128i sum = _mm_setzero_si128(), magnitudes = _mm_setzero_si128(), target = _mm_set1_epi32(account);
+
+			size_t i = 0;
+			if constexpr (Filter) {
+				for(; i + 4 <= n; i += 4){
+					// Check four accounts at once, the amounts are only loaded if one of them matches (most of the time none do)
+					__m128i matches = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (accounts + i)), target);
+					if(!_mm_movemask_epi8(matches)) continue;
+					addSSE2(sum, magnitudes, _mm_and_si128(_mm_loadu_si128((const __m128i*) (amounts + i)), _mm_unpacklo_epi32(matches, matches)));
+					addSSE2(sum, magnitudes, _mm_and_si128(_mm_loadu_si128((const __m128i*) (amounts + i + 2)), _mm_unpackhi_epi32(matches, matches)));
+				}
+			} else
+				for(; i + 2 <= n; i += 2)
+					addSSE2(sum, magnitudes, _mm_loadu_si128((const __m128i*) (amounts + i)));
+
+			alignas(16) uint64_t sums[2], mags[2];
+			_mm_store_si128((__m128i*) sums, sum);
+			_mm_store_si128((__m128i*) mags, magnitudes);
+			return sumTail<Filter>({sums[0] + sums[1], mags[0] | mags[1]}, accounts, amounts, i, n, account);
+		}
+
+		__attribute__((target("sse2"))) WrappingSum gatherSumSSE2(const uint64_t* const* values, size_t n) {
+			__m128i sum = _mm_setzero_si128(), magnitudes = _mm_setzero_si128();
+
+			size_t i = 0;
+			for(; i + 2 <= n; i += 2){
+				// SSE2 has no gather, so the pair is assembled from scalar loads
+				__m128i pair = _mm_set_epi64x(*values[i + 1], *values[i]);
+				sum = _mm_add_epi64(sum, pair);
+				magnitudes = _mm_or_si128(magnitudes, pair);
+			}
+
+			alignas(16) uint64_t sums[2], mags[2];
+			_mm_store_si128((__m128i*) sums, sum);
+			_mm_store_si128((__m128i*) mags, magnitudes);
+			return gatherTail({sums[0] + sums[1], mags[0] | mags[1]}, values, i, n);
+		}
+
+		__attribute__((target("sse2"))) size_t findSSE2(const uint32_t* accounts, size_t n, uint32_t account) {
+			__m128i target = _mm_set1_epi32(account);
+
+			size_t i = 0;
+			for(; i + 4 <= n; i += 4)
+				if(int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (accounts + i)), target))); mask)
+					return i + std::countr_zero(unsigned(mask));
+			return findTail(accounts, i, n, account);
+		}
+
+
+		// -- AVX2 --
+
+
+		// Adds four values to an AVX2 sum (and the bitwise or of their magnitudes)
+		__attribute__((target("avx2"))) inline void addAVX2(__m256i& sum, __m256i& magnitudes, __m256i values) {
+			sum = _mm256_add_epi64(sum, values);
+			magnitudes = _mm256_or_si256(magnitudes, _mm256_xor_si256(values, _mm256_cmpgt_epi64(_mm256_setzero_si256(), values)));
+		}
+
+		template<bool Filter>
+		__attribute__((target("avx2"))) WrappingSum sumAVX2(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account) {
+			__m256i sum = _mm256_setzero_si256(), magnitudes = _mm256_setzero_si256(), target = _mm256_set1_epi32(account);
+
+			size_t i = 0;
+			if constexpr (Filter) {
+				for(; i + 8 <= n; i += 8){
+					// Check eight accounts at once, the amounts are only loaded if one of them matches (most of the time none do)
+					__m256i matches = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (accounts + i)), target);
+					if(_mm256_testz_si256(matches, matches)) continue;
+					// Widen the matches to 64 bits so they line up with the amounts, then zero out the values whose account doesn't match
+					__m256i low = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(matches)), high = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(matches, 1));
+					addAVX2(sum, magnitudes, _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (amounts + i)), low));
+					addAVX2(sum, magnitudes, _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (amounts + i + 4)), high));
+				}
+			} else
+				for(; i + 4 <= n; i += 4)
+					addAVX2(sum, magnitudes, _mm256_loadu_si256((const __m256i*) (amounts + i)));
+
+			alignas(32) uint64_t sums[4], mags[4];
+			_mm256_store_si256((__m256i*) sums, sum);
+			_mm256_store_si256((__m256i*) mags, magnitudes);
+			return sumTail<Filter>({(sums[0] + sums[1]) + (sums[2] + sums[3]), mags[0] | mags[1] | mags[2] | mags[3]}, accounts, amounts, i, n, account);
+		}
+
+		__attribute__((target("avx2"))) WrappingSum gatherSumAVX2(const uint64_t* const* values, size_t n) {
+			__m256i sum = _mm256_setzero_si256(), magnitudes = _mm256_setzero_si256();
+
+			size_t i = 0;
+			for(; i + 4 <= n; i += 4){
+				// The pointers are used as (64 bit) indices from a null base
+				__m256i gathered = _mm256_i64gather_epi64((const long long*) nullptr, _mm256_loadu_si256((const __m256i*) (values + i)), 1);
+				sum = _mm256_add_epi64(sum, gathered);
+				magnitudes = _mm256_or_si256(magnitudes, gathered);
+			}
+
+			alignas(32) uint64_t sums[4], mags[4];
+			_mm256_store_si256((__m256i*) sums, sum);
+			_mm256_store_si256((__m256i*) mags, magnitudes);
+			return gatherTail({(sums[0] + sums[1]) + (sums[2] + sums[3]), mags[0] | mags[1] | mags[2] | mags[3]}, values, i, n);
+		}
+
+		__attribute__((target("avx2"))) size_t findAVX2(const uint32_t* accounts, size_t n, uint32_t account) {
+			__m256i target = _mm256_set1_epi32(account);
+
+			size_t i = 0;
+			for(; i + 8 <= n; i += 8)
+				if(int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (accounts + i)), target))); mask)
+					return i + std::countr_zero(unsigned(mask));
+			return findTail(accounts, i, n, account);
+		}
+
+
+		// -- AVX-512 --
+
+
+		// Adds the eight values whose bit in <mask> is set to an AVX-512 sum (only those amounts are loaded)
+		__attribute__((target("avx512f"))) inline void addAVX512(__m512i& sum, __m512i& magnitudes, __mmask8 mask, const Amount::Raw* values) {
+			__m512i loaded = _mm512_maskz_loadu_epi64(mask, values);
+			sum = _mm512_add_epi64(sum, loaded);
+			magnitudes = _mm512_or_si512(magnitudes, _mm512_xor_si512(loaded, _mm512_srai_epi64(loaded, 63)));
+		}
+
+		template<bool Filter>
+		__attribute__((target("avx512f"))) WrappingSum sumAVX512(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account) {
+			__m512i sum = _mm512_setzero_si512(), magnitudes = _mm512_setzero_si512(), target = _mm512_set1_epi32(account);
+
+			size_t i = 0;
+			if constexpr (Filter) {
+				for(; i + 16 <= n; i += 16){
+					// Check sixteen accounts at once, and only load the amounts whose account matches (most of the time none do)
+					__mmask16 matches = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*) (accounts + i)), target);
+					if(!matches) continue;
+					if(matches & 0xFF) addAVX512(sum, magnitudes, __mmask8(matches), amounts + i);
+					if(matches >> 8) addAVX512(sum, magnitudes, __mmask8(matches >> 8), amounts + i + 8);
+				}
+			} else
+				for(; i + 8 <= n; i += 8)
+					addAVX512(sum, magnitudes, 0xFF, amounts + i);
+
+			return sumTail<Filter>({uint64_t(_mm512_reduce_add_epi64(sum)), uint64_t(_mm512_reduce_or_epi64(magnitudes))}, accounts, amounts, i, n, account);
+		}
+
+		__attribute__((target("avx512f"))) WrappingSum gatherSumAVX512(const uint64_t* const* values, size_t n) {
+			__m512i sum = _mm512_setzero_si512(), magnitudes = _mm512_setzero_si512();
+
+			size_t i = 0;
+			for(; i + 8 <= n; i += 8){
+				// The pointers are used as (64 bit) indices from a null base
+				__m512i gathered = _mm512_i64gather_epi64(_mm512_loadu_si512((const void*) (values + i)), nullptr, 1);
+				sum = _mm512_add_epi64(sum, gathered);
+				magnitudes = _mm512_or_si512(magnitudes, gathered);
+			}
+
+			return gatherTail({uint64_t(_mm512_reduce_add_epi64(sum)), uint64_t(_mm512_reduce_or_epi64(magnitudes))}, values, i, n);
+		}
+
+		__attribute__((target("avx512f"))) size_t findAVX512(const uint32_t* accounts, size_t n, uint32_t account) {
+			__m512i target = _mm512_set1_epi32(account);
+
+			size_t i = 0;
+			for(; i + 16 <= n; i += 16)
+				if(__mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*) (accounts + i)), target); mask)
+					return i + std::countr_zero(unsigned(mask));
+			return findTail(accounts, i, n, account);
+		}
+#endif // KERNELS_X86
+
+
+		// -- SHA3 (Keccak) --
+
+
+		// Number of bytes of message absorbed by each permutation (SHA3-256's rate)
+		constexpr size_t SHA3_RATE = 136;
+		// Constants mixed into the first lane by each round
+		constexpr uint64_t KECCAK_ROUND_CONSTANTS[24] = {
+			0x0000000000000001, 0x0000000000008082, 0x800000000000808A, 0x8000000080008000, 0x000000000000808B, 0x0000000080000001,
+			0x8000000080008081, 0x8000000000008009, 0x000000000000008A, 0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
+			0x000000008000808B, 0x800000000000008B, 0x8000000000008089, 0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+			0x000000000000800A, 0x800000008000000A, 0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008,
+		};
+		// The rotation applied to each lane as it is moved, and the order lanes are moved in (the rho and pi steps, starting from lane 1)
+		constexpr uint8_t KECCAK_ROTATIONS[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+		constexpr uint8_t KECCAK_LANES[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+		// The vectors of lanes each instruction set permutes (one lane from each message being hashed)
+		typedef uint64_t Lanes2 __attribute__((vector_size(16)));
+		typedef uint64_t Lanes4 __attribute__((vector_size(32)));
+		typedef uint64_t Lanes8 __attribute__((vector_size(64)));
+
+		// Functions which get and set a single message's lane in a vector of lanes (or a plain integer for the scalar version)
+		template<typename V>
+		inline uint64_t getLane(const V& v, size_t j) {
+			if constexpr (std::is_same_v<V, uint64_t>) return v;
+			else return v[j];
+		}
+		template<typename V>
+		inline void setLane(V& v, size_t j, uint64_t value) {
+			if constexpr (std::is_same_v<V, uint64_t>) v = value;
+			else v[j] = value;
+		}
+
+		/**
+		 * @brief Function which applies the Keccak-f[1600] permutation to a state (or to several states at once, one per element of <V>)
+		 * @note Written with generic vector operations and always inlined, so it is compiled for the instruction set of whichever kernel calls it
+		 *
+		 * @param state - The 25 lanes of the state
+		 */
+		template<typename V>
+		[[gnu::always_inline]] inline void keccakF1600(V* state) {
+			// Work on a local copy (fully unrolled, so the compiler can keep as much of it in registers as possible)
+			V a[25], c[5], d;
+			#pragma GCC unroll 25
+			for(size_t i = 0; i < 25; i++)
+				a[i] = state[i];
+
+			for(size_t round = 0; round < 24; round++){
+				// Theta: mix each column's parity into its neighbours
+				#pragma GCC unroll 5
+				for(size_t x = 0; x < 5; x++)
+					c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+				#pragma GCC unroll 5
+				for(size_t x = 0; x < 5; x++){
+					d = c[(x + 4) % 5] ^ (c[(x + 1) % 5] << 1) ^ (c[(x + 1) % 5] >> 63);
+					#pragma GCC unroll 5
+					for(size_t y = 0; y < 25; y += 5)
+						a[y + x] ^= d;
+				}
+
+				// Rho and pi: rotate each lane and move it to its new position
+				V carried = a[1];
+				#pragma GCC unroll 24
+				for(size_t i = 0; i < 24; i++){
+					V next = a[KECCAK_LANES[i]];
+					a[KECCAK_LANES[i]] = (carried << KECCAK_ROTATIONS[i]) | (carried >> (64 - KECCAK_ROTATIONS[i]));
+					carried = next;
+				}
+
+				// Chi: mix each row non-linearly
+				#pragma GCC unroll 5
+				for(size_t y = 0; y < 25; y += 5){
+					#pragma GCC unroll 5
+					for(size_t x = 0; x < 5; x++)
+						c[x] = a[y + x];
+					#pragma GCC unroll 5
+					for(size_t x = 0; x < 5; x++)
+						a[y + x] = c[x] ^ (~c[(x + 1) % 5] & c[(x + 2) % 5]);
+				}
+
+				// Iota: break the symmetry between rounds
+				a[0] ^= KECCAK_ROUND_CONSTANTS[round];
+			}
+
+			#pragma GCC unroll 25
+			for(size_t i = 0; i < 25; i++)
+				state[i] = a[i];
+		}
+
+
+		// Function which calculates the number of blocks a message (plus its padding) is absorbed in
+		inline size_t sha3Blocks(size_t size) { return size / SHA3_RATE + 1; }
+
+		/**
+		 * @brief Function which reads a word of a padded message (SHA3 pads with 0x06, zeros, and a final 0x80)
+		 *
+		 * @param message - The message
+		 * @param block - Which block the word is in
+		 * @param word - Which word of the block to read
+		 * @return uint64_t - The (little endian) word
+		 */
+		inline uint64_t sha3Word(std::string_view message, size_t block, size_t word) {
+			size_t offset = block * SHA3_RATE + word * 8;
+			uint64_t out = 0;
+			if(offset + 8 <= message.size() && std::endian::native == std::endian::little)
+				std::memcpy(&out, message.data() + offset, 8);
+			else for(size_t i = 0; i < 8; i++)
+				if(offset + i < message.size()) out |= uint64_t(uint8_t(message[offset + i])) << (8 * i);
+				else if(offset + i == message.size()) out |= uint64_t(0x06) << (8 * i);
+
+			if(block + 1 == sha3Blocks(message.size()) && word == SHA3_RATE / 8 - 1)
+				out |= uint64_t(0x80) << 56;
+			return out;
+		}
+
+		/**
+		 * @brief Function which hashes up to one message per element of <V> at once
+		 * @note Messages are absorbed in lockstep, a message's digest is taken as soon as its last block has been permuted (later permutations of its lanes are ignored)
+		 *
+		 * @param messages - The messages
+		 * @param digests - Where to store the digests
+		 * @param order - The indices of the messages to hash
+		 * @param n - The number of indices (at most the number of elements in <V>)
+		 */
+		template<typename V>
+		[[gnu::always_inline]] inline void sha3Batch(const std::string_view* messages, Digest* digests, const size_t* order, size_t n) {
+			V state[25] = {};
+			size_t blocks = 0;
+			for(size_t j = 0; j < n; j++)
+				blocks = std::max(blocks, sha3Blocks(messages[order[j]].size()));
+
+			for(size_t block = 0; block < blocks; block++){
+				// Absorb the next block of every message which has one left
+				for(size_t word = 0; word < SHA3_RATE / 8; word++){
+					V absorbed = {};
+					for(size_t j = 0; j < n; j++)
+						if(block < sha3Blocks(messages[order[j]].size()))
+							setLane(absorbed, j, sha3Word(messages[order[j]], block, word));
+					state[word] ^= absorbed;
+				}
+				keccakF1600(state);
+
+				// Squeeze the digests of the messages which just finished
+				for(size_t j = 0; j < n; j++)
+					if(block + 1 == sha3Blocks(messages[order[j]].size()))
+						for(size_t word = 0; word < 4; word++){
+							uint64_t value = getLane(state[word], j);
+							for(size_t i = 0; i < 8; i++)
+								digests[order[j]][word * 8 + i] = uint8_t(value >> (8 * i));
+						}
+			}
+		}
+
+		void sha3Scalar(const std::string_view* messages, Digest* digests, const size_t* order, size_t n) { sha3Batch<uint64_t>(messages, digests, order, n); }
+#ifdef KERNELS_X86
+		__attribute__((target("sse2"))) void sha3SSE2(const std::string_view* messages, Digest* digests, const size_t* order, size_t n) { sha3Batch<Lanes2>(messages, digests, order, n); }
+		__attribute__((target("avx2"))) void sha3AVX2(const std::string_view* messages, Digest* digests, const size_t* order, size_t n) { sha3Batch<Lanes4>(messages, digests, order, n); }
+		__attribute__((target("avx512f"))) void sha3AVX512(const std::string_view* messages, Digest* digests, const size_t* order, size_t n) { sha3Batch<Lanes8>(messages, digests, order, n); }
+#endif // KERNELS_X86
+
+		// Function which dispatches a batch of (at most hashLanes()) messages to the active instruction set
+		void dispatchSHA3(const std::string_view* messages, Digest* digests, const size_t* order, size_t n) {
+			switch(active()){
+#ifdef KERNELS_X86
+			case ISA::AVX512: return sha3AVX512(messages, digests, order, n);
+			case ISA::AVX2: return sha3AVX2(messages, digests, order, n);
+			case ISA::SSE2: return sha3SSE2(messages, digests, order, n);
+#endif
+			default: return sha3Scalar(messages, digests, order, n);
+			}
+		}
+
+
+		// -- Base 64 --
+
+
+		// The base 64 alphabet (each character's position is the digit it represents)
+		constexpr char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		// The digit each character represents (-1 for characters outside the alphabet)
+		constexpr std::array<int8_t, 256> BASE64_DIGITS = []() {
+			std::array<int8_t, 256> out;
+			out.fill(-1);
+			for(int i = 0; i < 64; i++)
+				out[uint8_t(BASE64_ALPHABET[i])] = i;
+			return out;
+		}();
+
+		// Function which encodes a group of (up to) 3 bytes as 4 characters (padding with '=' if there are less than 3 bytes)
+		inline void encodeGroup(const uint8_t* data, size_t size, char* out) {
+			uint32_t group = uint32_t(data[0]) << 16 | (size > 1 ? uint32_t(data[1]) << 8 : 0) | (size > 2 ? data[2] : 0);
+			out[0] = BASE64_ALPHABET[group >> 18 & 63];
+			out[1] = BASE64_ALPHABET[group >> 12 & 63];
+			out[2] = size > 1 ? BASE64_ALPHABET[group >> 6 & 63] : '=';
+			out[3] = size > 2 ? BASE64_ALPHABET[group & 63] : '=';
+		}
+
+		// Finishes encoding starting at byte <i> (which must be a multiple of 3), returns the total number of characters written
+		size_t encodeTail(const uint8_t* data, size_t i, size_t size, char* out) {
+			for(; i < size; i += 3)
+				encodeGroup(data + i, std::min<size_t>(3, size - i), out + i / 3 * 4);
+			return base64EncodedSize(size);
+		}
+
+		/**
+		 * @brief Partially decoded base 64, the digits which haven't yet been turned into bytes
+		 */
+		struct DecodeState {
+			uint32_t bits = 0;
+			size_t pending = 0, written = 0;
+
+			// Function which adds a character (skipping characters outside the alphabet), writing out the bytes once 4 digits are pending
+			inline void add(char c, uint8_t* out) {
+				int8_t digit = BASE64_DIGITS[uint8_t(c)];
+				if(digit < 0) return;
+				bits = bits << 6 | digit;
+				if(++pending < 4) return;
+				out[written++] = bits >> 16;
+				out[written++] = bits >> 8;
+				out[written++] = bits;
+				bits = pending = 0;
+			}
+
+			// Function which writes out the whole bytes left in the pending digits (the leftover bits are dropped, like CryptoPP does)
+			inline size_t finish(uint8_t* out) {
+				if(pending >= 2) out[written++] = bits >> (6 * pending - 8);
+				if(pending == 3) out[written++] = bits >> 2;
+				return written;
+			}
+		};
+
+		// Finishes converting characters to digits starting at character <i>, returns the number of characters converted
+		size_t digitsTail(const char* encoded, size_t i, size_t size, uint8_t* out) {
+			for(; i < size; i++){
+				int8_t digit = BASE64_DIGITS[uint8_t(encoded[i])];
+				if(digit < 0) return i;
+				out[i] = digit;
+			}
+			return size;
+		}
+
+#ifdef KERNELS_X86
+		// Whether the CPU has SSSE3 (needed for byte shuffles, the SSE2 dispatch uses it when available)
+		bool hasSSSE3() {
+			static const bool supported = []{
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("ssse3");
+			}();
+			return supported;
+		}
+
+		// Function which finds the characters between <low> and <high> (inclusive)
+		__attribute__((target("sse2"))) inline __m128i betweenSSE2(__m128i chars, char low, char high) { return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(high + 1), chars)); }
+
+		/**
+		 * @brief Function which converts 16 characters into the digits they represent (found by range, so only SSE2 is needed)
+		 *
+		 * @param chars - The characters
+		 * @param digits - Where to store the digits
+		 * @return bool - False if any character is outside the alphabet
+		 */
+		__attribute__((target("sse2"))) inline bool digitsSSE2(__m128i chars, __m128i& digits) {
+			__m128i upper = betweenSSE2(chars, 'A', 'Z'), lower = betweenSSE2(chars, 'a', 'z'), digit = betweenSSE2(chars, '0', '9');
+			__m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+')), slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+			if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash)) != 0xFFFF) return false;
+
+			// Each range is a constant distance from its digits
+			__m128i offsets = _mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')), _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+				_mm_or_si128(_mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')), _mm_and_si128(plus, _mm_set1_epi8(62 - '+'))), _mm_and_si128(slash, _mm_set1_epi8(63 - '/'))));
+			digits = _mm_add_epi8(chars, offsets);
+			return true;
+		}
+
+		// Converts 16 characters at a time into digits (finding exactly where the first character outside the alphabet is one at a time)
+		__attribute__((target("sse2"))) size_t base64DigitsSSE2(const char* encoded, size_t size, uint8_t* out) {
+			size_t i = 0;
+			for(; i + 16 <= size; i += 16){
+				__m128i digits;
+				if(!digitsSSE2(_mm_loadu_si128((const __m128i*) (encoded + i)), digits)) break;
+				_mm_storeu_si128((__m128i*) (out + i), digits);
+			}
+			return digitsTail(encoded, i, size, out);
+		}
+
+		// Encodes 12 bytes (read as 16, the last 4 are ignored) into 16 characters
+		__attribute__((target("ssse3"))) size_t base64EncodeSSSE3(const uint8_t* data, size_t size, char* out) {
+			size_t i = 0, o = 0;
+			for(; i + 16 <= size; i += 12, o += 16){
+				// Spread each group of 3 bytes into 4 bytes, then shift each 6 bit digit into its own byte
+				__m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (data + i)), _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+				__m128i digits = _mm_or_si128(_mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040)),
+					_mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010)));
+
+				// Find each digit's range (0 = lowercase, 1-10 = numbers, 11 = '+', 12 = '/', 13 = uppercase), and add the range's distance from its characters
+				__m128i range = _mm_subs_epu8(digits, _mm_set1_epi8(51));
+				range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), digits), _mm_set1_epi8(13)));
+				__m128i offsets = _mm_shuffle_epi8(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0), range);
+				_mm_storeu_si128((__m128i*) (out + o), _mm_add_epi8(digits, offsets));
+			}
+			return encodeTail(data, i, size, out);
+		}
+
+		// Decodes 16 characters at a time into 12 bytes (falling back to one character at a time around characters outside the alphabet)
+		__attribute__((target("ssse3"))) size_t base64DecodeSSSE3(const char* encoded, size_t size, uint8_t* out) {
+			DecodeState state;
+			for(size_t i = 0; i < size;){
+				__m128i digits;
+				if(state.pending == 0 && i + 16 <= size && digitsSSE2(_mm_loadu_si128((const __m128i*) (encoded + i)), digits)){
+					// Merge pairs of digits into 12 bits, then pairs of those into 24 bits, then pack the 3 bytes of each group together
+					__m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(digits, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+					__m128i bytes = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+					_mm_storel_epi64((__m128i*) (out + state.written), bytes);
+					uint32_t last = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+					std::memcpy(out + state.written + 8, &last, 4);
+					state.written += 12;
+					i += 16;
+				} else state.add(encoded[i++], out);
+			}
+			return state.finish(out);
+		}
+
+		// Encodes 24 bytes (read as two overlapping 16 byte loads) into 32 characters
+		__attribute__((target("avx2"))) size_t base64EncodeAVX2(const uint8_t* data, size_t size, char* out) {
+			size_t i = 0, o = 0;
+			for(; i + 28 <= size; i += 24, o += 32){
+				__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) (data + i))), _mm_loadu_si128((const __m128i*) (data + i + 12)), 1);
+				in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+				__m256i digits = _mm256_or_si256(_mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040)),
+					_mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010)));
+
+				__m256i range = _mm256_subs_epu8(digits, _mm256_set1_epi8(51));
+				range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), digits), _mm256_set1_epi8(13)));
+				__m256i offsets = _mm256_shuffle_epi8(_mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+					'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0), range);
+				_mm256_storeu_si256((__m256i*) (out + o), _mm256_add_epi8(digits, offsets));
+			}
+			return encodeTail(data, i, size, out);
+		}
+
+		__attribute__((target("avx2"))) inline __m256i betweenAVX2(__m256i chars, char low, char high) { return _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chars)); }
+
+		// Function which converts 32 characters into the digits they represent, returns false if any character is outside the alphabet
+		__attribute__((target("avx2"))) inline bool digitsAVX2(__m256i chars, __m256i& digits) {
+			__m256i upper = betweenAVX2(chars, 'A', 'Z'), lower = betweenAVX2(chars, 'a', 'z'), digit = betweenAVX2(chars, '0', '9');
+			__m256i plus = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('+')), slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+			if(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, plus)), slash)) != -1) return false;
+
+			__m256i offsets = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')), _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+				_mm256_or_si256(_mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')), _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+'))), _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/'))));
+			digits = _mm256_add_epi8(chars, offsets);
+			return true;
+		}
+
+		__attribute__((target("avx2"))) size_t base64DigitsAVX2(const char* encoded, size_t size, uint8_t* out) {
+			size_t i = 0;
+			for(; i + 32 <= size; i += 32){
+				__m256i digits;
+				if(!digitsAVX2(_mm256_loadu_si256((const __m256i*) (encoded + i)), digits)) break;
+				_mm256_storeu_si256((__m256i*) (out + i), digits);
+			}
+			return digitsTail(encoded, i, size, out);
+		}
+
+		// Decodes 32 characters at a time into 24 bytes (falling back to one character at a time around characters outside the alphabet)
+		__attribute__((target("avx2"))) size_t base64DecodeAVX2(const char* encoded, size_t size, uint8_t* out) {
+			DecodeState state;
+			for(size_t i = 0; i < size;){
+				__m256i digits;
+				if(state.pending == 0 && i + 32 <= size && digitsAVX2(_mm256_loadu_si256((const __m256i*) (encoded + i)), digits)){
+					__m256i merged = _mm256_madd_epi16(_mm256_maddubs_epi16(digits, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+					__m256i bytes = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+					// Move the 12 bytes from the upper half down next to the 12 from the lower half
+					bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+					_mm_storeu_si128((__m128i*) (out + state.written), _mm256_castsi256_si128(bytes));
+					_mm_storel_epi64((__m128i*) (out + state.written + 16), _mm256_extracti128_si256(bytes, 1));
+					state.written += 24;
+					i += 32;
+				} else state.add(encoded[i++], out);
+			}
+			return state.finish(out);
+		}
+#endif // KERNELS_X86
+
+
+		// The instruction set currently being dispatched to
+		std::atomic<ISA> current = detected();
+
+		// Function which dispatches a (filtered) sum to the active instruction set
+		template<bool Filter>
+		Amount dispatchSum(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account) {
+			WrappingSum s;
+			switch(active()){
+#ifdef KERNELS_X86
+			case ISA::AVX512: s = sumAVX512<Filter>(accounts, amounts, n, account); break;
+			case ISA::AVX2: s = sumAVX2<Filter>(accounts, amounts, n, account); break;
+			case ISA::SSE2: s = sumSSE2<Filter>(accounts, amounts, n, account); break;
+#endif
+			default: return sumChecked<Filter>(accounts, amounts, n, account);
+			}
+
+			// If the vector sum might have overflowed, redo it with checks (which throws if it really did)
+			if(auto out = toAmount(s, n); out) return *out;
+			return sumChecked<Filter>(accounts, amounts, n, account);
+		}
+	}
+
+	/**
+	 * @brief Function which determines the best instruction set supported by this CPU
+	 * @return ISA - The detected instruction set
+	 */
+	ISA detected() {
+		static const ISA isa = []() -> ISA {
+#ifdef KERNELS_X86
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx512f")) return ISA::AVX512;
+			if(__builtin_cpu_supports("avx2")) return ISA::AVX2;
+			if(__builtin_cpu_supports("sse2")) return ISA::SSE2;
+#endif
+			return ISA::Scalar;
+		}();
+		return isa;
+	}
+
+	// The instruction set the kernels are currently dispatching to
+	ISA active() { return current.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Forces the kernels to dispatch to a specific instruction set
+	 *
+	 * @param isa - The requested instruction set
+	 * @return ISA - The instruction set which will actually be used (the detected set if the requested one isn't supported)
+	 */
+	ISA setActive(ISA isa) {
+		if(isa > detected()) isa = detected();
+		current.store(isa, std::memory_order_relaxed);
+		return isa;
+	}
+
+	// Human readable name of an instruction set
+	const char* name(ISA isa) {
+		switch(isa){
+		case ISA::AVX512: return "AVX-512";
+		case ISA::AVX2: return "AVX2";
+		case ISA::SSE2: return "SSE2";
+		default: return "Scalar";
+		}
+	}
+
+	/**
+	 * @brief Function which sums every amount
+	 *
+	 * @param amounts - Contiguous array of amounts
+	 * @param n - The number of amounts
+	 * @return Amount - The sum (throws Amount::Overflow if it can't be represented)
+	 */
+	Amount sum(const Amount::Raw* amounts, size_t n) { return dispatchSum<false>(nullptr, amounts, n, 0); }
+
+	/**
+	 * @brief Function which sums every amount whose matching account is <account>
+	 *
+	 * @param accounts - Contiguous array of account IDs
+	 * @param amounts - Contiguous array of amounts (amounts[i] belongs to accounts[i])
+	 * @param n - The number of accounts/amounts
+	 * @param account - The account to sum the amounts of
+	 * @return Amount - The sum (throws Amount::Overflow if it can't be represented)
+	 */
+	Amount sumMatching(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account) { return dispatchSum<true>(accounts, amounts, n, account); }
+
+	/**
+	 * @brief Function which sums the weights pointed to by each of the provided pointers
+	 * @note Integer sums are exact, so every instruction set produces the same result
+	 *
+	 * @param values - Contiguous array of pointers to weights
+	 * @param n - The number of pointers
+	 * @return uint64_t - The sum (saturated at the largest representable weight)
+	 */
+	uint64_t gatherSum(const uint64_t* const* values, size_t n) {
+		WrappingSum s;
+		switch(active()){
+#ifdef KERNELS_X86
+		case ISA::AVX512: s = gatherSumAVX512(values, n); break;
+		case ISA::AVX2: s = gatherSumAVX2(values, n); break;
+		case ISA::SSE2: s = gatherSumSSE2(values, n); break;
+#endif
+		default: s = gatherTail({}, values, 0, n);
+		}
+
+		// If the wrapping sum might have overflowed, redo it with saturation
+		if(auto out = toWeight(s, n); out) return *out;
+		return gatherSaturating(values, n);
+	}
+
+	/**
+	 * @brief Function which calculates log(sum(exp(values))) without overflowing or underflowing
+	 * @note The largest value is factored out, so every exponential is at most 1 and at least one of them is exactly 1
+	 * @note Scalar on every instruction set (there are no vector exponential instructions, and an approximation would break bit-identical results)
+	 *
+	 * @param values - Contiguous array of values (log weights)
+	 * @param n - The number of values
+	 * @return double - The log of the sum of the exponentials of the values (-infinity if there are no values)
+	 */
+	double logSumExp(const double* values, size_t n) {
+		if(n == 0) return -std::numeric_limits<double>::infinity();
+
+		double max = *std::max_element(values, values + n);
+		if(!std::isfinite(max)) return max;
+
+		double sum = 0;
+		for(size_t i = 0; i < n; i++)
+			sum += std::exp(values[i] - max);
+		return max + std::log(sum);
+	}
+
+	/**
+	 * @brief Function which finds the index of the first occurrence of <account>
+	 *
+	 * @param accounts - Contiguous array of account IDs
+	 * @param n - The number of account IDs
+	 * @param account - The account to search for
+	 * @return size_t - The index of the account, or n if it isn't present
+	 */
+	size_t find(const uint32_t* accounts, size_t n, uint32_t account) {
+		switch(active()){
+#ifdef KERNELS_X86
+		case ISA::AVX512: return findAVX512(accounts, n, account);
+		case ISA::AVX2: return findAVX2(accounts, n, account);
+		case ISA::SSE2: return findSSE2(accounts, n, account);
+#endif
+		default: return findTail(accounts, 0, n, account);
+		}
+	}
+
+	/**
+	 * @brief Function which base 64 encodes binary data
+	 * @note Produces the same characters as CryptoPP's Base64Encoder (without its line breaks) on every instruction set
+	 *
+	 * @param data - The data to encode
+	 * @param size - The number of bytes of data
+	 * @param out - Where to store the characters (must have room for base64EncodedSize(size) characters)
+	 * @return size_t - The number of characters written
+	 */
+	size_t base64Encode(const uint8_t* data, size_t size, char* out) {
+		switch(active()){
+#ifdef KERNELS_X86
+		case ISA::AVX512:
+		case ISA::AVX2: return base64EncodeAVX2(data, size, out);
+		case ISA::SSE2: if(hasSSSE3()) return base64EncodeSSSE3(data, size, out); [[fallthrough]];
+#endif
+		default: return encodeTail(data, 0, size, out);
+		}
+	}
+
+	/**
+	 * @brief Function which decodes base 64 characters
+	 * @note Like CryptoPP's Base64Decoder: characters outside the alphabet (line breaks and padding) are skipped, and leftover bits which don't make a whole byte are dropped
+	 *
+	 * @param encoded - The characters to decode
+	 * @param size - The number of characters
+	 * @param out - Where to store the bytes (must have room for base64DecodedSize(size) bytes)
+	 * @return size_t - The number of bytes written
+	 */
+	size_t base64Decode(const char* encoded, size_t size, uint8_t* out) {
+		switch(active()){
+#ifdef KERNELS_X86
+		case ISA::AVX512:
+		case ISA::AVX2: return base64DecodeAVX2(encoded, size, out);
+		case ISA::SSE2: if(hasSSSE3()) return base64DecodeSSSE3(encoded, size, out); [[fallthrough]];
+#endif
+		default: {
+			DecodeState state;
+			for(size_t i = 0; i < size; i++)
+				state.add(encoded[i], out);
+			return state.finish(out);
+		}
+		}
+	}
+
+	/**
+	 * @brief Function which converts base 64 characters into the digits they represent, stopping at the first character outside the alphabet
+	 *
+	 * @param encoded - The characters to convert
+	 * @param size - The number of characters
+	 * @param out - Where to store the digits (out[i] is the digit encoded[i] represents)
+	 * @return size_t - The number of characters converted (size if every character was in the alphabet)
+	 */
+	size_t base64Digits(const char* encoded, size_t size, uint8_t* out) {
+		switch(active()){
+#ifdef KERNELS_X86
+		case ISA::AVX512:
+		case ISA::AVX2: return base64DigitsAVX2(encoded, size, out);
+		case ISA::SSE2: return base64DigitsSSE2(encoded, size, out);
+#endif
+		default: return digitsTail(encoded, 0, size, out);
+		}
+	}
+
+	// Number of messages the active instruction set hashes at once
+	size_t hashLanes() {
+		switch(active()){
+		case ISA::AVX512: return 8;
+		case ISA::AVX2: return 4;
+		case ISA::SSE2: return 2;
+		default: return 1;
+		}
+	}
+
+	/**
+	 * @brief Function which hashes each of <n> independent messages with SHA3-256
+	 * @note Every instruction set produces byte-identical digests, the vector versions just hash several messages at once
+	 *
+	 * @param messages - Contiguous array of messages
+	 * @param digests - Contiguous array the digests are stored in (digests[i] is the digest of messages[i])
+	 * @param n - The number of messages
+	 */
+	void sha3_256(const std::string_view* messages, Digest* digests, size_t n) {
+		static constexpr size_t identity[] = {0, 1, 2, 3, 4, 5, 6, 7};
+		size_t lanes = hashLanes();
+		// A single message is faster to hash without vectors
+		if(n == 1) return sha3Scalar(messages, digests, identity, n);
+		if(n <= lanes) return dispatchSHA3(messages, digests, identity, n);
+
+		// A batch takes as many permutations as its longest message needs, so batch messages with the same number of blocks together
+		std::vector<size_t> order(n);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [messages](size_t a, size_t b) { return sha3Blocks(messages[a].size()) < sha3Blocks(messages[b].size()); });
+		for(size_t i = 0; i < n; i += lanes)
+			dispatchSHA3(messages, digests, order.data() + i, std::min(lanes, n - i));
+	}
+
+} // kernels
@@ -0,0 +1,74 @@
+/**
+ * @file kernels.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides vectorized kernels for the balance and weight passes over the tangle, multi-buffer hashing, and base 64 encoding
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "amount.hpp"
+
+namespace kernels {
+
+	/**
+	 * @brief Instruction sets the kernels can be dispatched to
+	 * @note Every instruction set produces bit-identical results to the scalar version
+	 */
+	enum class ISA { Scalar, SSE2, AVX2, AVX512 };
+
+	// The best instruction set supported by this CPU (detected once at startup)
+	ISA detected();
+	// The instruction set the kernels are currently dispatching to
+	ISA active();
+	// Forces the kernels to dispatch to a specific instruction set (falls back to the detected set if unsupported)
+	ISA setActive(ISA isa);
+	// Human readable name of an instruction set
+	const char* name(ISA isa);
+
+	// Function which sums every amount, throws Amount::Overflow if the sum can't be represented
+	Amount sum(const Amount::Raw* amounts, size_t n);
+	// Function which sums every amount whose matching account is <account>, throws Amount::Overflow if the sum can't be represented
+	Amount sumMatching(const uint32_t* accounts, const Amount::Raw* amounts, size_t n, uint32_t account);
+	// Function which sums the weights pointed to by each of the provided pointers, saturating at the largest representable weight
+	uint64_t gatherSum(const uint64_t* const* values, size_t n);
+	// Function which calculates log(sum(exp(values))) without overflowing or underflowing
+	double logSumExp(const double* values, size_t n);
+	// Function which finds the index of the first occurrence of <account> (returns n if not found)
+	size_t find(const uint32_t* accounts, size_t n, uint32_t account);
+
+	// Function which checks if <account> is present in the list of accounts
+	inline bool contains(const uint32_t* accounts, size_t n, uint32_t account) { return find(accounts, n, account) != n; }
+
+	// A SHA3-256 digest
+	using Digest = std::array<uint8_t, 32>;
+	// Number of messages the active instruction set hashes at once (1 scalar, 2 SSE2, 4 AVX2, 8 AVX-512)
+	size_t hashLanes();
+	// Function which hashes each of <n> independent messages with SHA3-256, as many at once as the active instruction set allows (digests[i] is the digest of messages[i])
+	void sha3_256(const std::string_view* messages, Digest* digests, size_t n);
+	// Function which hashes a single message with SHA3-256
+	inline Digest sha3_256(std::string_view message) { Digest out; sha3_256(&message, &out, 1); return out; }
+
+	// Number of characters base 64 encoding <size> bytes produces (including padding)
+	constexpr size_t base64EncodedSize(size_t size) { return (size + 2) / 3 * 4; }
+	// Largest number of bytes decoding <size> base 64 characters can produce
+	constexpr size_t base64DecodedSize(size_t size) { return size / 4 * 3 + size % 4; }
+	// Function which base 64 encodes <size> bytes into <out> (which must have room for base64EncodedSize(size) characters), returns the number of characters written
+	size_t base64Encode(const uint8_t* data, size_t size, char* out);
+	// Function which decodes base 64 characters into <out> (which must have room for base64DecodedSize(size) bytes), characters outside the alphabet (line breaks and padding) are skipped, returns the number of bytes written
+	size_t base64Decode(const char* encoded, size_t size, uint8_t* out);
+	// Function which converts base 64 characters into the digits (0-63) they represent, stopping at the first character outside the alphabet, returns the number of characters converted
+	size_t base64Digits(const char* encoded, size_t size, uint8_t* out);
+
+} // kernels
+
+#endif /* end of include guard: KERNELS_HPP */
@@ -0,0 +1,152 @@
+/**
+ * @file kernels_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark checking that every instruction set's balance and weight kernels (see kernels.hpp) produce identical results to the scalar versions, and measuring how much faster they recompute balances and weights
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "kernels.hpp"
+
+// Every instruction set (the ones this CPU doesn't support are skipped)
+constexpr kernels::ISA ISAS[] = {kernels::ISA::Scalar, kernels::ISA::SSE2, kernels::ISA::AVX2, kernels::ISA::AVX512};
+
+/**
+ * @brief Function which runs <f> until at least <seconds> have passed
+ *
+ * @param seconds - How long to run for
+ * @param f - The operation to run, returns the number of elements it processed
+ * @return double - Elements processed per second
+ */
+template<typename F>
+double measure(double seconds, F f) {
+	size_t elements = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0;
+	while(elapsed < seconds){
+		elements += f();
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return elements / elapsed;
+}
+
+// Function which runs a kernel which may overflow, returning nothing if it did
+template<typename F>
+std::optional<Amount::Raw> checked(F f) {
+	try {
+		return f().raw;
+	} catch (Amount::Overflow&) {
+		return {};
+	}
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<column length> = 1000000] [<seconds per measurement> = 1]" << std::endl;
+		return 1;
+	}
+
+	size_t length = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+	double seconds = argc > 2 ? std::stod(argv[2]) : 1;
+	std::mt19937_64 rng(0);
+
+	// Columns like the tangle's (amounts, the interned accounts they belong to, and weights reached through pointers)
+	auto column = [&](size_t n, uint32_t accounts, Amount::Raw largest) {
+		std::vector<uint32_t> ids(n);
+		std::vector<Amount::Raw> amounts(n);
+		for(size_t i = 0; i < n; i++){
+			ids[i] = rng() % accounts;
+			amounts[i] = Amount::Raw(rng() % uint64_t(largest)) - (rng() % 4 == 0 ? largest / 2 : 0);
+		}
+		return std::make_pair(ids, amounts);
+	};
+
+	// -- Equivalence --
+
+	bool identical = true;
+	auto mismatch = [&](kernels::ISA isa, const std::string& kernel, size_t n) {
+		std::cout << kernels::name(isa) << " " << kernel << " of " << n << " elements doesn't match the scalar version!" << std::endl;
+		identical = false;
+	};
+
+	// Every length around the vector widths (and their remainders), with amounts small enough to sum and large enough to overflow
+	for(size_t n = 0; n <= 67 && identical; n++)
+		for(Amount::Raw largest: {Amount::Raw(1'000'000), std::numeric_limits<Amount::Raw>::max() / 8, std::numeric_limits<Amount::Raw>::max()}){
+			auto [ids, amounts] = column(n, 4, largest);
+			std::vector<uint64_t> weights(n);
+			std::vector<const uint64_t*> pointers(n);
+			for(size_t i = 0; i < n; i++){
+				weights[i] = largest == std::numeric_limits<Amount::Raw>::max() ? rng() : rng() % 1'000'000;
+				pointers[i] = &weights[rng() % n];
+			}
+			std::vector<double> logs(n);
+			for(auto& l: logs) l = std::uniform_real_distribution<double>(-800, 800)(rng);
+
+			kernels::setActive(kernels::ISA::Scalar);
+			auto sum = checked([&]{ return kernels::sum(amounts.data(), n); });
+			auto matching = checked([&]{ return kernels::sumMatching(ids.data(), amounts.data(), n, 1); });
+			auto gathered = kernels::gatherSum(pointers.data(), n);
+			auto logSum = kernels::logSumExp(logs.data(), n);
+			auto found = kernels::find(ids.data(), n, 3);
+
+			for(kernels::ISA isa: ISAS){
+				if(isa == kernels::ISA::Scalar || kernels::setActive(isa) != isa) continue;
+				if(checked([&]{ return kernels::sum(amounts.data(), n); }) != sum) mismatch(isa, "sum", n);
+				if(checked([&]{ return kernels::sumMatching(ids.data(), amounts.data(), n, 1); }) != matching) mismatch(isa, "sumMatching", n);
+				if(kernels::gatherSum(pointers.data(), n) != gathered) mismatch(isa, "gatherSum", n);
+				double l = kernels::logSumExp(logs.data(), n);
+				if(std::memcmp(&l, &logSum, sizeof(double)) != 0) mismatch(isa, "logSumExp", n);
+				if(kernels::find(ids.data(), n, 3) != found) mismatch(isa, "find", n);
+			}
+		}
+
+	// -- Recompute Speed --
+
+	// Recomputing one account's balance from the input/output columns, and a node's cumulative weight from its approvers
+	auto [ids, amounts] = column(length, 1024, 1'000'000);
+	std::vector<uint64_t> weights(length);
+	std::vector<const uint64_t*> pointers(length);
+	for(size_t i = 0; i < length; i++){
+		weights[i] = rng() % 1'000'000;
+		pointers[i] = &weights[rng() % length];
+	}
+
+	std::cout << length << " element columns" << std::endl;
+	double scalarBalance = 0, scalarWeight = 0;
+	for(kernels::ISA isa: ISAS){
+		if(kernels::setActive(isa) != isa) continue;
+		uint32_t account = 0;
+		double balance = measure(seconds, [&]{
+			if(kernels::sumMatching(ids.data(), amounts.data(), length, account++ % 1024).raw == 1) return size_t(0);
+			return length;
+		});
+		double weight = measure(seconds, [&]{
+			if(kernels::gatherSum(pointers.data(), length) == 1) return size_t(0);
+			return length;
+		});
+		if(isa == kernels::ISA::Scalar){
+			scalarBalance = balance;
+			scalarWeight = weight;
+		}
+
+		std::cout << kernels::name(isa) << ": balance recompute " << (balance / 1e6) << "M entries/s (" << (balance / scalarBalance) << "x scalar), weight recompute "
+			<< (weight / 1e6) << "M approvers/s (" << (weight / scalarWeight) << "x scalar)" << std::endl;
+	}
+	kernels::setActive(kernels::detected());
+
+	std::cout << (identical ? "Every instruction set matches the scalar kernels" : "MISMATCH") << std::endl;
+	return identical ? 0 : 1;
+}
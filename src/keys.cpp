@@ -10,11 +10,118 @@
  */
 #include "keys.hpp"
 
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <unordered_map>
 #include "cryptopp/osrng.h"
+#include "cryptopp/oids.h"
+#include "cryptopp/xed25519.h"
+#include "monitor.hpp"
+
+// Maximum number of public keys which have verifiers cached
+#define KEY_VERIFIER_CACHE_SIZE 4096
 
 namespace key {
 
+	// Function which gets this thread's random number generator (seeded once per thread, so signing doesn't need to gather entropy each time)
+	static CryptoPP::RandomNumberGenerator& rng() {
+		thread_local CryptoPP::AutoSeededRandomPool prng;
+		return prng;
+	}
+
+	/**
+	 * @brief Pool of reusable signing (or verification) objects for a single key, each with fixed-base precomputation enabled (where the scheme supports it)
+	 * @note Crypto++'s curve arithmetic keeps scratch state inside the objects, so each object is checked out by one thread at a time
+	 */
+	template<typename T>
+	struct Pool {
+		// Function which creates a new (precomputed) object
+		const std::function<std::unique_ptr<T>()> create;
+		monitor<std::vector<std::unique_ptr<T>>> idle;
+
+		Pool(std::function<std::unique_ptr<T>()> create) : create(std::move(create)) {}
+
+		// Function which runs <f> with an object from the pool (creating a new one if none are idle)
+		template<typename F>
+		auto use(F f) {
+			std::unique_ptr<T> object;
+			{
+				auto lock = idle.write_lock();
+				if(!lock->empty()){
+					object = std::move(lock->back());
+					lock->pop_back();
+				}
+			}
+			if(!object) object = create();
+
+			auto result = f(*object);
+			idle.write_lock()->push_back(std::move(object));
+			return result;
+		}
+	};
+
+	struct SignerContext : public Pool<CryptoPP::PK_Signer> {
+		SignerContext(const PrivateKey& key) : Pool([key]() -> std::unique_ptr<CryptoPP::PK_Signer> {
+			if(auto ecdsa = std::get_if<ECDSA::PrivateKey>(&key)){
+				auto signer = std::make_unique<ECDSA::Signer>(*ecdsa);
+				signer->AccessKey().Precompute();
+				return signer;
+			}
+			return std::make_unique<CryptoPP::ed25519Signer>(std::get<Ed25519PrivateKey>(key).bytes.data());
+		}) {}
+	};
+
+	struct VerifierContext : public Pool<CryptoPP::PK_Verifier> {
+		VerifierContext(const PublicKey& key) : Pool([key]() -> std::unique_ptr<CryptoPP::PK_Verifier> {
+			if(auto ecdsa = std::get_if<ECDSA::PublicKey>(&key)){
+				auto verifier = std::make_unique<ECDSA::Verifier>(*ecdsa);
+				verifier->AccessKey().Precompute();
+				return verifier;
+			}
+			return std::make_unique<CryptoPP::ed25519Verifier>(std::get<Ed25519PublicKey>(key).bytes.data());
+		}) {}
+	};
+
+	// Verifiers for recently seen public keys (keyed by the saved key)
+	static monitor<std::unordered_map<std::string, std::shared_ptr<VerifierContext>>> verifiers;
+
+	// Function which finds (or creates) the verifiers for a public key
+	static std::shared_ptr<VerifierContext> verifiersFor(const PublicKey& key) {
+		std::string saved = util::bytes2string(save(key));
+		if(auto lock = verifiers.read_lock(); lock->contains(saved))
+			return lock->at(saved);
+
+		auto lock = verifiers.write_lock();
+		// Forget every key once the cache is full (most keys belong to a handful of active peers, which will quickly be cached again)
+		if(lock->size() >= KEY_VERIFIER_CACHE_SIZE) lock->clear();
+		auto& context = (*lock)[saved];
+		if(!context) context = std::make_shared<VerifierContext>(key);
+		return context;
+	}
+
+	// Function which converts a scheme to its name
+	std::string_view name(Scheme scheme) {
+		switch(scheme){
+		case Scheme::ECDSA: return "ecdsa";
+		case Scheme::Ed25519: return "ed25519";
+		}
+		return "unknown";
+	}
+
+	// Function which converts a name to its scheme
+	Scheme parseScheme(std::string_view name) {
+		if(name == "ecdsa") return Scheme::ECDSA;
+		if(name == "ed25519") return Scheme::Ed25519;
+		throw std::invalid_argument("Unknown signature scheme `" + std::string(name) + "`");
+	}
+
+	// Constructor which creates the pair's signer context
+	KeyPair::KeyPair(const PrivateKey& pri, const PublicKey& pub) : pri(pri), pub(pub), signers(std::make_shared<SignerContext>(pri)) {
+		if(key::scheme(pri) != key::scheme(pub))
+			throw InvalidKey("Private and public keys use different schemes.");
+	}
+
 	// Function which checks if the key pair properly sign and verify eachother
 	bool KeyPair::validate(){
 		std::string message = "VALIDATION";
@@ -23,48 +130,86 @@ namespace key {
 	}
 
 	// Function which generates a private key
-	PrivateKey generatePrivateKey(const CryptoPP::OID& oid) {
-		CryptoPP::AutoSeededRandomPool prng;
-		PrivateKey key;
+	ECDSA::PrivateKey generatePrivateKey(const CryptoPP::OID& oid) {
+		ECDSA::PrivateKey key;
 
-		key.Initialize(prng, oid);
-		if(!key.Validate(prng, 3))
+		key.Initialize(rng(), oid);
+		if(!key.Validate(rng(), 3))
 			throw InvalidKey("Private Key failed to pass validation.");
 
 		return key;
 	}
 
 	// Function which generates a public key
-	PublicKey generatePublicKey(const PrivateKey& privateKey) {
-		CryptoPP::AutoSeededRandomPool prng;
-		PublicKey publicKey;
+	ECDSA::PublicKey generatePublicKey(const ECDSA::PrivateKey& privateKey) {
+		ECDSA::PublicKey publicKey;
 
 		privateKey.MakePublicKey(publicKey);
-		if(!publicKey.Validate(prng, 3))
+		if(!publicKey.Validate(rng(), 3))
 			throw InvalidKey("Public Key failed to pass validation.");
 
 		return publicKey;
 	}
 
-	// Function which generates a private and public key pair
+	// Function which derives the public key matching an Ed25519 private key
+	Ed25519PublicKey generatePublicKey(const Ed25519PrivateKey& privateKey) {
+		CryptoPP::ed25519Signer signer(privateKey.bytes.data());
+		CryptoPP::ed25519Verifier verifier(signer);
+
+		Ed25519PublicKey publicKey;
+		auto& key = static_cast<const CryptoPP::ed25519PublicKey&>(verifier.GetPublicKey());
+		std::copy_n(key.GetPublicKeyBytePtr(), publicKey.bytes.size(), publicKey.bytes.begin());
+		return publicKey;
+	}
+
+	// Function which generates a private and public (ECDSA) key pair on the given curve
 	KeyPair generateKeyPair(const CryptoPP::OID& oid){
-		PrivateKey pri = generatePrivateKey(oid);
+		ECDSA::PrivateKey pri = generatePrivateKey(oid);
 		return { pri, generatePublicKey(pri) };
 	}
 
+	// Function which generates a private and public key pair using the given scheme
+	KeyPair generateKeyPair(Scheme scheme /*= DEFAULT_SCHEME*/){
+		if(scheme == Scheme::ECDSA)
+			return generateKeyPair(CryptoPP::ASN1::secp160r1());
+
+		// Any 32 random bytes are a valid Ed25519 private key
+		Ed25519PrivateKey pri;
+		rng().GenerateBlock(pri.bytes.data(), pri.bytes.size());
+		return { pri, generatePublicKey(pri) };
+	}
+
+	// Function which converts raw key bytes to hexadecimal (for printing)
+	static std::string hex(const std::array<byte, 32>& bytes) {
+		std::stringstream out;
+		for(byte b: bytes)
+			out << std::hex << std::setw(2) << std::setfill('0') << int(b);
+		return out.str();
+	}
+
 	// Function which prints a private key
 	void print(const PrivateKey& key) {
 		std::cout << std::endl;
-		std::cout << "Private Exponent:" << std::endl;
-		std::cout << " " << key.GetPrivateExponent() << std::endl;
+		if(auto ecdsa = std::get_if<ECDSA::PrivateKey>(&key)){
+			std::cout << "Private Exponent:" << std::endl;
+			std::cout << " " << ecdsa->GetPrivateExponent() << std::endl;
+		} else {
+			std::cout << "Private Key (Ed25519):" << std::endl;
+			std::cout << " " << hex(std::get<Ed25519PrivateKey>(key).bytes) << std::endl;
+		}
 	}
 
 	// Function which prints a public key
 	void print(const PublicKey& key) {
 		std::cout << std::endl;
-		std::cout << "Public Element:" << std::endl;
-		std::cout << " X: " << key.GetPublicElement().x << std::endl;
-		std::cout << " Y: " << key.GetPublicElement().y << std::endl;
+		if(auto ecdsa = std::get_if<ECDSA::PublicKey>(&key)){
+			std::cout << "Public Element:" << std::endl;
+			std::cout << " X: " << ecdsa->GetPublicElement().x << std::endl;
+			std::cout << " Y: " << ecdsa->GetPublicElement().y << std::endl;
+		} else {
+			std::cout << "Public Key (Ed25519):" << std::endl;
+			std::cout << " " << hex(std::get<Ed25519PublicKey>(key).bytes) << std::endl;
+		}
 	}
 
 	// Function which prints a keypair
@@ -76,24 +221,33 @@ namespace key {
 	// Function which converts a private key to a byte array
 	std::vector<byte> save(const PrivateKey& key) {
 		std::vector<byte> out;
-		key.Save(CryptoPP::VectorSink(out).Ref());
+		if(auto ecdsa = std::get_if<ECDSA::PrivateKey>(&key))
+			ecdsa->Save(CryptoPP::VectorSink(out).Ref());
+		else {
+			auto& bytes = std::get<Ed25519PrivateKey>(key).bytes;
+			out.push_back(ED25519_TAG);
+			out.insert(out.end(), bytes.begin(), bytes.end());
+		}
 		return out;
 	}
 
 	// Function which converts a public key to a byte array
 	std::vector<byte> save(const PublicKey& key) {
 		std::vector<byte> out;
-		key.Save(CryptoPP::VectorSink(out).Ref());
+		if(auto ecdsa = std::get_if<ECDSA::PublicKey>(&key))
+			ecdsa->Save(CryptoPP::VectorSink(out).Ref());
+		else {
+			auto& bytes = std::get<Ed25519PublicKey>(key).bytes;
+			out.push_back(ED25519_TAG);
+			out.insert(out.end(), bytes.begin(), bytes.end());
+		}
 		return out;
 	}
 
 	// Function which converts a string to base 64 string
 	std::string saveBase64(const PublicKey& key){
 		auto decoded = save(key);
-		std::string encoded;
-
-		CryptoPP::VectorSource ss(decoded, true, new CryptoPP::Base64Encoder(new CryptoPP::StringSink(encoded)) );
-		return encoded;
+		return util::base64Encode(decoded.data(), decoded.size(), /*lineBreaks*/ true); // Line broken (like CryptoPP's encoder) so accounts keep the representation they have always had
 	}
 
 	// Function which converts a keypair to a byte array
@@ -105,46 +259,82 @@ namespace key {
 		return out;
 	}
 
+	// Function which loads a tagged Ed25519 key from <source> starting at <offset>
+	template<typename Key>
+	static Key loadEd25519(const std::vector<byte>& source, size_t offset = 0) {
+		Key key;
+		if(source.size() < offset + 1 + key.bytes.size() || source[offset] != ED25519_TAG)
+			throw InvalidKey("Malformed Ed25519 key.");
+		std::copy_n(source.begin() + offset + 1, key.bytes.size(), key.bytes.begin());
+		return key;
+	}
+
 	// Function which converts a byte array to a private key
-	PrivateKey loadPrivate(CryptoPP::VectorSource& source) {
-		PrivateKey key;
-		key.Load(source.Ref());
+	PrivateKey loadPrivate(const std::vector<byte>& source) {
+		if(!source.empty() && source.front() == ED25519_TAG)
+			return loadEd25519<Ed25519PrivateKey>(source);
+
+		ECDSA::PrivateKey key;
+		key.Load(CryptoPP::VectorSource(source, true).Ref());
 		return key;
 	}
 
 	// Function which converts a byte array to a public key
-	PublicKey loadPublic(CryptoPP::VectorSource& source) {
-		PublicKey key;
-		key.Load(source.Ref());
+	PublicKey loadPublic(const std::vector<byte>& source) {
+		if(!source.empty() && source.front() == ED25519_TAG)
+			return loadEd25519<Ed25519PublicKey>(source);
+
+		ECDSA::PublicKey key;
+		key.Load(CryptoPP::VectorSource(source, true).Ref());
 		return key;
 	}
 
 	// Function which loads a public key from a base 64 string
 	PublicKey loadPublicBase64(const std::string& encoded){
-		std::vector<byte> decoded;
-		CryptoPP::StringSource ss(encoded, true, new CryptoPP::Base64Decoder(new CryptoPP::VectorSink(decoded)));
+		std::vector<byte> decoded(kernels::base64DecodedSize(encoded.size()));
+		decoded.resize(kernels::base64Decode(encoded.data(), encoded.size(), decoded.data()));
 
 		return loadPublic(decoded);
 	}
 
-	// Function which signs the provided message
-	std::string signMessage(const PrivateKey& key, const std::string& message) {
-		CryptoPP::AutoSeededRandomPool prng;
-		std::string signature;
+	// Function which converts a byte array (private key followed by public key) to a key pair
+	KeyPair load(const std::vector<byte>& source) {
+		if(!source.empty() && source.front() == ED25519_TAG)
+			return { loadEd25519<Ed25519PrivateKey>(source), loadEd25519<Ed25519PublicKey>(source, 1 + sizeof(Ed25519PrivateKey::bytes)) };
+
+		// ECDSA keys are read one after the other out of the same source
+		CryptoPP::VectorSource vs(source, true);
+		ECDSA::PrivateKey pri;
+		ECDSA::PublicKey pub;
+		pri.Load(vs.Ref());
+		pub.Load(vs.Ref());
+		return { pri, pub };
+	}
 
-		CryptoPP::StringSource(message, true, new CryptoPP::SignerFilter(prng, KeyBase::Signer(key), new CryptoPP::StringSink(signature)));
+	// Function which signs the provided message with a signer
+	static std::string sign(const CryptoPP::PK_Signer& signer, const std::string& message) {
+		std::string signature(signer.MaxSignatureLength(), '\0');
+		signature.resize(signer.SignMessage(rng(), (const byte*) message.data(), message.size(), (byte*) signature.data()));
 		return signature;
 	}
 
-	// Function which confirms that the signature was created from the message with the matching private key
-	bool verifyMessage(const PublicKey& key, const std::string& message, const std::string& signature) {
-		bool result = false;
+	// Function which signs the provided message (creating a one off signer)
+	std::string signMessage(const PrivateKey& key, const std::string& message) {
+		if(auto ecdsa = std::get_if<ECDSA::PrivateKey>(&key))
+			return sign(ECDSA::Signer(*ecdsa), message);
+		return sign(CryptoPP::ed25519Signer(std::get<Ed25519PrivateKey>(key).bytes.data()), message);
+	}
 
-		CryptoPP::StringSource(signature + message, true,
-			new CryptoPP::SignatureVerificationFilter(KeyBase::Verifier(key), new CryptoPP::ArraySink((CryptoPP::byte*)&result, sizeof(result)))
-		);
+	// Function which signs the provided message (using one of the pair's precomputed signers)
+	std::string signMessage(const KeyPair& pair, const std::string& message) {
+		return pair.signers->use([&message](const CryptoPP::PK_Signer& signer) { return sign(signer, message); });
+	}
 
-		return result;
+	// Function which confirms that the signature was created from the message with the matching private key
+	bool verifyMessage(const PublicKey& key, const std::string& message, const std::string& signature) {
+		return verifiersFor(key)->use([&](const CryptoPP::PK_Verifier& verifier) {
+			return verifier.VerifyMessage((const byte*) message.data(), message.size(), (const byte*) signature.data(), signature.size());
+		});
 	}
 
 } // key
@@ -11,6 +11,9 @@
 #ifndef KEYS_HPP
 #define KEYS_HPP
 
+#include <array>
+#include <variant>
+
 #include "utility.hpp"
 #include "cryptopp/eccrypto.h"
 #include <breep/util/serialization.hpp>
@@ -18,22 +21,61 @@
 namespace key {
 	// Key definitions
 	using byte = CryptoPP::byte;
-	// We are using SHA3_256 backed ECC keys
-	using KeyBase = CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA3_256>;
-	using PublicKey = KeyBase::PublicKey;
-	using PrivateKey = KeyBase::PrivateKey;
+	// ECDSA keys are SHA3_256 backed ECC keys
+	using ECDSA = CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA3_256>;
+
+	/**
+	 * @brief The signature schemes an account can use
+	 * @note ECDSA keys are saved as DER (which always starts with a SEQUENCE byte), every other scheme's saved keys start with its tag
+	 */
+	enum class Scheme : uint8_t {
+		ECDSA,
+		Ed25519,
+	};
+
+	// The scheme newly generated accounts use
+	constexpr Scheme DEFAULT_SCHEME = Scheme::Ed25519;
+	// Tag which starts saved Ed25519 keys
+	constexpr byte ED25519_TAG = 0xED;
+
+	// Ed25519 keys are stored as their raw 32 bytes
+	struct Ed25519PublicKey { std::array<byte, 32> bytes; };
+	struct Ed25519PrivateKey { std::array<byte, 32> bytes; };
+
+	// Keys of any scheme (the index of the active alternative matches the Scheme)
+	using PublicKey = std::variant<ECDSA::PublicKey, Ed25519PublicKey>;
+	using PrivateKey = std::variant<ECDSA::PrivateKey, Ed25519PrivateKey>;
+
+	// Functions which determine which scheme a key uses
+	inline Scheme scheme(const PublicKey& key) { return Scheme(key.index()); }
+	inline Scheme scheme(const PrivateKey& key) { return Scheme(key.index()); }
 
 	/**
 	 * @brief Exception thrown when we can't generate/verify a key
 	 */
 	struct InvalidKey : public std::runtime_error { using std::runtime_error::runtime_error; };
 
+	// Functions which convert schemes to and from their names
+	std::string_view name(Scheme scheme);
+	Scheme parseScheme(std::string_view name);
+
+	// Pool of reusable signers (with fixed-base precomputation) for a single private key
+	struct SignerContext;
+
 	/**
 	 * @brief Pair of a public and private key
+	 * @note Copies of a pair share the same signer context, so precomputation is only done once per key
 	 */
 	struct KeyPair {
 		const PrivateKey pri;
 		const PublicKey pub;
+		// Signers reused by every signature made with this pair
+		const std::shared_ptr<SignerContext> signers;
+
+		KeyPair(const PrivateKey& pri, const PublicKey& pub);
+
+		// Function which determines which scheme the pair uses
+		Scheme scheme() const { return key::scheme(pub); }
 
 		// Function which checks if the key pair properly sign and verify eachother
 		bool validate();
@@ -41,6 +83,7 @@ namespace key {
 
 	// Function which generates a private and public key pair
 	KeyPair generateKeyPair(const CryptoPP::OID& oid);
+	KeyPair generateKeyPair(Scheme scheme = DEFAULT_SCHEME);
 
 	// Functions which print out keys
 	void print(const PrivateKey& key);
@@ -59,44 +102,38 @@ namespace key {
 	inline std::string hash(const KeyPair& pair) { return hash(pair.pub); }
 
 	// Functions which convert byte arrays to keys
-	PrivateKey loadPrivate(CryptoPP::VectorSource& source);
-	inline PrivateKey loadPrivate(CryptoPP::VectorSource&& source) { return loadPrivate(source); }
-	inline PrivateKey loadPrivate(const std::vector<byte>& source) { return loadPrivate({source, true}); }
-	inline PrivateKey loadPrivate(const std::vector<byte>&& source) { return loadPrivate({source, true}); }
-	PublicKey loadPublic(CryptoPP::VectorSource& source);
+	PrivateKey loadPrivate(const std::vector<byte>& source);
+	PublicKey loadPublic(const std::vector<byte>& source);
 	PublicKey loadPublicBase64(const std::string& source);
-	inline PublicKey loadPublic(CryptoPP::VectorSource&& source) { return loadPublic(source); }
-	inline PublicKey loadPublic(const std::vector<byte>& source) { return loadPublic({source, true}); }
-	inline PublicKey loadPublic(const std::vector<byte>&& source) { return loadPublic({source, true}); }
-	inline KeyPair load(CryptoPP::VectorSource& source) { return { loadPrivate(source), loadPublic(source) }; }
-	inline KeyPair load(CryptoPP::VectorSource&& source) { return { loadPrivate(source), loadPublic(source) }; }
-	inline KeyPair load(const std::vector<byte>& source) { return load({source, true}); }
-	inline KeyPair load(const std::vector<byte>&& source) { return load({source, true}); }
-
-	// Function which signs a message
+	KeyPair load(const std::vector<byte>& source);
+
+	// Function which signs a message (signing with a key pair reuses its signers, and is much faster than signing with a bare private key)
 	std::string signMessage(const PrivateKey& key, const std::string& message);
-	inline std::string signMessage(const KeyPair& pair, const std::string& message) { return signMessage(pair.pri, message); }
+	std::string signMessage(const KeyPair& pair, const std::string& message);
 	// Function which verifies that the given message is correctly signed
 	bool verifyMessage(const PublicKey& key, const std::string& message, const std::string& signature);
 	inline bool verifyMessage(const KeyPair& pair, const std::string& message, const std::string& signature) { return verifyMessage(pair.pub, message, signature); }
 
 } // key
 
-// De/serialization
+// De/serialization (keys are sent as their scheme followed by the key, ECDSA keys are compressed)
 inline breep::serializer& operator<<(breep::serializer& s, const key::PublicKey& pub) {
-	// Convert the key into decompressed binary and send it
-	std::vector<key::byte> data = key::save(pub);
-	s << util::compress(util::bytes2string(data));
+	std::string data = util::bytes2string(key::save(pub));
+	s << uint8_t(key::scheme(pub)) << (key::scheme(pub) == key::Scheme::ECDSA ? util::compress(data) : data);
 
 	return s;
 }
 inline breep::deserializer& operator>>(breep::deserializer& d, key::PublicKey& pub) {
-	// Read the compressed binary
-	std::string compressed;
-	d >> compressed;
-
-	// Decompress it and load the key from it
-	pub = key::loadPublic(util::string2bytes<key::byte>(util::decompress(compressed)));
+	// Read the scheme and the key
+	uint8_t scheme;
+	std::string data;
+	d >> scheme >> data;
+
+	// Decompress it (if needed) and load the key from it
+	if(key::Scheme(scheme) == key::Scheme::ECDSA) data = util::decompress(data);
+	pub = key::loadPublic(util::string2bytes<key::byte>(data));
+	if(key::scheme(pub) != key::Scheme(scheme))
+		throw key::InvalidKey("Received key doesn't match its advertised scheme.");
 
 	return d;
 }
@@ -0,0 +1,107 @@
+/**
+ * @file keys_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Signing and verification throughput benchmark, comparing signature schemes, one off signers/verifiers against the cached contexts (see keys.hpp), and end to end transaction validation
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "transaction.hpp"
+#include "cryptopp/osrng.h"
+
+/**
+ * @brief Function which runs <f> <iterations> times on each of <threads> threads and prints the throughput
+ *
+ * @param name - The name of the operation (printed)
+ * @param threads - The number of threads to run on
+ * @param iterations - The number of times each thread runs the operation
+ * @param f - The operation to run, returns false on failure
+ * @param operations - How many operations running <f> everywhere amounts to (defaults to one per call)
+ */
+template<typename F>
+void measure(const std::string& name, size_t threads, size_t iterations, F f, size_t operations = 0) {
+	if(!operations) operations = threads * iterations;
+	std::atomic<size_t> failures = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for(size_t t = 0; t < threads; t++)
+		workers.emplace_back([&](){
+			for(size_t i = 0; i < iterations; i++)
+				if(!f()) failures++;
+		});
+	for(auto& worker: workers)
+		worker.join();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << " (" << threads << " threads): " << (operations / elapsed) << " ops/s" << (failures ? " (" + std::to_string(failures) + " failures)" : "") << std::endl;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 4){
+		std::cout << "Usage: " << argv[0] << " [<iterations per thread> = 2000] [<threads> = hardware concurrency] [<transactions> = 2000]" << std::endl;
+		return 1;
+	}
+
+	size_t iterations = argc > 1 ? std::stoul(argv[1]) : 2000;
+	size_t threads = argc > 2 ? std::stoul(argv[2]) : std::max(std::thread::hardware_concurrency(), 1u);
+	size_t transactions = argc > 3 ? std::stoul(argv[3]) : 2000;
+	const std::string message = "The quick brown fox jumps over the lazy dog";
+
+	for(key::Scheme scheme: {key::Scheme::ECDSA, key::Scheme::Ed25519}){
+		key::KeyPair pair = key::generateKeyPair(scheme);
+		const std::string signature = key::signMessage(pair, message);
+		std::string name(key::name(scheme));
+
+		for(size_t t: {size_t(1), threads}){
+			// Baseline: a fresh random pool and signer (or verifier) for every message
+			if(scheme == key::Scheme::ECDSA){
+				measure(name + " sign (one off signer)", t, iterations, [&]{
+					CryptoPP::AutoSeededRandomPool prng;
+					std::string out;
+					CryptoPP::StringSource(message, true, new CryptoPP::SignerFilter(prng, key::ECDSA::Signer(std::get<key::ECDSA::PrivateKey>(pair.pri)), new CryptoPP::StringSink(out)));
+					return !out.empty();
+				});
+				measure(name + " verify (one off verifier)", t, iterations, [&]{
+					key::ECDSA::Verifier verifier(std::get<key::ECDSA::PublicKey>(pair.pub));
+					return verifier.VerifyMessage((const key::byte*) message.data(), message.size(), (const key::byte*) signature.data(), signature.size());
+				});
+			}
+
+			measure(name + " sign (cached context)", t, iterations, [&]{ return !key::signMessage(pair, message).empty(); });
+			measure(name + " verify (cached context)", t, iterations, [&]{ return key::verifyMessage(pair.pub, message, signature); });
+		}
+
+		// End to end ingest: validating (decoding accounts, checking totals, and verifying signatures of) transactions moving money between accounts of this scheme
+		std::vector<key::KeyPair> accounts;
+		for(size_t i = 0; i < 16; i++)
+			accounts.push_back(key::generateKeyPair(scheme));
+		std::vector<std::unique_ptr<Transaction>> batch;
+		for(size_t i = 0; i < transactions; i++){
+			auto& from = accounts[i % accounts.size()];
+			std::vector<Transaction::Output> outputs;
+			outputs.emplace_back(accounts[(i + 1) % accounts.size()].pub, 1);
+			std::vector<Transaction::Input> inputs;
+			inputs.emplace_back(from, 1, i, outputs);
+			batch.push_back(std::make_unique<Transaction>(std::span<Hash>{}, inputs, outputs, 0));
+		}
+
+		std::atomic<size_t> next = 0;
+		measure(name + " ingest (transactions)", threads, 1, [&]{
+			bool good = true;
+			for(size_t i = next++; i < batch.size(); i = next++)
+				good &= batch[i]->validateTransaction();
+			return good;
+		}, batch.size());
+	}
+}
@@ -0,0 +1,134 @@
+/**
+ * @file light_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark comparing the memory and bandwidth of a light node (filtered gossip, see bloom.hpp and NetworkedTangle::enableLightMode) against a full node on a simulated busy network
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <iostream>
+#include <random>
+#include <unordered_set>
+
+#include "bloom.hpp"
+
+// Sizes (in bytes) of the pieces of a transaction as they are sent: a base 64 hash (SHA3-256), a base 64 account (tagged Ed25519 key), and a base 64 signature
+constexpr size_t HASH_BYTES = 44, ACCOUNT_BYTES = 48, SIGNATURE_BYTES = 88;
+// Estimated overhead (in bytes) of keeping a transaction in the tangle (the node's children, metrics, columns, and snapshot entry) on top of its data
+constexpr size_t NODE_OVERHEAD_BYTES = 320;
+
+/**
+ * @brief Parameters of the simulated network
+ */
+struct Network {
+	// Number of accounts transacting, and transactions per second
+	size_t accounts;
+	double tps;
+	// How long to simulate (seconds), and how often full nodes prune (seconds, everything older is collapsed into the genesis)
+	double duration, pruneInterval;
+};
+
+/**
+ * @brief Parameters of a light node (mirroring the LIGHT_* defines in networking.hpp)
+ */
+struct Light {
+	// Number of accounts tracked
+	size_t accounts;
+	double falsePositiveRate = 0.01;
+	size_t tipWindow = 64, history = 256, proofSample = 3;
+	// How often (seconds) tips and proofs are refreshed
+	double refreshInterval = 5;
+};
+
+// Function which estimates the size of a transaction with the given number of inputs/outputs (parents, timestamp, nonce, difficulty, and each input/output's account, amount, and sequence number, plus each input's signature)
+size_t transactionBytes(size_t inputs, size_t outputs) { return 2 * HASH_BYTES + 8 + 8 + 2 + (inputs + outputs) * (ACCOUNT_BYTES + 8 + 8) + inputs * SIGNATURE_BYTES + HASH_BYTES; }
+// Function which estimates the size of the message gossiping a transaction (the transaction, its claimed hash, and the sender's signature)
+size_t gossipBytes(size_t inputs, size_t outputs) { return transactionBytes(inputs, outputs) + HASH_BYTES + SIGNATURE_BYTES; }
+
+/**
+ * @brief Counters describing what a node received and kept
+ */
+struct Result {
+	size_t received = 0, falsePositives = 0, bytesIn = 0, peakMemory = 0;
+};
+
+/**
+ * @brief Function which simulates a full node and a light node on the same stream of transactions
+ *
+ * @param net - The network to simulate
+ * @param light - The light node to simulate
+ * @param seed - Seed for the random transactions
+ * @return std::pair<Result, Result> - What the full node and the light node received and kept
+ */
+std::pair<Result, Result> simulate(const Network& net, const Light& light, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<size_t> pickAccount(0, net.accounts - 1);
+	std::bernoulli_distribution twoOutputs(0.5); // Half of the transactions send change back
+
+	// The light node tracks the first few accounts
+	auto name = [](size_t account) { return "account" + std::to_string(account); };
+	BloomFilter filter(light.accounts, light.falsePositiveRate);
+	for(size_t i = 0; i < light.accounts; i++)
+		filter.insert(name(i));
+
+	Result full, thin;
+	size_t transactions = net.tps * net.duration, perPrune = std::max<size_t>(net.tps * net.pruneInterval, 1), perRefresh = std::max<size_t>(net.tps * light.refreshInterval, 1);
+	size_t fullMemory = 0, history = 0, historyBytes = 0;
+	size_t proofBytes = (size_t(std::log2(net.accounts)) + 1) * HASH_BYTES + ACCOUNT_BYTES + 16 + HASH_BYTES + SIGNATURE_BYTES;
+
+	for(size_t i = 0; i < transactions; i++){
+		size_t outputs = 1 + twoOutputs(rng);
+		std::vector<size_t> touched = {pickAccount(rng)};
+		for(size_t o = 0; o < outputs; o++)
+			touched.push_back(o == 1 ? touched.front() : pickAccount(rng));
+		size_t bytes = gossipBytes(1, outputs);
+
+		// The full node receives and keeps everything (until it prunes)
+		full.received++;
+		full.bytesIn += bytes;
+		fullMemory += transactionBytes(1, outputs) + NODE_OVERHEAD_BYTES;
+		full.peakMemory = std::max(full.peakMemory, fullMemory);
+		if((i + 1) % perPrune == 0) fullMemory = 0;
+
+		// The light node only receives transactions matching its filter, and only keeps those which actually touch its accounts
+		if(std::any_of(touched.begin(), touched.end(), [&](size_t account) { return filter.mayContain(name(account)); })){
+			thin.received++;
+			thin.bytesIn += bytes;
+			if(std::any_of(touched.begin(), touched.end(), [&](size_t account) { return account < light.accounts; })){
+				if(history == light.history) historyBytes -= historyBytes / history;
+				else history++;
+				historyBytes += transactionBytes(1, outputs) + 64; // Transactions are kept in a deque, without a node around them
+			} else thin.falsePositives++;
+		}
+
+		// The light node periodically refreshes its tips and balance proofs from a sample of peers
+		if((i + 1) % perRefresh == 0)
+			thin.bytesIn += light.proofSample * (light.tipWindow * HASH_BYTES + light.accounts * proofBytes);
+		thin.peakMemory = std::max(thin.peakMemory, filter.size() + light.tipWindow * (HASH_BYTES + 32) + historyBytes + light.accounts * (ACCOUNT_BYTES + 64));
+	}
+	return {full, thin};
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 4){
+		std::cout << "Usage: " << argv[0] << " [<accounts> = 10000] [<tps> = 200] [<seconds> = 300]" << std::endl;
+		return 1;
+	}
+
+	Network net{argc > 1 ? std::stoul(argv[1]) : 10000, argc > 2 ? std::stod(argv[2]) : 200, argc > 3 ? std::stod(argv[3]) : 300, 60};
+	std::cout << net.accounts << " accounts, " << net.tps << " tps for " << net.duration << "s (full nodes prune every " << net.pruneInterval << "s)" << std::endl;
+
+	for(size_t tracked: {1, 10, 100}){
+		Light light{tracked};
+		auto [full, thin] = simulate(net, light, 0);
+		std::cout << tracked << " tracked account(s): "
+			<< "full node received " << full.received << " transactions (" << full.bytesIn / 1e6 << " MB), peak memory " << full.peakMemory / 1e6 << " MB; "
+			<< "light node received " << thin.received << " (" << thin.falsePositives << " false positives, " << thin.bytesIn / 1e6 << " MB including refreshes), peak memory " << thin.peakMemory / 1e3 << " KB"
+			<< " (" << full.bytesIn / double(std::max<size_t>(thin.bytesIn, 1)) << "x less bandwidth)" << std::endl;
+	}
+}
@@ -13,15 +13,17 @@
 #include <fstream>
 #include <signal.h>
 
-#include "cryptopp/oids.h"
-#include "networking.hpp"
+#include "daemon.hpp"
+#include "rpc.hpp"
 
-// Bool marking that the handshake thread should shutdown
-bool handshakeThreadShouldRun = true;
 // Pointer to the peer-to-peer network network
 std::unique_ptr<breep::tcp::network> network;
-// Reference to the thread responsible for handshaking
-std::thread handshakeThread;
+// Pointer to the server responsible for handshaking
+std::unique_ptr<handshake::Server> handshakeServer;
+// Pointer to the local RPC server
+std::unique_ptr<rpc::Server> rpcServer;
+// Pointer to the load generator (if enabled)
+std::unique_ptr<LoadGenerator> loadGenerator;
 
 /**
  * @brief Function which loads a keypair from a file
@@ -67,13 +69,24 @@ void saveKeyFile(key::KeyPair& keyPair, std::ofstream& fout){
  * @param signal - The interrupt signal which caused this function to be called 
  */
 void shutdownProcedure(int signal){
-	// Clean up the handshake thread (if started)
-	if(handshakeThread.joinable()){
-		handshakeThreadShouldRun = false;
-		handshakeThread.detach();
+	// Stop the handshake server (if started)
+	if(handshakeServer){
+		handshakeServer->stop();
 		std::cout << "Stopped handshake listener" << std::endl;
 	}
 
+	// Stop the load generator (if started) and report how it did
+	if(loadGenerator){
+		loadGenerator->stop();
+		loadGenerator->printSummary(std::cout);
+	}
+
+	// Stop the RPC server (if started)
+	if(rpcServer){
+		rpcServer->stop();
+		std::cout << "Stopped RPC server" << std::endl;
+	}
+
 	// Disconnect from the network (if connected)
 	if(network){
 		network->disconnect();
@@ -88,9 +101,12 @@ void shutdownProcedure(int signal){
  * @brief Main function
  */
 int main(int argc, char* argv[]) {
-	// If we are given an invalid number of arguments, explain to the user how to use the program
-	if (argc != 1 && argc != 2) {
-		std::cout << "Usage: " << argv[0] << " [<target ip>]" << std::endl;
+	// Parse the command line (and any config files), if we are given invalid arguments explain to the user how to use the program
+	Options options;
+	try {
+		options = Options::parse(argc, argv);
+	} catch (Options::InvalidOption io) {
+		std::cout << io.what() << std::endl << Options::usage(argv[0]);
 		return 1;
 	}
 
@@ -101,21 +117,14 @@ int main(int argc, char* argv[]) {
 
 	// Clean up the network connection and handshake thread if we are force shutdown
 	signal(SIGINT, shutdownProcedure);
+	signal(SIGTERM, shutdownProcedure);
 
-	// Create an IO service used by the handshake algorithm
-	boost::asio::io_service io_service;
-
-
-	// Find an open port for the handshake listener, and create a thread accepting handshakes
-	auto handshakePort = determineLocalPort();
-	boost::asio::ip::tcp::acceptor acceptor(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), handshakePort));
+	// Find an open port for the handshake listener, and start a server answering handshakes
+	auto handshakePort = options.handshakePort ? options.handshakePort : determineLocalPort();
 	// Find another open thread for the networkd
-	unsigned short networkPort = determineLocalPort();
-	handshakeThread = std::thread([&acceptor, &io_service, networkPort](){
-		while(handshakeThreadShouldRun)
-			handshake::acceptHandshakeConnection(acceptor, io_service, networkPort);
-	});
-	std::cout << "Started handshake listener on port " << handshakePort << std::endl;
+	unsigned short networkPort = options.networkPort ? options.networkPort : determineLocalPort(handshakePort + 1);
+	handshakeServer = std::make_unique<handshake::Server>(handshakePort, networkPort);
+	std::cout << "Started handshake listener on port " << handshakeServer->port() << std::endl;
 
 
 	// reate a network listening on the network port we found
@@ -124,16 +133,25 @@ int main(int argc, char* argv[]) {
 	NetworkedTangle t(*network);
 
 
-	// Generate or load a keypair
+	// Generate or load a keypair (only prompting for a path if one wasn't provided and we aren't running as a daemon)
 	{
-		std::cout << "Enter relative path to your key file (blank to generate new account): ";
-		std::string path;
-		std::getline(std::cin, path);
+		std::string path = options.keyPath;
+		if(path.empty() && !options.daemon){
+			std::cout << "Enter relative path to your key file (blank to generate new account): ";
+			std::getline(std::cin, path);
+		}
 
 		std::ifstream fin(path);
 		if(!fin){
-			t.setKeyPair(std::make_shared<key::KeyPair>( key::generateKeyPair(CryptoPP::ASN1::secp160r1()) ), /*networkSync*/ false);
+			t.setKeyPair(std::make_shared<key::KeyPair>( key::generateKeyPair(options.scheme) ), /*networkSync*/ false);
 			std::cout << "Generated new account" << std::endl;
+
+			// If a key path was provided, save the new account there so it is reused next time
+			if(!options.keyPath.empty()){
+				std::ofstream fout(options.keyPath, std::ios::binary);
+				saveKeyFile(*t.personalKeys, fout);
+				std::cout << "Saved account to: " << options.keyPath << std::endl;
+			}
 		} else {
 			t.setKeyPair(std::make_shared<key::KeyPair>( loadKeyFile(fin) ), /*networkSync*/ false);
 			std::cout << "Loaded account stored in: " << path << std::endl;
@@ -141,19 +159,23 @@ int main(int argc, char* argv[]) {
 		fin.close();
 	}
 
+	// Start the RPC server on the loopback interface
+	rpcServer = std::make_unique<rpc::Server>(t, options.rpcPort ? options.rpcPort : determineLocalPort(DEFAULT_RPC_PORT_NUMBER), options.rpcThreads, options.dataDir);
+	std::cout << "Started RPC server on port " << rpcServer->port() << " (auth token written to " << rpcServer->cookiePath() << ")" << std::endl;
+
 
 	// Establish a network if not given an IP to connect to
-	if (argc == 1) {
+	if (options.peer.empty()) {
 		// Runs the network in another thread.
 		network->awake();
 		// Create a keypair for the network
-		std::shared_ptr<key::KeyPair> networkKeys = std::make_shared<key::KeyPair>(key::generateKeyPair(CryptoPP::ASN1::secp160r1()));
+		std::shared_ptr<key::KeyPair> networkKeys = std::make_shared<key::KeyPair>(key::generateKeyPair(options.scheme));
 
-		// Create a genesis which gives the network key "infinate" money
+		// Create a genesis which gives the network key the entire (finite) supply of money
 		std::vector<TransactionNode::const_ptr> parents;
 		std::vector<Transaction::Input> inputs;
 		std::vector<Transaction::Output> outputs;
-		outputs.push_back({networkKeys->pub, std::numeric_limits<double>::max()});
+		outputs.push_back({networkKeys->pub, Amount::supply()});
 		t.setGenesis(TransactionNode::create(parents, inputs, outputs));
 
 		// Add a key response listener that give each key that connects to the network a million money
@@ -165,11 +187,11 @@ int main(int argc, char* argv[]) {
 					if(t.queryBalance(t.peerKeys[source.id()]) == 0){
 						std::cout << "Sending `" << key::hash(t.peerKeys[source.id()]) << "` a million money!" << std::endl;
 
-						std::vector<Transaction::Input> inputs;
-						inputs.emplace_back(*networkKeys, 1000000);
 						std::vector<Transaction::Output> outputs;
 						outputs.emplace_back(t.peerKeys[source.id()], 1000000);
-						t.add(TransactionNode::createAndMine(t, inputs, outputs, 1));
+						std::vector<Transaction::Input> inputs;
+						inputs.emplace_back(*networkKeys, 1000000, t.reserveSequence(*networkKeys), outputs);
+						t.add(TransactionNode::createAndMine(t, inputs, outputs, t.miningDifficulty(inputs, 1)));
 					}
 				} catch (...){}
 			}).detach();
@@ -180,11 +202,11 @@ int main(int argc, char* argv[]) {
 			std::cout << "Sending us a million money!" << std::endl;
 
 			try {
-				std::vector<Transaction::Input> inputs;
-				inputs.emplace_back(*networkKeys, 1000000);
 				std::vector<Transaction::Output> outputs;
 				outputs.emplace_back(*t.personalKeys, 1000000);
-				t.add(TransactionNode::createAndMine(t, inputs, outputs, 1));
+				std::vector<Transaction::Input> inputs;
+				inputs.emplace_back(*networkKeys, 1000000, t.reserveSequence(*networkKeys), outputs);
+				t.add(TransactionNode::createAndMine(t, inputs, outputs, t.miningDifficulty(inputs, 1)));
 			} catch (...){}
 		}).detach();
 
@@ -195,14 +217,23 @@ int main(int argc, char* argv[]) {
 		std::cout << "Attempting to automatically connect to the network..." << std::endl;
 
 		// Find network connection (if we can't quickly find one ask for a manual port number)
-		boost::asio::ip::address address = boost::asio::ip::address::from_string(argv[1]);
-		unsigned short remotePort = handshake::determineRemotePort(io_service, address);
+		boost::asio::ip::address address = boost::asio::ip::address::from_string(options.peer);
+		unsigned short remotePort = options.peerPort;
+		if(!remotePort && options.daemon){
+			// Daemons can't ask for a port, so failing to find one is fatal
+			auto probed = handshake::probeRemotePort(address);
+			if(!probed){
+				std::cout << "Failed to find a network on `" << options.peer << "`" << std::endl;
+				return 2;
+			}
+			remotePort = *probed;
+		} else if(!remotePort) remotePort = handshake::determineRemotePort(address);
 		if(!network->connect(address, remotePort)){ // TODO: Hangs on invalid connection
 			std::cout << "Failed to connect to the network" << std::endl;
 			return 2;
 		}
 
-		std::thread([&t, networkPort](){
+		std::thread([&t, networkPort, light = options.light](){
 			// Wait half a second
 			std::this_thread::sleep_for(std::chrono::milliseconds(100));
 			// Send our public key to the rest of the network
@@ -212,11 +243,53 @@ int main(int argc, char* argv[]) {
 			std::this_thread::sleep_for(std::chrono::milliseconds(100));
 			std::cout << "Connected to the network (listening on port " << networkPort << ")" << std::endl;
 
-			// If we are a client... ask the network to vote on our new genesis
-			network->send_object(NetworkedTangle::GenesisVoteRequest(t));
+			// If we are a client... ask (a sample of) the network to vote on our new genesis, and sync it
+			if(!light) return t.join();
+
+			// If we are a light client... subscribe to our account's transactions (instead of syncing the tangle), and periodically refresh our tips and balance proofs
+			t.enableLightMode();
+			while(true){
+				std::this_thread::sleep_for(std::chrono::milliseconds(LIGHT_REFRESH_INTERVAL));
+				t.refreshLightState();
+			}
+		}).detach();
+	}
+
+
+	// Periodically prune the tangle (if requested)
+	if(options.pruneInterval)
+		std::thread([&t, interval = options.pruneInterval](){
+			while(true){
+				std::this_thread::sleep_for(std::chrono::seconds(interval));
+				try {
+					t.prune();
+				} catch (std::exception& e) {
+					std::cerr << "Failed to prune the tangle: " << e.what() << std::endl;
+				}
+			}
 		}).detach();
+
+	// Periodically let the minimum difficulty fall back (and advertise it) while transactions aren't arriving
+	std::thread([&t](){
+		while(true){
+			std::this_thread::sleep_for(std::chrono::milliseconds(DIFFICULTY_REFRESH_INTERVAL));
+			t.refreshDifficulty();
+		}
+	}).detach();
+
+	// Start generating load (if requested)
+	if(options.loadTPS > 0){
+		loadGenerator = std::make_unique<LoadGenerator>(t, options);
+		loadGenerator->start();
+		std::cout << "Started load generator targeting " << options.loadTPS << " transactions per second" << std::endl;
 	}
 
+	// When running as a daemon, skip the menu and wait until the load generator finishes (or we are signaled to stop)
+	if(options.daemon){
+		while(!loadGenerator || !loadGenerator->finished())
+			std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		shutdownProcedure(0);
+	}
 
 	// Explain how to get to help message
 	std::cout << "Press `h` for additional instruction" << std::endl;
@@ -228,7 +301,12 @@ int main(int argc, char* argv[]) {
 		switch(cmd){
 		// Query our balance
 		case 'b':
-			{
+			if(t.isLight()){
+				auto balance = t.lightBalance(key::saveBase64(t.personalKeys->pub));
+				std::cout << "Our (Account = " << key::hash(*t.personalKeys) << ") proven balance is: ";
+				if(balance) std::cout << balance->amount << std::endl;
+				else std::cout << "unknown (no proof has been agreed on yet)" << std::endl;
+			} else {
 				std::cout << "Our (Account = " << key::hash(*t.personalKeys) << ") balance is: " << t.queryBalance(t.personalKeys->pub) << "(0%) " << t.queryBalance(t.personalKeys->pub, .5) << "(50%) " <<  t.queryBalance(t.personalKeys->pub, .95) << "(95%)"<< std::endl;
 			}
 			break;
@@ -308,7 +386,7 @@ int main(int argc, char* argv[]) {
 
 				// Generate new key pair
 				if(cmd == 'g'){
-					auto keyPair = std::make_shared<key::KeyPair>( key::generateKeyPair(CryptoPP::ASN1::secp160r1()) );
+					auto keyPair = std::make_shared<key::KeyPair>( key::generateKeyPair(options.scheme) );
 					keyPair->validate();
 
 					// Update our key and send it to the rest of the network
@@ -361,8 +439,11 @@ int main(int argc, char* argv[]) {
 				// Otherwise add a new listerner to ping transactions
 				} else {
 					pingingID = network->add_data_listener<NetworkedTangle::AddTransactionRequest>([&t] (breep::tcp::netdata_wrapper<NetworkedTangle::AddTransactionRequest>& dw) -> void {
+						// Ignore transactions which weren't admitted (they are only unpacked once admitted)
+						if(!dw.data.unpacked()) return;
+
 						// Calculate how much we recieved from this transaction
-						double recieved = 0;
+						Amount recieved = 0;
 						for(const Transaction::Output& output: dw.data.transaction.outputs)
 							recieved += output.amount;
 
@@ -383,16 +464,18 @@ int main(int argc, char* argv[]) {
 
 									try{
 										// Create transaction inputs and outputs
-										std::vector<Transaction::Input> inputs;
-										inputs.emplace_back(*t.personalKeys, recieved);
 										std::vector<Transaction::Output> outputs;
 										outputs.emplace_back(account, recieved);
+										std::vector<Transaction::Input> inputs;
+										inputs.emplace_back(*t.personalKeys, recieved, t.reserveSequence(*t.personalKeys), outputs);
 
 										// Create, mine, and add the transaction
 										std::cout << "Pinging " << recieved << " money"/*to " << key::hash(account)*/ << std::endl;
-										t.add(TransactionNode::createAndMine(t, inputs, outputs, /*difficulty*/ 3));
+										t.add(TransactionNode::createAndMine(t, inputs, outputs, t.miningDifficulty(inputs, /*difficulty*/ 3)));
 									} catch (Tangle::InvalidBalance ib) {
 										std::cerr << ib.what() << " Discarding transaction!" << std::endl;
+									} catch (Tangle::InvalidSequence is) {
+										std::cerr << is.what() << " Discarding transaction!" << std::endl;
 									} catch (NetworkedTangle::InvalidAccount ia) {
 										std::cerr << ia.what() << " Discarding transaction!" << std::endl;
 									}
@@ -469,12 +552,12 @@ int main(int argc, char* argv[]) {
 				// Ask who to send too, how much to send, and how much effort to put into mining
 				std::string accountHash;
 				uint difficulty;
-				double amount;
+				Amount amount;
 				std::cout << "Enter account to transfer to ('r' for random): ";
 				std::cin >> accountHash;
 				std::cout << "Enter amount to transfer: ";
 				std::cin >> amount;
-				std::cout << "Select mining difficulty (1-5): ";
+				std::cout << "Select mining difficulty (" << int(t.networkDifficulty()) << "-5, lower difficulties are raised to what the network accepts): ";
 				std::cin >> difficulty;
 
 				// If they asked for random choose a random account
@@ -492,18 +575,23 @@ int main(int argc, char* argv[]) {
 
 				try{
 					// Create transaction inputs and outputs
-					std::vector<Transaction::Input> inputs;
-					inputs.emplace_back(*t.personalKeys, amount);
 					std::vector<Transaction::Output> outputs;
 					outputs.emplace_back(t.findAccount(accountHash), amount);
+					std::vector<Transaction::Input> inputs;
+					inputs.emplace_back(*t.personalKeys, amount, t.isLight() ? t.reserveLightSequence(key::saveBase64(t.personalKeys->pub)) : t.reserveSequence(*t.personalKeys), outputs);
 
 					// Create, mine, and add the transaction
 					std::cout << "Sending " << amount << " money to " << accountHash << std::endl;
-					t.add(TransactionNode::createAndMine(t, inputs, outputs, difficulty));
+					if(t.isLight()) t.addLight(inputs, outputs, difficulty);
+					else t.add(TransactionNode::createAndMine(t, inputs, outputs, t.miningDifficulty(inputs, difficulty)));
 				} catch (Tangle::InvalidBalance ib) {
 					std::cerr << ib.what() << " Discarding transaction!" << std::endl;
+				} catch (Tangle::InvalidSequence is) {
+					std::cerr << is.what() << " Discarding transaction!" << std::endl;
 				} catch (NetworkedTangle::InvalidAccount ia) {
 					std::cerr << ia.what() << " Discarding transaction!" << std::endl;
+				} catch (std::runtime_error& e) {
+					std::cerr << e.what() << " Discarding transaction!" << std::endl;
 				}
 			}
 			break;
@@ -0,0 +1,284 @@
+/**
+ * @file merkle.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides an authenticated (sparse Merkle tree) store of account balances, with compact inclusion proofs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef MERKLE_HPP
+#define MERKLE_HPP
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "transaction.hpp"
+
+namespace merkle {
+	// Hash of an empty subtree
+	inline const std::string& emptyHash() {
+		static const std::string empty = util::hash("empty");
+		return empty;
+	}
+	// Function which calculates the hash of an interior node from the hashes of its children
+	inline Hash combine(const std::string& left, const std::string& right) { return util::hash("node:" + left + right); }
+
+	/**
+	 * @brief Function which decodes a base 64 hash into raw bytes (an account's path through the tree)
+	 *
+	 * @param base64 - The hash to decode
+	 * @return std::string - The raw bytes of the hash
+	 */
+	inline std::string decode(const std::string& base64) {
+		std::string out;
+		uint32_t bits = 0, count = 0;
+		for(char c: base64){
+			if(c == '=') break;
+			uint32_t value = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 : c >= '0' && c <= '9' ? c - '0' + 52 : c == '+' ? 62 : 63;
+			bits = (bits << 6) | value;
+			if((count += 6) >= 8){
+				count -= 8;
+				out.push_back(char(bits >> count));
+				bits &= (1u << count) - 1;
+			}
+		}
+		return out;
+	}
+
+	// Function which gets the bit of a <key> at the given <depth> in the tree (0 goes left, 1 goes right)
+	inline bool bit(const std::string& key, size_t depth) { return (uint8_t(key[depth / 8]) >> (7 - depth % 8)) & 1; }
+
+	// Function which counts how many leading bits two keys share
+	inline size_t commonBits(const std::string& a, const std::string& b) {
+		size_t i = 0, size = std::min(a.size(), b.size());
+		while(i < size && a[i] == b[i]) i++;
+		if(i == size) return 8 * size;
+		return 8 * i + __builtin_clz(uint32_t(uint8_t(a[i] ^ b[i]))) - 24;
+	}
+
+	/**
+	 * @brief The balance and next sequence number of an account (a leaf of the tree)
+	 */
+	struct Balance {
+		// The base 64 representation of the account's key
+		std::string account;
+		// The account's path through the tree (derived from the account)
+		std::string key;
+		// The account's balance
+		Amount amount;
+		// The next sequence number the account is allowed to spend
+		uint64_t sequence = 0;
+
+		Balance() = default;
+		Balance(const std::string& account, Amount amount = {}, uint64_t sequence = 0) : account(account), key(decode(util::hash(account))), amount(amount), sequence(sequence) {}
+		Balance(const Transaction::Output& output) : Balance(output.accountBase64(), output.amount, output.sequence) {}
+
+		// Function which calculates the leaf's hash (committing to where it is in the tree as well as its contents)
+		Hash hash() const { return util::hash("leaf:" + key + account + ":" + std::to_string(amount.raw) + ":" + std::to_string(sequence)); }
+		// Function which checks if the balance holds no information (such leaves are left out of the tree)
+		bool empty() const { return amount.raw == 0 && sequence == 0; }
+	};
+
+	/**
+	 * @brief Sparse Merkle tree over account balances
+	 * @note The tree is a (256 level) binary trie over the hashes of the accounts, where subtrees holding a single leaf are collapsed into that leaf
+	 * 	and empty subtrees hash to a constant, so proofs are only as long as the number of levels needed to separate an account from its neighbors (about log2 of the number of accounts)
+	 * @note Interior hashes are cached and only the path through a changed leaf is invalidated, so updates are incremental
+	 */
+	class AccountTree {
+	public:
+		/**
+		 * @brief Proof that an account has (or doesn't have) a balance in the tree
+		 */
+		struct Proof {
+			// The hashes of the siblings along the account's path (from the root down)
+			std::vector<std::string> siblings;
+			// The leaf the path ends at (the account's own balance if it is in the tree, another account sharing the path, or nothing)
+			std::optional<Balance> leaf;
+
+			// Function which checks if the proof shows the account is in the tree
+			bool includes(const std::string& account) const { return leaf && leaf->account == account; }
+		};
+
+		AccountTree() = default;
+		/**
+		 * @brief Creates a tree from the outputs of a genesis (each holding an account's balance and next sequence number)
+		 *
+		 * @param balances - The outputs to fill the tree with
+		 */
+		AccountTree(const std::vector<Transaction::Output>& balances) {
+			for(auto& balance: balances)
+				set(Balance(balance));
+		}
+
+		// The number of accounts in the tree
+		size_t size() const { return leaves.size(); }
+
+		/**
+		 * @brief Function which gets the balance of an account
+		 *
+		 * @param account - The base 64 representation of the account's key
+		 * @return Balance - The account's balance (empty if it isn't in the tree)
+		 */
+		Balance get(const std::string& account) const {
+			Balance balance(account);
+			if(auto leaf = leaves.find(balance.key); leaf != leaves.end())
+				return leaf->second;
+			return balance;
+		}
+
+		/**
+		 * @brief Function which updates the balance of an account (removing it from the tree if the balance is empty)
+		 *
+		 * @param balance - The new balance
+		 */
+		void set(const Balance& balance) {
+			auto leaf = leaves.find(balance.key);
+			if(leaf != leaves.end()) invalidate(balance.key);
+
+			if(balance.empty()){
+				if(leaf != leaves.end()) leaves.erase(leaf);
+			} else {
+				leaves.insert_or_assign(balance.key, balance);
+				invalidate(balance.key);
+			}
+		}
+
+		/**
+		 * @brief Function which applies the balance changes (and spent sequence numbers) of a transaction to the tree
+		 *
+		 * @param transaction - The (confirmed, non-genesis) transaction to apply
+		 */
+		void apply(const Transaction& transaction) {
+			for(auto& input: transaction.inputs){
+				auto balance = get(input.accountBase64());
+				balance.amount -= input.amount;
+				balance.sequence = std::max(balance.sequence, input.sequence + 1);
+				set(balance);
+			}
+			for(auto& output: transaction.outputs){
+				auto balance = get(output.accountBase64());
+				balance.amount += output.amount;
+				set(balance);
+			}
+		}
+
+		// Function which calculates the root of the tree (the commitment to every balance)
+		Hash root() const { return hash(leaves.begin(), leaves.end(), 0); }
+
+		/**
+		 * @brief Function which creates a proof of an account's balance (or that it has no balance)
+		 *
+		 * @param account - The base 64 representation of the account's key
+		 * @return Proof - The proof
+		 */
+		Proof prove(const std::string& account) const {
+			std::string key = decode(util::hash(account));
+			Proof proof;
+
+			// Walk down the account's path until the subtree holds at most one leaf
+			auto lo = leaves.begin(), hi = leaves.end();
+			for(size_t depth = 0; lo != hi && std::next(lo) != hi; depth++){
+				auto mid = split(key, depth);
+				if(bit(key, depth)){
+					proof.siblings.push_back(hash(lo, mid, depth + 1));
+					lo = mid;
+				} else {
+					proof.siblings.push_back(hash(mid, hi, depth + 1));
+					hi = mid;
+				}
+			}
+
+			if(lo != hi) proof.leaf = lo->second;
+			return proof;
+		}
+
+		/**
+		 * @brief Function which checks a proof against a root
+		 * @note Use Proof::includes to tell if the (verified) proof shows the account is in the tree
+		 *
+		 * @param root - The root the proof should lead to
+		 * @param account - The base 64 representation of the account's key
+		 * @param proof - The proof to check
+		 * @return bool - True if the proof is valid, false otherwise
+		 */
+		static bool verify(const std::string& root, const std::string& account, const Proof& proof) {
+			std::string key = decode(util::hash(account));
+			if(proof.siblings.size() > 8 * key.size()) return false;
+
+			std::string current = emptyHash();
+			if(proof.leaf){
+				// The leaf must actually sit on the account's path (its key is recomputed so it can't be forged)
+				Balance leaf(proof.leaf->account, proof.leaf->amount, proof.leaf->sequence);
+				if(commonBits(leaf.key, key) < proof.siblings.size()) return false;
+				current = leaf.hash();
+			}
+
+			// Fold the siblings back up to the root
+			for(size_t depth = proof.siblings.size(); depth-- > 0; )
+				current = bit(key, depth) ? combine(proof.siblings[depth], current) : combine(current, proof.siblings[depth]);
+			return current == root;
+		}
+
+	protected:
+		// The leaves of the tree, ordered by their path
+		using Leaves = std::map<std::string, Balance>;
+		Leaves leaves;
+		// Cache of the hashes of interior nodes, keyed by their depth and path
+		mutable std::unordered_map<std::string, std::string> cache;
+
+		// Function which creates the cache key for the node at <depth> along the <key>'s path
+		static std::string prefix(const std::string& key, size_t depth) {
+			std::string out = std::to_string(depth) + ":" + key.substr(0, (depth + 7) / 8);
+			if(depth % 8) out.back() &= char(0xFF << (8 - depth % 8));
+			return out;
+		}
+
+		// Function which finds the first leaf (sharing the <key>'s path down to <depth>) which goes right at <depth>
+		Leaves::const_iterator split(const std::string& key, size_t depth) const {
+			std::string probe = key;
+			probe[depth / 8] = char((uint8_t(probe[depth / 8]) & (0xFF << (8 - depth % 8))) | (0x80 >> (depth % 8)));
+			std::fill(probe.begin() + depth / 8 + 1, probe.end(), 0);
+			return leaves.lower_bound(probe);
+		}
+
+		// Function which calculates the hash of the subtree at <depth> holding the leaves [lo, hi)
+		Hash hash(Leaves::const_iterator lo, Leaves::const_iterator hi, size_t depth) const {
+			if(lo == hi) return emptyHash();
+			if(std::next(lo) == hi) return lo->second.hash();
+
+			auto id = prefix(lo->first, depth);
+			if(auto cached = cache.find(id); cached != cache.end())
+				return cached->second;
+
+			auto mid = split(lo->first, depth);
+			return cache[id] = combine(hash(lo, mid, depth + 1), hash(mid, hi, depth + 1));
+		}
+
+		// Function which invalidates the cached hashes along a (present) leaf's path (only subtrees holding it and a neighbor are cached)
+		void invalidate(const std::string& key) {
+			auto leaf = leaves.find(key);
+			size_t shared = 0;
+			if(leaf != leaves.begin()) shared = std::max(shared, commonBits(key, std::prev(leaf)->first));
+			if(std::next(leaf) != leaves.end()) shared = std::max(shared, commonBits(key, std::next(leaf)->first));
+
+			for(size_t depth = 0; depth <= shared; depth++)
+				cache.erase(prefix(key, depth));
+		}
+	};
+
+	/**
+	 * @brief Function which calculates the commitment to a set of account balances
+	 *
+	 * @param balances - Genesis outputs holding each account's balance and next sequence number
+	 * @return Hash - The commitment (the root of the tree holding the balances)
+	 */
+	inline Hash commit(const std::vector<Transaction::Output>& balances) { return AccountTree(balances).root(); }
+}
+
+#endif /* end of include guard: MERKLE_HPP */
@@ -4,26 +4,92 @@
  * @brief File which provides a thread safe wrapper around arbitrary data
  * @version 0.1
  * @date 2021-11-29
- * 
+ *
  * @copyright Copyright (c) 2021
- * 
+ *
  */
 #ifndef MONITOR_HPP
 #define MONITOR_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <thread>
+#include <type_traits>
+
+/**
+ * @brief Reader-biased spinning reader/writer lock (meets the SharedMutex requirements)
+ * @note Readers only wait while a writer holds the lock, writers wait until there are no readers. Waiters spin briefly then yield, so it is only a good fit for very short critical sections
+ */
+class spin_shared_mutex {
+	// Bit marking that a writer holds the lock, the rest of the state counts readers
+	static constexpr uint32_t WRITER = 1;
+	static constexpr uint32_t READER = 2;
+	// How many times a waiter spins before yielding its time slice
+	static constexpr size_t SPINS_BEFORE_YIELD = 64;
+
+	std::atomic<uint32_t> state = 0;
+
+	static void backoff(size_t& spins) {
+		if(++spins < SPINS_BEFORE_YIELD) {
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#endif
+		} else std::this_thread::yield();
+	}
+
+public:
+	bool try_lock() {
+		uint32_t expected = 0;
+		return state.compare_exchange_strong(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+	void lock() {
+		for(size_t spins = 0; !try_lock(); backoff(spins))
+			while(state.load(std::memory_order_relaxed) != 0) backoff(spins);
+	}
+	void unlock() { state.fetch_and(~WRITER, std::memory_order_release); }
+
+	bool try_lock_shared() {
+		// Optimistically register as a reader, backing out if a writer holds the lock
+		if(!(state.fetch_add(READER, std::memory_order_acquire) & WRITER)) return true;
+		state.fetch_sub(READER, std::memory_order_relaxed);
+		return false;
+	}
+	void lock_shared() {
+		for(size_t spins = 0; !try_lock_shared(); backoff(spins))
+			while(state.load(std::memory_order_relaxed) & WRITER) backoff(spins);
+	}
+	void unlock_shared() { state.fetch_sub(READER, std::memory_order_release); }
+};
+
+/**
+ * @brief Locking policies a monitor can use
+ */
+namespace monitor_policy {
+	// Readers and writers share a std::shared_mutex (the default)
+	struct Shared { using Mutex = std::shared_mutex; };
+	// Readers and writers share a spinning reader-biased lock (for very short critical sections)
+	struct Spin { using Mutex = spin_shared_mutex; };
+	// Readers take a consistent copy without ever blocking writers (for small trivially copyable data)
+	struct SeqLock {};
+	// Readers hold an immutable snapshot, writers modify a copy which is published when they finish (for read-mostly containers)
+	struct RCU {};
+}
 
 /**
  * @brief Class that provides some thread safe wrappers around other types
  * @note Modified from https://stackoverflow.com/questions/12647217/making-a-c-class-a-monitor-in-the-concurrent-sense/48408987#48408987
  *
  * @tparam T - The type this monitor guards
- * @tparam Mutex - The mutex the locks the data
- * @tparam LockingMutex - The mutex that locks, un/locking
+ * @tparam Policy - How access to the data is synchronized (see monitor_policy)
  */
-template<class T, typename Mutex = std::shared_mutex, typename LockingMutex = std::recursive_mutex>
+template<class T, typename Policy = monitor_policy::Shared>
 class monitor {
+	using Mutex = typename Policy::Mutex;
+
 	/**
 	 * @brief Base class that provides pointer type access to locked data
 	 */
@@ -48,8 +114,6 @@ private:
 	T data;
 	// Data mutex
 	mutable Mutex mutex;
-	// Un/locking mutex
-	mutable LockingMutex lockingMutex;
 
 public:
 	// Construction is forwarded to the wrapped type
@@ -79,23 +143,11 @@ public:
 	};
 
 	// Return a write locked pointer to the underlying data
-	monitor_helper_unique write_lock() {
-		std::scoped_lock lock(lockingMutex);
-		return monitor_helper_unique(this);
-	}
-	const monitor_helper_unique write_lock() const {
-		std::scoped_lock lock(lockingMutex);
-		return monitor_helper_unique(this);
-	}
+	monitor_helper_unique write_lock() { return monitor_helper_unique(this); }
+	const monitor_helper_unique write_lock() const { return monitor_helper_unique(this); }
 	// Return a read locked pointer to the underlying data
-	monitor_helper_shared read_lock() {
-		std::scoped_lock lock(lockingMutex);
-		return monitor_helper_shared(this);
-	}
-	const monitor_helper_shared read_lock() const {
-		std::scoped_lock lock(lockingMutex);
-		return monitor_helper_shared(this);
-	}
+	monitor_helper_shared read_lock() { return monitor_helper_shared(this); }
+	const monitor_helper_shared read_lock() const { return monitor_helper_shared(this); }
 	// Return an unsafe (no lock) reference to the underlying data
 	T& unsafe() { return data; }
 	const T& unsafe() const { return data; }
@@ -105,4 +157,167 @@ public:
 	const monitor_helper_shared operator->() const { return read_lock(); }	// If we can't change the data return a read lock
 };
 
+/**
+ * @brief Monitor where readers take a consistent copy of the data, retrying if a writer changed it while they were copying
+ * @note Readers never block (or slow down) writers, writers are serialized by a mutex. The data is stored as atomic words so the racing copy is well defined
+ *
+ * @tparam T - The (trivially copyable) type this monitor guards
+ */
+template<class T>
+class monitor<T, monitor_policy::SeqLock> {
+	static_assert(std::is_trivially_copyable_v<T>, "SeqLock monitors can only guard trivially copyable data");
+
+	// Number of words the data is stored in
+	static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	// The wrapped data (split into words)
+	std::atomic<uint64_t> words[WORDS];
+	// Sequence number, odd while a write is in progress
+	mutable std::atomic<uint64_t> sequence = 0;
+	// Mutex serializing writers
+	mutable std::mutex writerMutex;
+
+	// Function which copies the words into a value (the copy may be torn, callers validate it with the sequence)
+	T copy() const {
+		uint64_t buffer[WORDS];
+		for(size_t i = 0; i < WORDS; i++)
+			buffer[i] = words[i].load(std::memory_order_relaxed);
+		T out;
+		std::memcpy(&out, buffer, sizeof(T));
+		return out;
+	}
+
+	// Function which stores a value into the words (the caller must hold the writer mutex)
+	void store(const T& value) {
+		uint64_t buffer[WORDS] = {};
+		std::memcpy(buffer, &value, sizeof(T));
+
+		sequence.fetch_add(1, std::memory_order_relaxed); // Odd: write in progress
+		std::atomic_thread_fence(std::memory_order_release);
+		for(size_t i = 0; i < WORDS; i++)
+			words[i].store(buffer[i], std::memory_order_relaxed);
+		sequence.fetch_add(1, std::memory_order_release); // Even: write finished
+	}
+
+public:
+	// Construction is forwarded to the wrapped type
+	template<typename ...Args>
+	monitor(Args&&... args) {
+		for(auto& word: words) word.store(0, std::memory_order_relaxed);
+		store(T(std::forward<Args>(args)...));
+	}
+
+	/**
+	 * @brief Function which takes a consistent copy of the data
+	 *
+	 * @return T - The copy
+	 */
+	T load() const {
+		while(true){
+			uint64_t before = sequence.load(std::memory_order_acquire);
+			// A write is in progress... give the writer a chance to finish
+			if(before & 1){
+				std::this_thread::yield();
+				continue;
+			}
+
+			T out = copy();
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(sequence.load(std::memory_order_relaxed) == before)
+				return out;
+		}
+	}
+
+	/**
+	 * @brief A pointer type wrapper around a consistent copy of the data
+	 */
+	struct monitor_helper_shared {
+		const T value;
+
+		const T* operator->() const { return &value; }
+		const T& operator*() const { return value; }
+	};
+
+	/**
+	 * @brief A pointer type wrapper which holds the writer lock, changes are made to a copy which is stored when the wrapper is destroyed
+	 */
+	struct monitor_helper_unique {
+		monitor* const creator;
+		std::unique_lock<std::mutex> lock;
+		T value;
+
+		monitor_helper_unique(monitor* creator) : creator(creator), lock(creator->writerMutex), value(creator->copy()) {}
+		~monitor_helper_unique() { creator->store(value); }
+
+		T* operator->() { return &value; }
+		T& operator*() { return value; }
+	};
+
+	// Return a write locked pointer to (a copy of) the underlying data
+	monitor_helper_unique write_lock() { return monitor_helper_unique(this); }
+	// Return a pointer to a consistent copy of the underlying data
+	const monitor_helper_shared read_lock() const { return {load()}; }
+
+	// Call a function or access a member of the base type directly
+	monitor_helper_unique operator->() { return write_lock(); }				// If we might change the data return a write lock
+	const monitor_helper_shared operator->() const { return read_lock(); }	// If we can't change the data return a copy
+};
+
+/**
+ * @brief Monitor where readers hold an immutable snapshot of the data, and writers publish a modified copy (read-copy-update)
+ * @note Reads are wait-free with respect to writers (a reader keeps its snapshot alive for as long as it holds it), writers are serialized by a mutex and pay for a copy of the data
+ *
+ * @tparam T - The type this monitor guards
+ */
+template<class T>
+class monitor<T, monitor_policy::RCU> {
+	// The currently published data
+	std::atomic<std::shared_ptr<const T>> current;
+	// Mutex serializing writers
+	mutable std::mutex writerMutex;
+
+public:
+	// Construction is forwarded to the wrapped type
+	template<typename ...Args>
+	monitor(Args&&... args) : current(std::make_shared<const T>(std::forward<Args>(args)...)) { }
+
+	/**
+	 * @brief A pointer type wrapper around an immutable snapshot of the data
+	 */
+	struct monitor_helper_shared {
+		std::shared_ptr<const T> snapshot;
+
+		const T* operator->() const { return snapshot.get(); }
+		const T& operator*() const { return *snapshot; }
+		template<typename _T> const auto& operator[](_T&& index) const { return (*snapshot)[index]; }
+	};
+
+	/**
+	 * @brief A pointer type wrapper which holds the writer lock, changes are made to a copy which is published when the wrapper is destroyed
+	 */
+	struct monitor_helper_unique {
+		monitor* const creator;
+		std::unique_lock<std::mutex> lock;
+		std::shared_ptr<T> copy;
+
+		monitor_helper_unique(monitor* creator) : creator(creator), lock(creator->writerMutex), copy(std::make_shared<T>(*creator->current.load(std::memory_order_acquire))) {}
+		~monitor_helper_unique() { creator->current.store(std::move(copy), std::memory_order_release); }
+
+		T* operator->() { return copy.get(); }
+		T& operator*() { return *copy; }
+		template<typename _T> auto& operator[](_T&& index) { return (*copy)[index]; }
+	};
+
+	// Return a write locked pointer to (a copy of) the underlying data
+	monitor_helper_unique write_lock() { return monitor_helper_unique(this); }
+	// Return a pointer to an immutable snapshot of the underlying data
+	const monitor_helper_shared read_lock() const { return {current.load(std::memory_order_acquire)}; }
+	// Return the current snapshot directly (it stays valid, and unchanged, for as long as it is held)
+	std::shared_ptr<const T> snapshot() const { return current.load(std::memory_order_acquire); }
+
+	// Call a function or access a member of the base type directly
+	monitor_helper_unique operator->() { return write_lock(); }				// If we might change the data publish a new copy
+	const monitor_helper_shared operator->() const { return read_lock(); }	// If we can't change the data return a snapshot
+};
+
 #endif /* end of include guard: MONITOR_HPP */
@@ -0,0 +1,159 @@
+/**
+ * @file monitor_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark comparing the monitor locking policies (see monitor.hpp) across read/write ratios, on data shaped like a node's children, the tangle's tips, and a small block of node metrics
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "monitor.hpp"
+
+/**
+ * @brief The monitor as it used to be: an outer recursive mutex taken just to hand out the shared mutex lock
+ * @note Kept as a baseline to compare the policies against
+ */
+template<typename T>
+struct LegacyMonitor {
+	monitor<T> inner;
+	std::recursive_mutex lockingMutex;
+
+	auto write_lock() { std::scoped_lock lock(lockingMutex); return inner.write_lock(); }
+	auto read_lock() { std::scoped_lock lock(lockingMutex); return inner.read_lock(); }
+};
+
+// Small trivially copyable block of data (like a node's weight, height, and confidence)
+struct Metrics {
+	uint64_t cumulativeWeight, height;
+	double confidence;
+	uint64_t epoch;
+};
+
+/**
+ * @brief Function which runs a mix of reads and writes against a monitor on several threads
+ *
+ * @param threads - Number of threads accessing the monitor
+ * @param operations - Number of operations each thread performs
+ * @param readPercent - Percentage of operations which are reads
+ * @param read - Function performing a read, returns a value which is accumulated (so the read isn't optimized away)
+ * @param write - Function performing a write
+ * @return double - Operations per second
+ */
+template<typename Read, typename Write>
+double run(size_t threads, size_t operations, unsigned readPercent, Read read, Write write) {
+	std::atomic<size_t> sink = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for(size_t t = 0; t < threads; t++)
+		workers.emplace_back([&, t](){
+			std::mt19937 rng(t);
+			std::uniform_int_distribution<unsigned> percent(0, 99);
+			size_t local = 0;
+			for(size_t i = 0; i < operations; i++)
+				if(percent(rng) < readPercent) local += read();
+				else write(i);
+			sink += local;
+		});
+	for(auto& worker: workers)
+		worker.join();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return threads * operations / elapsed;
+}
+
+/**
+ * @brief Function which benchmarks a list of nodes guarded by a monitor (readers walk the list, writers append to it and occasionally clear it)
+ *
+ * @param m - The monitor to benchmark
+ * @param threads - Number of threads accessing the monitor
+ * @param operations - Number of operations each thread performs
+ * @param readPercent - Percentage of operations which are reads
+ * @param maxSize - Size the list is cleared at (children lists are short, tip lists are somewhat longer)
+ * @return double - Operations per second
+ */
+template<typename Monitor>
+double runList(Monitor& m, size_t threads, size_t operations, unsigned readPercent, size_t maxSize) {
+	return run(threads, operations, readPercent, [&]{
+		size_t sum = 0;
+		auto lock = m.read_lock();
+		for(auto& node: *lock) sum += *node;
+		return sum;
+	}, [&](size_t i){
+		auto lock = m.write_lock();
+		if(lock->size() >= maxSize) lock->clear();
+		lock->push_back(std::make_shared<size_t>(i));
+	});
+}
+
+/**
+ * @brief Function which benchmarks a block of metrics guarded by a monitor (readers combine the fields, writers bump them)
+ *
+ * @param m - The monitor to benchmark
+ * @param threads - Number of threads accessing the monitor
+ * @param operations - Number of operations each thread performs
+ * @param readPercent - Percentage of operations which are reads
+ * @return double - Operations per second
+ */
+template<typename Monitor>
+double runMetrics(Monitor& m, size_t threads, size_t operations, unsigned readPercent) {
+	return run(threads, operations, readPercent, [&]{
+		auto lock = m.read_lock();
+		return size_t(lock->cumulativeWeight + lock->height + lock->confidence + lock->epoch);
+	}, [&](size_t i){
+		auto lock = m.write_lock();
+		lock->cumulativeWeight++;
+		lock->height = i;
+		lock->confidence = 1.0 / (i + 1);
+		lock->epoch++;
+	});
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<operations per thread> = 200000] [<threads> = 4]" << std::endl;
+		return 1;
+	}
+
+	size_t operations = argc > 1 ? std::stoul(argv[1]) : 200000;
+	size_t threads = argc > 2 ? std::stoul(argv[2]) : 4;
+	using List = std::vector<std::shared_ptr<size_t>>;
+
+	std::cout << threads << " threads, " << operations << " operations each (Mops/s)" << std::endl;
+	for(auto [name, maxSize]: {std::make_pair("children", size_t(4)), std::make_pair("tips", size_t(32))})
+		for(unsigned readPercent: {50, 90, 99, 100}){
+			LegacyMonitor<List> legacy;
+			monitor<List> shared;
+			monitor<List, monitor_policy::Spin> spin;
+			monitor<List, monitor_policy::RCU> rcu;
+
+			std::cout << name << " " << readPercent << "% reads:"
+				<< " legacy " << runList(legacy, threads, operations, readPercent, maxSize) / 1e6
+				<< ", shared " << runList(shared, threads, operations, readPercent, maxSize) / 1e6
+				<< ", spin " << runList(spin, threads, operations, readPercent, maxSize) / 1e6
+				<< ", rcu " << runList(rcu, threads, operations, readPercent, maxSize) / 1e6 << std::endl;
+		}
+
+	for(unsigned readPercent: {50, 90, 99, 100}){
+		LegacyMonitor<Metrics> legacy;
+		monitor<Metrics> shared;
+		monitor<Metrics, monitor_policy::Spin> spin;
+		monitor<Metrics, monitor_policy::SeqLock> seqlock;
+
+		std::cout << "metrics " << readPercent << "% reads:"
+			<< " legacy " << runMetrics(legacy, threads, operations, readPercent) / 1e6
+			<< ", shared " << runMetrics(shared, threads, operations, readPercent) / 1e6
+			<< ", spin " << runMetrics(spin, threads, operations, readPercent) / 1e6
+			<< ", seqlock " << runMetrics(seqlock, threads, operations, readPercent) / 1e6 << std::endl;
+	}
+}
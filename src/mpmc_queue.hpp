@@ -0,0 +1,190 @@
+/**
+ * @file mpmc_queue.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides a bounded, lock-free, multi-producer/multi-consumer queue
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef MPMC_QUEUE_HPP
+#define MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <new>
+#include <optional>
+
+/**
+ * @brief Bounded lock-free queue which any number of threads can push to and pop from concurrently
+ * @note Based on Dmitry Vyukov's bounded MPMC queue: every cell carries a sequence number which tells producers and consumers whose turn it is, so each operation is a single CAS on the shared position plus a release store on the cell
+ * @note Storage is allocated once (capacity is rounded up to a power of two), elements are moved in and out and never copied
+ * @note When the queue is full pushes fail instead of blocking (backpressure), or displace the oldest element if asked to. Both outcomes are counted
+ *
+ * @tparam T - The type the queue holds
+ */
+template<typename T>
+class MPMCQueue {
+	// Size of a cache line (used to keep the positions, and each cell, from false sharing)
+	static constexpr size_t CACHE_LINE = 64;
+
+	/**
+	 * @brief Slot in the queue, the sequence says if the slot is waiting to be filled or to be emptied (and for which lap around the buffer)
+	 */
+	struct alignas(CACHE_LINE) Cell {
+		std::atomic<size_t> sequence;
+		alignas(T) std::byte storage[sizeof(T)];
+
+		T* data() { return std::launder(reinterpret_cast<T*>(storage)); }
+	};
+
+public:
+	/**
+	 * @brief How a push should behave when the queue is full
+	 */
+	enum class DropPolicy {
+		RejectNewest,	// The push fails, the caller keeps the element
+		DropOldest,		// The oldest element is popped (and destroyed) to make room
+	};
+
+	/**
+	 * @brief Counters describing what the queue has done
+	 */
+	struct Stats {
+		size_t pushed, popped, rejected, displaced;
+	};
+
+	MPMCQueue(size_t capacity) : mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), cells(new Cell[mask + 1]) {
+		for(size_t i = 0; i <= mask; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	~MPMCQueue() {
+		// Destroy any elements left in the queue
+		while(tryPop());
+	}
+
+	MPMCQueue(const MPMCQueue&) = delete;
+	MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+	/**
+	 * @brief Function which constructs an element in place at the back of the queue
+	 *
+	 * @param args - Arguments forwarded to the element's constructor
+	 * @return bool - True if the element was added, false if the queue is full
+	 */
+	template<typename... Args>
+	bool tryEmplace(Args&&... args) {
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while(true){
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = intptr_t(sequence) - intptr_t(pos);
+
+			// The cell is free for this lap... try to claim it
+			if(difference == 0){
+				if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			// The cell still holds an element from the previous lap... the queue is full
+			} else if(difference < 0){
+				rejected.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			// Another producer claimed the cell first... try again from the new position
+			} else pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+
+		new (cell->storage) T(std::forward<Args>(args)...);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		pushed.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * @brief Function which moves an element to the back of the queue
+	 *
+	 * @param value - The element to add (only moved from if it was added)
+	 * @param policy - What to do if the queue is full
+	 * @return bool - True if the element was added, false if the queue is full (and the policy rejects new elements)
+	 */
+	bool tryPush(T&& value, DropPolicy policy = DropPolicy::RejectNewest) {
+		while(!tryEmplace(std::move(value))){
+			if(policy == DropPolicy::RejectNewest) return false;
+
+			// Make room by throwing away the oldest element (the failed push was counted as a rejection, so undo that)
+			rejected.fetch_sub(1, std::memory_order_relaxed);
+			if(tryPop()) displaced.fetch_add(1, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Function which moves the element at the front of the queue out of it
+	 *
+	 * @return std::optional<T> - The element, or nothing if the queue is empty
+	 */
+	std::optional<T> tryPop() {
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while(true){
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = intptr_t(sequence) - intptr_t(pos + 1);
+
+			// The cell has been filled for this lap... try to claim it
+			if(difference == 0){
+				if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			// The cell hasn't been filled yet... the queue is empty
+			} else if(difference < 0)
+				return {};
+			// Another consumer claimed the cell first... try again from the new position
+			else pos = dequeuePos.load(std::memory_order_relaxed);
+		}
+
+		std::optional<T> out(std::move(*cell->data()));
+		cell->data()->~T();
+		// Mark the cell as free for the next lap
+		cell->sequence.store(pos + mask + 1, std::memory_order_release);
+		popped.fetch_add(1, std::memory_order_relaxed);
+		return out;
+	}
+
+	/**
+	 * @brief Function which determines how many elements are in the queue
+	 * @note Only a snapshot, other threads may be pushing or popping concurrently
+	 *
+	 * @return size_t - The (approximate) number of queued elements
+	 */
+	size_t size() const {
+		size_t enqueued = enqueuePos.load(std::memory_order_relaxed), dequeued = dequeuePos.load(std::memory_order_relaxed);
+		return enqueued > dequeued ? std::min(enqueued - dequeued, capacity()) : 0;
+	}
+	bool empty() const { return size() == 0; }
+	size_t capacity() const { return mask + 1; }
+
+	/**
+	 * @brief Function which gets a snapshot of the queue's counters
+	 *
+	 * @return Stats - How many elements have been pushed, popped, rejected because the queue was full, and displaced to make room
+	 */
+	Stats stats() const {
+		return { pushed.load(std::memory_order_relaxed), popped.load(std::memory_order_relaxed), rejected.load(std::memory_order_relaxed), displaced.load(std::memory_order_relaxed) };
+	}
+
+protected:
+	// Mask used to wrap positions into the buffer (capacity - 1)
+	const size_t mask;
+	// The buffer of cells
+	const std::unique_ptr<Cell[]> cells;
+
+	// Position the next element will be pushed to/popped from (each on its own cache line)
+	alignas(CACHE_LINE) std::atomic<size_t> enqueuePos = 0;
+	alignas(CACHE_LINE) std::atomic<size_t> dequeuePos = 0;
+
+	// Counters (kept away from the positions so updating them doesn't slow down claiming cells)
+	alignas(CACHE_LINE) std::atomic<size_t> pushed = 0, popped = 0, rejected = 0, displaced = 0;
+};
+
+#endif /* end of include guard: MPMC_QUEUE_HPP */
@@ -12,73 +12,74 @@
 #define NETWORKING_HPP
 
 #include "tangle.hpp"
+#include "mpmc_queue.hpp"
+#include "genesis_election.hpp"
+#include "merkle.hpp"
+#include "bloom.hpp"
+#include "admission.hpp"
+#include "difficulty.hpp"
 
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
 #include <breep/network/tcp.hpp>
 
 // The default port to start searching for ports at
-#define DEFAULT_PORT_NUMBER 12345;
+#define DEFAULT_PORT_NUMBER 12345
 
-// Network Queue limits
-#define NETWORK_QUEUE_MIN_SIZE 8
-#define NETWORK_QUEUE_MAX_SIZE 1024
+// Number of ports (starting at the default port) probed for a handshake server, and how long (in milliseconds) probing may take
+#define HANDSHAKE_PROBE_RANGE 32
+#define HANDSHAKE_DEADLINE 3000
 
-/**
- * @brief Function which attempts to remotely read data from a sodket until the <timeout> amount of time has elapsed
- * 
- * @param io_service - ASIO IO Service
- * @param sock - The socket to read data from
- * @param buffers - The buffer to store data in
- * @param timeout - How long to read for before giving
- * @return bool - Returns true if the read was successful, false otherwise
- */
-template <typename MutableBufferSequence, typename Duration>
-bool readWithTimeout(boost::asio::io_service& io_service, boost::asio::ip::tcp::socket& sock, const MutableBufferSequence& buffers, Duration timeout){
-	// Start a timer with <timeout> duration
-	std::optional<boost::system::error_code> timer_result;
-	boost::asio::steady_timer timer(io_service);
-	timer.expires_from_now(timeout);
-	// Have the timer store its result when done
-	timer.async_wait([&timer_result](const boost::system::error_code& error){
-		timer_result = error;
-	});
-
-
-	// Begin an async read, saving the error code which results
-	std::optional<boost::system::error_code> read_result;
-	sock.async_read_some(buffers, [&read_result](const boost::system::error_code& error, std::size_t bytes_transferred){
-		read_result = error;
-	});
-
-	// Wait for the read or the timer to finish
-	io_service.reset();
-	while (io_service.run_one()) {
-		if (read_result)
-			timer.cancel();
-		else if (timer_result)
-			sock.cancel();
-	}
+// Number of transactions the network queue can hold
+#define NETWORK_QUEUE_SIZE 1024
 
-	// If there was an error reading... propagate it
-	if (*read_result)
-		throw boost::system::system_error(*read_result);
+// Number of transactions sent (and verified) together in each chunk of a tangle sync
+#define SYNC_CHUNK_SIZE 64
 
-	// If there was no problem reading... return success
-	if(read_result && read_result == boost::system::errc::success)
-		return true;
-	// Otherwise... return failure
-	return false;
-}
+// False positive rate of the gossip filter a light node subscribes with
+#define LIGHT_FILTER_FALSE_POSITIVE_RATE 0.01
+// Number of recent tips a light node remembers (and picks the parents of its transactions from)
+#define LIGHT_TIP_WINDOW 64
+// Number of transactions touching its accounts a light node remembers
+#define LIGHT_HISTORY_SIZE 256
+// Number of peers a light node asks for tips and balance proofs
+#define LIGHT_PROOF_SAMPLE_SIZE 3
+// How often (in milliseconds) a light node refreshes its tips and balance proofs
+#define LIGHT_REFRESH_INTERVAL 5000
 
 // Function which finds a free port to listen on
-unsigned short determineLocalPort();
+unsigned short determineLocalPort(unsigned short start = DEFAULT_PORT_NUMBER);
 
 namespace handshake {
-	// Function which runs in a thread... looking for handshake pings
-	void acceptHandshakeConnection(boost::asio::ip::tcp::acceptor& acceptor, boost::asio::io_service& io_service, unsigned short localNetworkPort);
+	/**
+	 * @brief Asynchronous handshake server, answers requests for our network port
+	 * @note Runs on its own IO context and thread, so any number of handshakes can be in flight without blocking each other (or the rest of the program)
+	 */
+	struct Server {
+		Server(unsigned short port, unsigned short localNetworkPort);
+		~Server() { stop(); }
+
+		void stop();
+
+		// The port the server is listening on
+		unsigned short port() const { return acceptor.local_endpoint().port(); }
+
+	protected:
+		// The network port reported to peers
+		const unsigned short localNetworkPort;
+		// IO context (run on its own thread) and the acceptor listening for handshakes
+		boost::asio::io_context io;
+		boost::asio::ip::tcp::acceptor acceptor;
+		// Thread running the IO context
+		std::thread ioThread;
+
+		void accept();
+	};
 
-	// Function which pings ports on a remote address for connectivity
-	unsigned short determineRemotePort(boost::asio::io_service& io_service, boost::asio::ip::address& address);
+	// Function which probes a range of ports on a remote address (in parallel) for a handshake server, returning the network port it reports
+	std::optional<unsigned short> probeRemotePort(const boost::asio::ip::address& address, unsigned short start = DEFAULT_PORT_NUMBER, unsigned short range = HANDSHAKE_PROBE_RANGE, std::chrono::milliseconds deadline = std::chrono::milliseconds(HANDSHAKE_DEADLINE));
+
+	// Function which discovers the network port of a remote address, asking the user for it if no handshake server answers
+	unsigned short determineRemotePort(const boost::asio::ip::address& address);
 }
 
 
@@ -110,14 +111,165 @@ struct NetworkedTangle: public Tangle {
 	Hash add(TransactionNode::ptr node);
 
 	TransactionNode::ptr createLatestCommonGenesis();
+	std::vector<Transaction::Output> tabulateBalances(const std::vector<TransactionNode::const_ptr>& chosen) const;
+	static TransactionNode::ptr createGenesis(const std::vector<std::string>& cut, const std::vector<Transaction::Output>& balances);
 	void prune();
 
+	void join(size_t sampleSize = GENESIS_VOTE_SAMPLE_SIZE);
+
+	void setGenesis(TransactionNode::ptr genesis);
+	size_t confirmTransactions(float threshold = 1);
+	std::string stateRoot();
+	std::pair<std::string, merkle::AccountTree::Proof> proveAccount(const std::string& account);
+
+	/**
+	 * @brief Counters describing a light node
+	 */
+	struct LightStats {
+		// Whether the node is in light mode
+		bool enabled;
+		// Accounts tracked, size of the gossip filter (bytes), tips in the window, and transactions remembered
+		size_t accounts, filterBytes, tips, transactions;
+		// Transactions received through the filter, how many of them didn't touch our accounts (false positives), and proofs accepted/rejected
+		size_t received, falsePositives, proofsAccepted, proofsRejected;
+	};
+
+	void enableLightMode(const std::vector<std::string>& accounts = {});
+	bool isLight() const { return light.read_lock()->enabled; }
+	void refreshLightState();
+	std::optional<merkle::Balance> lightBalance(const std::string& account) const;
+	uint64_t reserveLightSequence(const std::string& account);
+	Hash addLight(const std::vector<Transaction::Input>& inputs, const std::vector<Transaction::Output>& outputs, uint8_t difficulty = 3);
+	LightStats lightStats() const;
+
 	void saveTangle(std::ostream& out);
 	void loadTangle(std::istream& in, size_t size);
 
+	// Counters describing the network queue, and how many transactions it currently holds (out of how many it can)
+	auto networkQueueStats() const { return networkAdditionQueue.stats(); }
+	size_t networkQueueSize() const { return networkAdditionQueue.size(); }
+	size_t networkQueueCapacity() const { return networkAdditionQueue.capacity(); }
+
+	// Counters describing which peer messages were admitted (and which were refused)
+	AdmissionControl::Stats admissionStats() const { return admissions.stats(); }
+	std::chrono::milliseconds backoff(AdmissionControl::Class type) const;
+
+	// Counters describing the adaptive minimum difficulty
+	DifficultyPolicy::Stats difficultyStats() const { return difficulty.stats(); }
+	uint8_t networkDifficulty() const;
+	void refreshDifficulty();
+	uint8_t miningDifficulty(const std::vector<Transaction::Input>& inputs, uint8_t requested = 0) const;
+
 private:
-	// Pointer to a map used for counting votes for different tangles during startup
-	std::unique_ptr<std::map<std::vector<std::string>, std::pair<boost::uuids::uuid, size_t>>> genesisVotes = nullptr;
+	/**
+	 * @brief Authenticated account state, the balances as of the genesis (a checkpoint) plus the changes made by every transaction confirmed since
+	 */
+	struct AccountState {
+		merkle::AccountTree tree;
+		// Hash of the genesis the tree was checkpointed at
+		std::string genesis = INVALID_HASH;
+		// Hashes of the (confirmed) transactions which have been applied to the tree
+		std::unordered_set<std::string> applied;
+	};
+	monitor<AccountState> accountState;
+
+	/**
+	 * @brief State of a light node, which keeps only a window of recent tips and the transactions touching its own accounts (rather than the whole tangle)
+	 * @note Balances are taken from Merkle proofs which a majority of a sample of peers agree on
+	 */
+	struct LightState {
+		bool enabled = false;
+		// The (base 64) accounts being tracked, and the filter peers are asked to gossip with
+		std::vector<std::string> accounts;
+		BloomFilter filter;
+		// Recent tips (oldest first)
+		std::deque<std::string> tips;
+		// The transactions touching our accounts (oldest first)
+		std::deque<Transaction> transactions;
+		// The verified balance of each account, and the next sequence number reserved for each account
+		std::unordered_map<std::string, merkle::Balance> confirmed;
+		std::unordered_map<std::string, uint64_t> sequences;
+		// The peers asked for proofs, and the balance each of them proved for each account
+		std::vector<boost::uuids::uuid> sample;
+		std::unordered_map<std::string, std::unordered_map<boost::uuids::uuid, merkle::Balance, boost::hash<boost::uuids::uuid>>> proofs;
+		// Counters
+		size_t received = 0, falsePositives = 0, proofsAccepted = 0, proofsRejected = 0;
+
+		bool tracks(const Transaction& transaction) const;
+		void observe(const Transaction& transaction);
+	};
+	monitor<LightState> light;
+
+	// The gossip filters peers have subscribed with (peers without a filter receive every transaction)
+	monitor<std::unordered_map<boost::uuids::uuid, BloomFilter, boost::hash<boost::uuids::uuid>>> peerFilters;
+
+	void gossip(const Transaction& transaction);
+
+	// Rate limits and queue bounds applied to every peer's messages
+	AdmissionControl admissions;
+	// When each peer who told us to slow down will accept each class of message again
+	monitor<std::unordered_map<boost::uuids::uuid, std::array<std::chrono::steady_clock::time_point, AdmissionControl::CLASS_COUNT>, boost::hash<boost::uuids::uuid>>> backoffs;
+
+	bool admit(const breep::tcp::peer& source, AdmissionControl::Class type);
+
+	// Minimum difficulty transactions must be mined at (adapting to the load we observe), and the minimum each peer has advertised
+	DifficultyPolicy difficulty;
+	monitor<std::unordered_map<boost::uuids::uuid, uint8_t, boost::hash<boost::uuids::uuid>>> peerDifficulties;
+
+	static std::vector<std::string> spenders(const std::vector<Transaction::Input>& inputs);
+	void recordIngest(const Transaction& transaction);
+	void advertiseDifficulty();
+
+	// Election used to decide which genesis to sync while joining the network (null when we aren't accepting votes)
+	// NOTE: atomic since join replaces it while network threads are reading it (readers load their own copy)
+	std::atomic<std::shared_ptr<GenesisElection>> election = nullptr;
+	// Votes (hashes and signature) from sampled peers whose public key hadn't arrived yet, counted once their key arrives
+	monitor<std::unordered_map<boost::uuids::uuid, std::pair<GenesisElection::Ballot, std::string>, boost::hash<boost::uuids::uuid>>> pendingVotes;
+
+	void submitVote(const boost::uuids::uuid& voter, GenesisElection::Ballot genesisHashes, std::string signature);
+
+	struct SyncChunk;
+	/**
+	 * @brief State of a tangle download (split into hash range parts, each downloaded from a different peer as a sequence of signed chunks)
+	 */
+	struct SyncSession {
+		// The peers who agreed on the genesis (parts are reassigned round robin between them if a chunk fails verification)
+		std::vector<boost::uuids::uuid> sources;
+		// The peer currently sending each part, the index of the next chunk expected for each part, and whether each part has finished
+		std::vector<boost::uuids::uuid> assigned;
+		std::vector<uint32_t> nextChunk;
+		std::vector<bool> complete;
+		// Transactions which arrived before one of their parents, keyed by the hash of the missing parent
+		std::unordered_map<std::string, std::vector<Transaction>> waiting;
+		// Chunks which arrived before their sender's public key (in the order they arrived), verified once it does
+		std::unordered_map<boost::uuids::uuid, std::vector<SyncChunk>, boost::hash<boost::uuids::uuid>> unverified;
+		// The cut the state snapshot was taken at (empty while we don't have a snapshot, or when downloading the full history), the balances as of the cut, and their commitment
+		std::vector<std::string> cut;
+		std::vector<Transaction::Output> balances;
+		std::string root;
+		// The sources who have attested to the snapshot's commitment, and how many of them agreed with it
+		std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>> attested;
+		size_t agreed = 0;
+		// Whether the snapshot has been installed as our genesis
+		bool installed = false;
+		// Counters
+		size_t chunks = 0, rejectedChunks = 0, added = 0, parked = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		SyncSession(std::vector<boost::uuids::uuid> sources) : sources(sources), assigned(sources), nextChunk(sources.size(), 0), complete(sources.size(), false) {}
+	};
+	// The current tangle download (null when we aren't syncing), and the mutex protecting it
+	std::unique_ptr<SyncSession> sync = nullptr;
+	std::mutex syncMutex;
+
+	void installSnapshot();
+	void fallbackSync();
+	void requestParts(const boost::uuids::uuid& source);
+	void receiveChunk(const boost::uuids::uuid& source, const SyncChunk& chunk);
+	void receiveUnverifiedChunks(const boost::uuids::uuid& source);
+	void insertSynced(std::vector<Transaction> ready);
+	void releaseSynced(const std::string& parentHash);
+	void finishSync();
 	// Hash we expect a genesis sync to have (invalid hash means we aren't expecting a new genesis)
 	std::string genesisSyncExpectedHash = INVALID_HASH;
 
@@ -134,33 +286,41 @@ private:
 
 		TransactionAndHashVerificationPair() = default;
 		TransactionAndHashVerificationPair(const Transaction& transaction, const HashVerificationPair& pair) : transaction(transaction), pair(pair) {}
+		TransactionAndHashVerificationPair(Transaction&& transaction, HashVerificationPair&& pair) : transaction(std::move(transaction)), pair(std::move(pair)) {}
 		TransactionAndHashVerificationPair(const TransactionAndHashVerificationPair& o) : transaction(o.transaction), pair(o.pair) {}
-		TransactionAndHashVerificationPair(const TransactionAndHashVerificationPair&& o) : transaction(std::move(o.transaction)), pair(o.pair) {}
+		TransactionAndHashVerificationPair(TransactionAndHashVerificationPair&& o) : transaction(std::move(o.transaction)), pair(std::move(o.pair)) {}
 		TransactionAndHashVerificationPair& operator=(const TransactionAndHashVerificationPair& other){ transaction = other.transaction; pair = other.pair; return *this; }
-		TransactionAndHashVerificationPair& operator=(const TransactionAndHashVerificationPair&& other){ transaction = std::move(other.transaction); pair = other.pair; return *this; }
+		TransactionAndHashVerificationPair& operator=(TransactionAndHashVerificationPair&& other){ transaction = std::move(other.transaction); pair = std::move(other.pair); return *this; }
 		bool operator==(const TransactionAndHashVerificationPair& o) const {
 			return transaction.hash == o.transaction.hash && pair.peerID == o.pair.peerID && pair.signature == o.pair.signature;
 		}
 	};
-	// Queue which holds incoming transactions that weren't immediately added to the tangle
-	ModifiableQueue<TransactionAndHashVerificationPair, circular_buffer<std::vector<TransactionAndHashVerificationPair>>> networkAdditionQueue;
+	// Queue which holds incoming transactions that weren't immediately added to the tangle (shared by every network thread)
+	MPMCQueue<TransactionAndHashVerificationPair> networkAdditionQueue{NETWORK_QUEUE_SIZE};
 
 	/**
-	 * @brief Function that expands the network queue if it is getting close to running out of size
+	 * @brief Function which enqueues a transaction to be added later
+	 * @note If the queue is full the transaction is dropped (it will be recovered the next time we synchronize with the network)
+	 *
+	 * @param transaction - The transaction to enqueue (moved into the queue)
+	 * @param pair - Information needed to verify the transaction's sender
+	 * @return bool - True if the transaction was enqueued, false if it was dropped
 	 */
-	void growNetworkQueue(){
-		auto& container = networkAdditionQueue.getContainer();
-		if(size_t size = container.size(), capacity = container.capacity(); size == capacity && size < NETWORK_QUEUE_MAX_SIZE)
-			networkAdditionQueue.getContainer().resize(std::clamp(size * 2, (size_t) NETWORK_QUEUE_MIN_SIZE, (size_t) NETWORK_QUEUE_MAX_SIZE)); // Clamp the queues size in the range [10, NETWORK_QUEUE_MAX_SIZE]
-	}
+	bool enqueueTransaction(Transaction&& transaction, HashVerificationPair&& pair){
+		std::string hash = transaction.hash;
+		// Each peer can only hold a share of the queue (our own transactions aren't limited)
+		bool limited = pair.peerID != network.self().id();
+		if(limited && !admissions.enqueue(pair.peerID)){
+			std::cerr << "Peer `" << pair.peerID << "` has " << ADMISSION_PEER_QUEUE_SIZE << " transactions waiting in the network queue, dropping transaction with hash `" << hash << "`" << std::endl;
+			return false;
+		}
 
-	/**
-	 * @brief Function which shrinks the network queue if more than half of it is wasted space
-	 */
-	void shrinkNetworkQueue(){
-		auto& container = networkAdditionQueue.getContainer();
-		if(size_t size = container.size(), capacity = container.capacity(); size <= capacity / 2 && size > NETWORK_QUEUE_MIN_SIZE)
-			container = std::vector<TransactionAndHashVerificationPair>(container.begin(), container.end()); // Make a new container containing only the used values of the buffer with its start reset
+		boost::uuids::uuid peer = pair.peerID;
+		if(networkAdditionQueue.tryEmplace(std::move(transaction), std::move(pair))) return true;
+
+		if(limited) admissions.dequeue(peer);
+		std::cerr << "Network queue is full (" << networkAdditionQueue.capacity() << " transactions), dropping transaction with hash `" << hash << "`" << std::endl;
+		return false;
 	}
 
 protected:
@@ -171,13 +331,20 @@ protected:
 	 * @param peer 
 	 */
 	void connect_disconnectListener(breep::tcp::network& network, const breep::tcp::peer& peer) {
-		// Someone connected...
-		if (peer.is_connected())
+		// Someone connected... (tell them our minimum difficulty, and if we are a light node what to gossip to us)
+		if (peer.is_connected()) {
 			std::cout << peer.id() << " connected!" << std::endl;
+			network.send_object_to(peer, DifficultyAnnouncement{difficulty.minimum()});
+			if(auto state = light.read_lock(); state->enabled)
+				network.send_object_to(peer, GossipFilter{state->filter});
 
-		// Someone disconnected...
-		else
+		// Someone disconnected... (forget their filter, their admission state is kept until it idles out so reconnecting doesn't reset their limits)
+		} else {
 			std::cout << peer.id() << " disconnected" << std::endl;
+			peerFilters.write_lock()->erase(peer.id());
+			peerDifficulties.write_lock()->erase(peer.id());
+			backoffs.write_lock()->erase(peer.id());
+		}
 	}
 
 
@@ -212,7 +379,7 @@ public:
 		 * @brief Constructor which stores the public key and a signature done with the associated private key
 		 * @param pair - Keypair, the public key is sent and the private key is used to confirm the validity of the public key
 		 */
-		PublicKeySyncResponse(const key::KeyPair& pair) : _key(pair.pub), signature(key::signMessage(pair.pri, VERIFICATION_STRING)) {}
+		PublicKeySyncResponse(const key::KeyPair& pair) : _key(pair.pub), signature(key::signMessage(pair, VERIFICATION_STRING)) {}
 
 		/**
 		 * @brief Listener for PublicKeySyncResponse events. If the received key is verifiable, mark it as the key associated with the sending peer.
@@ -225,7 +392,16 @@ public:
 			if(key::verifyMessage(networkData.data._key, VERIFICATION_STRING, networkData.data.signature))
 				// Mark the key as the sending peer's public key
 				t.peerKeys[networkData.source.id()] = networkData.data._key;
-			else std::cout << "Failed to verify key from `" << networkData.source.id() << "`" << std::endl;
+			else {
+				std::cout << "Failed to verify key from `" << networkData.source.id() << "`" << std::endl;
+				return;
+			}
+
+			// If the peer voted before we had their key... count their vote now
+			if(auto vote = t.pendingVotes.write_lock()->extract(networkData.source.id()))
+				t.submitVote(networkData.source.id(), std::move(vote.mapped().first), std::move(vote.mapped().second));
+			// If the peer sent us part of the tangle before we had their key... verify it now
+			t.receiveUnverifiedChunks(networkData.source.id());
 		}
 
 		#undef VERIFICATION_STRING
@@ -235,11 +411,6 @@ public:
 	 * @brief Message which requests a vote for what genesis is being used
 	 */
 	struct GenesisVoteRequest {
-		GenesisVoteRequest() = default;
-		GenesisVoteRequest(NetworkedTangle& t) { // Use this constructor to mark the local tangle as accepting of requests
-			t.genesisVotes = std::make_unique<std::map<std::vector<std::string>, std::pair<boost::uuids::uuid, size_t>>>();
-		}
-
 		/**
 		 * @brief Listener for GenesisVoteRequest events. Sends the hashes our genesis represents to the requester
 		 * 
@@ -247,6 +418,7 @@ public:
 		 * @param t - The tangle which received the event
 		 */
 		static void listener(breep::tcp::netdata_wrapper<GenesisVoteRequest> &networkData, NetworkedTangle &t) {
+			if(!t.admit(networkData.source, AdmissionControl::Class::Query)) return;
 			t.network.send_object_to(networkData.source, GenesisVoteResponse(t));
 			std::cout << "Sent genesis vote to `" << networkData.source.id() << "`" << std::endl;
 		}
@@ -270,44 +442,238 @@ public:
 
 
 	/**
-	 * @brief Message which causes the recipient to send us their tangle
+	 * @brief Message which requests a state snapshot (the balance of every account as of a recent, fully confirmed, cut through the tangle)
+	 */
+	struct StateSnapshotRequest {
+		static void listener(breep::tcp::netdata_wrapper<StateSnapshotRequest>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which sends a state snapshot to a joining node
+	 * @note The balances are committed to with a Merkle root (see merkle.hpp), which is signed along with the cut and confirmed by other peers before the snapshot is used
+	 */
+	struct StateSnapshotResponse {
+		// The hashes of the nodes making up the cut
+		std::vector<std::string> cut;
+		// Transaction whose outputs hold the balance and next sequence number of every account as of the cut
+		Transaction balances;
+		// The commitment to the balances
+		std::string root;
+		// Signature of the cut and commitment
+		std::string signature;
+		// Whether the snapshot decompressed to more than we accept (the other fields are empty)
+		bool oversized = false;
+
+		StateSnapshotResponse() = default;
+		StateSnapshotResponse(const NetworkedTangle& t);
+
+		/**
+		 * @brief Function which calculates the message signed to vouch for the commitment at a cut
+		 *
+		 * @param cut - The hashes of the nodes making up the cut
+		 * @param root - The commitment to the balances as of the cut
+		 * @return std::string - The message to sign
+		 */
+		static std::string digest(const std::vector<std::string>& cut, const std::string& root) {
+			std::string message = "snapshot:" + root;
+			for(auto& hash: cut)
+				message += "|" + hash;
+			return message;
+		}
+
+		static void listener(breep::tcp::netdata_wrapper<StateSnapshotResponse>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which asks the recipient to calculate the commitment to the balances as of a cut (confirming a snapshot received from another peer)
+	 */
+	struct StateSnapshotAttestRequest {
+		// The hashes of the nodes making up the cut
+		std::vector<std::string> cut;
+
+		static void listener(breep::tcp::netdata_wrapper<StateSnapshotAttestRequest>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which sends our commitment to the balances as of a cut (an invalid hash if the cut isn't in our tangle)
+	 */
+	struct StateSnapshotAttestation {
+		// The hashes of the nodes making up the cut
+		std::vector<std::string> cut;
+		// The commitment to the balances
+		std::string root = INVALID_HASH;
+		// Signature of the cut and commitment
+		std::string signature;
+
+		static void listener(breep::tcp::netdata_wrapper<StateSnapshotAttestation>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which causes the recipient to send us their tangle (or one part of it)
+	 * @note A joining node requests a different part from each of several peers, so the tangle is downloaded from all of them in parallel
+	 * @note Parts are ranges of transaction hashes (so every peer splits the tangle the same way), each part is sent as a sequence of SyncChunks
 	 */
 	struct TangleSynchronizeRequest {
+		// Which part of the tangle to send, and how many parts it is split into
+		uint32_t part = 0, parts = 1;
+		// Cut (from a state snapshot) the recipient already has, only transactions after it are sent (empty sends the genesis and every transaction)
+		std::vector<std::string> after = {};
+
+		/**
+		 * @brief Function which determines which part a transaction belongs to
+		 *
+		 * @param hash - The (base64) hash of the transaction
+		 * @param parts - The number of parts the tangle is split into
+		 * @return uint32_t - The part (hashes are split evenly between the parts using their first 24 bits)
+		 */
+		static uint32_t partOf(const std::string& hash, uint32_t parts) {
+			uint32_t bits = 0;
+			for(size_t i = 0; i < 4; i++){
+				char c = i < hash.size() ? hash[i] : 'A';
+				uint32_t value = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 : c >= '0' && c <= '9' ? c - '0' + 52 : c == '+' ? 62 : 63;
+				bits = (bits << 6) | value;
+			}
+			return uint64_t(bits) * parts >> 24;
+		}
+
+		static void listener(breep::tcp::netdata_wrapper<TangleSynchronizeRequest>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which sends a chunk of one part of our tangle to a syncing peer
+	 * @note The chunk's integrity is checked as a whole: the signature covers a digest of every transaction's hash (which the recipient recomputes)
+	 */
+	struct SyncChunk {
+		// The part this chunk belongs to, how many parts the tangle was split into, the chunk's position in the part, and whether it is the last chunk of the part
+		uint32_t part = 0, parts = 1, index = 0;
+		bool last = false;
+		// The transactions in the chunk (parents come before their children, though parents may be in other chunks or parts)
+		std::vector<Transaction> transactions;
+		// Signature of the chunk's digest
+		std::string signature;
+		// Whether the chunk decompressed to more than we accept (the other fields are empty)
+		bool oversized = false;
+
+		SyncChunk() = default;
+		/**
+		 * @brief Constructs a chunk with automatic signing
+		 *
+		 * @param part - The part the chunk belongs to
+		 * @param parts - The number of parts
+		 * @param index - The chunk's position in the part
+		 * @param last - Whether this is the last chunk of the part
+		 * @param transactions - The transactions to send
+		 * @param keys - Keypair used for signing
+		 */
+		SyncChunk(uint32_t part, uint32_t parts, uint32_t index, bool last, std::vector<Transaction>&& transactions, const key::KeyPair& keys)
+			: part(part), parts(parts), index(index), last(last), transactions(std::move(transactions)) { signature = key::signMessage(keys, digest()); }
+
+		// Function which computes the digest of the chunk (its position and the hashes of its transactions)
+		Hash digest() const {
+			std::string message = std::to_string(part) + "/" + std::to_string(parts) + ":" + std::to_string(index) + (last ? "!" : "");
+			for(auto& transaction: transactions)
+				message += transaction.hash;
+			return util::hash(message);
+		}
+
+		static void listener(breep::tcp::netdata_wrapper<SyncChunk>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which subscribes the sender to only the transactions touching the accounts in a filter (sent by light nodes)
+	 */
+	struct GossipFilter {
+		// The filter (an empty filter unsubscribes, so every transaction is gossiped again)
+		BloomFilter filter;
+
 		/**
-		 * @brief Listener for TangleSynchronizeRequest events. Sends the sender every node in our tangle
+		 * @brief Listener for GossipFilter events. Remembers (or forgets) the filter the sending peer wants transactions gossiped through
 		 * 
 		 * @param networkData - The event received
 		 * @param t - The tangle which received the event
 		 */
-		static void listener(breep::tcp::netdata_wrapper<TangleSynchronizeRequest>& networkData, NetworkedTangle& t){
-			std::scoped_lock lock(t.mutex); // Can't add or remove nodes while we are sending the tangle to someone
-			// Send the tangle to the sender
-			recursiveSendTangle(networkData.source, t, t.genesis);
-
-			// Suggest that the recipient update their weights
-			t.network.send_object_to(networkData.source, UpdateWeightsRequest());
-			std::cout << "Sent tangle to `" << networkData.source.id() << "`" << std::endl;
+		static void listener(breep::tcp::netdata_wrapper<GossipFilter>& networkData, NetworkedTangle& t){
+			auto filters = t.peerFilters.write_lock();
+			if(networkData.data.filter.empty()) filters->erase(networkData.source.id());
+			else filters->insert_or_assign(networkData.source.id(), std::move(networkData.data.filter));
 		}
+	};
+
+	/**
+	 * @brief Message which tells the recipient they have exceeded our limits for a class of message (and how long to wait before sending more)
+	 */
+	struct SlowDown {
+		AdmissionControl::Class type = AdmissionControl::Class::Transaction;
+		// How long (in milliseconds) until we will accept another message of the class
+		uint32_t retryAfter = 0;
+
+		static void listener(breep::tcp::netdata_wrapper<SlowDown>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which advertises the minimum difficulty we currently accept transactions at (sent to new peers, and broadcast whenever it changes)
+	 */
+	struct DifficultyAnnouncement {
+		uint8_t minimum = DIFFICULTY_MINIMUM;
 
-	protected:
 		/**
-		 * @brief Function which recursively sends all of the nodes in our tangle
+		 * @brief Listener for DifficultyAnnouncement events. Remembers the minimum the sending peer accepts (so we mine transactions it will accept)
 		 * 
-		 * @param requester - The peer to send nodes to
-		 * @param t - Reference to the tangle (stores reference to the network and keys)
-		 * @param node - The current node in the recursive call
+		 * @param networkData - The event received
+		 * @param t - The tangle which received the event
 		 */
-		static void recursiveSendTangle(const breep::tcp::peer& requester, NetworkedTangle& t, const TransactionNode::ptr& node){
-			// Send this node (make it a genesis sync if it is the genesis)
-			if(node->isGenesis) t.network.send_object_to(requester, SyncGenesisRequest(*node, *t.personalKeys));
-			else t.network.send_object_to(requester, SynchronizationAddTransactionRequest(*node, *t.personalKeys));
-
-			// Recursively call for all of our children
-			for(int i = 0; i < node->children.read_lock()->size(); i++)
-				recursiveSendTangle(requester, t, node->children.read_lock()[i]);
+		static void listener(breep::tcp::netdata_wrapper<DifficultyAnnouncement>& networkData, NetworkedTangle& t){
+			(*t.peerDifficulties.write_lock())[networkData.source.id()] = std::clamp<uint8_t>(networkData.data.minimum, DIFFICULTY_MINIMUM, DIFFICULTY_MAXIMUM);
 		}
 	};
 
+	/**
+	 * @brief Message which requests the recipient's current tips (sent by light nodes, who don't have the graph to find tips in)
+	 */
+	struct TipsRequest {
+		static void listener(breep::tcp::netdata_wrapper<TipsRequest>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which sends our current tips to a light node
+	 */
+	struct TipsResponse {
+		// The hashes of the tips
+		std::vector<std::string> tips;
+
+		static void listener(breep::tcp::netdata_wrapper<TipsResponse>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which requests a proof of an account's confirmed balance (sent by light nodes)
+	 */
+	struct AccountProofRequest {
+		// The base 64 representation of the account's key
+		std::string account;
+
+		static void listener(breep::tcp::netdata_wrapper<AccountProofRequest>& networkData, NetworkedTangle& t);
+	};
+
+	/**
+	 * @brief Message which sends a proof of an account's confirmed balance against our account state
+	 * @note The proof is checked against the root, the signature vouches that the root is the sender's state
+	 */
+	struct AccountProofResponse {
+		// The base 64 representation of the account's key
+		std::string account;
+		// The root of the sender's account state
+		std::string root;
+		// The proof
+		merkle::AccountTree::Proof proof;
+		// Signature of the root and account
+		std::string signature;
+
+		// Function which calculates the message signed to vouch for the root
+		std::string digest() const { return "proof:" + account + ":" + root; }
+
+		static void listener(breep::tcp::netdata_wrapper<AccountProofResponse>& networkData, NetworkedTangle& t);
+	};
+
 	/**
 	 * @brief Message which causes the tangle to update its weight
 	 */
@@ -337,6 +703,8 @@ public:
 		std::string validitySignature;
 		// The node being sent
 		Transaction genesis;
+		// Whether the request decompressed to more than we accept (the other fields are empty)
+		bool oversized = false;
 
 		SyncGenesisRequest() = default;
 		/**
@@ -345,7 +713,7 @@ public:
 		 * @param _genesis - The transaction which should become the new genesis
 		 * @param keys - Keypair used for signing
 		 */
-		SyncGenesisRequest(Transaction& _genesis, const key::KeyPair& keys) : claimedHash(_genesis.hash), actualHash(_genesis.hashTransaction()), validitySignature(key::signMessage(keys, claimedHash + actualHash)), genesis(_genesis) {}
+		SyncGenesisRequest(const Transaction& _genesis, const key::KeyPair& keys) : claimedHash(_genesis.hash), actualHash(_genesis.hashTransaction()), validitySignature(key::signMessage(keys, claimedHash + actualHash)), genesis(_genesis) {}
 
 		static void listener(breep::tcp::netdata_wrapper<SyncGenesisRequest>& networkData, NetworkedTangle& t);
 	};
@@ -368,12 +736,25 @@ public:
 		 * @param _transaction - The transaction which should become the new genesis
 		 * @param keys - Keypair used for signing
 		 */
-		AddTransactionRequestBase(Transaction& _transaction, const key::KeyPair& keys) : validityHash(_transaction.hash), validitySignature(key::signMessage(keys, validityHash)), transaction(_transaction) {}
+		AddTransactionRequestBase(const Transaction& _transaction, const key::KeyPair& keys) : validityHash(_transaction.hash), validitySignature(key::signMessage(keys, validityHash)), transaction(_transaction) {}
+
+		// Function which stores the compressed request as it was received (decompressing and hashing it is deferred until the sender has been admitted)
+		void receive(std::string compressed) { receivedSize = compressed.size(); packed = std::move(compressed); }
+		// Function which checks if the request has been unpacked (the fields above are only filled in once the sender has been admitted)
+		bool unpacked() const { return packed.empty(); }
+		// The size of the request as it was received (compressed)
+		size_t wireSize() const { return receivedSize; }
+		void unpack();
 
 		static void listener(breep::tcp::netdata_wrapper<AddTransactionRequestBase>& networkData, NetworkedTangle& t);
 
 	protected:
-		static void attemptToAddTransaction(const Transaction& transaction, HashVerificationPair validityPair, NetworkedTangle& t);
+		// The compressed request as it was received (empty once unpacked), and its size
+		std::string packed;
+		size_t receivedSize = 0;
+
+		static std::optional<std::string> check(const AddTransactionRequestBase& request, const NetworkedTangle& t, bool enforceDifficulty = true);
+		static void attemptToAddTransaction(Transaction transaction, HashVerificationPair validityPair, NetworkedTangle& t);
 	};
 
 	/**
@@ -444,16 +825,130 @@ inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::
 }
 BREEP_DECLARE_TYPE(NetworkedTangle::GenesisVoteResponse)
 
-// Empty serialization (no data to send)
-inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::TangleSynchronizeRequest& r) { return s; }
-inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::TangleSynchronizeRequest& r) { return d; }
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::TangleSynchronizeRequest& r) {
+	s << r.part;
+	s << r.parts;
+	s << r.after;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::TangleSynchronizeRequest& r) {
+	d >> r.part;
+	d >> r.parts;
+	d >> r.after;
+	return d;
+}
 BREEP_DECLARE_TYPE(NetworkedTangle::TangleSynchronizeRequest)
 
+// Empty serialization (no data to send)
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::StateSnapshotRequest& r) { return s; }
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::StateSnapshotRequest& r) { return d; }
+BREEP_DECLARE_TYPE(NetworkedTangle::StateSnapshotRequest)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::StateSnapshotAttestRequest& r) {
+	s << r.cut;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::StateSnapshotAttestRequest& r) {
+	d >> r.cut;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::StateSnapshotAttestRequest)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::StateSnapshotAttestation& r) {
+	s << r.cut;
+	s << r.root;
+	s << r.signature;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::StateSnapshotAttestation& r) {
+	d >> r.cut;
+	d >> r.root;
+	d >> r.signature;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::StateSnapshotAttestation)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::GossipFilter& r) {
+	s << r.filter.bits;
+	s << r.filter.hashes;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::GossipFilter& r) {
+	d >> r.filter.bits;
+	d >> r.filter.hashes;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::GossipFilter)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::SlowDown& r) {
+	s << uint8_t(r.type);
+	s << r.retryAfter;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::SlowDown& r) {
+	uint8_t type;
+	d >> type;
+	r.type = AdmissionControl::Class(std::min<uint8_t>(type, AdmissionControl::CLASS_COUNT - 1));
+	d >> r.retryAfter;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::SlowDown)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::DifficultyAnnouncement& r) {
+	s << r.minimum;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::DifficultyAnnouncement& r) {
+	d >> r.minimum;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::DifficultyAnnouncement)
+
+// Empty serialization (no data to send)
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::TipsRequest& r) { return s; }
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::TipsRequest& r) { return d; }
+BREEP_DECLARE_TYPE(NetworkedTangle::TipsRequest)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::TipsResponse& r) {
+	s << r.tips;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::TipsResponse& r) {
+	d >> r.tips;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::TipsResponse)
+
+inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::AccountProofRequest& r) {
+	s << r.account;
+	return s;
+}
+inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::AccountProofRequest& r) {
+	d >> r.account;
+	return d;
+}
+BREEP_DECLARE_TYPE(NetworkedTangle::AccountProofRequest)
+
 // Empty serialization (no data to send)
 inline breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::UpdateWeightsRequest& r) { return s; }
 inline breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::UpdateWeightsRequest& r) { return d; }
 BREEP_DECLARE_TYPE(NetworkedTangle::UpdateWeightsRequest)
 
+// In .cpp
+breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::StateSnapshotResponse& r);
+breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::StateSnapshotResponse& r);
+BREEP_DECLARE_TYPE(NetworkedTangle::StateSnapshotResponse)
+
+// In .cpp
+breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::AccountProofResponse& r);
+breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::AccountProofResponse& r);
+BREEP_DECLARE_TYPE(NetworkedTangle::AccountProofResponse)
+
+// In .cpp
+breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::SyncChunk& r);
+breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::SyncChunk& r);
+BREEP_DECLARE_TYPE(NetworkedTangle::SyncChunk)
+
 // In .cpp
 breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::SyncGenesisRequest& r);
 breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::SyncGenesisRequest& r);
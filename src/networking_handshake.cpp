@@ -12,9 +12,10 @@
 
 /**
  * @brief Function which finds a free port to listen on
+ * @param start - The port to start searching from
  * @return unsigned short - the discovered free port
  */
-unsigned short determineLocalPort(){
+unsigned short determineLocalPort(unsigned short start /*= DEFAULT_PORT_NUMBER*/){
 	// Function which checks if a port is open
 	auto portInUse = [](unsigned short port) -> bool {
 	    boost::asio::io_service svc;
@@ -28,8 +29,8 @@ unsigned short determineLocalPort(){
 	    return ec == boost::asio::error::address_in_use;
 	};
 
-	// Start searching at the default port and increment until a port is found
-	unsigned short localPortNumber = DEFAULT_PORT_NUMBER;
+	// Start searching at the starting port and increment until a port is found
+	unsigned short localPortNumber = start;
 	while(portInUse(localPortNumber)) localPortNumber++;
 	return localPortNumber;
 }
@@ -44,83 +45,141 @@ struct Handshake {
 	unsigned short port;
 };
 
+// The request sent to handshake servers
+static constexpr std::string_view HANDSHAKE_REQUEST = "REMOTE PORT";
+
 /**
- * @brief Function which runs in a thread... looking for handshake pings
+ * @brief Function which checks that a received handshake is valid
  *
- * @param acceptor - ASIO connection acceptor
- * @param io_service - ASIO IO service
- * @param localNetworkPort - The port we are currently connected on
+ * @param hs - The handshake to validate
+ * @return bool - True if the header is correct and it contains a port, false otherwise
+ */
+static bool validHandshake(const Handshake& hs) {
+	return hs.H == 'H' && hs.A == 'A' && hs.N == 'N' && hs.D == 'D' && hs.S == 'S' && hs.K == 'K' && hs.E == 'E'
+		&& hs.port != std::numeric_limits<unsigned short>::max();
+}
+
+/**
+ * @brief A single connection to the handshake server, reads one request and answers it (dropped if the request doesn't arrive within the deadline)
  */
-void handshake::acceptHandshakeConnection(boost::asio::ip::tcp::acceptor& acceptor, boost::asio::io_service& io_service, unsigned short localNetworkPort) {
-	const int max_length = 1024;
-	char data[max_length];
+struct HandshakeSession : public std::enable_shared_from_this<HandshakeSession> {
+	boost::asio::ip::tcp::socket sock;
+	boost::asio::steady_timer timeout;
+	std::array<char, HANDSHAKE_REQUEST.size()> request;
 	Handshake hs;
 
-	// Wait for a new connection
-	boost::asio::ip::tcp::socket sock(io_service);
-	acceptor.accept(sock);
+	HandshakeSession(boost::asio::ip::tcp::socket sock, unsigned short localNetworkPort) : sock(std::move(sock)), timeout(this->sock.get_executor()) { hs.port = localNetworkPort; }
 
-	// Wait for a request on the connection
-    boost::system::error_code error;
-    sock.read_some(boost::asio::buffer(data), error);
-    if ( !(error == boost::asio::error::eof || error == boost::system::errc::success) )
-		throw boost::system::system_error(error); // Some other error.
+	void start() {
+		auto self = shared_from_this();
+		timeout.expires_after(std::chrono::milliseconds(HANDSHAKE_DEADLINE));
+		timeout.async_wait([self](const boost::system::error_code& ec){
+			if(!ec) self->sock.close();
+		});
 
-	// If it is asking for our port... send them the port to connect to
-	if(std::string(data) == "REMOTE PORT"){
-		hs.port = localNetworkPort;
-		sock.write_some(boost::asio::buffer(reinterpret_cast<char*>(&hs), sizeof(hs)));
+		// Wait for the request, and if it is asking for our port... send them the port to connect to
+		boost::asio::async_read(sock, boost::asio::buffer(request), [self](const boost::system::error_code& ec, size_t){
+			if(ec || std::string_view(self->request.data(), self->request.size()) != HANDSHAKE_REQUEST){
+				self->timeout.cancel();
+				return;
+			}
+
+			boost::asio::async_write(self->sock, boost::asio::buffer(reinterpret_cast<char*>(&self->hs), sizeof(self->hs)), [self](const boost::system::error_code&, size_t){
+				self->timeout.cancel();
+			});
+		});
 	}
+};
+
+/**
+ * @brief Constructor which starts listening for handshakes (on all interfaces)
+ *
+ * @param port - The port to listen on
+ * @param localNetworkPort - The port our network is listening on (sent to peers)
+ */
+handshake::Server::Server(unsigned short port, unsigned short localNetworkPort) :
+	localNetworkPort(localNetworkPort), acceptor(io, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)) {
+	accept();
+	ioThread = std::thread([this](){ io.run(); });
+}
+
+/**
+ * @brief Function which stops the server, abandoning any in flight handshakes
+ */
+void handshake::Server::stop() {
+	if(!ioThread.joinable()) return;
+
+	io.stop();
+	ioThread.join();
+}
+
+/**
+ * @brief Function which accepts connections, starting a session for each of them
+ */
+void handshake::Server::accept() {
+	acceptor.async_accept([this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket){
+		if(!ec) std::make_shared<HandshakeSession>(std::move(socket), localNetworkPort)->start();
+		if(acceptor.is_open()) accept();
+	});
 }
 
 /**
- * @brief Function which pings ports on a remote address for connectivity
+ * @brief Function which probes a range of ports on a remote address for a handshake server
+ * @note Every port is probed at once, the first valid handshake wins and probing gives up once the deadline passes
  *
- * @param io_service - ASIO IO service
- * @param address - IP Address to ping
- * @return unsigned short - The discovered remote port
+ * @param address - IP Address to probe
+ * @param start - The first port to probe
+ * @param range - How many ports to probe
+ * @param deadline - How long to wait for a handshake (in total, not per port)
+ * @return std::optional<unsigned short> - The network port the remote reported, or nothing if no handshake was received
  */
-unsigned short handshake::determineRemotePort(boost::asio::io_service& io_service, boost::asio::ip::address& address){
-	unsigned short handshakePort = DEFAULT_PORT_NUMBER;
-	unsigned short remotePort = -1;
-	Handshake hs;
+std::optional<unsigned short> handshake::probeRemotePort(const boost::asio::ip::address& address, unsigned short start /*= DEFAULT_PORT_NUMBER*/, unsigned short range /*= HANDSHAKE_PROBE_RANGE*/, std::chrono::milliseconds deadline /*= HANDSHAKE_DEADLINE*/){
+	// State of the probe of a single port
+	struct Probe {
+		boost::asio::ip::tcp::socket sock;
+		Handshake hs;
+		Probe(boost::asio::io_context& io) : sock(io) {}
+	};
 
-	// Try connecting to incremented ports for 5 seconds...
-	auto start = std::chrono::steady_clock::now();
-	while(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count() < 3) // Try to connect for 3 seconds
-		try{
-			// Ping for a handshake
-			boost::system::error_code ec;
-			boost::asio::ip::tcp::socket sock(io_service);
-			sock.connect(boost::asio::ip::tcp::endpoint(address, handshakePort++), ec);
-			if(ec) throw boost::system::system_error(ec);
-			std::string data = "REMOTE PORT";
-			sock.write_some(boost::asio::buffer(data, data.size()), ec);
-			if(ec) throw boost::system::system_error(ec);
-
-			// Wait 500ms for a response
-			if(readWithTimeout(io_service, sock, boost::asio::buffer(reinterpret_cast<char*>(&hs), sizeof(hs)), std::chrono::milliseconds(500))){ // TODO: is 500ms too short of a time frame?
-				sock.close(ec);
-				if(ec) throw boost::system::system_error(ec);
-
-				// Quick validation of the returned data
-				if(hs.H == 'H' && hs.A == 'A' && hs.N == 'N' && hs.D == 'D' && hs.S == 'S' && hs.K == 'K' && hs.E == 'E'){
-					if(hs.port != std::numeric_limits<unsigned short>::max())
-						// If the data looks good return the port
-						return hs.port;
-				}
-			}
+	boost::asio::io_context io;
+	std::optional<unsigned short> remotePort;
+	std::vector<std::unique_ptr<Probe>> probes;
+
+	// Connect to every port, send a request, and wait for a handshake in response
+	for(size_t port = start; port < size_t(start) + range && port <= std::numeric_limits<unsigned short>::max(); port++){
+		Probe* probe = probes.emplace_back(std::make_unique<Probe>(io)).get();
+		probe->sock.async_connect({address, (unsigned short) port}, [&, probe](const boost::system::error_code& ec){
+			if(ec) return;
+			boost::asio::async_write(probe->sock, boost::asio::buffer(HANDSHAKE_REQUEST), [&, probe](const boost::system::error_code& ec, size_t){
+				if(ec) return;
+				boost::asio::async_read(probe->sock, boost::asio::buffer(reinterpret_cast<char*>(&probe->hs), sizeof(probe->hs)), [&, probe](const boost::system::error_code& ec, size_t){
+					// Once a valid handshake arrives, stop probing
+					if(!ec && validHandshake(probe->hs) && !remotePort){
+						remotePort = probe->hs.port;
+						io.stop();
+					}
+				});
+			});
+		});
+	}
 
-			// Make sure we close the socket before we open a new one
-			sock.close(ec);
-			if(ec) throw boost::system::system_error(ec);
+	// Returns early if every probe finishes (or a handshake is found) before the deadline
+	io.run_for(deadline);
+	return remotePort;
+}
 
-		} catch(boost::system::system_error&) {
-			// On ASIO exception try the handshake port again
-			handshakePort--;
-		} catch(...) { }
+/**
+ * @brief Function which discovers the network port of a remote address
+ *
+ * @param address - IP Address to ping
+ * @return unsigned short - The discovered remote port
+ */
+unsigned short handshake::determineRemotePort(const boost::asio::ip::address& address){
+	if(auto remotePort = probeRemotePort(address))
+		return *remotePort;
 
-	// If we couldn't connect in 5 seconds
+	// If we couldn't find a handshake server in time
+	unsigned short remotePort = -1;
 	std::cout << "We were unable to automatically detect a network on `" << address.to_string() << "`" << std::endl << " please provide a port manually: ";
 	std::cin >> remotePort;
 
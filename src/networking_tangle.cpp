@@ -15,8 +15,9 @@
  * @param network The network this tangle is connected to
  */
 NetworkedTangle::NetworkedTangle(breep::tcp::network& network) : network(network) {
-    // Make sure that the network queue has some memory backing it
-    networkAdditionQueue.getContainer().resize(NETWORK_QUEUE_MIN_SIZE);
+    // Checkpoint the account state at the starting genesis, and apply transactions to it as the confirmation checker finds them confirmed
+    accountState.write_lock()->genesis = genesis->hash;
+    onConfirmationCheck = [this]() { confirmTransactions(); };
 
     // Listen to dis/connection events
     auto connect_disconnectListenerClosure = [this] (breep::tcp::network& network, const breep::tcp::peer& peer) -> void {
@@ -43,6 +44,21 @@ NetworkedTangle::NetworkedTangle(breep::tcp::network& network) : network(network
     network.add_data_listener<TangleSynchronizeRequest>([this] (breep::tcp::netdata_wrapper<TangleSynchronizeRequest>& dw) -> void {
         TangleSynchronizeRequest::listener(dw, *this);
     });
+    network.add_data_listener<StateSnapshotRequest>([this] (breep::tcp::netdata_wrapper<StateSnapshotRequest>& dw) -> void {
+        StateSnapshotRequest::listener(dw, *this);
+    });
+    network.add_data_listener<StateSnapshotResponse>([this] (breep::tcp::netdata_wrapper<StateSnapshotResponse>& dw) -> void {
+        StateSnapshotResponse::listener(dw, *this);
+    });
+    network.add_data_listener<StateSnapshotAttestRequest>([this] (breep::tcp::netdata_wrapper<StateSnapshotAttestRequest>& dw) -> void {
+        StateSnapshotAttestRequest::listener(dw, *this);
+    });
+    network.add_data_listener<StateSnapshotAttestation>([this] (breep::tcp::netdata_wrapper<StateSnapshotAttestation>& dw) -> void {
+        StateSnapshotAttestation::listener(dw, *this);
+    });
+    network.add_data_listener<SyncChunk>([this] (breep::tcp::netdata_wrapper<SyncChunk>& dw) -> void {
+        SyncChunk::listener(dw, *this);
+    });
     network.add_data_listener<UpdateWeightsRequest>([this] (breep::tcp::netdata_wrapper<UpdateWeightsRequest>& dw) -> void {
         UpdateWeightsRequest::listener(dw, *this);
     });
@@ -57,6 +73,31 @@ NetworkedTangle::NetworkedTangle(breep::tcp::network& network) : network(network
     network.add_data_listener<AddTransactionRequest>([this] (breep::tcp::netdata_wrapper<AddTransactionRequest>& dw) -> void {
         AddTransactionRequest::listener(dw, *this);
     });
+
+    // Listen for light node subscriptions and requests
+    network.add_data_listener<GossipFilter>([this] (breep::tcp::netdata_wrapper<GossipFilter>& dw) -> void {
+        GossipFilter::listener(dw, *this);
+    });
+    network.add_data_listener<TipsRequest>([this] (breep::tcp::netdata_wrapper<TipsRequest>& dw) -> void {
+        TipsRequest::listener(dw, *this);
+    });
+    network.add_data_listener<TipsResponse>([this] (breep::tcp::netdata_wrapper<TipsResponse>& dw) -> void {
+        TipsResponse::listener(dw, *this);
+    });
+    network.add_data_listener<AccountProofRequest>([this] (breep::tcp::netdata_wrapper<AccountProofRequest>& dw) -> void {
+        AccountProofRequest::listener(dw, *this);
+    });
+    network.add_data_listener<AccountProofResponse>([this] (breep::tcp::netdata_wrapper<AccountProofResponse>& dw) -> void {
+        AccountProofResponse::listener(dw, *this);
+    });
+
+    // Listen for peers telling us to slow down, or what difficulty they accept
+    network.add_data_listener<SlowDown>([this] (breep::tcp::netdata_wrapper<SlowDown>& dw) -> void {
+        SlowDown::listener(dw, *this);
+    });
+    network.add_data_listener<DifficultyAnnouncement>([this] (breep::tcp::netdata_wrapper<DifficultyAnnouncement>& dw) -> void {
+        DifficultyAnnouncement::listener(dw, *this);
+    });
 }
 
 /**
@@ -93,10 +134,367 @@ const key::PublicKey& NetworkedTangle::findAccount(Hash keyHash) const {
  */
 Hash NetworkedTangle::add(TransactionNode::ptr node){
     Hash out = Tangle::add(node);
-    network.send_object(AddTransactionRequest(*node, *personalKeys)); // The add gets validated by the base tangle, if we get to this code (no exception) then the node is acceptable
+    gossip(*node); // The add gets validated by the base tangle, if we get to this code (no exception) then the node is acceptable
+    recordIngest(*node);
     return out;
 }
 
+/**
+ * @brief Function which sends a transaction to every peer, skipping peers whose gossip filter it doesn't match
+ * 
+ * @param transaction - The transaction to send
+ */
+void NetworkedTangle::gossip(const Transaction& transaction) {
+    AddTransactionRequest request(transaction, *personalKeys);
+    auto filters = peerFilters.read_lock();
+
+    // If nobody has subscribed with a filter... simply broadcast
+    if(filters->empty()) return network.send_object(request);
+
+    // Function which checks if any account the transaction touches might be in a filter
+    auto matches = [&transaction](const BloomFilter& filter) {
+        return std::any_of(transaction.inputs.begin(), transaction.inputs.end(), [&filter](auto& input) { return filter.mayContain(input.accountBase64()); })
+            || std::any_of(transaction.outputs.begin(), transaction.outputs.end(), [&filter](auto& output) { return filter.mayContain(output.accountBase64()); });
+    };
+
+    for(auto& [id, peer]: network.peers())
+        if(auto filter = filters->find(id); filter == filters->end() || matches(filter->second))
+            network.send_object_to(peer, request);
+}
+
+/**
+ * @brief Function which decides if a message from a peer should be processed, telling the peer to slow down if they have exceeded their limit
+ * @note Our own messages are always admitted
+ * 
+ * @param source - The peer who sent the message
+ * @param type - The class of the message
+ * @return bool - True if the message should be processed, false if it should be dropped
+ */
+bool NetworkedTangle::admit(const breep::tcp::peer& source, AdmissionControl::Class type) {
+    if(source.id() == network.self().id()) return true;
+
+    auto verdict = admissions.admit(source.id(), type);
+    if(verdict.slowDown){
+        network.send_object_to(source, SlowDown{type, uint32_t(std::min<int64_t>(verdict.retryAfter.count(), ADMISSION_MAX_BACKOFF))});
+        std::cerr << "Peer `" << source.id() << "` exceeded its " << AdmissionControl::name(type) << " limit, told it to slow down for " << verdict.retryAfter.count() << "ms" << std::endl;
+    }
+    return verdict.admitted;
+}
+
+/**
+ * @brief Function which determines how long we should hold off sending a class of message (the longest any peer has asked us to wait)
+ * 
+ * @param type - The class of message
+ * @return std::chrono::milliseconds - How long to wait (0 if nobody has asked us to slow down)
+ */
+std::chrono::milliseconds NetworkedTangle::backoff(AdmissionControl::Class type) const {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::milliseconds longest(0);
+    for(auto& [peer, until]: *backoffs.read_lock())
+        if(until[size_t(type)] > now)
+            longest = std::max(longest, std::chrono::duration_cast<std::chrono::milliseconds>(until[size_t(type)] - now));
+    return longest;
+}
+
+/**
+ * @brief Listener for SlowDown events. Remembers how long the peer asked us to wait (capped, so a peer can't stall us indefinitely)
+ * 
+ * @param networkData - The event received
+ * @param t - The tangle which received the event
+ */
+void NetworkedTangle::SlowDown::listener(breep::tcp::netdata_wrapper<SlowDown>& networkData, NetworkedTangle& t){
+    auto wait = std::chrono::milliseconds(std::min<uint32_t>(networkData.data.retryAfter, ADMISSION_MAX_BACKOFF));
+    (*t.backoffs.write_lock())[networkData.source.id()][size_t(networkData.data.type)] = std::chrono::steady_clock::now() + wait;
+    std::cerr << "Peer `" << networkData.source.id() << "` asked us to slow down our " << AdmissionControl::name(networkData.data.type) << " messages for " << wait.count() << "ms" << std::endl;
+}
+
+/**
+ * @brief Function which lists the accounts a transaction spends from
+ * 
+ * @param inputs - The transaction's inputs
+ * @return std::vector<std::string> - The (base 64) accounts
+ */
+std::vector<std::string> NetworkedTangle::spenders(const std::vector<Transaction::Input>& inputs) {
+    std::vector<std::string> out;
+    for(auto& input: inputs)
+        out.push_back(input.accountBase64());
+    return out;
+}
+
+/**
+ * @brief Function which records a transaction which was added to the tangle in the difficulty policy, advertising the new minimum difficulty to our peers if it changed
+ * 
+ * @param transaction - The transaction which was added
+ */
+void NetworkedTangle::recordIngest(const Transaction& transaction) {
+    if(difficulty.record(spenders(transaction.inputs), tips.read_lock()->size()))
+        advertiseDifficulty();
+}
+
+/**
+ * @brief Function which recalculates the minimum difficulty while transactions aren't arriving (so it falls back once a burst passes), advertising it to our peers if it changed
+ * @note Called every DIFFICULTY_REFRESH_INTERVAL milliseconds
+ */
+void NetworkedTangle::refreshDifficulty() {
+    if(difficulty.refresh(tips.read_lock()->size()))
+        advertiseDifficulty();
+}
+
+/**
+ * @brief Function which advertises our current minimum difficulty to our peers
+ */
+void NetworkedTangle::advertiseDifficulty() {
+    auto minimum = difficulty.minimum();
+    network.send_object(DifficultyAnnouncement{minimum});
+    std::cout << "Minimum difficulty changed to " << int(minimum) << std::endl;
+}
+
+/**
+ * @brief Function which determines the minimum difficulty most of the network accepts (the median of the minimums our peers have advertised and our own)
+ * 
+ * @return uint8_t - The minimum difficulty
+ */
+uint8_t NetworkedTangle::networkDifficulty() const {
+    std::vector<uint8_t> minimums = {difficulty.minimum()};
+    for(auto& [peer, minimum]: *peerDifficulties.read_lock())
+        minimums.push_back(minimum);
+
+    auto median = minimums.begin() + minimums.size() / 2;
+    std::nth_element(minimums.begin(), median, minimums.end());
+    return *median;
+}
+
+/**
+ * @brief Function which determines the difficulty a new transaction should be mined at, so that we and most of our peers will accept it
+ * 
+ * @param inputs - The transaction's inputs (accounts which spend often need to mine at a higher difficulty)
+ * @param requested - The difficulty requested (used if it is higher)
+ * @return uint8_t - The difficulty to mine at
+ */
+uint8_t NetworkedTangle::miningDifficulty(const std::vector<Transaction::Input>& inputs, uint8_t requested /*= 0*/) const {
+    return std::max({requested, difficulty.required(spenders(inputs)), networkDifficulty()});
+}
+
+/**
+ * @brief Function which replaces the tangle's genesis, checkpointing the authenticated account state at the new genesis' balances
+ * 
+ * @param genesis - The new genesis
+ */
+void NetworkedTangle::setGenesis(TransactionNode::ptr genesis) {
+    Tangle::setGenesis(genesis);
+    if(genesis) *accountState.write_lock() = {merkle::AccountTree(genesis->outputs), genesis->hash, {}};
+}
+
+/**
+ * @brief Function which applies every newly confirmed transaction to the authenticated account state
+ * @note Only transactions which haven't been applied yet have their confidence measured, so the state is updated incrementally
+ * @note Called by the confirmation checker (rate limited to one run every EVENT_CONFIRMATION_INTERVAL milliseconds), readers of the state never call it
+ * 
+ * @param threshold - The confidence at which a transaction is considered confirmed
+ * @return size_t - The number of transactions which were applied
+ */
+size_t NetworkedTangle::confirmTransactions(float threshold /*= 1*/) {
+    // Find the transactions which haven't been applied yet
+    std::vector<TransactionNode::const_ptr> pending;
+    std::string checkpoint;
+    {
+        auto nodes = listTransactions();
+        auto state = accountState.read_lock();
+        checkpoint = state->genesis;
+        for(auto& node: nodes)
+            if(!node->isGenesis && !state->applied.contains(node->hash))
+                pending.push_back(node);
+    }
+
+    // Measure their confidence (without holding the state's lock)
+    std::vector<TransactionNode::const_ptr> confirmed;
+    for(auto& node: pending)
+        if(node->isConfident(threshold, CONFIDENCE_STRICT_INDIFFERENCE)) // NOTE: applied balances can't be taken back, so transactions just short of the threshold don't count
+            confirmed.push_back(node);
+
+    // Apply them (unless the state was checkpointed at a new genesis in the meantime)
+    auto state = accountState.write_lock();
+    if(state->genesis != checkpoint) return 0;
+    size_t applied = 0;
+    for(auto& node: confirmed)
+        if(state->applied.insert(node->hash).second){
+            state->tree.apply(*node);
+            applied++;
+        }
+    return applied;
+}
+
+/**
+ * @brief Function which gets the root of the authenticated account state (the commitment to every confirmed balance)
+ * 
+ * @return std::string - The root
+ */
+std::string NetworkedTangle::stateRoot() {
+    return accountState.write_lock()->tree.root(); // NOTE: calculating the root fills the tree's cache, so a write lock is needed
+}
+
+/**
+ * @brief Function which proves an account's confirmed balance (or that it has none) against the authenticated account state
+ * 
+ * @param account - The base 64 representation of the account's key
+ * @return std::pair<std::string, merkle::AccountTree::Proof> - The root the proof leads to, and the proof
+ */
+std::pair<std::string, merkle::AccountTree::Proof> NetworkedTangle::proveAccount(const std::string& account) {
+    auto state = accountState.write_lock();
+    return {state->tree.root(), state->tree.prove(account)};
+}
+
+/**
+ * @brief Function which switches the node into light mode, where only a window of recent tips and the transactions touching the given accounts are kept
+ * @note Peers are asked to only gossip transactions which match a Bloom filter of the accounts, balances are then confirmed with proofs from a sample of peers
+ * @note The tangle itself is no longer updated (it is reduced to its genesis), so nothing but the light functions should be used afterwards
+ * 
+ * @param accounts - The base 64 representations of the accounts to track (our own account if empty)
+ */
+void NetworkedTangle::enableLightMode(const std::vector<std::string>& accounts /*= {}*/) {
+    {
+        auto state = light.write_lock();
+        state->enabled = true;
+        state->accounts = accounts.empty() ? std::vector<std::string>{key::saveBase64(personalKeys->pub)} : accounts;
+        state->filter = BloomFilter(state->accounts.size(), LIGHT_FILTER_FALSE_POSITIVE_RATE);
+        for(auto& account: state->accounts)
+            state->filter.insert(account);
+
+        // Subscribe to the filtered gossip
+        network.send_object(GossipFilter{state->filter});
+    }
+
+    // Free the graph (only the genesis is kept), transactions already gossiped to us are refreshed from the proofs
+    setGenesis(genesis);
+    std::cout << "Switched to light mode, tracking " << accounts.size() + accounts.empty() << " account(s)" << std::endl;
+
+    refreshLightState();
+}
+
+/**
+ * @brief Function which asks a fresh sample of peers for their tips and proofs of our accounts' balances
+ */
+void NetworkedTangle::refreshLightState() {
+    auto state = light.write_lock();
+    if(!state->enabled) return;
+
+    auto& peers = network.peers();
+    state->sample = GenesisElection::choose(peers, LIGHT_PROOF_SAMPLE_SIZE);
+    state->proofs.clear();
+    for(auto& id: state->sample){
+        network.send_object_to(peers.at(id), TipsRequest());
+        for(auto& account: state->accounts)
+            network.send_object_to(peers.at(id), AccountProofRequest{account});
+    }
+}
+
+/**
+ * @brief Function which gets the (proof verified) confirmed balance of a tracked account
+ * 
+ * @param account - The base 64 representation of the account's key
+ * @return std::optional<merkle::Balance> - The balance, or nothing if it hasn't been verified yet
+ */
+std::optional<merkle::Balance> NetworkedTangle::lightBalance(const std::string& account) const {
+    auto state = light.read_lock();
+    if(auto balance = state->confirmed.find(account); balance != state->confirmed.end())
+        return balance->second;
+    return {};
+}
+
+/**
+ * @brief Function which reserves the next sequence number of a tracked account (the light version of reserveSequence)
+ * @note Sequence numbers start after the confirmed balance's, and skip any spent by transactions we have seen
+ * 
+ * @param account - The base 64 representation of the account's key
+ * @return uint64_t - The reserved sequence number
+ */
+uint64_t NetworkedTangle::reserveLightSequence(const std::string& account) {
+    auto state = light.write_lock();
+    uint64_t next = 0;
+    if(auto balance = state->confirmed.find(account); balance != state->confirmed.end())
+        next = balance->second.sequence;
+    for(auto& transaction: state->transactions)
+        for(auto& input: transaction.inputs)
+            if(input.accountBase64() == account)
+                next = std::max(next, input.sequence + 1);
+
+    auto& reserved = state->sequences[account];
+    reserved = std::max(reserved, next);
+    return reserved++;
+}
+
+/**
+ * @brief Function which creates, mines, and gossips a transaction from a light node (the light version of add)
+ * @note Parents are picked at random from the recent tips window, the network validates the balance when the transaction is added to full nodes' tangles
+ * 
+ * @param inputs - The inputs of the transaction
+ * @param outputs - The outputs of the transaction
+ * @param difficulty - The mining difficulty (raised to what the network accepts if lower)
+ * @return Hash - The hash of the transaction
+ */
+Hash NetworkedTangle::addLight(const std::vector<Transaction::Input>& inputs, const std::vector<Transaction::Output>& outputs, uint8_t difficulty /*= 3*/) {
+    // Pick (up to) two recent tips to approve
+    std::vector<std::string> parents;
+    {
+        auto state = light.read_lock();
+        if(state->tips.empty()) throw std::runtime_error("Failed to find a tip! (no peer has sent us their tips yet)");
+        std::sample(state->tips.begin(), state->tips.end(), std::back_inserter(parents), 2, std::mt19937(std::random_device{}()));
+    }
+
+    // Make sure the transaction is mined at a difficulty the network will accept
+    difficulty = miningDifficulty(inputs, difficulty);
+    Transaction transaction(std::span<Hash>(parents.data(), parents.size()), inputs, outputs, difficulty);
+    if(!transaction.validateTransaction()) throw std::runtime_error("Transaction with hash `" + transaction.hash + "` is invalid, discarding.");
+    transaction.mineTransaction();
+
+    light.write_lock()->observe(transaction);
+    gossip(transaction);
+    return transaction.hash;
+}
+
+/**
+ * @brief Function which gets the counters describing light mode
+ * 
+ * @return LightStats - The counters
+ */
+NetworkedTangle::LightStats NetworkedTangle::lightStats() const {
+    auto state = light.read_lock();
+    return { state->enabled, state->accounts.size(), state->filter.size(), state->tips.size(), state->transactions.size(), state->received, state->falsePositives, state->proofsAccepted, state->proofsRejected };
+}
+
+/**
+ * @brief Function which checks if a transaction touches any of the tracked accounts (exactly, unlike the filter)
+ * 
+ * @param transaction - The transaction to check
+ * @return bool - True if one of the transaction's inputs or outputs belongs to a tracked account
+ */
+bool NetworkedTangle::LightState::tracks(const Transaction& transaction) const {
+    auto tracked = [this](const Transaction::Output& output) { return std::find(accounts.begin(), accounts.end(), output.accountBase64()) != accounts.end(); };
+    return std::any_of(transaction.inputs.begin(), transaction.inputs.end(), tracked) || std::any_of(transaction.outputs.begin(), transaction.outputs.end(), tracked);
+}
+
+/**
+ * @brief Function which records a transaction seen by a light node, the transaction becomes a tip (replacing its parents) and is remembered if it touches our accounts
+ * 
+ * @param transaction - The transaction
+ */
+void NetworkedTangle::LightState::observe(const Transaction& transaction) {
+    for(auto& parent: transaction.parentHashes)
+        if(auto tip = std::find(tips.begin(), tips.end(), parent); tip != tips.end())
+            tips.erase(tip);
+    if(std::find(tips.begin(), tips.end(), transaction.hash) == tips.end())
+        tips.push_back(transaction.hash);
+    while(tips.size() > LIGHT_TIP_WINDOW) tips.pop_front();
+
+    if(!tracks(transaction)) {
+        falsePositives++;
+        return;
+    }
+    if(std::any_of(transactions.begin(), transactions.end(), [&transaction](auto& seen) { return seen.hash == transaction.hash; })) return;
+    transactions.push_back(transaction);
+    while(transactions.size() > LIGHT_HISTORY_SIZE) transactions.pop_front();
+}
+
 /**
  * @brief Function which creates the latest common genesis (node representing a set of what were once tips with 100% confidence)
  * @return TransactionNode::ptr - The generated genesis
@@ -112,7 +510,7 @@ TransactionNode::ptr NetworkedTangle::createLatestCommonGenesis(){
     for(auto& canidate: genesisCandidates.getContainer()){
         bool valid = true;
         for(auto& trx: canidate)
-            if(trx->confirmationConfidence() < 1){
+            if(!trx->isConfident(1, CONFIDENCE_STRICT_INDIFFERENCE)){ // NOTE: everything before the genesis is pruned, so only unanimous walks count
                 valid = false;
                 break;
             }
@@ -125,49 +523,76 @@ TransactionNode::ptr NetworkedTangle::createLatestCommonGenesis(){
     if(!_chosen) return genesis;
     std::cout << "Picked Genesis Nodes" << std::endl;
 
-    std::vector<TransactionNode::const_ptr>& chosen = *_chosen;
-    std::vector<TransactionNode::const_ptr> parents;
-    std::vector<Transaction::Input> inputs;
+    // Create a new genesis holding the balances as of the chosen nodes, its hash is the hash of the first chosen node and it aliases the rest
+    std::vector<std::string> cut;
+    for(auto& node: *_chosen)
+        cut.push_back(node->hash);
+    return createGenesis(cut, tabulateBalances(*_chosen));
+}
+
+/**
+ * @brief Function which calculates the balance (and next sequence number) of every account as of a cut through the tangle
+ * @note Accounts which are only referenced after the cut (which would have an empty balance) are left out, so the result only depends on the cut
+ *
+ * @param chosen - The nodes making up the cut (their ancestors are everything before the cut)
+ * @return std::vector<Transaction::Output> - An output holding the balance and next sequence number of each account
+ */
+std::vector<Transaction::Output> NetworkedTangle::tabulateBalances(const std::vector<TransactionNode::const_ptr>& chosen) const {
     std::vector<Transaction::Output> outputs;
 
-    // Lamba which calculates the balance of the given acount as seen by the chosen nodes
-    auto reverseBalanceQuery = [&](const key::PublicKey& account){
-        std::list<std::string> considered;
-        double balance = 0;
+    // The next sequence number each account can spend after the cut
+    std::unordered_map<account::ID, uint64_t> nextSequences;
+
+    // Lambda which flattens the inputs and outputs of the chosen nodes (and all of their ancestors) into contiguous columns of accounts and balance changes
+    // NOTE: also tabulates the next sequence number of each account
+    auto gatherBalanceChanges = [&](){
+        std::unordered_set<std::string> considered;
+        TransactionNode::AccountColumns changes;
 
         std::queue<TransactionNode::const_ptr> q;
-        for(auto& c: chosen) q.push(c);
+        for(auto& c: chosen)
+            if(considered.insert(c->hash).second)
+                q.push(c);
 
         while(!q.empty()){
             auto head = q.front();
             q.pop();
             if(!head) continue;
 
-            // NOTE: the balances have already been validated going forward... assuming they are correct
-            // Add up how this transaction takes away from the balance of interest
-            for(const Transaction::Input& input: head->inputs)
-                if(input.account() == account)
-                    balance -= input.amount;
-            // Add up how this transaction adds to the balance of interest
-            for(const Transaction::Output& output: head->outputs)
-                if(output.account() == account)
-                    balance += output.amount;
+            // NOTE: the balances have already been validated going forward... assuming they are correct (and thus non-negative)
+            // Inputs take away from the balance of their account
+            changes.accounts.insert(changes.accounts.end(), head->inputColumns.accounts.begin(), head->inputColumns.accounts.end());
+            for(Amount::Raw amount: head->inputColumns.amounts)
+                changes.amounts.push_back(-amount);
+            // Outputs add to the balance of their account
+            changes.accounts.insert(changes.accounts.end(), head->outputColumns.accounts.begin(), head->outputColumns.accounts.end());
+            changes.amounts.insert(changes.amounts.end(), head->outputColumns.amounts.begin(), head->outputColumns.amounts.end());
+
+            // Every sequence number spent at or before the cut can't be spent again (the old genesis carries forward the sequence numbers spent before it)
+            for(size_t i = 0; i < head->inputs.size(); i++){
+                auto& next = nextSequences[head->inputColumns.accounts[i]];
+                next = std::max(next, head->inputs[i].sequence + 1);
+            }
+            if(head->isGenesis)
+                for(size_t i = 0; i < head->outputs.size(); i++){
+                    auto& next = nextSequences[head->outputColumns.accounts[i]];
+                    next = std::max(next, head->outputs[i].sequence);
+                }
 
             // Add all of the parents to the queue if they weren't already there
             for(auto& parent: head->parents)
-                if(std::find(considered.begin(), considered.end(), parent->hash) == considered.end()){
+                if(considered.insert(parent->hash).second)
                     q.push(parent);
-                    considered.push_back(parent->hash);
-                }
         }
 
-        return balance;
+        return changes;
     };
 
     // Lambda which generates a list of every account refernced in the tangle
     auto listAccounts = [&](){
-        std::list<std::string> considered;
-        std::list<key::PublicKey> out;
+        std::unordered_set<std::string> considered;
+        std::vector<account::ID> ids;
+        std::vector<std::pair<account::ID, key::PublicKey>> out;
 
         std::queue<TransactionNode::const_ptr> q;
         q.push(genesis);
@@ -179,12 +604,15 @@ TransactionNode::ptr NetworkedTangle::createLatestCommonGenesis(){
 
             // Find all of the accounts referenced in this transaction and add them to the output list (if they aren't already there)
             for(const Transaction::Input& input: head->inputs)
-                if(auto account = input.account(); std::find(out.begin(), out.end(), account) == out.end())
-                    out.push_back(account);
-            // Add up how this transaction adds to the balance of interest
+                if(auto id = input.accountID(); !kernels::contains(ids.data(), ids.size(), id)){
+                    ids.push_back(id);
+                    out.emplace_back(id, input.account());
+                }
             for(const Transaction::Output& output: head->outputs)
-                if(auto account = output.account(); std::find(out.begin(), out.end(), account) == out.end())
-                    out.push_back(account);
+                if(auto id = output.accountID(); !kernels::contains(ids.data(), ids.size(), id)){
+                    ids.push_back(id);
+                    out.emplace_back(id, output.account());
+                }
 
             // Determine if this node is one of the chosen nodes
             bool isChosen = false;
@@ -198,10 +626,8 @@ TransactionNode::ptr NetworkedTangle::createLatestCommonGenesis(){
             if(!isChosen) {
                 auto lock = head->children.read_lock();
                 for(size_t i = 0, size = lock->size(); i < size; i++)
-                    if(auto child = lock[i]; std::find(considered.begin(), considered.end(), child->hash) == considered.end()){
+                    if(auto child = lock[i]; considered.insert(child->hash).second)
                         q.push(child);
-                        considered.push_back(child->hash);
-                    }
             }
         }
 
@@ -209,21 +635,33 @@ TransactionNode::ptr NetworkedTangle::createLatestCommonGenesis(){
     };
 
     // Calculate the balance of every peer referenced in an account before the chosen nodes, and add that balance as an output of the genesis
-    for(auto accounts = listAccounts(); auto& account: accounts)
-        outputs.emplace_back(account, reverseBalanceQuery(account));
+    auto changes = gatherBalanceChanges();
+    for(auto accounts = listAccounts(); auto& [id, account]: accounts)
+        if(Amount balance = changes.total(id); balance.raw != 0 || nextSequences[id] != 0)
+            outputs.emplace_back(account, balance, nextSequences[id]);
 
     std::cout << "Tabulated account balances" << std::endl;
+    return outputs;
+}
 
-    // Create a new transaction and set its hash to the hash of the first chosen node
-    auto trx = TransactionNode::create(parents, inputs, outputs);
-    util::mutable_cast(trx->hash) = chosen[0]->hash;
+/**
+ * @brief Function which creates a genesis node representing a cut through the tangle
+ *
+ * @param cut - The hashes of the nodes making up the cut (the genesis takes the first hash and aliases the rest)
+ * @param balances - The balance (and next sequence number) of every account as of the cut
+ * @return TransactionNode::ptr - The generated genesis
+ */
+TransactionNode::ptr NetworkedTangle::createGenesis(const std::vector<std::string>& cut, const std::vector<Transaction::Output>& balances) {
+    // Create a new transaction and set its hash to the hash of the first node in the cut
+    auto trx = TransactionNode::create({}, {}, balances);
+    util::mutable_cast(trx->hash) = cut[0];
 
-    // Fill the transaction's parent hashes with the remaining hashes of the chosen nodes
+    // Fill the transaction's parent hashes with the remaining hashes of the cut
     auto& parentHashes = util::mutable_cast(trx->parentHashes);
     delete [] parentHashes.data(); // Free the current parent hashes
-    parentHashes = {new Hash[chosen.size() - 1], chosen.size() - 1}; // Create new memory to back the parent hashes
-    for(int i = 1; i < chosen.size(); i++)
-        util::mutable_cast(parentHashes[i]) = chosen[i]->hash;
+    parentHashes = {new Hash[cut.size() - 1], cut.size() - 1}; // Create new memory to back the parent hashes
+    for(int i = 1; i < cut.size(); i++)
+        util::mutable_cast(parentHashes[i - 1]) = cut[i];
 
     return trx;
 }
@@ -232,6 +670,8 @@ TransactionNode::ptr NetworkedTangle::createLatestCommonGenesis(){
  * @brief // Function which prunes the tangle, it finds the latest common genesis and removes all nodes before it
  */
 void NetworkedTangle::prune(){
+    // Remember what the tangle held (so subscribers can be told which transactions were pruned)
+    auto before = snapshot();
     // Generate the new latest common genesis
     auto genesis = createLatestCommonGenesis();
 
@@ -286,6 +726,9 @@ void NetworkedTangle::prune(){
 
     // Restore the original list of tips
     *util::mutable_cast(tips.write_lock()) = originalTips;
+    // Publish a snapshot with the restored tips
+    republish();
+    announcePruned(*before);
 }
 
 /**
@@ -293,23 +736,17 @@ void NetworkedTangle::prune(){
  * @param out - Output stream to save the file to
  */
 void NetworkedTangle::saveTangle(std::ostream& out) {
-    // List all of the transactions in the tangle
-    std::list<TransactionNode*> transactions = listTransactions();
-    // Sort them according to time, ensuring that the genesis remains at the front of the list
-    Transaction* genesis = transactions.front();
-    transactions.sort([genesis](Transaction* a, Transaction* b){
-        if(a->hash == genesis->hash) return true;
-        if(b->hash == genesis->hash) return false;
-        return a->timestamp < b->timestamp;
-    });
+    // List all of the transactions in a snapshot of the tangle (the genesis comes first, and parents always come before their children)
+    std::vector<TransactionNode::const_ptr> transactions = listTransactions();
 
-    // Serialize the number of transactions
+    // Serialize the number of transactions, and the commitment to the genesis' balances (checked when loading)
     breep::serializer s;
     s << transactions.size();
+    s << merkle::commit(transactions.front()->outputs);
 
     // Serialize each of the transactions
-    for(Transaction* _t: transactions){
-        const Transaction& t = *_t;
+    for(const TransactionNode::const_ptr& node: transactions){
+        const Transaction& t = *node;
         s << t;
     }
 
@@ -340,18 +777,22 @@ void NetworkedTangle::loadTangle(std::istream& in, size_t size) {
     // Determine how many transactions there are to read
     size_t transactionCount;
     d >> transactionCount;
+    std::string commitment;
+    d >> commitment;
 
-    // The genesis is always the first transaction in the file
+    // The genesis is always the first transaction in the file (ensure its balances weren't corrupted)
     Transaction trx;
     d >> trx;
+    if(merkle::commit(trx.outputs) != commitment)
+        throw std::runtime_error("Saved genesis doesn't match its commitment, the file is corrupted");
     genesisSyncExpectedHash = trx.hash; // Flag us as prepared to receive a new genesis
     network.send_object_to_self(SyncGenesisRequest(trx, *personalKeys));
 
-    // Read in each transaction from the deserializer and then add it to the tangle
-    for(int i = 0; i < transactionCount - 1; i++) { // Minus 1 since we already synced the genesis
-        d >> trx;
-        network.send_object_to_self(SynchronizationAddTransactionRequest(trx, *personalKeys));
-    }
+    // Read in every transaction from the deserializer (rehashing them all at once) and then add them to the tangle
+    std::vector<Transaction> transactions(transactionCount - 1); // Minus 1 since we already synced the genesis
+    deserializeTransactions(d, transactions);
+    for(auto& transaction: transactions)
+        network.send_object_to_self(SynchronizationAddTransactionRequest(transaction, *personalKeys));
 
     // Update our weights
     network.send_object_to_self(UpdateWeightsRequest());
@@ -405,68 +846,104 @@ NetworkedTangle::GenesisVoteResponse::GenesisVoteResponse(const NetworkedTangle&
 }
 
 /**
- * @brief Listener for GenesisVoteResponse events. Counts the vote of the sender, if enouph votes have accrued for a genesis or everyone we are aware of has voted request it
+ * @brief Listener for GenesisVoteResponse events. Submits the sender's vote to the current election (once we have their public key)
  * 
  * @param networkData - The event recieved
  * @param t - The tangle which recieved the event
  */
 void NetworkedTangle::GenesisVoteResponse::listener(breep::tcp::netdata_wrapper<GenesisVoteResponse> &networkData, NetworkedTangle &t) {
-    // If we aren't accepting votes... ignore the message
-    if(!t.genesisVotes) return;
-    // If we don't have the sender's public key, ask for it and then ask for their vote again
+    // If we aren't accepting votes (or didn't ask this peer to vote)... ignore the message
+    auto election = t.election.load();
+    if(!election || !election->sampled(networkData.source.id())) return;
+
+    // If we don't have the sender's public key, hold onto their vote and ask for the key (the vote is counted once it arrives)
     if(!t.peerKeys.contains(networkData.source.id())){
+        t.pendingVotes.write_lock()->insert_or_assign(networkData.source.id(), std::make_pair(networkData.data.genesisHashes, networkData.data.signature));
         t.network.send_object_to(networkData.source, PublicKeySyncRequest());
-        t.network.send_object_to(networkData.source, GenesisVoteRequest());
         return;
     }
-    // Verify that the vote is from who it says it is
+
+    t.submitVote(networkData.source.id(), networkData.data.genesisHashes, networkData.data.signature);
+    std::cout << "Recieved genesis vote from `" << networkData.source.id() << "`" << std::endl;
+}
+
+/**
+ * @brief Function which submits a genesis vote to the current election, the vote's signature is verified on one of the election's verifying threads
+ * 
+ * @param voter - The peer who cast the vote (we must have their public key)
+ * @param genesisHashes - The hashes the voter's genesis represents
+ * @param signature - Signature of the hashes
+ */
+void NetworkedTangle::submitVote(const boost::uuids::uuid& voter, GenesisElection::Ballot genesisHashes, std::string signature) {
+    auto election = this->election.load();
+    if(!election) return;
+
+    // Combine the hashes (what was signed)
     std::string message;
-    for(auto& hash: networkData.data.genesisHashes)
+    for(auto& hash: genesisHashes)
         message += hash;
-    if(!key::verifyMessage(t.peerKeys[networkData.source.id()], message, networkData.data.signature))
-        throw std::runtime_error("Genesis vote failed, sender's identity failed to be verified, discarding.");
-
-    // Increment the hash's count in the recieved map
-    auto& hashes = networkData.data.genesisHashes;
-    auto& genesisVotes = *t.genesisVotes;
-    if(!genesisVotes.contains(hashes))
-        genesisVotes[hashes] = {networkData.source.id(), 1};
-    else genesisVotes[hashes].second++;
-    std::cout << "Recieved genesis vote from `" << networkData.source.id() << "`" << std::endl;
 
-    
-    // Lambda which accepts a vote from a peer
-    auto acceptVote = [&t](const breep::tcp::peer& source, std::string_view expectedHash){
-        // Clear the votes
-        t.genesisVotes.reset(nullptr);
+    // NOTE: the key is copied so the verifying thread doesn't touch the key map
+    election->submit(voter, std::move(genesisHashes), [voter, key = peerKeys.at(voter), message = std::move(message), signature = std::move(signature)] {
+        if(key::verifyMessage(key, message, signature)) return true;
+
+        std::cerr << "Genesis vote from `" << voter << "` failed, sender's identity failed to be verified, discarding." << std::endl;
+        return false;
+    });
+}
+
+/**
+ * @brief Function which joins the network, asking a random sample of our peers to vote on which genesis to use and then downloading the winning tangle (in parallel) from several of the peers who voted for it
+ * @note If not every sampled peer votes before GENESIS_VOTE_DEADLINE, the genesis with the most votes received wins
+ * 
+ * @param sampleSize - The number of peers asked to vote
+ */
+void NetworkedTangle::join(size_t sampleSize) {
+    auto sample = GenesisElection::choose(network.peers(), sampleSize);
+    if(sample.empty()) {
+        std::cout << "No peers to join" << std::endl;
+        return;
+    }
 
+    pendingVotes.write_lock()->clear();
+    auto election = std::make_shared<GenesisElection>(sample, [this](const GenesisElection::Result& result) {
         // Mark that we are expecting the hash at the back of the list (the last hash is the actual hash, as opposed to the parent hashes)
-        t.genesisSyncExpectedHash = expectedHash;
-        // Request a tangle sync from the recieved voter
-        t.network.send_object_to(source, TangleSynchronizeRequest());
-    };
+        genesisSyncExpectedHash = result.ballot.back();
+
+        // Pick the (still connected) voters we will download from
+        auto& peers = network.peers();
+        std::vector<boost::uuids::uuid> sources;
+        for(auto& voter: result.voters)
+            if(sources.size() < GENESIS_SYNC_SOURCES && peers.contains(voter))
+                sources.push_back(voter);
+        if(sources.empty()) {
+            std::cerr << "Every peer who voted for genesis `" << result.ballot.back() << "` disconnected, failed to join" << std::endl;
+            return;
+        }
 
-    // If this genesis pair has a majority of the vote
-    if(genesisVotes[hashes].second > t.peerKeys.size() / 2)
-        acceptVote(networkData.source, hashes.back());
-
-    else {
-        // Total how many votes there currently are
-        size_t totalVotes = 0;
-        for(auto& [hashes, idVotes]: genesisVotes)
-            totalVotes += idVotes.second;
-        // If everyone has voted
-        if(totalVotes >= t.peerKeys.size() - 1){ // Minus 1 since we are also listed in peer keys
-            // Find the genesis with the most votes
-            auto best = *std::max_element(genesisVotes.begin(), genesisVotes.end(), [](const auto& a, const auto& b) {
-                return a.second.second < b.second.second;
-            });
-
-            // Request a tangle sync from the first voter for the best genesis
-            if(t.network.peers().contains(best.second.first))
-                acceptVote(t.network.peers().at(best.second.first), best.first.back());
+        // Ask the first of them for a state snapshot (the rest are asked to confirm it, and then each sends part of the tangle after it)
+        {
+            std::scoped_lock lock(syncMutex);
+            sync = std::make_unique<SyncSession>(sources);
         }
-    }
+        network.send_object_to(peers.at(sources[0]), StateSnapshotRequest());
+        std::cout << "Genesis `" << result.ballot.back() << "` won with " << result.voters.size() << " votes, syncing from " << sources.size() << " peers" << std::endl;
+    });
+
+    this->election = election;
+
+    // Ask the sampled peers to vote
+    auto& peers = network.peers();
+    for(auto& id: sample)
+        network.send_object_to(peers.at(id), GenesisVoteRequest());
+
+    // Settle with whatever votes have arrived once the deadline passes
+    std::thread([election]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(GENESIS_VOTE_DEADLINE));
+        election->close();
+        if(election->stats().verified == 0)
+            std::cerr << "No genesis votes were verified before the deadline, failed to join" << std::endl;
+    }).detach();
 }
 
 /**
@@ -476,6 +953,12 @@ void NetworkedTangle::GenesisVoteResponse::listener(breep::tcp::netdata_wrapper<
  * @param t - The tangle which recieved the event
  */
 void NetworkedTangle::SyncGenesisRequest::listener(breep::tcp::netdata_wrapper<SyncGenesisRequest>& networkData, NetworkedTangle& t){
+    // A genesis which inflated past the limit wasn't deserialized, reject its sender
+    if(networkData.data.oversized){
+        t.admissions.reject(networkData.source.id());
+        std::cerr << "Genesis sync from `" << networkData.source.id() << "` decompressed to more than " << ADMISSION_MAX_UNPACKED_STATE_BYTES << " bytes, discarding." << std::endl;
+        return;
+    }
     // If we didn't request a new genesis... do nothing
     if(t.genesisSyncExpectedHash == INVALID_HASH)
         return;
@@ -488,10 +971,10 @@ void NetworkedTangle::SyncGenesisRequest::listener(breep::tcp::netdata_wrapper<S
     // If the remote transaction's hash doesn't match what is actual... it has an invalid hash
     if(networkData.data.genesis.hashTransaction() != networkData.data.actualHash)
         throw Transaction::InvalidHash(networkData.data.actualHash, networkData.data.genesis.hash); // TODO: Exception caught by Breep, need alternative error handling?
-    // If we don't have the sender's public key, ask for it and then ask them to resend the tangle
+    // If we don't have the sender's public key, ask for it and then ask them to resend their part(s) of the tangle
     if(!t.peerKeys.contains(networkData.source.id())){
         t.network.send_object_to(networkData.source, PublicKeySyncRequest());
-        t.network.send_object_to(networkData.source, TangleSynchronizeRequest());
+        t.requestParts(networkData.source.id());
         return;
     }
     // If we can't verify the transaction discard it
@@ -508,6 +991,512 @@ void NetworkedTangle::SyncGenesisRequest::listener(breep::tcp::netdata_wrapper<S
 
     std::cout << "Synchronized new genesis with hash `" + t.genesis->hash + "` from `" << networkData.source.id() << "`" << std::endl;
     t.genesisSyncExpectedHash = INVALID_HASH;
+
+    // Add any synced transactions which arrived before the genesis
+    t.releaseSynced(t.genesis->hash);
+}
+
+/**
+ * @brief Construct a state snapshot from the latest fully confirmed cut through the tangle (or our genesis if no cut is confirmed)
+ * @param t - The tangle to generate from
+ */
+NetworkedTangle::StateSnapshotResponse::StateSnapshotResponse(const NetworkedTangle& t) {
+    auto genesis = util::mutable_cast(t).createLatestCommonGenesis();
+    cut.push_back(genesis->hash);
+    cut.insert(cut.end(), genesis->parentHashes.begin(), genesis->parentHashes.end());
+
+    balances = Transaction({}, {}, genesis->outputs);
+    root = merkle::commit(genesis->outputs);
+    signature = key::signMessage(*t.personalKeys, digest(cut, root));
+}
+
+/**
+ * @brief Listener for StateSnapshotRequest events. Sends the requester a snapshot of the balances as of our latest confirmed cut
+ * 
+ * @param networkData - The event recieved
+ * @param t - The tangle which recieved the event
+ */
+void NetworkedTangle::StateSnapshotRequest::listener(breep::tcp::netdata_wrapper<StateSnapshotRequest>& networkData, NetworkedTangle& t){
+    if(!t.admit(networkData.source, AdmissionControl::Class::Sync)) return;
+
+    StateSnapshotResponse response(t);
+    t.network.send_object_to(networkData.source, response);
+    std::cout << "Sent state snapshot (" << response.balances.outputs.size() << " accounts) to `" << networkData.source.id() << "`" << std::endl;
+}
+
+/**
+ * @brief Listener for StateSnapshotResponse events. Verifies the snapshot's commitment and signature, then asks the other sources to confirm the commitment
+ * @note If the snapshot can't be verified we fall back to downloading the full history
+ * 
+ * @param networkData - The event recieved
+ * @param t - The tangle which recieved the event
+ */
+void NetworkedTangle::StateSnapshotResponse::listener(breep::tcp::netdata_wrapper<StateSnapshotResponse>& networkData, NetworkedTangle& t){
+    const StateSnapshotResponse& snapshot = networkData.data;
+    auto source = networkData.source.id();
+    // A snapshot which inflated past the limit wasn't deserialized, reject its sender
+    if(snapshot.oversized){
+        t.admissions.reject(source);
+        std::cerr << "State snapshot from `" << source << "` decompressed to more than " << ADMISSION_MAX_UNPACKED_STATE_BYTES << " bytes, discarding." << std::endl;
+        return;
+    }
+
+    std::scoped_lock lock(t.syncMutex);
+    // If we didn't ask this peer for a snapshot (or already have one)... ignore the message
+    if(!t.sync || t.sync->sources.front() != source || !t.sync->cut.empty() || t.sync->installed) return;
+    auto& sync = *t.sync;
+
+    // Ensure the commitment matches the balances, and that the sender vouches for it
+    if(snapshot.cut.empty() || merkle::commit(snapshot.balances.outputs) != snapshot.root || !t.peerKeys.contains(source)
+      || !key::verifyMessage(t.peerKeys[source], digest(snapshot.cut, snapshot.root), snapshot.signature)){
+        std::cerr << "State snapshot from `" << source << "` failed verification" << std::endl;
+        return t.fallbackSync();
+    }
+
+    sync.cut = snapshot.cut;
+    sync.balances = snapshot.balances.outputs;
+    sync.root = snapshot.root;
+    sync.attested.insert(source);
+    sync.agreed = 1;
+    std::cout << "Recieved state snapshot (" << sync.balances.size() << " accounts, commitment `" << sync.root << "`) from `" << source << "`" << std::endl;
+
+    // If there is nobody else to confirm the snapshot... use it
+    if(sync.sources.size() == 1)
+        return t.installSnapshot();
+
+    // Ask the other sources to confirm the commitment
+    for(size_t i = 1; i < sync.sources.size(); i++)
+        if(t.network.peers().contains(sync.sources[i]))
+            t.network.send_object_to(t.network.peers().at(sync.sources[i]), StateSnapshotAttestRequest{sync.cut});
+}
+
+/**
+ * @brief Listener for StateSnapshotAttestRequest events. Calculates the commitment to our balances as of the requested cut, and sends it back
+ * 
+ * @param networkData - The event recieved
+ * @param t - The tangle which recieved the event
+ */
+void NetworkedTangle::StateSnapshotAttestRequest::listener(breep::tcp::netdata_wrapper<StateSnapshotAttestRequest>& networkData, NetworkedTangle& t){
+    if(!t.admit(networkData.source, AdmissionControl::Class::Query)) return;
+
+    const auto& cut = networkData.data.cut;
+    StateSnapshotAttestation attestation{cut};
+
+    if(!cut.empty()){
+        // If the cut is our genesis... its outputs are the balances
+        if(cut.front() == t.genesis->hash)
+            attestation.root = merkle::commit(t.genesis->outputs);
+        // Otherwise tabulate the balances as of the cut (if every node in it is in our tangle)
+        else {
+            std::vector<TransactionNode::const_ptr> chosen;
+            for(auto& hash: cut)
+                if(auto node = t.find(hash); node && !node->isGenesis)
+                    chosen.push_back(node);
+            if(chosen.size() == cut.size())
+                attestation.root = merkle::commit(t.tabulateBalances(chosen));
+        }
+    }
+
+    attestation.signature = key::signMessage(*t.personalKeys, StateSnapshotResponse::digest(attestation.cut, attestation.root));
+    t.network.send_object_to(networkData.source, attestation);
+}
+
+/**
+ * @brief Listener for StateSnapshotAttestation events. Counts whether the sender agrees with the snapshot, using it once a majority of the sources agree
+ * @note Falls back to downloading the full history once a majority can no longer agree
+ * 
+ * @param networkData - The event recieved
+ * @param t - The tangle which recieved the event
+ */
+void NetworkedTangle::StateSnapshotAttestation::listener(breep::tcp::netdata_wrapper<StateSnapshotAttestation>& networkData, NetworkedTangle& t){
+    const StateSnapshotAttestation& attestation = networkData.data;
+    auto source = networkData.source.id();
+
+    std::scoped_lock lock(t.syncMutex);
+    // If we aren't waiting on attestations for this cut (or this peer isn't a source, or already attested)... ignore the message
+    if(!t.sync || t.sync->installed || t.sync->cut.empty() || attestation.cut != t.sync->cut) return;
+    auto& sync = *t.sync;
+    if(std::find(sync.sources.begin(), sync.sources.end(), source) == sync.sources.end() || !sync.attested.insert(source).second) return;
+
+    bool agrees = attestation.root == sync.root && t.peerKeys.contains(source)
+        && key::verifyMessage(t.peerKeys[source], StateSnapshotResponse::digest(attestation.cut, attestation.root), attestation.signature);
+    if(agrees) sync.agreed++;
+    else std::cerr << "`" << source << "` disagrees with the state snapshot" << std::endl;
+
+    // Use the snapshot once a majority of the sources agree with it, give up on it once a majority can't
+    size_t majority = sync.sources.size() / 2 + 1, outstanding = sync.sources.size() - sync.attested.size();
+    if(sync.agreed >= majority) t.installSnapshot();
+    else if(sync.agreed + outstanding < majority) t.fallbackSync();
+}
+
+/**
+ * @brief Function which makes the (confirmed) state snapshot our genesis, then requests the transactions after its cut from every source
+ * @note The caller must hold the sync mutex
+ */
+void NetworkedTangle::installSnapshot() {
+    sync->installed = true;
+    // We are no longer waiting on a genesis sync
+    genesisSyncExpectedHash = INVALID_HASH;
+
+    setGenesis(createGenesis(sync->cut, sync->balances));
+    std::cout << "Loaded state snapshot as genesis `" << genesis->hash << "` (" << sync->balances.size() << " accounts, confirmed by " << sync->agreed << " of " << sync->sources.size() << " peers)" << std::endl;
+
+    // Request a different part of the transactions after the cut from each source
+    auto& peers = network.peers();
+    for(uint32_t i = 0; i < sync->sources.size(); i++)
+        if(peers.contains(sync->sources[i]))
+            network.send_object_to(peers.at(sync->sources[i]), TangleSynchronizeRequest{i, uint32_t(sync->sources.size()), sync->cut});
+}
+
+/**
+ * @brief Function which gives up on the state snapshot, requesting the full history (starting with the genesis we voted for) from every source instead
+ * @note The caller must hold the sync mutex
+ */
+void NetworkedTangle::fallbackSync() {
+    sync->installed = true;
+    sync->cut.clear();
+    std::cerr << "Falling back to synchronizing the full history" << std::endl;
+
+    auto& peers = network.peers();
+    for(uint32_t i = 0; i < sync->sources.size(); i++)
+        if(peers.contains(sync->sources[i]))
+            network.send_object_to(peers.at(sync->sources[i]), TangleSynchronizeRequest{i, uint32_t(sync->sources.size())});
+}
+
+/**
+ * @brief Listener for TangleSynchronizeRequest events. Sends the sender the genesis and then the requested part of our tangle, in signed chunks
+ * 
+ * @param networkData - The event recieved
+ * @param t - The tangle which recieved the event
+ */
+void NetworkedTangle::TangleSynchronizeRequest::listener(breep::tcp::netdata_wrapper<TangleSynchronizeRequest>& networkData, NetworkedTangle& t){
+    if(!t.admit(networkData.source, AdmissionControl::Class::Sync)) return;
+
+    auto& [part, parts, after] = networkData.data;
+    if(parts == 0 || part >= parts)
+        throw std::runtime_error("Requested invalid part " + std::to_string(part) + " of " + std::to_string(parts) + " of the tangle, discarding.");
+
+    // Take a snapshot of the tangle (so nodes can keep being added while we send)
+    // NOTE: parents always come before their children in the snapshot, and the genesis is first
+    auto nodes = t.listTransactions();
+    if(nodes.empty()) return;
+
+    // If the recipient has a state snapshot... skip everything at or before its cut
+    std::unordered_set<std::string> skip;
+    if(!after.empty()){
+        std::queue<TransactionNode::const_ptr> q;
+        for(auto& hash: after)
+            if(auto node = t.find(hash); node && skip.insert(node->hash).second)
+                q.push(node);
+            else if(!node) std::cerr << "Requested transactions after `" << hash << "`, which isn't in our tangle" << std::endl;
+
+        while(!q.empty()){
+            auto head = q.front();
+            q.pop();
+            for(auto& parent: head->parents)
+                if(skip.insert(parent->hash).second)
+                    q.push(parent);
+        }
+    // Otherwise every part starts with the genesis (so the recipient can start syncing no matter which part arrives first)
+    } else t.network.send_object_to(networkData.source, SyncGenesisRequest(*nodes.front(), *t.personalKeys));
+
+    // Send the transactions whose hash falls in the requested part, a chunk at a time
+    std::vector<Transaction> chunk;
+    uint32_t index = 0;
+    size_t sent = 0;
+    for(size_t i = 1; i < nodes.size(); i++){
+        if(partOf(nodes[i]->hash, parts) != part || skip.contains(nodes[i]->hash)) continue;
+
+        chunk.push_back(*nodes[i]);
+        sent++;
+        if(chunk.size() == SYNC_CHUNK_SIZE){
+            t.network.send_object_to(networkData.source, SyncChunk(part, parts, index++, false, std::move(chunk), *t.personalKeys));
+            chunk.clear();
+        }
+    }
+    // The last chunk (possibly empty) marks the end of the part
+    t.network.send_object_to(networkData.source, SyncChunk(part, parts, index, true, std::move(chunk), *t.personalKeys));
+
+    std::cout << "Sent part " << part + 1 << " of " << parts << " of the tangle (" << sent << " transactions in " << index + 1 << " chunks) to `" << networkData.source.id() << "`" << std::endl;
+}
+
+/**
+ * @brief Listener for SyncChunk events. Verifies the chunk as a whole and then adds its transactions to the tangle (transactions whose parents haven't arrived yet are held until they do)
+ * @note If we don't have the sender's public key yet, the chunk is held (and the key requested) until it arrives
+ * 
+ * @param networkData - The event recieved
+ * @param t - The tangle which recieved the event
+ */
+void NetworkedTangle::SyncChunk::listener(breep::tcp::netdata_wrapper<SyncChunk>& networkData, NetworkedTangle& t){
+    const SyncChunk& chunk = networkData.data;
+    auto source = networkData.source.id();
+    // A chunk which inflated past the limit wasn't deserialized, reject its sender
+    if(chunk.oversized){
+        t.admissions.reject(source);
+        std::cerr << "Sync chunk from `" << source << "` decompressed to more than " << ADMISSION_MAX_UNPACKED_CHUNK_BYTES << " bytes, discarding." << std::endl;
+        return;
+    }
+
+    std::scoped_lock lock(t.syncMutex);
+    // If we aren't syncing... ignore the chunk
+    if(!t.sync) return;
+    auto& sync = *t.sync;
+    // Ignore chunks from a different split of the tangle, or for parts we aren't downloading from this peer
+    if(chunk.parts != sync.assigned.size() || chunk.part >= chunk.parts || sync.assigned[chunk.part] != source || sync.complete[chunk.part])
+        return;
+
+    // If we don't have the sender's public key, hold onto the chunk and ask for the key (the chunk is verified once it arrives)
+    if(!t.peerKeys.contains(source)){
+        auto& held = sync.unverified[source];
+        if(held.empty()) t.network.send_object_to(networkData.source, PublicKeySyncRequest());
+        held.push_back(chunk);
+        return;
+    }
+
+    t.receiveChunk(source, chunk);
+}
+
+/**
+ * @brief Function which verifies the chunks <source> sent before we had their public key (in the order they arrived)
+ * 
+ * @param source - The peer whose key just arrived
+ */
+void NetworkedTangle::receiveUnverifiedChunks(const boost::uuids::uuid& source) {
+    std::scoped_lock lock(syncMutex);
+    if(!sync || !peerKeys.contains(source)) return;
+
+    if(auto held = sync->unverified.extract(source))
+        for(auto& chunk: held.mapped())
+            // NOTE: the session ends once the last part finishes
+            if(sync) receiveChunk(source, chunk);
+}
+
+/**
+ * @brief Function which verifies a chunk as a whole and then adds its transactions to the tangle
+ * @note If the chunk fails verification its part is requested from the next peer who agreed on the genesis
+ * @note The caller must hold the sync mutex, and we must have <source>'s public key
+ * 
+ * @param source - The peer who sent the chunk
+ * @param chunk - The chunk
+ */
+void NetworkedTangle::receiveChunk(const boost::uuids::uuid& source, const SyncChunk& chunk) {
+    // Ignore chunks for parts we aren't (or are no longer) downloading from this peer, or which aren't the next chunk in their part
+    if(chunk.parts != sync->assigned.size() || chunk.part >= chunk.parts || sync->assigned[chunk.part] != source
+      || sync->complete[chunk.part] || chunk.index != sync->nextChunk[chunk.part])
+        return;
+
+    // Verify the chunk (the digest is recomputed from the hashes of the received transactions, so any altered transaction breaks the signature)
+    if(!key::verifyMessage(peerKeys.at(source), chunk.digest(), chunk.signature)){
+        sync->rejectedChunks++;
+
+        // Request the part again from the next peer who agreed on the genesis (only after our snapshot's cut, if we installed one)
+        size_t i = std::find(sync->sources.begin(), sync->sources.end(), source) - sync->sources.begin();
+        auto next = sync->sources[(i + 1) % sync->sources.size()];
+        sync->assigned[chunk.part] = next;
+        sync->nextChunk[chunk.part] = 0;
+        if(network.peers().contains(next))
+            network.send_object_to(network.peers().at(next), TangleSynchronizeRequest{chunk.part, chunk.parts, sync->cut});
+
+        std::cerr << "Chunk " << chunk.index << " of part " << chunk.part + 1 << " from `" << source << "` failed verification, requesting the part from `" << next << "`" << std::endl;
+        return;
+    }
+    sync->chunks++;
+    sync->nextChunk[chunk.part]++;
+
+    // Add the transactions (without recalculating weights after each one, they are updated once the sync finishes)
+    updateWeights = false;
+    insertSynced(chunk.transactions);
+    updateWeights = true;
+
+    // If every part has been received... the sync is finished
+    if(chunk.last){
+        sync->complete[chunk.part] = true;
+        if(std::all_of(sync->complete.begin(), sync->complete.end(), [](bool complete) { return complete; }))
+            finishSync();
+    }
+}
+
+/**
+ * @brief Function which re-requests every unfinished part of the tangle being downloaded from <source>
+ * 
+ * @param source - The peer to request from
+ */
+void NetworkedTangle::requestParts(const boost::uuids::uuid& source) {
+    std::scoped_lock lock(syncMutex);
+    if(!sync || !network.peers().contains(source)) return;
+
+    for(uint32_t part = 0; part < sync->assigned.size(); part++)
+        if(sync->assigned[part] == source && !sync->complete[part]){
+            sync->nextChunk[part] = 0;
+            network.send_object_to(network.peers().at(source), TangleSynchronizeRequest{part, uint32_t(sync->assigned.size()), sync->cut});
+        }
+}
+
+/**
+ * @brief Function which adds synced transactions to the tangle as soon as their parents are present
+ * @note Transactions missing a parent are held (keyed by that parent), and are added as soon as it is
+ * @note The caller must hold the sync mutex
+ * 
+ * @param ready - The transactions to add
+ */
+void NetworkedTangle::insertSynced(std::vector<Transaction> ready) {
+    // Work from the back of the list (reversed so the transactions are added in the order they were sent, parents first)
+    std::reverse(ready.begin(), ready.end());
+    while(!ready.empty()){
+        Transaction transaction = std::move(ready.back());
+        ready.pop_back();
+        // Skip transactions we already have (parts are re-requested in full if a chunk fails)
+        if(find(transaction.hash)) continue;
+
+        // If a parent hasn't arrived yet... hold the transaction until it does
+        auto missing = std::find_if(transaction.parentHashes.begin(), transaction.parentHashes.end(), [this](Hash& hash) { return !find(hash); });
+        if(missing != transaction.parentHashes.end()){
+            sync->waiting[*missing].push_back(std::move(transaction));
+            sync->parked++;
+            continue;
+        }
+
+        try {
+            Tangle::add(TransactionNode::create(*this, transaction)); // Call the tangle version so that we don't spam the network with extra messages
+            sync->added++;
+        } catch (std::exception& e) {
+            std::cerr << "Invalid synced transaction, discarding" << std::endl << "\t" << e.what() << std::endl;
+            continue;
+        }
+
+        // Anything waiting on this transaction can now be added
+        if(auto waiting = sync->waiting.extract(transaction.hash))
+            for(auto& child: waiting.mapped())
+                ready.push_back(std::move(child));
+    }
+}
+
+/**
+ * @brief Function which adds the synced transactions waiting on <parentHash> (once it has been added to the tangle)
+ * 
+ * @param parentHash - Hash of the newly added transaction
+ */
+void NetworkedTangle::releaseSynced(const std::string& parentHash) {
+    std::scoped_lock lock(syncMutex);
+    if(!sync) return;
+
+    if(auto waiting = sync->waiting.extract(parentHash)){
+        updateWeights = false;
+        insertSynced(std::move(waiting.mapped()));
+        updateWeights = true;
+    }
+}
+
+/**
+ * @brief Function which finishes a sync, reporting how it went and updating the weights of the downloaded tangle
+ * @note The caller must hold the sync mutex
+ */
+void NetworkedTangle::finishSync() {
+    size_t orphaned = 0;
+    for(auto& [hash, transactions]: sync->waiting)
+        orphaned += transactions.size();
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sync->start).count();
+    std::cout << "Synchronized " << sync->added << " transactions from " << sync->sources.size() << " peers in " << elapsed << "ms (" << sync->chunks << " chunks, "
+        << sync->rejectedChunks << " rejected, " << sync->parked << " arrived before a parent)" << std::endl;
+    if(orphaned)
+        std::cerr << orphaned << " synced transactions never received a parent, discarding (they will be recovered the next time we synchronize)" << std::endl;
+    sync.reset();
+
+    // Update all the weights (in a thread)
+    std::thread([this](){ updateCumulativeWeights(); }).detach();
+}
+
+/**
+ * @brief Listener for TipsRequest events. Sends our current tips to the requester
+ * 
+ * @param networkData - The event received
+ * @param t - The tangle which received the event
+ */
+void NetworkedTangle::TipsRequest::listener(breep::tcp::netdata_wrapper<TipsRequest>& networkData, NetworkedTangle& t){
+    if(!t.admit(networkData.source, AdmissionControl::Class::Query)) return;
+
+    TipsResponse response;
+    for(auto& tip: *t.snapshot()->tips)
+        response.tips.push_back(tip->hash);
+    t.network.send_object_to(networkData.source, response);
+}
+
+/**
+ * @brief Listener for TipsResponse events. Adds the tips a sampled peer sent us to our recent tips window
+ * 
+ * @param networkData - The event received
+ * @param t - The tangle which received the event
+ */
+void NetworkedTangle::TipsResponse::listener(breep::tcp::netdata_wrapper<TipsResponse>& networkData, NetworkedTangle& t){
+    auto state = t.light.write_lock();
+    if(!state->enabled || std::find(state->sample.begin(), state->sample.end(), networkData.source.id()) == state->sample.end()) return;
+
+    for(auto& tip: networkData.data.tips)
+        if(std::find(state->tips.begin(), state->tips.end(), tip) == state->tips.end())
+            state->tips.push_back(tip);
+    while(state->tips.size() > LIGHT_TIP_WINDOW) state->tips.pop_front();
+}
+
+/**
+ * @brief Listener for AccountProofRequest events. Proves the account's confirmed balance against our account state, and sends the signed proof to the requester
+ * 
+ * @param networkData - The event received
+ * @param t - The tangle which received the event
+ */
+void NetworkedTangle::AccountProofRequest::listener(breep::tcp::netdata_wrapper<AccountProofRequest>& networkData, NetworkedTangle& t){
+    if(!t.admit(networkData.source, AdmissionControl::Class::Query)) return;
+
+    AccountProofResponse response;
+    response.account = networkData.data.account;
+    std::tie(response.root, response.proof) = t.proveAccount(response.account);
+    response.signature = key::signMessage(*t.personalKeys, response.digest());
+    t.network.send_object_to(networkData.source, response);
+}
+
+/**
+ * @brief Listener for AccountProofResponse events. Verifies a sampled peer's proof, and once a majority of the sample agrees on an account's balance accepts it as confirmed
+ * @note Peers may have confirmed slightly different sets of transactions (and so have different roots), only the proven balances need to agree
+ * 
+ * @param networkData - The event received
+ * @param t - The tangle which received the event
+ */
+void NetworkedTangle::AccountProofResponse::listener(breep::tcp::netdata_wrapper<AccountProofResponse>& networkData, NetworkedTangle& t){
+    auto& response = networkData.data;
+    auto state = t.light.write_lock();
+    if(!state->enabled || std::find(state->sample.begin(), state->sample.end(), networkData.source.id()) == state->sample.end()) return;
+    if(std::find(state->accounts.begin(), state->accounts.end(), response.account) == state->accounts.end()) return;
+
+    // The root must be vouched for by the peer, and the proof must lead to it
+    if(!t.peerKeys.contains(networkData.source.id())){
+        t.network.send_object_to(networkData.source, PublicKeySyncRequest());
+        std::cout << "Received balance proof from unverified peer `" << networkData.source.id() << "`, discarding and requesting peer's key." << std::endl;
+        return;
+    }
+    if(!key::verifyMessage(t.peerKeys[networkData.source.id()], response.digest(), response.signature) || !merkle::AccountTree::verify(response.root, response.account, response.proof)){
+        state->proofsRejected++;
+        std::cerr << "Balance proof from `" << networkData.source.id() << "` failed to verify, discarding." << std::endl;
+        return;
+    }
+    state->proofsAccepted++;
+
+    // Tally the proven balance (an account which isn't in the tree has an empty balance)
+    merkle::Balance balance = response.proof.includes(response.account) ? *response.proof.leaf : merkle::Balance(response.account);
+    auto& proven = state->proofs[response.account];
+    proven.insert_or_assign(networkData.source.id(), balance);
+
+    size_t agreeing = std::count_if(proven.begin(), proven.end(), [&balance](auto& other) { return other.second.amount == balance.amount && other.second.sequence == balance.sequence; });
+    if(agreeing <= state->sample.size() / 2) return;
+
+    // A majority agrees... accept the balance, and forget our transactions whose spends it already includes (transactions which don't spend from the account, like money it received, aren't covered by the balance and are kept)
+    state->confirmed.insert_or_assign(response.account, balance);
+    std::erase_if(state->transactions, [&](const Transaction& transaction) {
+        auto spends = [&](auto& input) { return input.accountBase64() == response.account; };
+        return std::any_of(transaction.inputs.begin(), transaction.inputs.end(), spends) && std::all_of(transaction.inputs.begin(), transaction.inputs.end(), [&](auto& input) {
+            return !spends(input) || input.sequence < balance.sequence;
+        });
+    });
+    std::cout << "Confirmed balance of " << balance.amount << " (next sequence " << balance.sequence << ") with " << agreeing << " of " << state->sample.size() << " sampled peers" << std::endl;
 }
 
 /**
@@ -517,25 +1506,55 @@ void NetworkedTangle::SyncGenesisRequest::listener(breep::tcp::netdata_wrapper<S
  * @param t - The tangle which recieved the event
  */
 void NetworkedTangle::AddTransactionRequestBase::listener(breep::tcp::netdata_wrapper<AddTransactionRequestBase>& networkData, NetworkedTangle& t){
-    const Transaction& transaction = networkData.data.transaction;
+    auto& request = util::mutable_cast(networkData.data);
+    auto source = networkData.source.id();
+
+    // Admit the request before doing any expensive work: first the sender's rate limit, then the size of the request (before it is decompressed, and then while it is decompressed), then the shape and proof of work of the transaction (before any signature is verified)
+    if(!t.admit(networkData.source, AdmissionControl::Class::Transaction)) return;
+    if(request.wireSize() > ADMISSION_MAX_TRANSACTION_BYTES){
+        t.admissions.reject(source);
+        std::cerr << "Transaction add from `" << source << "` is too large (" << request.wireSize() << " bytes), discarding." << std::endl;
+        return;
+    }
+    try {
+        request.unpack();
+    } catch (std::exception& e) {
+        t.admissions.reject(source);
+        std::cerr << "Transaction add from `" << source << "` couldn't be unpacked, discarding." << std::endl << "\t" << e.what() << std::endl;
+        return;
+    }
+    if(auto error = check(request, t, source != t.network.self().id())){
+        t.admissions.reject(source);
+        std::cerr << "Transaction add from `" << source << "` failed admission, discarding." << std::endl << "\t" << *error << std::endl;
+        return;
+    }
+    const Transaction& transaction = request.transaction;
 
-    // If the remote transaction's hash doesn't match what is claimed... it has an invalid hash
-    if(transaction.hash != networkData.data.validityHash)
-        throw Transaction::InvalidHash(networkData.data.validityHash, transaction.hash); // TODO: Exception caught by Breep, need alternative error handling?
+    // Light nodes don't keep the graph... just verify the sender and record the transaction
+    if(t.isLight()){
+        if(!t.peerKeys.contains(networkData.source.id())){
+            t.network.send_object_to(networkData.source, PublicKeySyncRequest());
+            return;
+        }
+        if(!key::verifyMessage(t.peerKeys[networkData.source.id()], transaction.hash, networkData.data.validitySignature)) return;
+
+        auto state = t.light.write_lock();
+        state->received++;
+        state->observe(transaction);
+        return;
+    }
 
     // Try to add the transaction to the tangle
     attemptToAddTransaction(transaction, {networkData.source.id(), networkData.data.validitySignature}, t);
 
-    // For every transaction in the tangle's network addition queue... attempt to add that transaction
+    // For every transaction in the tangle's network addition queue... attempt to add that transaction (transactions which are still orphaned are requeued, so only the current contents are processed)
     size_t listSize = t.networkAdditionQueue.size();
     for(size_t i = 0; i < listSize; i++){
-        Transaction frontTrx = t.networkAdditionQueue.front().transaction;
-        HashVerificationPair frontSig = t.networkAdditionQueue.front().pair;
-        t.networkAdditionQueue.pop();
-        attemptToAddTransaction(frontTrx, frontSig, t);
+        auto front = t.networkAdditionQueue.tryPop();
+        if(!front) break; // Another thread emptied the queue
+        if(front->pair.peerID != t.network.self().id()) t.admissions.dequeue(front->pair.peerID);
+        attemptToAddTransaction(std::move(front->transaction), std::move(front->pair), t);
     }
-    // Reduce the size of the network queue if we are wasting space
-    t.shrinkNetworkQueue();
 
     std::cout << "Processed remote transaction add with hash `" + transaction.hash + "` from " << networkData.source.id() << std::endl;
 }
@@ -547,7 +1566,7 @@ void NetworkedTangle::AddTransactionRequestBase::listener(breep::tcp::netdata_wr
  * @param validityPair - Hash and key used for verification
  * @param t - The tangle to add the transaction to
  */
-void NetworkedTangle::AddTransactionRequestBase::attemptToAddTransaction(const Transaction& transaction, HashVerificationPair validityPair, NetworkedTangle& t){
+void NetworkedTangle::AddTransactionRequestBase::attemptToAddTransaction(Transaction transaction, HashVerificationPair validityPair, NetworkedTangle& t){
     try {
         // If we don't have the peer's public key, request it and enqueue the transaction for later
         if(!t.peerKeys.contains(validityPair.peerID)){
@@ -555,11 +1574,8 @@ void NetworkedTangle::AddTransactionRequestBase::attemptToAddTransaction(const T
             auto& sender = peers.at(validityPair.peerID);
             t.network.send_object_to(sender, PublicKeySyncRequest());
 
-            // If we are running out of room in the network queue, expand it
-            t.growNetworkQueue();
-            t.networkAdditionQueue.emplace(transaction, validityPair);
-
             std::cout << "Received transaction add from unverified peer `" << validityPair.peerID << "`, enquing transaction with hash `" << transaction.hash << "` and requesting peer's key." << std::endl;
+            t.enqueueTransaction(std::move(transaction), std::move(validityPair));
             return;
         }
 
@@ -578,11 +1594,9 @@ void NetworkedTangle::AddTransactionRequestBase::attemptToAddTransaction(const T
                 parents.push_back(parent);
             // If the parent is not found enqueue the transaction for later
             else {
-                // If we are running out of room in the network queue, expand it
-                t.growNetworkQueue();
-                t.networkAdditionQueue.emplace(transaction, validityPair);
                 parentsFound = false;
                 std::cout << "Remote transaction with hash `" + transaction.hash + "` is temporarily orphaned... enqueuing for later" << std::endl;
+                t.enqueueTransaction(std::move(transaction), std::move(validityPair));
                 break;
             }
         }
@@ -590,12 +1604,53 @@ void NetworkedTangle::AddTransactionRequestBase::attemptToAddTransaction(const T
         // If the transaction's parents could be validated... add the transaction to the tangle
         if(parentsFound) {
             (*(Tangle*) &t).add(TransactionNode::create(t, transaction)); // Call the tangle version so that we don't spam the network with extra messages
+            if(validityPair.peerID != t.network.self().id()) t.recordIngest(transaction); // Transactions we are loading aren't new load
             std::cout << "Added remote transaction with hash `" + transaction.hash + "` to the tangle" << std::endl;
         }
     // If an exception is thrown by the add process, discard the transaction and display an error message
     } catch (std::exception& e) { std::cerr << "Invalid transaction in network queue, discarding" << std::endl << "\t" << e.what() << std::endl; }
 }
 
+/**
+ * @brief Function which decompresses the request (filling in the hash, signature, and transaction), does nothing if the request has already been unpacked
+ */
+void NetworkedTangle::AddTransactionRequestBase::unpack() {
+    if(unpacked()) return;
+    auto uncompressed = util::decompress(std::move(packed), ADMISSION_MAX_UNPACKED_TRANSACTION_BYTES); // NOTE: throws if the request inflates past the limit
+    packed.clear();
+    breep::deserializer d(*(std::basic_string<unsigned char>*) &uncompressed);
+
+    std::string hash;
+    d >> hash;
+    util::mutable_cast(validityHash) = hash;
+    d >> validitySignature;
+    d >> transaction;
+}
+
+/**
+ * @brief Function which performs the cheap checks of an (unpacked) request: the transaction's shape, that its hash is what was claimed, and that it was mined at (at least) the difficulty we currently accept
+ * @note None of these checks verify a signature or touch the tangle
+ *
+ * @param request - The request to check
+ * @param t - The tangle the request was sent to
+ * @param enforceDifficulty - Whether the minimum difficulty is enforced (transactions we are loading were accepted when they were mined)
+ * @return std::optional<std::string> - Why the request failed, or nothing if it passed
+ */
+std::optional<std::string> NetworkedTangle::AddTransactionRequestBase::check(const AddTransactionRequestBase& request, const NetworkedTangle& t, bool enforceDifficulty) {
+    const Transaction& transaction = request.transaction;
+    if(transaction.parentHashes.empty() || transaction.parentHashes.size() > ADMISSION_MAX_PARENTS)
+        return "Transaction with hash `" + transaction.hash + "` has " + std::to_string(transaction.parentHashes.size()) + " parents";
+    if(transaction.inputs.size() + transaction.outputs.size() > ADMISSION_MAX_TRANSACTION_IO)
+        return "Transaction with hash `" + transaction.hash + "` has " + std::to_string(transaction.inputs.size() + transaction.outputs.size()) + " inputs and outputs";
+    if(transaction.hash != request.validityHash)
+        return Transaction::InvalidHash(transaction.hash, request.validityHash).what();
+    if(uint8_t accepted = enforceDifficulty ? t.difficulty.accepted(spenders(transaction.inputs)) : 0; transaction.miningDifficulty < accepted)
+        return "Transaction with hash `" + transaction.hash + "` was mined at difficulty " + std::to_string(int(transaction.miningDifficulty)) + ", but at least " + std::to_string(int(accepted)) + " is required";
+    if(!util::mutable_cast(transaction).validateTransactionMined())
+        return "Transaction with hash `" + transaction.hash + "` wasn't mined (difficulty " + std::to_string(int(transaction.miningDifficulty)) + ")";
+    return {};
+}
+
 
 // -- Message De/serialization --
 
@@ -604,6 +1659,16 @@ void NetworkedTangle::AddTransactionRequestBase::attemptToAddTransaction(const T
  * All of these functions simply convert a particular type of message to/from a string
  */
 
+// Function which decompresses a message, or returns nothing (flagging the message as oversized, so its listener can reject the sender) if it would decompress to more than <limit> bytes
+static std::optional<std::string> decompressMessage(const std::string& compressed, size_t limit, bool& oversized) {
+	try {
+		return util::decompress(compressed, limit);
+	} catch (util::DecompressionLimitExceeded&) {
+		oversized = true;
+		return {};
+	}
+}
+
 breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::SyncGenesisRequest& r) {
 	breep::serializer s;
 	s << r.claimedHash;
@@ -620,8 +1685,9 @@ breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::SyncGe
     // decompress the request
 	std::string compressed;
 	_d >> compressed;
-	auto uncompressed = util::decompress(compressed);
-	breep::deserializer d(*(std::basic_string<unsigned char>*) &uncompressed);
+	auto uncompressed = decompressMessage(compressed, ADMISSION_MAX_UNPACKED_STATE_BYTES, r.oversized);
+	if(!uncompressed) return _d;
+	breep::deserializer d(*(std::basic_string<unsigned char>*) &*uncompressed);
 
 	util::mutable_cast(r.claimedHash).clear();
 	d >> util::mutable_cast(r.claimedHash);
@@ -633,6 +1699,101 @@ breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::SyncGe
 	return _d;
 }
 
+breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::StateSnapshotResponse& r) {
+	breep::serializer s;
+	s << r.cut;
+	s << r.balances;
+	s << r.root;
+	s << r.signature;
+
+    // Compress the snapshot
+	auto uncompressed = s.str();
+	_s << util::compress(*(std::string*) &uncompressed);
+	return _s;
+}
+breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::StateSnapshotResponse& r) {
+    // Decompress the snapshot
+	std::string compressed;
+	_d >> compressed;
+	auto uncompressed = decompressMessage(compressed, ADMISSION_MAX_UNPACKED_STATE_BYTES, r.oversized);
+	if(!uncompressed) return _d;
+	breep::deserializer d(*(std::basic_string<unsigned char>*) &*uncompressed);
+
+	d >> r.cut;
+	d >> r.balances;
+	d >> r.root;
+	d >> r.signature;
+	return _d;
+}
+
+breep::serializer& operator<<(breep::serializer& s, const NetworkedTangle::AccountProofResponse& r) {
+	s << r.account;
+	s << r.root;
+	s << r.proof.siblings;
+	s << r.proof.leaf.has_value();
+	if(r.proof.leaf){
+		s << r.proof.leaf->account;
+		s << r.proof.leaf->amount.raw;
+		s << r.proof.leaf->sequence;
+	}
+	s << r.signature;
+	return s;
+}
+breep::deserializer& operator>>(breep::deserializer& d, NetworkedTangle::AccountProofResponse& r) {
+	d >> r.account;
+	d >> r.root;
+	d >> r.proof.siblings;
+	bool hasLeaf;
+	d >> hasLeaf;
+	if(hasLeaf){
+		std::string account;
+		Amount::Raw amount;
+		uint64_t sequence;
+		d >> account;
+		d >> amount;
+		d >> sequence;
+		r.proof.leaf = merkle::Balance(account, Amount::fromRaw(amount), sequence); // NOTE: the leaf's key is recalculated from the account
+	}
+	d >> r.signature;
+	return d;
+}
+
+breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::SyncChunk& r) {
+	breep::serializer s;
+	s << r.part;
+	s << r.parts;
+	s << r.index;
+	s << r.last;
+	s << r.signature;
+	s << r.transactions.size();
+	for(auto& transaction: r.transactions)
+		s << transaction;
+
+    // Compress the chunk
+	auto uncompressed = s.str();
+	_s << util::compress(*(std::string*) &uncompressed);
+	return _s;
+}
+breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::SyncChunk& r) {
+    // Decompress the chunk
+	std::string compressed;
+	_d >> compressed;
+	auto uncompressed = decompressMessage(compressed, ADMISSION_MAX_UNPACKED_CHUNK_BYTES, r.oversized);
+	if(!uncompressed) return _d;
+	breep::deserializer d(*(std::basic_string<unsigned char>*) &*uncompressed);
+
+	d >> r.part;
+	d >> r.parts;
+	d >> r.index;
+	d >> r.last;
+	d >> r.signature;
+	size_t size;
+	d >> size;
+	r.transactions.resize(size);
+	deserializeTransactions(d, r.transactions); // NOTE: the hashes are recalculated (all at once) while deserializing
+	return _d;
+}
+
 breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::AddTransactionRequest& r) {
 	breep::serializer s;
 	s << r.validityHash;
@@ -645,17 +1806,10 @@ breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::AddT
 	return _s;
 }
 breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::AddTransactionRequest& r) {
-    // Decompress the request
+    // Read the (still compressed) request
 	std::basic_string<unsigned char> compressed;
 	_d >> compressed;
-	auto uncompressed = util::decompress(*(std::string*) &compressed);
-	breep::deserializer d(*(std::basic_string<unsigned char>*) &uncompressed);
-
-	std::string validityHash;
-	d >> validityHash;
-	(*(std::string*) &r.validityHash) = validityHash;
-	d >> r.validitySignature;
-	d >> r.transaction;
+	r.receive(*(std::string*) &compressed); // NOTE: the request is decompressed once the sender has been admitted (see AddTransactionRequestBase::unpack)
 	return _d;
 }
 
@@ -671,16 +1825,9 @@ breep::serializer& operator<<(breep::serializer& _s, const NetworkedTangle::Sync
 	return _s;
 }
 breep::deserializer& operator>>(breep::deserializer& _d, NetworkedTangle::SynchronizationAddTransactionRequest& r) {
-    // Decompress the request
+    // Read the (still compressed) request
 	std::basic_string<unsigned char> compressed;
 	_d >> compressed;
-	auto uncompressed = util::decompress(*(std::string*) &compressed);
-	breep::deserializer d(*(std::basic_string<unsigned char>*) &uncompressed);
-
-	std::string validityHash;
-	d >> validityHash;
-	(*(std::string*) &r.validityHash) = validityHash;
-	d >> r.validitySignature;
-	d >> r.transaction;
+	r.receive(*(std::string*) &compressed); // NOTE: the request is decompressed once the sender has been admitted (see AddTransactionRequestBase::unpack)
 	return _d;
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+/**
+ * @file queue_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Contention benchmark for the network queue, comparing the lock-free MPMC queue (see mpmc_queue.hpp) against a mutex guarded std::queue
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpmc_queue.hpp"
+
+// Element moved through the queues (similar in size to a queued transaction's handle and signature)
+struct Payload {
+	std::unique_ptr<size_t> value;
+	std::string signature;
+};
+
+/**
+ * @brief Baseline queue, a std::queue protected by a single mutex (with the same bounded, non-blocking interface)
+ */
+struct LockedQueue {
+	std::mutex mutex;
+	std::queue<Payload> queue;
+	size_t capacity;
+
+	LockedQueue(size_t capacity) : capacity(capacity) {}
+
+	bool tryPush(Payload&& value) {
+		std::scoped_lock lock(mutex);
+		if(queue.size() >= capacity) return false;
+		queue.push(std::move(value));
+		return true;
+	}
+
+	std::optional<Payload> tryPop() {
+		std::scoped_lock lock(mutex);
+		if(queue.empty()) return {};
+		std::optional<Payload> out(std::move(queue.front()));
+		queue.pop();
+		return out;
+	}
+};
+
+/**
+ * @brief Function which moves <items> elements through <queue>, split between <threads> threads (half producing, half consuming)
+ *
+ * @param queue - The queue to benchmark
+ * @param threads - Total number of threads
+ * @param items - Number of elements to move through the queue
+ * @return double - Operations (pushes plus pops) per second
+ */
+template<typename Queue>
+double run(Queue& queue, size_t threads, size_t items) {
+	size_t producers = std::max<size_t>(threads / 2, 1), consumers = std::max<size_t>(threads - producers, 1);
+	std::atomic<size_t> consumed = 0, checksum = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for(size_t p = 0; p < producers; p++)
+		workers.emplace_back([&, p](){
+			for(size_t i = p; i < items; i += producers){
+				Payload payload{std::make_unique<size_t>(i), "signature"};
+				// Back off while the queue is full
+				while(!queue.tryPush(std::move(payload))) std::this_thread::yield();
+			}
+		});
+	for(size_t c = 0; c < consumers; c++)
+		workers.emplace_back([&](){
+			while(consumed < items)
+				if(auto payload = queue.tryPop()){
+					checksum += *payload->value;
+					consumed++;
+				} else std::this_thread::yield();
+		});
+	for(auto& worker: workers)
+		worker.join();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if(checksum != items * (items - 1) / 2)
+		std::cerr << "Checksum mismatch, elements were lost or duplicated!" << std::endl;
+	return 2 * items / elapsed;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 3){
+		std::cout << "Usage: " << argv[0] << " [<items> = 1000000] [<capacity> = 1024]" << std::endl;
+		return 1;
+	}
+
+	size_t items = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	size_t capacity = argc > 2 ? std::stoul(argv[2]) : 1024;
+
+	std::cout << "Moving " << items << " elements through a queue of " << capacity << " (ops/s, pushes + pops)" << std::endl;
+	for(size_t threads: {1, 2, 4, 8, 16, 32}){
+		MPMCQueue<Payload> lockFree(capacity);
+		LockedQueue locked(capacity);
+
+		double lockFreeRate = run(lockFree, threads, items);
+		double lockedRate = run(locked, threads, items);
+		std::cout << threads << " threads: lock-free " << lockFreeRate << ", mutex " << lockedRate << " (" << (lockFreeRate / lockedRate) << "x)" << std::endl;
+	}
+}
@@ -0,0 +1,680 @@
+/**
+ * @file rpc.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Code backing rpc.hpp
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "rpc.hpp"
+
+#include <fstream>
+
+#include <cryptopp/osrng.h>
+
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+/**
+ * @brief Function which escapes a string so it can be embedded in JSON
+ *
+ * @param str - The string to escape
+ * @return std::string - The escaped string (including the surrounding quotes)
+ */
+std::string rpc::quote(std::string_view str) {
+	std::string out = "\"";
+	out.reserve(str.size() + 2);
+	for(char c: str)
+		switch(c){
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			// Any other control characters are unicode escaped
+			if((unsigned char) c < 0x20){
+				char escaped[7];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out += escaped;
+			} else out += c;
+		}
+	return out + "\"";
+}
+
+/**
+ * @brief Function which decodes a percent encoded URL component
+ * @note '+' is left as is (rather than being decoded to a space) since it is common in base64 hashes
+ *
+ * @param str - The string to decode
+ * @return std::string - The decoded string
+ */
+std::string rpc::percentDecode(std::string_view str) {
+	auto hex = [](char c) -> int {
+		if(c >= '0' && c <= '9') return c - '0';
+		if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	};
+
+	std::string out;
+	out.reserve(str.size());
+	for(size_t i = 0; i < str.size(); i++)
+		if(int high, low; str[i] == '%' && i + 2 < str.size() && (high = hex(str[i + 1])) >= 0 && (low = hex(str[i + 2])) >= 0){
+			out += char(high * 16 + low);
+			i += 2;
+		} else out += str[i];
+	return out;
+}
+
+/**
+ * @brief Function which parses a query string (or form encoded body) into a map of parameters
+ *
+ * @param query - The query string (ex. a=1&b=2)
+ * @param params - The map to add the parameters to
+ */
+void rpc::parseParams(std::string_view query, std::unordered_map<std::string, std::string>& params) {
+	while(!query.empty()){
+		// Split off the next parameter
+		size_t end = query.find('&');
+		std::string_view pair = query.substr(0, end);
+		query = end == std::string_view::npos ? std::string_view() : query.substr(end + 1);
+		if(pair.empty()) continue;
+
+		// Split the parameter into its name and value
+		size_t equals = pair.find('=');
+		std::string name = percentDecode(pair.substr(0, equals));
+		params[name] = equals == std::string_view::npos ? "" : percentDecode(pair.substr(equals + 1));
+	}
+}
+
+// Function which creates the JSON body of an error response
+static std::string error(std::string_view message) { return "{\"error\":" + rpc::quote(message) + "}"; }
+
+// Function which converts a HTTP status code into its reason phrase
+static const char* reason(unsigned short status) {
+	switch(status){
+	case 200: return "OK";
+	case 400: return "Bad Request";
+	case 401: return "Unauthorized";
+	case 403: return "Forbidden";
+	case 404: return "Not Found";
+	case 405: return "Method Not Allowed";
+	case 409: return "Conflict";
+	case 413: return "Payload Too Large";
+	default: return "Internal Server Error";
+	}
+}
+
+
+// -- Session --
+
+
+/**
+ * @brief A single (keep-alive) connection to the server
+ * @note Reads and writes happen on the IO thread, the request itself is handled on the worker pool
+ */
+struct rpc::Server::Session : public std::enable_shared_from_this<Session> {
+	// The server this session belongs to
+	Server& server;
+	// The connection
+	boost::asio::ip::tcp::socket socket;
+	// Buffer data is read into (limited so that a client can't make us buffer an unbounded request)
+	boost::asio::streambuf buffer{RPC_MAX_REQUEST_SIZE};
+	// The request currently being handled
+	Request request;
+
+	Session(Server& server, boost::asio::ip::tcp::socket&& socket) : server(server), socket(std::move(socket)) {}
+
+	/**
+	 * @brief Function which reads the headers of the next request
+	 */
+	void readHeaders() {
+		boost::asio::async_read_until(socket, buffer, "\r\n\r\n", [self = shared_from_this()](const boost::system::error_code& ec, size_t headerSize){
+			// NOTE: a request larger than the buffer also results in an error, and simply closes the connection
+			if(!ec) self->parseHeaders(headerSize);
+		});
+	}
+
+	/**
+	 * @brief Function which parses the request line and headers, and then reads the body (if there is one)
+	 *
+	 * @param headerSize - Number of bytes in the buffer which make up the headers
+	 */
+	void parseHeaders(size_t headerSize) {
+		std::string headers(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_begin(buffer.data()) + headerSize);
+		buffer.consume(headerSize);
+
+		// Parse the request line
+		request = {};
+		std::istringstream lines(headers);
+		std::string line, target, version;
+		std::getline(lines, line);
+		std::istringstream(line) >> request.method >> target >> version;
+		if(request.method.empty() || target.empty() || !version.starts_with("HTTP/"))
+			return respond({400, error("Malformed request line")}, /*close*/ true);
+		request.keepAlive = version != "HTTP/1.0";
+
+		// Parse the headers we care about
+		size_t contentLength = 0;
+		while(std::getline(lines, line) && line != "\r"){
+			size_t colon = line.find(':');
+			if(colon == std::string::npos) continue;
+
+			std::string name = line.substr(0, colon), value = line.substr(colon + 1);
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+			std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+			value.erase(0, value.find_first_not_of(" \t"));
+			value.erase(value.find_last_not_of(" \t\r") + 1);
+
+			if(name == "content-length"){
+				if(auto [_, ec] = std::from_chars(value.data(), value.data() + value.size(), contentLength); ec != std::errc())
+					return respond({400, error("Invalid Content-Length")}, /*close*/ true);
+			} else if(name == "connection")
+				request.keepAlive = value == "keep-alive" || (request.keepAlive && value != "close");
+			// NOTE: the token is hex, so comparing it lowercased is fine
+			else if(name == "x-auth-token")
+				request.token = value;
+			else if(name == "origin")
+				request.crossOrigin = true;
+		}
+		if(contentLength > RPC_MAX_REQUEST_SIZE)
+			return respond({413, error("Request body too large")}, /*close*/ true);
+
+		// Split the target into a path and query string
+		size_t question = target.find('?');
+		request.path = percentDecode(std::string_view(target).substr(0, question));
+		if(question != std::string::npos)
+			parseParams(std::string_view(target).substr(question + 1), request.params);
+
+		// Read the rest of the body (if it hasn't already been buffered)
+		if(buffer.size() >= contentLength)
+			return readBody(contentLength);
+		boost::asio::async_read(socket, buffer, boost::asio::transfer_exactly(contentLength - buffer.size()), [self = shared_from_this(), contentLength](const boost::system::error_code& ec, size_t){
+			if(!ec) self->readBody(contentLength);
+		});
+	}
+
+	/**
+	 * @brief Function which parses the (form encoded) body and hands the request off to the worker pool
+	 *
+	 * @param contentLength - The length of the body
+	 */
+	void readBody(size_t contentLength) {
+		std::string body(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_begin(buffer.data()) + contentLength);
+		buffer.consume(contentLength);
+		parseParams(body, request.params);
+
+		// Handle the request on the worker pool (so slow requests don't hold up the IO thread), and then respond back on the IO thread
+		boost::asio::post(server.workers, [self = shared_from_this()](){
+			Response response = self->server.handle(self->request);
+			boost::asio::post(self->socket.get_executor(), [self, response = std::move(response)](){
+				self->respond(response);
+			});
+		});
+	}
+
+	/**
+	 * @brief Function which writes a response, and then waits for the next request (if the connection is being kept alive)
+	 *
+	 * @param response - The response to write
+	 * @param close - Weather the connection should be closed after the response, regardless of what the request wanted
+	 */
+	void respond(const Response& response, bool close = false) {
+		if(close) request.keepAlive = false;
+
+		std::ostringstream out;
+		out << "HTTP/1.1 " << response.status << " " << reason(response.status) << "\r\n"
+			<< "Content-Type: application/json\r\n"
+			<< "Content-Length: " << response.body.size() << "\r\n"
+			<< "Connection: " << (request.keepAlive ? "keep-alive" : "close") << "\r\n\r\n"
+			<< response.body;
+
+		auto data = std::make_shared<std::string>(out.str());
+		boost::asio::async_write(socket, boost::asio::buffer(*data), [self = shared_from_this(), data](const boost::system::error_code& ec, size_t){
+			if(ec) return;
+			if(self->request.keepAlive) self->readHeaders();
+			else {
+				boost::system::error_code ignored;
+				self->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+			}
+		});
+	}
+};
+
+
+// -- Server --
+
+
+// Function which generates a random (hex encoded) auth token
+static std::string generateToken() {
+	CryptoPP::AutoSeededRandomPool rng;
+	std::array<CryptoPP::byte, 32> bytes;
+	rng.GenerateBlock(bytes.data(), bytes.size());
+
+	std::string out;
+	out.reserve(2 * bytes.size());
+	for(auto b: bytes){
+		char digits[3];
+		std::snprintf(digits, sizeof(digits), "%02x", b);
+		out += digits;
+	}
+	return out;
+}
+
+/**
+ * @brief Creates a RPC server, listening on the loopback interface
+ *
+ * @param t - The tangle to serve
+ * @param port - The port to listen on
+ * @param workers - How many requests can be handled concurrently
+ */
+rpc::Server::Server(NetworkedTangle& t, unsigned short port, size_t workers /*= max(hardware_concurrency, 2)*/, std::filesystem::path dataDir /*= {}*/) :
+	t(t), dataDir(std::move(dataDir)), token(generateToken()), acceptor(io, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port)), workers(workers), longPollLimit(std::max<size_t>(1, workers / 2)) {
+	// Write the token to the cookie file (only readable by our user, so only programs running as us can authenticate)
+	cookie = this->dataDir.empty() ? std::filesystem::temp_directory_path() / ("tangle-" + std::to_string(this->port()) + "-" RPC_COOKIE_FILE) : this->dataDir / RPC_COOKIE_FILE;
+	{ std::ofstream create(cookie, std::ios::trunc); }
+	std::filesystem::permissions(cookie, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+	std::ofstream out(cookie, std::ios::trunc);
+	if(!(out << token << std::flush))
+		throw std::runtime_error("Failed to write the RPC cookie file `" + cookie.string() + "`");
+
+	accept();
+	ioThread = std::thread([this](){ io.run(); });
+}
+
+/**
+ * @brief Function which stops the server, waiting for in flight requests to finish
+ */
+void rpc::Server::stop() {
+	if(!ioThread.joinable()) return;
+
+	io.stop();
+	ioThread.join();
+	workers.join();
+
+	// The token is useless once the server stops
+	std::error_code ignored;
+	std::filesystem::remove(cookie, ignored);
+}
+
+/**
+ * @brief Function which accepts connections, starting a session for each of them
+ */
+void rpc::Server::accept() {
+	acceptor.async_accept([this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket){
+		if(!ec) std::make_shared<Session>(*this, std::move(socket))->readHeaders();
+		if(acceptor.is_open()) accept();
+	});
+}
+
+/**
+ * @brief Function which checks if a request carries the auth token
+ *
+ * @param request - The request to check
+ * @return bool - Weather the request's token matches ours
+ */
+bool rpc::Server::authorized(const Request& request) const {
+	if(request.token.size() != token.size()) return false;
+
+	// Compare every character (so how long the comparison takes doesn't reveal how much of the token was right)
+	unsigned char difference = 0;
+	for(size_t i = 0; i < token.size(); i++)
+		difference |= request.token[i] ^ token[i];
+	return difference == 0;
+}
+
+/**
+ * @brief Function which routes a request to its endpoint
+ * @note Exceptions thrown by the endpoints are converted into error responses
+ * @note Requests from web pages are refused, and POST requests (which change state or spend money) must carry the auth token
+ *
+ * @param request - The request to handle
+ * @return Response - The response to the request
+ */
+rpc::Response rpc::Server::handle(const Request& request) {
+	// Table of endpoints (method, path, handler)
+	static const std::array<std::tuple<std::string_view, std::string_view, Response (Server::*)(const Request&)>, 11> endpoints = {{
+		{"GET", "/balance", &Server::balance},
+		{"GET", "/proof", &Server::proof},
+		{"GET", "/transaction", &Server::transaction},
+		{"GET", "/tips", &Server::tips},
+		{"GET", "/stats", &Server::stats},
+		{"POST", "/submit", &Server::submit},
+		{"POST", "/save", &Server::save},
+		{"POST", "/load", &Server::load},
+		{"POST", "/subscribe", &Server::subscribe},
+		{"GET", "/events", &Server::events},
+		{"POST", "/unsubscribe", &Server::unsubscribe},
+	}};
+
+	Response response = {404, error("Unknown endpoint `" + request.path + "`")};
+	// NOTE: browsers attach an Origin to requests made by web pages (and we serve no pages of our own), so refusing them stops other sites from reaching the server through the browser
+	if(request.crossOrigin)
+		response = {403, error("Cross origin requests are refused")};
+	// NOTE: the token is presented in a custom header, which browsers won't send cross site without the server's permission
+	else if(request.method == "POST" && !authorized(request))
+		response = {401, error("POST requests must carry the token from `" + cookie.string() + "` in a " RPC_AUTH_HEADER " header")};
+	else try {
+		for(auto& [method, path, endpoint]: endpoints)
+			if(path == request.path){
+				if(method == request.method) response = (this->*endpoint)(request);
+				else response = {405, error("`" + request.path + "` expects a " + std::string(method) + " request")};
+				break;
+			}
+	} catch (Tangle::InvalidBalance& e) {
+		response = {409, error(e.what())};
+	} catch (Tangle::InvalidSequence& e) {
+		response = {409, error(e.what())};
+	} catch (NetworkedTangle::InvalidAccount& e) {
+		response = {404, error(e.what())};
+	} catch (std::invalid_argument& e) { // Includes Amount::InvalidFormat
+		response = {400, error(e.what())};
+	} catch (std::exception& e) {
+		response = {500, error(e.what())};
+	}
+
+	(response.status < 400 ? served : failed)++;
+	return response;
+}
+
+
+// -- Endpoints --
+
+
+/**
+ * @brief Endpoint which reports the balance of an account at 0%, 50%, and 95% confidence
+ */
+rpc::Response rpc::Server::balance(const Request& request) {
+	std::string account = request.param("account", key::hash(*t.personalKeys));
+	const key::PublicKey& key = account == key::hash(*t.personalKeys) ? t.personalKeys->pub : t.findAccount(account);
+
+	// Light nodes only know the balances peers have proven to them
+	if(t.isLight()){
+		auto balance = t.lightBalance(key::saveBase64(key));
+		return {200, "{\"account\":" + quote(account) + ",\"light\":true,\"balance\":" + (balance ? quote(balance->amount.toString()) : "null") + "}"};
+	}
+
+	// Every tier is calculated against the same snapshot
+	auto snapshot = t.snapshot();
+	auto id = account::intern(key);
+	std::ostringstream out;
+	out << "{\"account\":" << quote(account) << ",\"epoch\":" << snapshot->epoch << ",\"balance\":{"
+		<< "\"0\":" << quote(t.queryBalance(*snapshot, id).toString())
+		<< ",\"50\":" << quote(t.queryBalance(*snapshot, id, .5).toString())
+		<< ",\"95\":" << quote(t.queryBalance(*snapshot, id, .95).toString()) << "}}";
+	return {200, out.str()};
+}
+
+/**
+ * @brief Endpoint which proves an account's confirmed balance (or that it has none) against the authenticated account state
+ * @note The state only includes the transactions the confirmation checker has found confirmed so far
+ */
+rpc::Response rpc::Server::proof(const Request& request) {
+	std::string account = request.param("account", key::hash(*t.personalKeys));
+	const key::PublicKey& key = account == key::hash(*t.personalKeys) ? t.personalKeys->pub : t.findAccount(account);
+
+	auto [root, proof] = t.proveAccount(key::saveBase64(key));
+
+	std::ostringstream out;
+	out << "{\"account\":" << quote(account) << ",\"root\":" << quote(root) << ",\"included\":" << (proof.includes(key::saveBase64(key)) ? "true" : "false");
+	if(proof.leaf)
+		out << ",\"leaf\":{\"account\":" << quote(proof.leaf->account) << ",\"balance\":" << quote(proof.leaf->amount.toString()) << ",\"sequence\":" << proof.leaf->sequence << "}";
+	out << ",\"siblings\":[";
+	for(size_t i = 0; i < proof.siblings.size(); i++)
+		out << (i ? "," : "") << quote(proof.siblings[i]);
+	out << "]}";
+	return {200, out.str()};
+}
+
+/**
+ * @brief Endpoint which reports the details of a transaction
+ */
+rpc::Response rpc::Server::transaction(const Request& request) {
+	std::string hash = request.param("hash");
+	if(hash.empty()) return {400, error("Missing `hash` parameter")};
+
+	auto node = t.snapshot()->find(hash);
+	if(!node) return {404, error("Transaction `" + hash + "` not found")};
+
+	auto confidence = node->measureConfidence();
+	std::ostringstream out;
+	out << "{\"hash\":" << quote(node->hash)
+		<< ",\"timestamp\":" << node->timestamp
+		<< ",\"difficulty\":" << int(node->miningDifficulty)
+		<< ",\"isGenesis\":" << (node->isGenesis ? "true" : "false")
+		<< ",\"cumulativeWeight\":" << (double(node->cumulativeWeight()) / WEIGHT_SCALE)
+		<< ",\"height\":" << node->height()
+		<< ",\"confidence\":" << confidence.estimate
+		<< ",\"confidenceInterval\":[" << confidence.lower << "," << confidence.upper << "]";
+
+	out << ",\"parents\":[";
+	for(size_t i = 0; i < node->parentHashes.size(); i++)
+		out << (i ? "," : "") << quote(node->parentHashes[i]);
+
+	out << "],\"inputs\":[";
+	for(size_t i = 0; i < node->inputs.size(); i++)
+		out << (i ? "," : "") << "{\"account\":" << quote(key::hash(node->inputs[i].account())) << ",\"amount\":" << quote(node->inputs[i].amount.toString()) << ",\"sequence\":" << node->inputs[i].sequence << "}";
+
+	out << "],\"outputs\":[";
+	for(size_t i = 0; i < node->outputs.size(); i++)
+		out << (i ? "," : "") << "{\"account\":" << quote(key::hash(node->outputs[i].account())) << ",\"amount\":" << quote(node->outputs[i].amount.toString()) << "}";
+
+	out << "]}";
+	return {200, out.str()};
+}
+
+/**
+ * @brief Endpoint which lists the current tips
+ */
+rpc::Response rpc::Server::tips(const Request& request) {
+	auto snapshot = t.snapshot();
+	auto& tips = *snapshot->tips;
+
+	std::ostringstream out;
+	out << "{\"epoch\":" << snapshot->epoch << ",\"tips\":[";
+	for(size_t i = 0; i < tips.size(); i++)
+		out << (i ? "," : "") << "{\"hash\":" << quote(tips[i]->hash) << ",\"cumulativeWeight\":" << (double(tips[i]->cumulativeWeight()) / WEIGHT_SCALE) << ",\"height\":" << tips[i]->height() << "}";
+	out << "]}";
+	return {200, out.str()};
+}
+
+/**
+ * @brief Endpoint which reports statistics about the tangle and the server
+ */
+rpc::Response rpc::Server::stats(const Request& request) {
+	auto snapshot = t.snapshot();
+	auto queue = t.networkQueueStats();
+	auto light = t.lightStats();
+	auto admission = t.admissionStats();
+	auto difficulty = t.difficultyStats();
+
+	std::ostringstream out;
+	out << "{\"epoch\":" << snapshot->epoch
+		<< ",\"genesis\":" << quote(snapshot->genesis ? snapshot->genesis->hash : INVALID_HASH)
+		<< ",\"transactions\":" << snapshot->size
+		<< ",\"stateRoot\":" << quote(t.stateRoot())
+		<< ",\"tips\":" << snapshot->tips->size()
+		<< ",\"peers\":" << t.network.peers().size()
+		<< ",\"discardedBeforeMining\":" << t.discardedBeforeMining
+		<< ",\"rejectedAfterMining\":" << t.rejectedAfterMining
+		<< ",\"networkQueue\":{\"size\":" << t.networkQueueSize() << ",\"capacity\":" << t.networkQueueCapacity()
+			<< ",\"pushed\":" << queue.pushed << ",\"popped\":" << queue.popped << ",\"rejected\":" << queue.rejected << "}"
+		<< ",\"light\":" << (!light.enabled ? std::string("null") : "{\"accounts\":" + std::to_string(light.accounts) + ",\"filterBytes\":" + std::to_string(light.filterBytes)
+			+ ",\"tips\":" + std::to_string(light.tips) + ",\"transactions\":" + std::to_string(light.transactions) + ",\"received\":" + std::to_string(light.received)
+			+ ",\"falsePositives\":" + std::to_string(light.falsePositives) + ",\"proofsAccepted\":" + std::to_string(light.proofsAccepted) + ",\"proofsRejected\":" + std::to_string(light.proofsRejected) + "}")
+		<< ",\"difficulty\":{\"minimum\":" << int(difficulty.minimum) << ",\"accepted\":" << int(difficulty.accepted) << ",\"network\":" << int(t.networkDifficulty())
+			<< ",\"ingestRate\":" << difficulty.ingestRate << ",\"tips\":" << difficulty.tips << ",\"accounts\":" << difficulty.accounts << "}"
+		<< ",\"admission\":{\"peers\":" << admission.peers << ",\"admitted\":" << admission.admitted << ",\"limited\":" << admission.limited
+			<< ",\"rejected\":" << admission.rejected << ",\"queueFull\":" << admission.queueFull << ",\"slowDowns\":" << admission.slowDowns << "}"
+		<< ",\"kernels\":" << quote(kernels::name(kernels::active()))
+		<< ",\"rpc\":{\"served\":" << served << ",\"failed\":" << failed << "}}";
+	return {200, out.str()};
+}
+
+/**
+ * @brief Endpoint which creates, mines, and adds a transaction sending money from our account
+ */
+rpc::Response rpc::Server::submit(const Request& request) {
+	std::string to = request.param("to");
+	if(to.empty()) return {400, error("Missing `to` parameter")};
+	Amount amount = Amount::parse(request.param("amount"));
+	if(amount <= 0) return {400, error("`amount` must be positive")};
+	int difficulty = std::stoi(request.param("difficulty", "0"));
+	if(difficulty < 0 || difficulty > DIFFICULTY_MAXIMUM) return {400, error("`difficulty` must be between 0 (the network's minimum) and " + std::to_string(DIFFICULTY_MAXIMUM))};
+
+	// Create transaction inputs and outputs
+	std::vector<Transaction::Output> outputs;
+	outputs.emplace_back(to == key::hash(*t.personalKeys) ? t.personalKeys->pub : t.findAccount(to), amount);
+	std::vector<Transaction::Input> inputs;
+	inputs.emplace_back(*t.personalKeys, amount, t.isLight() ? t.reserveLightSequence(key::saveBase64(t.personalKeys->pub)) : t.reserveSequence(*t.personalKeys), outputs);
+
+	// Create, mine (at no less than the network's minimum difficulty), and add the transaction
+	uint8_t mined = t.miningDifficulty(inputs, difficulty);
+	Hash hash = t.isLight() ? t.addLight(inputs, outputs, mined) : t.add(TransactionNode::createAndMine(t, inputs, outputs, mined));
+	return {200, "{\"hash\":" + quote(hash) + ",\"difficulty\":" + std::to_string(mined) + "}"};
+}
+
+/**
+ * @brief Function which resolves a path provided by a client to a file inside the data directory
+ * @note Absolute paths, and paths which step outside the directory (through .. or symbolic links), are rejected
+ *
+ * @param path - The (relative) path provided by the client
+ * @return std::optional<std::filesystem::path> - The resolved path, or nothing if it isn't allowed
+ */
+std::optional<std::filesystem::path> rpc::Server::resolveDataPath(const std::string& path) const {
+	std::filesystem::path relative(path);
+	if(dataDir.empty() || path.empty() || relative.has_root_name() || relative.has_root_directory()) return {};
+	for(auto& component: relative)
+		if(component == "..") return {};
+
+	// Make sure the resolved file (following any links) still lies inside the directory
+	std::error_code error;
+	auto root = std::filesystem::weakly_canonical(dataDir, error);
+	if(error) return {};
+	auto resolved = std::filesystem::weakly_canonical(root / relative, error);
+	if(error) return {};
+	auto [end, _] = std::mismatch(root.begin(), root.end(), resolved.begin(), resolved.end());
+	if(end != root.end()) return {};
+	return resolved;
+}
+
+/**
+ * @brief Endpoint which saves the tangle to a file (in the data directory)
+ */
+rpc::Response rpc::Server::save(const Request& request) {
+	std::string path = request.param("path");
+	if(dataDir.empty()) return {403, error("Saving is disabled (no data directory was configured)")};
+	auto resolved = resolveDataPath(path);
+	if(!resolved) return {403, error("Path `" + path + "` is outside of the data directory")};
+
+	std::ofstream fout(*resolved, std::ios::binary);
+	if(!fout) return {400, error("Invalid path: `" + path + "`")};
+
+	t.saveTangle(fout);
+	return {200, "{\"path\":" + quote(path) + "}"};
+}
+
+/**
+ * @brief Endpoint which loads the tangle from a file (in the data directory)
+ * @note The load completes asynchronously, as the loaded transactions are processed by the network queue
+ */
+rpc::Response rpc::Server::load(const Request& request) {
+	std::string path = request.param("path");
+	if(dataDir.empty()) return {403, error("Loading is disabled (no data directory was configured)")};
+	auto resolved = resolveDataPath(path);
+	if(!resolved) return {403, error("Path `" + path + "` is outside of the data directory")};
+
+	std::ifstream fin(*resolved, std::ios::binary);
+	if(!fin) return {400, error("Invalid path: `" + path + "`")};
+
+	// Determine the size of the file
+	fin.seekg(0l, std::ios::end);
+	size_t size = fin.tellg();
+	fin.seekg(0l, std::ios::beg);
+
+	t.loadTangle(fin, size);
+	return {200, "{\"path\":" + quote(path) + "}"};
+}
+
+/**
+ * @brief Endpoint which subscribes to the stream of transaction events (filtered by account, event type, and confidence threshold)
+ */
+rpc::Response rpc::Server::subscribe(const Request& request) {
+	events::Filter filter;
+	std::string param;
+
+	// Parse the comma separated list of accounts to watch
+	std::istringstream accounts(request.param("account"));
+	while(std::getline(accounts, param, ','))
+		if(!param.empty())
+			filter.accounts.insert(key::saveBase64(param == key::hash(*t.personalKeys) ? t.personalKeys->pub : t.findAccount(param)));
+
+	// Parse the comma separated list of event types
+	if(std::istringstream types(request.param("types")); !types.str().empty()){
+		filter.types = 0;
+		while(std::getline(types, param, ','))
+			if(auto type = events::parse(param)) filter.types |= uint8_t(*type);
+			else return {400, error("Unknown event type `" + param + "`")};
+	}
+
+	// Parse the comma separated list of confidence thresholds
+	if(std::istringstream thresholds(request.param("thresholds")); !thresholds.str().empty()){
+		filter.thresholds.clear();
+		while(std::getline(thresholds, param, ','))
+			if(float threshold = std::stof(param); threshold > 0 && threshold <= 1) filter.thresholds.push_back(threshold);
+			else return {400, error("Thresholds must be in (0, 1]")};
+	}
+
+	size_t capacity = std::stoul(request.param("capacity", std::to_string(EVENT_QUEUE_CAPACITY)));
+	if(capacity < 1 || capacity > RPC_MAX_EVENT_CAPACITY) return {400, error("`capacity` must be between 1 and " + std::to_string(RPC_MAX_EVENT_CAPACITY))};
+
+	auto subscription = t.events.subscribe(std::move(filter), capacity);
+	return {200, "{\"id\":" + std::to_string(subscription->id) + ",\"capacity\":" + std::to_string(capacity) + "}"};
+}
+
+/**
+ * @brief Endpoint which takes the events waiting for a subscription (waiting up to <wait> milliseconds for one to arrive if none are waiting)
+ * @note Only half of the workers may wait at once, once they are the request returns immediately (with whatever is waiting)
+ */
+rpc::Response rpc::Server::events(const Request& request) {
+	auto subscription = t.events.find(std::stoull(request.param("id", "0")));
+	if(!subscription) return {404, error("Subscription `" + request.param("id") + "` not found")};
+	size_t max = std::stoul(request.param("max", std::to_string(EVENT_QUEUE_CAPACITY)));
+	auto wait = std::chrono::milliseconds(std::clamp<long>(std::stol(request.param("wait", "0")), 0, RPC_MAX_EVENT_WAIT));
+
+	// If too many requests are already waiting... don't wait
+	size_t polling = wait.count() > 0 ? ++longPolls : 0;
+	if(polling > longPollLimit) wait = std::chrono::milliseconds(0);
+	auto waiting = subscription->poll(max, wait);
+	if(polling) longPolls--;
+	auto stats = subscription->stats();
+
+	std::ostringstream out;
+	out << "{\"id\":" << subscription->id << ",\"delivered\":" << stats.delivered << ",\"dropped\":" << stats.dropped << ",\"queued\":" << stats.queued << ",\"events\":[";
+	for(size_t i = 0; i < waiting.size(); i++){
+		auto& event = waiting[i];
+		out << (i ? "," : "") << "{\"id\":" << event.id << ",\"type\":" << quote(events::name(event.type)) << ",\"hash\":" << quote(event.hash);
+		if(event.type == events::Type::Confirmed)
+			out << ",\"threshold\":" << event.threshold << ",\"confidence\":" << event.confidence;
+		out << ",\"accounts\":[";
+		for(size_t j = 0; j < event.accounts.size(); j++)
+			out << (j ? "," : "") << quote(key::hash(key::loadPublicBase64(event.accounts[j])));
+		out << "]}";
+	}
+	out << "]}";
+	return {200, out.str()};
+}
+
+/**
+ * @brief Endpoint which cancels a subscription
+ */
+rpc::Response rpc::Server::unsubscribe(const Request& request) {
+	std::string id = request.param("id", "0");
+	if(!t.events.unsubscribe(std::stoull(id))) return {404, error("Subscription `" + id + "` not found")};
+	return {200, "{\"id\":" + id + "}"};
+}
@@ -0,0 +1,162 @@
+/**
+ * @file rpc.hpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief File which provides a local (HTTP over localhost) RPC server exposing the tangle to other programs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef RPC_HPP
+#define RPC_HPP
+
+#include "networking.hpp"
+
+#include <atomic>
+#include <filesystem>
+
+#include <boost/asio/thread_pool.hpp>
+
+// The default port to start searching for RPC ports at
+#define DEFAULT_RPC_PORT_NUMBER 12400
+
+// Largest request (headers and body) the RPC server will accept
+#define RPC_MAX_REQUEST_SIZE (64 * 1024)
+
+// Longest (in milliseconds) a request for events will wait for one to arrive (waiting ties up a worker, so at most half of the workers, and at least one, wait at once)
+#define RPC_MAX_EVENT_WAIT 10000
+// Largest number of events a subscription can have waiting
+#define RPC_MAX_EVENT_CAPACITY (16 * EVENT_QUEUE_CAPACITY)
+
+// Name of the file (in the data directory, or the temporary directory without one) the per-run auth token is written to
+#define RPC_COOKIE_FILE "rpc.cookie"
+// Header POST requests must carry the auth token in
+#define RPC_AUTH_HEADER "X-Auth-Token"
+
+namespace rpc {
+
+	/**
+	 * @brief A parsed HTTP request
+	 */
+	struct Request {
+		std::string method;
+		// Path component of the target (ex. /balance)
+		std::string path;
+		// Combined query string and (form encoded) body parameters
+		std::unordered_map<std::string, std::string> params;
+		// Weather the connection should be kept open after the response
+		bool keepAlive = true;
+		// The auth token the request carried (in its X-Auth-Token header)
+		std::string token;
+		// Weather the request carried an Origin header (which browsers attach to requests made by web pages)
+		bool crossOrigin = false;
+
+		/**
+		 * @brief Function which gets a parameter, or a default value if it wasn't provided
+		 *
+		 * @param name - The name of the parameter
+		 * @param fallback - The value returned if the parameter isn't present
+		 * @return std::string - The parameter's value
+		 */
+		std::string param(const std::string& name, const std::string& fallback = "") const {
+			if(auto found = params.find(name); found != params.end())
+				return found->second;
+			return fallback;
+		}
+	};
+
+	/**
+	 * @brief A HTTP response (bodies are always JSON)
+	 */
+	struct Response {
+		unsigned short status = 200;
+		std::string body;
+	};
+
+	/**
+	 * @brief Embedded RPC server, serving JSON over HTTP on the loopback interface
+	 * @note IO is handled asynchronously by one thread, while requests are handled concurrently by a pool of workers
+	 * @note Queries are answered from an immutable snapshot of the tangle, so they never hold up transactions being added
+	 * @note POST requests must carry the per-run token from the cookie file in an X-Auth-Token header, and requests carrying an Origin header are refused (so web pages can't reach the server)
+	 *
+	 * Endpoints:
+	 * 	GET  /balance?account=<hash>			- Balance at 0%, 50%, and 95% confidence (defaults to our account, light nodes report the proven balance)
+	 * 	GET  /proof?account=<hash>			- Proof of the account's confirmed balance against the authenticated account state (defaults to our account)
+	 * 	GET  /transaction?hash=<hash>		- Details of a transaction
+	 * 	GET  /tips							- The current tips
+	 * 	GET  /stats							- Statistics about the tangle and server
+	 * 	POST /submit?to=<hash>&amount=<amount>[&difficulty=<0-5>]	- Creates, mines (at no less than the network's minimum difficulty, 0 mines at exactly it), and adds a transaction from our account
+	 * 	POST /save?path=<path>				- Saves the tangle to a file (relative to the data directory, disabled without one)
+	 * 	POST /load?path=<path>				- Loads the tangle from a file (relative to the data directory, disabled without one)
+	 * 	POST /subscribe[?account=<hash>,...][&types=committed,confirmed,pruned][&thresholds=0.5,0.95][&capacity=<n>]	- Subscribes to transaction events (returns the subscription's id)
+	 * 	GET  /events?id=<id>[&max=<n>][&wait=<ms>]	- Takes the subscription's waiting events (long polls for up to <wait> ms, unless half the workers already are), reports how many were dropped
+	 * 	POST /unsubscribe?id=<id>			- Cancels a subscription
+	 */
+	struct Server {
+		// Number of requests which were successfully served
+		std::atomic<size_t> served = 0;
+		// Number of requests which resulted in an error
+		std::atomic<size_t> failed = 0;
+
+		Server(NetworkedTangle& t, unsigned short port, size_t workers = std::max(std::thread::hardware_concurrency(), 2u), std::filesystem::path dataDir = {});
+		~Server() { stop(); }
+
+		void stop();
+
+		// The port the server is listening on
+		unsigned short port() const { return acceptor.local_endpoint().port(); }
+		// The file the auth token was written to
+		const std::filesystem::path& cookiePath() const { return cookie; }
+
+		Response handle(const Request& request);
+
+	protected:
+		// The tangle being served
+		NetworkedTangle& t;
+		// Directory which saved tangles are read from and written to (empty disables saving and loading)
+		std::filesystem::path dataDir;
+		// Random token generated each run (which POST requests must present), and the file it is written to (readable only by our user)
+		const std::string token;
+		std::filesystem::path cookie;
+		// IO context (run on its own thread) and the acceptor listening for connections
+		boost::asio::io_context io;
+		boost::asio::ip::tcp::acceptor acceptor;
+		// Pool of threads which handle requests
+		boost::asio::thread_pool workers;
+		// Number of requests currently waiting for events, and how many may wait at once (so long polls can't starve the other requests)
+		std::atomic<size_t> longPolls = 0;
+		const size_t longPollLimit;
+		// Thread running the IO context
+		std::thread ioThread;
+
+		// A single connection to the server
+		struct Session;
+
+		void accept();
+		bool authorized(const Request& request) const;
+		std::optional<std::filesystem::path> resolveDataPath(const std::string& path) const;
+
+		Response balance(const Request& request);
+		Response proof(const Request& request);
+		Response transaction(const Request& request);
+		Response tips(const Request& request);
+		Response stats(const Request& request);
+		Response submit(const Request& request);
+		Response save(const Request& request);
+		Response load(const Request& request);
+		Response subscribe(const Request& request);
+		Response events(const Request& request);
+		Response unsubscribe(const Request& request);
+	};
+
+	// Function which escapes a string so it can be embedded in JSON
+	std::string quote(std::string_view str);
+	// Function which decodes a percent encoded URL component
+	std::string percentDecode(std::string_view str);
+	// Function which parses a query string (or form encoded body) into a map of parameters
+	void parseParams(std::string_view query, std::unordered_map<std::string, std::string>& params);
+
+} // rpc
+
+#endif /* end of include guard: RPC_HPP */
@@ -0,0 +1,121 @@
+/**
+ * @file rpc_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Throughput/latency benchmark client for the RPC server (see rpc.hpp)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+/**
+ * @brief Function which sends a single request over a (keep-alive) connection and waits for the full response
+ *
+ * @param sock - The connection to send the request on
+ * @param buffer - Buffer used to read the response (leftover data is preserved between requests)
+ * @param request - The raw request to send
+ * @return unsigned short - The status code of the response
+ */
+unsigned short roundTrip(boost::asio::ip::tcp::socket& sock, boost::asio::streambuf& buffer, const std::string& request) {
+	boost::asio::write(sock, boost::asio::buffer(request));
+
+	// Read the headers
+	size_t headerSize = boost::asio::read_until(sock, buffer, "\r\n\r\n");
+	std::string headers(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_begin(buffer.data()) + headerSize);
+	buffer.consume(headerSize);
+
+	// Determine the status and how long the body is
+	unsigned short status = std::stoi(headers.substr(headers.find(' ') + 1, 3));
+	size_t contentLength = 0;
+	if(size_t found = headers.find("Content-Length: "); found != std::string::npos)
+		contentLength = std::stoul(headers.substr(found + 16));
+
+	// Read (and discard) the body
+	if(buffer.size() < contentLength)
+		boost::asio::read(sock, buffer, boost::asio::transfer_exactly(contentLength - buffer.size()));
+	buffer.consume(contentLength);
+
+	return status;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc < 2 || argc > 7){
+		std::cout << "Usage: " << argv[0] << " <rpc port> [<target> = /stats] [<connections> = 4] [<requests per connection> = 1000] [<method> = GET] [<cookie file> (required for POST)]" << std::endl;
+		return 1;
+	}
+
+	unsigned short port = std::stoi(argv[1]);
+	std::string target = argc > 2 ? argv[2] : "/stats";
+	size_t connections = argc > 3 ? std::stoul(argv[3]) : 4;
+	size_t requests = argc > 4 ? std::stoul(argv[4]) : 1000;
+	std::string method = argc > 5 ? argv[5] : "GET";
+
+	// Read the auth token the server wrote to its cookie file (if given one)
+	std::string token;
+	if(argc > 6 && !(std::ifstream(argv[6]) >> token)){
+		std::cerr << "Failed to read the auth token from `" << argv[6] << "`" << std::endl;
+		return 1;
+	}
+
+	std::string request = method + " " + target + " HTTP/1.1\r\nHost: localhost\r\n" + (token.empty() ? "" : "X-Auth-Token: " + token + "\r\n") + "Content-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+	boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+
+	// Latencies (in microseconds) recorded by each connection
+	std::vector<std::vector<double>> latencies(connections);
+	std::atomic<size_t> errors = 0;
+
+	// Each connection sends its requests back to back from its own thread
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(size_t c = 0; c < connections; c++)
+		threads.emplace_back([&, c](){
+			try {
+				boost::asio::io_context io;
+				boost::asio::ip::tcp::socket sock(io);
+				sock.connect(endpoint);
+				boost::asio::streambuf buffer;
+
+				latencies[c].reserve(requests);
+				for(size_t i = 0; i < requests; i++){
+					auto sent = std::chrono::steady_clock::now();
+					if(roundTrip(sock, buffer, request) >= 400) errors++;
+					latencies[c].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+				}
+			} catch (std::exception& e) {
+				std::cerr << "Connection " << c << " failed: " << e.what() << std::endl;
+			}
+		});
+	for(auto& thread: threads)
+		thread.join();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Merge and sort the latencies so percentiles can be read off
+	std::vector<double> all;
+	for(auto& l: latencies)
+		all.insert(all.end(), l.begin(), l.end());
+	if(all.empty()){
+		std::cerr << "No requests completed" << std::endl;
+		return 1;
+	}
+	std::sort(all.begin(), all.end());
+	auto percentile = [&all](double p) { return all[std::min(all.size() - 1, size_t(p * all.size()))]; };
+
+	std::cout << method << " " << target << ": " << all.size() << " requests over " << connections << " connections in " << elapsed << "s (" << errors << " errors)" << std::endl
+		<< "Throughput: " << (all.size() / elapsed) << " requests/s" << std::endl
+		<< "Latency (us): p50 " << percentile(.5) << ", p90 " << percentile(.9) << ", p99 " << percentile(.99) << ", max " << all.back() << std::endl;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file sequences_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark checking how the tangle handles replayed, skipped, and conflicting sequence numbers (see Tangle::AccountSequences), and measuring that checking them stays constant time as the tangle grows
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+
+#include "bench.hpp"
+
+/**
+ * @brief Tangle which exposes its sequence number table, and how many of its entries the sequence checks examine
+ */
+struct SequenceTangle : public BenchTangle {
+	// Function which gets the number of claims recorded against an account
+	size_t claims(const key::KeyPair& pair) {
+		auto lock = sequences.read_lock();
+		auto record = lock->find(account::intern(pair.pub));
+		return record == lock->end() ? 0 : record->second.claims.size();
+	}
+
+	using Tangle::sequenceEntries;
+};
+
+// Function which creates (and mines) a transaction sending <amount> from <from> to <to> using sequence number <sequence>
+TransactionNode::ptr spend(const Tangle& t, const key::KeyPair& from, const key::KeyPair& to, Amount amount, uint64_t sequence) {
+	std::vector<Transaction::Output> outputs = {{to.pub, amount}};
+	std::vector<Transaction::Input> inputs = {{from, amount, sequence, outputs}};
+	return TransactionNode::createAndMine(t, inputs, outputs, 1);
+}
+
+// Function which checks if adding a node throws InvalidSequence
+bool rejectsSequence(Tangle& t, const TransactionNode::ptr& node) {
+	try {
+		t.add(node);
+	} catch (Tangle::InvalidSequence&) {
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 2){
+		std::cout << "Usage: " << argv[0] << " [<transactions> = 1000]" << std::endl;
+		return 1;
+	}
+	size_t transactions = argc > 1 ? std::stoul(argv[1]) : 1000;
+
+	auto alice = key::generateKeyPair(), bob = key::generateKeyPair();
+	SequenceTangle t;
+	t.setGenesis(TransactionNode::create({}, {}, {{alice.pub, Amount(1'000'000)}}));
+
+	// -- Replays --
+
+	auto first = spend(t, alice, bob, 10, 0);
+	t.add(first);
+	check(t.nextSequence(account::intern(alice.pub)) == 1, "spending sequence number 0 advances the next sequence number to 1");
+
+	// The same signed input in a new transaction (approving different parents, so it has a different hash)
+	std::vector<Transaction::Output> outputs = {{bob.pub, Amount(10)}};
+	auto replay = TransactionNode::create({first}, first->inputs, outputs, 1);
+	replay->mineTransaction();
+	check(rejectsSequence(t, replay), "replaying a signed input is rejected");
+
+	// The same content signed again (ECDSA signatures are randomized and malleable, so the signature bytes differ but it still verifies)
+	std::vector<Transaction::Input> resigned = {{alice, 10, 0, outputs}};
+	auto malleated = TransactionNode::create({first}, resigned, outputs, 1);
+	malleated->mineTransaction();
+	check(resigned.front().signature != first->inputs.front().signature && rejectsSequence(t, malleated), "replaying signed content under different signature bytes is rejected");
+
+	// The same sequence number twice in one transaction
+	std::vector<Transaction::Input> doubled = {{alice, 1, 1, outputs}, {alice, 9, 1, outputs}};
+	try {
+		t.add(TransactionNode::createAndMine(t, doubled, outputs, 1));
+		check(false, "spending a sequence number twice in one transaction is rejected");
+	} catch (Tangle::InvalidSequence&) {
+		check(true, "spending a sequence number twice in one transaction is rejected");
+	}
+
+	// -- Gaps --
+
+	auto skipped = spend(t, alice, bob, 10, 5);
+	t.add(skipped);
+	check(t.find(skipped->hash) != nullptr, "skipping sequence numbers (a gap) is allowed");
+	check(t.nextSequence(account::intern(alice.pub)) == 6, "the next sequence number continues after the gap");
+	auto filled = spend(t, alice, bob, 10, 3);
+	t.add(filled);
+	check(t.find(filled->hash) != nullptr, "an unspent sequence number inside the gap can still be spent");
+
+	// -- Conflicts --
+
+	// Different signed content spending an already claimed sequence number which also approves the spend it conflicts with (both sides of the conflict) is rejected, without leaving anything contested
+	std::vector<Transaction::Output> elsewhere = {{alice.pub, Amount(10)}};
+	auto inconsistent = TransactionNode::create({first}, {{alice, 10, 0, elsewhere}}, elsewhere, 1);
+	inconsistent->mineTransaction();
+	try {
+		t.add(inconsistent);
+		check(false, "approving both sides of a conflict is rejected");
+	} catch (std::runtime_error&) {
+		check(t.find(inconsistent->hash) == nullptr, "approving both sides of a conflict is rejected");
+	}
+	check(!t.isConflicted(first) && *first->contested.read_lock() == nullptr, "a rejected conflicting spend leaves the spend it conflicted with uncontested");
+
+	// Different signed content spending an already claimed sequence number (sending the money somewhere else, approving only the genesis so it doesn't approve the spend it conflicts with)
+	auto conflicting = TransactionNode::create({t.genesis}, {{alice, 10, 0, elsewhere}}, elsewhere, 1);
+	conflicting->mineTransaction();
+	check(!t.isConflicted(first), "an unconflicted spend isn't flagged");
+	t.add(conflicting);
+	check(t.isConflicted(first) && t.isConflicted(conflicting), "both sides of a conflicting spend are flagged");
+	check(*first->contested.read_lock() != nullptr, "an accepted conflicting spend marks the spend it conflicts with contested");
+	check(!t.isConflicted(skipped), "unrelated spends aren't flagged");
+
+	// -- Genesis Floor --
+
+	// A new genesis which records that alice's sequence numbers below 6 were spent before it
+	size_t before = t.claims(alice);
+	t.setGenesis(TransactionNode::create({}, {}, {{alice.pub, Amount(1'000'000), 6}, {bob.pub, Amount(40)}}));
+	check(before > 0 && t.claims(alice) == 0, "claims below the new genesis' floor are forgotten");
+	check(rejectsSequence(t, TransactionNode::create({t.genesis}, {{alice, 10, 4, outputs}}, outputs, 1)), "sequence numbers spent before the genesis are rejected");
+	auto after = spend(t, alice, bob, 10, 6);
+	t.add(after);
+	check(t.find(after->hash) != nullptr, "the sequence number at the floor can be spent");
+
+	// -- Constant Time Checks --
+
+	// Grow the tangle, counting the table entries the sequence check of a fresh spend examines (and timing it) when it is small and when it is large
+	auto measureCheck = [&](uint64_t sequence) {
+		auto node = spend(t, alice, bob, 1, sequence);
+		size_t before = t.sequenceEntries();
+		t.checkSequences(node);
+		size_t touched = t.sequenceEntries() - before;
+
+		auto start = std::chrono::steady_clock::now();
+		for(size_t i = 0; i < 10'000; i++)
+			t.checkSequences(node);
+		double nanoseconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 10'000 * 1e9;
+		return std::make_pair(touched, nanoseconds);
+	};
+	auto [smallTouched, small] = measureCheck(1'000'000);
+	for(size_t i = 0; i < transactions; i++)
+		t.add(spend(t, alice, bob, 1, t.reserveSequence(alice)));
+	auto [largeTouched, large] = measureCheck(2'000'000);
+	std::cout << "Sequence check with 2 transactions: " << smallTouched << " entries (" << small << "ns), with " << (transactions + 2) << " transactions: " << largeTouched << " entries (" << large << "ns)" << std::endl;
+	check(smallTouched == largeTouched, "checking sequence numbers examines as many table entries no matter how large the tangle grows");
+
+	return finish();
+}
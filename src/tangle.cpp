@@ -10,6 +10,7 @@
  */
 #include "tangle.hpp"
 
+#include <optional>
 #include <thread>
 
 #include <cryptopp/osrng.h>
@@ -35,7 +36,16 @@ TransactionNode::TransactionNode(const std::vector<TransactionNode::const_ptr> p
 		for(const TransactionNode::const_ptr& p: parents)
 			out.push_back(p->hash);
 		return out;
-	}(parents), inputs, outputs, difficulty), parents(parents) { }
+	}(parents), inputs, outputs, difficulty),
+	// The node starts out one level above its highest parent (parents never change height once they have children, except when the genesis changes)
+	metrics(Metrics{0, [](const std::vector<TransactionNode::const_ptr>& parents) -> uint32_t {
+		if(parents.empty()) return 0;
+		size_t max = 0;
+		for(auto& parent: parents)
+			max = std::max(parent->height(), max);
+		return max + 1;
+	}(parents)}),
+	parents(parents), inputColumns(this->inputs), outputColumns(this->outputs) { }
 
 /**
  * @brief Function which converts a transaction into a transaction node
@@ -67,17 +77,35 @@ TransactionNode::ptr TransactionNode::create(const Tangle& t, const Transaction&
  * @note G-IOTA DOI: 10.1109/INFCOMW.2019.8845163
  */
 TransactionNode::ptr TransactionNode::createAndMine(const Tangle& t, const std::vector<Transaction::Input>& inputs, const std::vector<Transaction::Output>& outputs, uint8_t difficulty /*= 3*/){
-	// Select two different (unless there is only 1) tips at random
+	// Random walk which avoids (up to 4 retries) tips which spend a conflicting sequence number, approve of both sides of a conflict,
+	// or (if provided) are or can't be approved alongside the <partner> tip
+	auto walk = [&t](const TransactionNode::const_ptr& partner = nullptr) {
+		auto acceptable = [&partner, &t](const TransactionNode::const_ptr& tip) {
+			return !t.isConflicted(tip) && tip->isConsistent() && (!partner || (tip != partner && tip->isCompatible(*partner)));
+		};
+
+		auto tip = t.biasedRandomWalk();
+		for(uint8_t tries = 0; tip && tries < 4 && !acceptable(tip); tries++)
+			tip = t.biasedRandomWalk();
+		// If the walks keep ending on unacceptable tips (most tips are conflicted), pick an acceptable tip directly rather than walking again
+		if(tip && !acceptable(tip))
+			for(auto [i, tipLock] = std::make_pair(size_t(0), util::mutable_cast(t.tips).read_lock()); i < tipLock->size(); i++)
+				if(acceptable(tipLock[i]))
+					return TransactionNode::const_ptr(tipLock[i]);
+		return tip;
+	};
+
+	// Select two different (unless there is only 1) compatible tips at random
 	std::vector<TransactionNode::const_ptr> parents;
-	parents.push_back(t.biasedRandomWalk()); // Tip1 = front
-	parents.push_back(t.biasedRandomWalk()); // Tip2 = back
-	// 256 tries to find a different tip before giving up
-	for(auto [counter, tipCount] = std::make_pair(uint8_t(1), t.tips.read_lock()->size());
-	  tipCount > 1 && parents.front() == parents.back() && counter != 0; counter++)
-		parents.back() = t.biasedRandomWalk();
+	parents.push_back(walk()); // Tip1 = front
+	parents.push_back(walk(parents.front())); // Tip2 = back
 
 	if(!parents.front() || !parents.back()) throw std::runtime_error("Failed to find a tip!");
 
+	// If we couldn't find a second tip compatible with the first, only approve the first
+	if(parents.back() == parents.front() || !parents.back()->isCompatible(*parents.front()))
+		parents.pop_back();
+
 	// Calculate the (truncated) average height of our chosen parents
 	size_t avgHeight = 0;
 	for(auto& parent: parents)
@@ -86,7 +114,8 @@ TransactionNode::ptr TransactionNode::createAndMine(const Tangle& t, const std::
 
 	// If we can find a tip whose height (longest path to genesis) qualifies it as left behind, also add it as a parent
 	for(auto [i, tipLock] = std::make_pair(size_t(0), util::mutable_cast(t.tips).read_lock()); i < tipLock->size(); i++)
-		if(tipLock[i]->height() <= avgHeight - LEFT_BEHIND_TIP_THRESHOLD){
+		if(tipLock[i]->height() <= avgHeight - LEFT_BEHIND_TIP_THRESHOLD
+		  && std::all_of(parents.begin(), parents.end(), [&tip = tipLock[i]](const TransactionNode::const_ptr& parent) { return tip->isCompatible(*parent); })){
 			parents.push_back(tipLock[i]);
 			break;
 		}
@@ -94,8 +123,19 @@ TransactionNode::ptr TransactionNode::createAndMine(const Tangle& t, const std::
 	// Ensure that each node only appears once in the list of parents
 	util::removeDuplicates(parents);
 
-	// Create and mine the transaction
+	// Create the transaction
 	TransactionNode::ptr trx = TransactionNode::create(parents, inputs, outputs, difficulty);
+
+	// Make sure the transaction's spends would be accepted before spending the effort to mine it
+	try {
+		t.checkSequences(trx);
+		t.checkBalances(trx);
+	} catch (...) {
+		t.discardedBeforeMining++;
+		throw;
+	}
+
+	// Mine the transaction
 	trx->mineTransaction();
 	return trx;
 }
@@ -107,11 +147,13 @@ void TransactionNode::debugDump() {
 	Transaction::debugDump();
 
 	std::cout << "Is Genesis? " << (isGenesis ? "True" : "False")  << std::endl;
-	std::cout << "Weight: " << ownWeight() << std::endl;
-	std::cout << "Cumulative weight: " << cumulativeWeight << std::endl;
+	std::cout << "Weight: " << (double(ownWeight()) / WEIGHT_SCALE) << std::endl;
+	std::cout << "Cumulative weight: " << (double(cumulativeWeight()) / WEIGHT_SCALE) << std::endl;
 	std::cout << "Height: " << height() << std::endl;
 	std::cout << "Depth: " << depth() << std::endl;
 	std::cout << "Confidence: " << (confirmationConfidence() * 100) << "%" << std::endl;
+	if(auto set = *contested.read_lock(); set)
+		std::cout << "Contested spends approved: " << set->size() << (isConsistent() ? "" : " (inconsistent)") << std::endl;
 }
 
 /**
@@ -123,7 +165,7 @@ void TransactionNode::debugDump() {
 TransactionNode::const_ptr TransactionNode::find(Hash& hash) const {
 	// Create a queue starting from this
 	std::queue<TransactionNode::const_ptr> q; q.push(shared_from_this());
-	std::list<std::string> considered;
+	std::unordered_set<std::string> considered;
 
 	// While the queue isn't empty, pop each element off and...
 	while(!q.empty()){
@@ -143,10 +185,8 @@ TransactionNode::const_ptr TransactionNode::find(Hash& hash) const {
 		// Add this node's children unless we have already considered them
 		auto lock = head->children.read_lock();
 		for(size_t i = 0, size = lock->size(); i < size; i++)
-			if(auto child = lock[i]; std::find(considered.begin(), considered.end(), child->hash) == considered.end()){
+			if(auto child = lock[i]; considered.insert(child->hash).second)
 				q.push(child);
-				considered.push_back(child->hash);
-			}
 	}
 
 	return nullptr;
@@ -162,7 +202,7 @@ TransactionNode::const_ptr TransactionNode::find(Hash& hash) const {
 TransactionNode::ptr TransactionNode::find(Hash& hash) {
 	// Create a queue starting from this
 	std::queue<TransactionNode::ptr> q; q.push(shared_from_this());
-	std::list<std::string> considered;
+	std::unordered_set<std::string> considered;
 
 	// While the queue isn't empty, pop each element off and...
 	while(!q.empty()){
@@ -182,10 +222,8 @@ TransactionNode::ptr TransactionNode::find(Hash& hash) {
 		// Add this node's children unless we have already considered them
 		auto lock = head->children.read_lock();
 		for(size_t i = 0, size = lock->size(); i < size; i++)
-			if(auto child = lock[i]; std::find(considered.begin(), considered.end(), child->hash) == considered.end()){
+			if(auto child = lock[i]; considered.insert(child->hash).second)
 				q.push(child);
-				considered.push_back(child->hash);
-			}
 	}
 
 	return nullptr;
@@ -196,21 +234,28 @@ TransactionNode::ptr TransactionNode::find(Hash& hash) {
  *
  * @param considered - List of nodes that have already been considered
  * @param height - The height of the current node
+ * @param epoch - Children added after this epoch are ignored
  */
-void TransactionNode::recursiveDebugDump(std::list<std::string>& considered, size_t height /*= 0*/) const {
+void TransactionNode::recursiveDebugDump(std::list<std::string>& considered, size_t height /*= 0*/, uint64_t epoch /*= max*/) const {
 	// Only print out information about a node if it hasn't already been printed
 	if(std::find(considered.begin(), considered.end(), hash) != considered.end()) return;
 
-	std::cout << std::left << std::setw(5) << height << std::string(height + 1, ' ') << hash << " children: [ ";
+	// Copy the children which were added before the <epoch> (so the list can't change out from under us)
+	std::vector<TransactionNode::ptr> children;
 	{
-		auto lock = children.read_lock();
-		for(size_t i = 0; i < children.unsafe().size(); i++)
-			std::cout << children.unsafe()[i]->hash << ", ";
+		auto lock = this->children.read_lock();
+		for(size_t i = 0; i < lock->size(); i++)
+			if(lock[i]->epoch <= epoch)
+				children.push_back(lock[i]);
 	}
+
+	std::cout << std::left << std::setw(5) << height << std::string(height + 1, ' ') << hash << " children: [ ";
+	for(auto& child: children)
+		std::cout << child->hash << ", ";
 	std::cout << "]" << std::endl;
 
-	for(size_t i = 0; i < children.unsafe().size(); i++)
-		children.unsafe()[i]->recursiveDebugDump(considered, height + 1);
+	for(auto& child: children)
+		child->recursiveDebugDump(considered, height + 1, epoch);
 
 	considered.push_back(hash);
 }
@@ -238,21 +283,6 @@ void TransactionNode::recursivelyListTransactions(std::list<TransactionNode*>& t
 // -- TransactionNode Consensus Functions --
 
 
-/**
- * @brief Function which calculates the height (longest path to genesis) of the transaction
- *
- * @return size_t - The height
- */
-size_t TransactionNode::height() const {
-	if(isGenesis) return 0;
-
-	size_t max = 0;
-	for(size_t i = 0; i < parents.size(); i++)
-		max = std::max(parents[i]->height(), max);
-
-	return max + 1;
-}
-
 /**
  * @brief Function which calculates the depth (longest path to tip) of the transaction
  *
@@ -278,44 +308,57 @@ size_t TransactionNode::depth() const {
 TransactionNode::const_ptr TransactionNode::biasedRandomWalk(double alpha /*= 10*/) const {
 	// Seed random number generator
 	CryptoPP::AutoSeededRandomPool rng;
-	// (Read) Lock our children
-	auto lock = children.read_lock();
+
+	// Copy our children (so the lock isn't held for the rest of the walk)
+	std::vector<TransactionNode::const_ptr> candidates;
+	{
+		auto lock = children.read_lock();
+		candidates.assign(lock->begin(), lock->end());
+	}
 
 	// If we are a tip, get the shared pointer referencing us
-	if(lock->empty())
+	if(candidates.empty())
 		return shared_from_this();
 
-	// Variable that stores the generated weighted list
-	std::vector<std::pair<TransactionNode::const_ptr, double>> weightedList(lock->size());
-	// Variable that stores the total weight of the list
-	double totalWeight = 0;
-
-	// Create a weighted list of children
-	for(size_t i = 0; i < weightedList.size(); i++){
-		TransactionNode::const_ptr child = lock[i];
-		double weight = std::max( std::exp(-alpha * (cumulativeWeight - child->cumulativeWeight)), std::numeric_limits<double>::min() );
-		weightedList[i] = {child, weight};
-		totalWeight += weight;
+	// Our weight (read once, the weights may be updated while we walk)
+	Weight ourWeight = cumulativeWeight();
+
+	// The log weight of each child is -alpha times how much lighter than us it is (in whole transaction weights)
+	std::vector<double> logWeights(candidates.size());
+	for(size_t i = 0; i < candidates.size(); i++){
+		Weight childWeight = candidates[i]->cumulativeWeight();
+		// NOTE: the difference is taken in integers, so it is exact no matter how heavy the nodes are
+		double difference = childWeight <= ourWeight ? double(ourWeight - childWeight) : -double(childWeight - ourWeight);
+		logWeights[i] = -alpha * difference / WEIGHT_SCALE;
 	}
 
-	// Randomly choose a child from the weighted list
-	double random = util::rand2double(rng.GenerateWord32(), rng.GenerateWord32()) * totalWeight;
-	auto chosen = weightedList.begin();
-	for(double w = 0; w <= random && chosen != weightedList.end(); w += chosen->second)
-		if(w > 0) chosen++;
+	// Normalize with log-sum-exp, the probabilities stay accurate even when every exponential would underflow on its own
+	double normalizer = kernels::logSumExp(logWeights.data(), logWeights.size());
+
+	// Randomly choose a child according to the probabilities
+	double random = util::rand2double(rng.GenerateWord32(), rng.GenerateWord32());
+	size_t chosen = 0;
+	for(double cumulative = 0; chosen + 1 < candidates.size(); chosen++)
+		if((cumulative += std::exp(logWeights[chosen] - normalizer)) > random)
+			break;
 
 	// Recursively walk down the chosen child
-	return chosen->first->biasedRandomWalk(alpha);
+	return candidates[chosen]->biasedRandomWalk(alpha);
 }
 
 /**
  * @brief Function which determines how confident the network is in a transaction
+ * @note Walks start from random nodes near the transaction, and stop as soon as they decide the confidence is at least the <threshold> or below it (up to the <indifference> margin, see SequentialConfidence)
  *
- * @return float - Confidence between [0, 1]
+ * @param threshold - (Optional) Confidence the caller is comparing against, without one every walk is performed
+ * @param indifference - Width of the margin below the threshold where the confidence may be decided either way (narrower margins need more walks to decide)
+ * @param error - Probability the confidence interval doesn't contain the true confidence (and that the threshold is decided wrongly)
+ * @param maxWalks - Most random walks to perform
+ * @return ConfidenceEstimate - The fraction of walks which approved the transaction, the interval the confidence lies in, and (given a threshold) whether it was reached
  */
-float TransactionNode::confirmationConfidence() const {
+ConfidenceEstimate TransactionNode::measureConfidence(std::optional<float> threshold /*= {}*/, double indifference /*= CONFIDENCE_INDIFFERENCE*/, double error /*= CONFIDENCE_ERROR*/, size_t maxWalks /*= CONFIDENCE_MAX_WALKS*/) const {
 	// Generates a list of all parents going <levels> deep (if able)
-	auto generateWalkSet = [this](size_t levels = 5) -> std::list<TransactionNode::const_ptr>{
+	auto generateWalkSet = [this](size_t levels = 5) -> std::vector<TransactionNode::const_ptr>{
 		auto self = shared_from_this();
 
 		std::unordered_set<TransactionNode::const_ptr> set;
@@ -345,27 +388,77 @@ float TransactionNode::confirmationConfidence() const {
 		return { set.begin(), set.end() };
 	};
 
-	// Merges two lists together
-	auto merge = [](std::list<TransactionNode::const_ptr>& a, std::list<TransactionNode::const_ptr> b){ // The second is a copy so that we duplicate the state of the list
-		a.insert(a.begin(), b.begin(), b.end());
-	};
-
-	// Generate an at least 100 element long list of nodes to walk from
-	std::list<TransactionNode::const_ptr> walkList = generateWalkSet();
-	if(walkList.empty()) return 0; // If the walk list is empty, we have no confidence in the node
-	while(walkList.size() < 100)
-		merge(walkList, walkList);
+	ConfidenceEstimate out;
+	std::vector<TransactionNode::const_ptr> walkSet = generateWalkSet();
+	if(walkSet.empty()){ // If the walk set is empty, we have no confidence in the node
+		out.upper = 0;
+		out.reached = threshold && *threshold <= 0;
+		out.decided = true;
+		return out;
+	}
 
+	// Walk from random nodes in the set, counting the walks that result in a tip that aproves this node, until the walks decide or run out
+	CryptoPP::AutoSeededRandomPool rng;
+	SequentialConfidence walks(error, indifference);
+	auto decision = SequentialConfidence::Decision::Undecided;
+	while(walks.samples() < maxWalks){
+		if(threshold && (decision = walks.decide(*threshold)) != SequentialConfidence::Decision::Undecided)
+			break;
 
-	// Count the number of random walks from the set that result in a tip that aproves this node
-	uint8_t confidence = 0;
-	for(TransactionNode::const_ptr base: walkList){
-		if(auto tip = base->biasedRandomWalk(); tip && isChild(tip))
-			confidence++;
+		auto& base = walkSet[rng.GenerateWord32(0, walkSet.size() - 1)];
+		auto tip = base->biasedRandomWalk();
+		walks.add(tip && isChild(tip));
 	}
+	if(threshold && decision == SequentialConfidence::Decision::Undecided)
+		decision = walks.decide(*threshold);
+
+	out.estimate = walks.estimate();
+	out.lower = walks.lower();
+	out.upper = walks.upper();
+	out.walks = walks.samples();
+	out.decided = decision != SequentialConfidence::Decision::Undecided;
+	// If the walks ran out before deciding, fall back to comparing the estimate against the threshold
+	out.reached = threshold && (out.decided ? decision == SequentialConfidence::Decision::Above : out.estimate >= *threshold);
+
+	// Remember the estimate (only when every walk was performed, early stopped estimates are only accurate enough to compare against their threshold)
+	if(!threshold) util::mutable_cast(metrics)->confidence = out.estimate;
+	return out;
+}
+
+/**
+ * @brief Function which determines if this transaction approves of at most one side of every conflict
+ *
+ * @return True if no sequence number is spent twice in the transaction's ancestry, false otherwise
+ */
+bool TransactionNode::isConsistent() const {
+	TransactionNode::SpendSet set = *contested.read_lock();
+	if(!set) return true;
+
+	// The set is sorted, so spends of the same sequence number are adjacent
+	for(size_t i = 1; i < set->size(); i++)
+		if((*set)[i - 1].sameSequence((*set)[i]))
+			return false;
+	return true;
+}
 
-	// Convert the confidence to a fraction in the range [0, 1]
-	return confidence / float(walkList.size());
+/**
+ * @brief Function which determines if this transaction and <other> can both be approved by the same transaction (they don't approve of opposite sides of a conflict)
+ *
+ * @param other - The other transaction
+ * @return True if the transactions are compatible, false otherwise
+ */
+bool TransactionNode::isCompatible(const TransactionNode& other) const {
+	TransactionNode::SpendSet a = *contested.read_lock(), b = *other.contested.read_lock();
+	if(!a || !b || a == b) return true;
+
+	// Walk both (sorted) sets in lockstep, looking for the same sequence number spent by different transactions
+	for(auto i = a->begin(), j = b->begin(); i != a->end() && j != b->end(); ){
+		if(i->sameSequence(*j) && i->hash != j->hash)
+			return false;
+		if(*i < *j) i++;
+		else j++;
+	}
+	return true;
 }
 
 
@@ -382,13 +475,35 @@ void Tangle::setGenesis(TransactionNode::ptr genesis){
 	if(genesis) util::mutable_cast(genesis->isGenesis) = true;
 
 	// Free the memory for every child of the old genesis (if it exists)
+	// NOTE: nodes are only freed once no snapshot references them
 	if(this->genesis)
 		for(auto lock = this->genesis->children.read_lock(); !lock->empty(); )
 			for(auto [i, tipsLock] = std::make_pair(size_t(0), util::mutable_cast(tips).read_lock()); i < tipsLock->size(); i++)
-				removeTip(tipsLock[0]);
+				unlinkTip(tipsLock[0]);
+	// Unlinking the old genesis' last children marked it as a tip, it isn't part of the new graph
+	if(this->genesis)
+		std::erase(*util::mutable_cast(tips).write_lock(), this->genesis);
 
 	// Update the genesis
 	util::mutable_cast(this->genesis) = genesis;
+	// Publish a snapshot rooted at the new genesis
+	republish();
+
+	// The genesis' outputs mark the sequence numbers each account spent before the cut (those can never be spent again)
+	if(genesis){
+		auto sequencesLock = sequences.write_lock();
+		for(auto& [account, record]: *sequencesLock)
+			record.floor = 0;
+		for(const Transaction::Output& output: genesis->outputs){
+			auto& record = (*sequencesLock)[output.accountID()];
+			record.floor = output.sequence;
+			record.next = std::max(record.next, record.floor);
+		}
+
+		// Claims below the floor can never be checked again (spending them is rejected outright), so forget them
+		for(auto& [account, record]: *sequencesLock)
+			std::erase_if(record.claims, [floor = record.floor](const auto& claims) { return claims.first < floor; });
+	}
 
 	// If we are updating weights... start updating weights
 	if(updateWeights) std::thread([this](){
@@ -404,6 +519,13 @@ void Tangle::setGenesis(TransactionNode::ptr genesis){
  * @return Hash - Hash of the node once added
  */
 Hash Tangle::add(const TransactionNode::ptr node){
+	// Ensure that the transaction doesn't replay a sequence number (cheap, so done before the signatures are verified)
+	try {
+		checkSequences(node);
+	} catch (InvalidSequence&) {
+		rejectedAfterMining++;
+		throw;
+	}
 	// Ensure that the transaction passes verification
 	if(!node->validateTransaction())
 		throw std::runtime_error("Transaction with hash `" + node->hash + "` failed to pass validation, discarding.");
@@ -415,33 +537,14 @@ Hash Tangle::add(const TransactionNode::ptr node){
 		throw std::runtime_error("Transaction with hash `" + node->hash + "` wasn't mined, discarding.");
 
 	// Validate that the inputs to this transaction do not cause their owner's balance to go into the negatives
-	std::vector<std::pair<key::PublicKey, double>> balanceMap; // List acting as a bootleg map of keys to balances
-	for(const Transaction::Input& input: node->inputs){
-		auto inputAccount = input.account();
-		// The account's balance is invalid
-		double balance = -1;
-
-		// If the account's balance is cached... use the cached balance
-		int i = 0;
-		for(auto& [account, bal]: balanceMap){
-			i++;
-			if(account == inputAccount){
-				balance = bal;
-				break;
-			}
-		}
-		// Otherwise... query its balance
-		if(balance < 0) balance = queryBalance(inputAccount);
-
-		// Subtace the input from the balance and ensure it doesn't cause the transaction to go into the negatives
-		balance -= input.amount;
-		if(balance < 0)
-			throw InvalidBalance(node, inputAccount, balance);
-
-		// Cache the balance (adding to the list if not already present)
-		if(i == balanceMap.size())
-			balanceMap.emplace_back(inputAccount, balance);
-		else balanceMap[i].second = balance;
+	try {
+		checkBalances(node);
+	} catch (InvalidBalance&) {
+		rejectedAfterMining++;
+		throw;
+	} catch (Amount::Overflow&) {
+		rejectedAfterMining++;
+		throw std::runtime_error("Transaction with hash `" + node->hash + "` overflows an account's balance, discarding.");
 	}
 
 
@@ -461,6 +564,40 @@ Hash Tangle::add(const TransactionNode::ptr node){
 	{ // Begin Critical Region
 		std::scoped_lock lock(mutex);
 
+		// Mark the sequence numbers spent by the node as claimed (throws if a concurrent add already claimed them with the same signed content)
+		auto newlyContested = claimSequences(node);
+
+		// Determine which contested spends the node approves of (including the ones its claims just made contested), it can't approve of both sides of a conflict
+		// NOTE: this is checked before anything else in the graph is marked, so a rejected node only has its claims to undo
+		inheritContested(node, newlyContested);
+		if(!node->isConsistent()){
+			releaseSequences(node);
+			rejectedAfterMining++;
+			throw std::runtime_error("Transaction with hash `" + node->hash + "` approves of both sides of a double spend, discarding.");
+		}
+
+		// Update the balances of the accounts the node touches (checked again now that no other node can be added concurrently)
+		try {
+			checkBalances(node);
+			applyBalances(*balances.write_lock(), *node);
+		} catch (InvalidBalance&) {
+			releaseSequences(node);
+			rejectedAfterMining++;
+			throw;
+		} catch (Amount::Overflow&) {
+			releaseSequences(node);
+			rejectedAfterMining++;
+			throw std::runtime_error("Transaction with hash `" + node->hash + "` overflows an account's balance, discarding.");
+		}
+
+		// The node was accepted... any transaction it conflicts with (and everything approving it) now approves of a contested spend
+		for(auto& spend: newlyContested)
+			markContested(spend);
+
+		// Stamp the node with the epoch it is being added in (before it becomes reachable, so older snapshots can ignore it)
+		auto previous = head.load();
+		util::mutable_cast(node->epoch) = previous->epoch + 1;
+
 		// For each parent of the new node...
 		// NOTE: this happens in a second loop since we need to ensure all of the parents are valid before we add the node as a child of any of them
 		for(const TransactionNode::const_ptr& parent: node->parents){
@@ -474,9 +611,19 @@ Hash Tangle::add(const TransactionNode::ptr node){
 			tipsLock->push_back(node);
 		}
 
-		// Update the weights of all the nodes aproved by this node
+		// Publish a new snapshot containing the node (sharing the rest of the list with the previous snapshot)
+		auto snapshot = std::make_shared<Snapshot>();
+		snapshot->epoch = node->epoch;
+		snapshot->genesis = previous->genesis;
+		snapshot->log = std::make_shared<const Snapshot::Entry>(node, previous->log);
+		snapshot->size = previous->size + 1;
+		snapshot->tips = std::make_shared<const std::vector<TransactionNode::const_ptr>>(*tips.read_lock());
+		head.store(snapshot);
+
+		// Update the weights of all the nodes aproved by this node (then see if any watched transactions have been confirmed)
 		if(updateWeights) std::thread([this, node](){
 			updateCumulativeWeights(node);
+			checkConfirmations();
 		}).detach();
 
 		// Add the current tips as canidate to become a new genesis
@@ -484,6 +631,9 @@ Hash Tangle::add(const TransactionNode::ptr node){
 			genesisCandidates.push(*tipsLock);
 	} // End Critical Region
 
+	// Let subscribers know the node was committed
+	announce(node);
+
 	// Return the hash of the node
 	return node->hash;
 }
@@ -495,6 +645,17 @@ Hash Tangle::add(const TransactionNode::ptr node){
  * @param tip - The tip to remove
  */
 void Tangle::removeTip(TransactionNode::const_ptr tip){
+	std::scoped_lock lock(mutex);
+	unlinkTip(tip);
+	publishRemoval(tip);
+}
+
+/**
+ * @brief Function which removes a node from the graph (can only remove tips [nodes with no children]), without publishing a new snapshot
+ *
+ * @param tip - The tip to remove
+ */
+void Tangle::unlinkTip(TransactionNode::const_ptr tip){
 	// Make sure the pointer is valid
 	if(!tip) return;
 
@@ -522,6 +683,11 @@ void Tangle::removeTip(TransactionNode::const_ptr tip){
 		// Remove the node from the list of tips
 		std::erase(util::mutable_cast(tips.unsafe()), tip);
 
+		// Free up the sequence numbers the node claimed
+		releaseSequences(tip);
+		// Take the node's effects back out of the balances
+		applyBalances(*balances.write_lock(), *tip, /*undo*/ true);
+
 		// Clear the list of parents
 		util::mutable_cast(tip->parents).clear();
 	} // End Critical Region
@@ -531,79 +697,623 @@ void Tangle::removeTip(TransactionNode::const_ptr tip){
 }
  
 /**
- * @brief Function which queries the balance of a given key only using transactions with a certain level of confidence
- * 
- * @param account - The account to calculate the balance
- * @param confidenceThreshold - (Optional) Confidence threshold the node must be above to be considered in the calculation
- * @return double - The account's balance
+ * @brief Function which validates that the inputs of a node do not cause their owner's balance to go into the negatives
+ * @note Throws InvalidBalance if they do (or Amount::Overflow if an output overflows an account's balance)
+ * @note Checked against the table of balances in the latest snapshot, rather than walking the tangle
+ *
+ * @param node - The node to check
+ */
+void Tangle::checkBalances(const TransactionNode::const_ptr& node) const {
+	// Copy the balances the node touches
+	std::unordered_map<account::ID, Amount> touched;
+	{
+		auto lock = balances.read_lock();
+		for(auto* columns: {&node->inputColumns, &node->outputColumns})
+			for(account::ID account: columns->accounts)
+				if(auto balance = lock->find(account); balance != lock->end())
+					touched.emplace(account, balance->second);
+	}
+
+	// Subtract the inputs from their owner's balances and ensure they don't go into the negatives
+	for(size_t i = 0; i < node->inputColumns.accounts.size(); i++){
+		auto account = node->inputColumns.accounts[i];
+		Amount& balance = touched[account];
+		balance -= Amount::fromRaw(node->inputColumns.amounts[i]);
+		if(balance < 0)
+			throw InvalidBalance(node, account, balance);
+	}
+
+	// Add the outputs (throws Amount::Overflow if one overflows an account's balance)
+	for(size_t i = 0; i < node->outputColumns.accounts.size(); i++)
+		touched[node->outputColumns.accounts[i]] += Amount::fromRaw(node->outputColumns.amounts[i]);
+}
+
+/**
+ * @brief Function which ensures that none of a node's inputs replay a sequence number
+ * @note Throws InvalidSequence if they do
+ *
+ * @param node - The node to check
  */
-double Tangle::queryBalance(const key::PublicKey& account, float confidenceThreshold /*= 0*/) const {
-	std::list<std::string> considered;
-	// The queue starts with the genesis
-	std::queue<TransactionNode::ptr> q; q.push(genesis);
-	double balance = 0;
+void Tangle::checkSequences(const TransactionNode::const_ptr& node) const {
+	sequenceEntriesExamined += checkSequences(*sequences.read_lock(), node);
+}
+
+/**
+ * @brief Function which publishes a new snapshot, rebuilt from the current genesis
+ * @note Used when nodes are removed (which the persistent list can't represent), adding nodes extends the previous snapshot instead
+ */
+void Tangle::republish() {
+	std::scoped_lock lock(mutex);
+	auto previous = head.load();
+
+	auto snapshot = std::make_shared<Snapshot>();
+	snapshot->epoch = previous ? previous->epoch + 1 : 0;
+	snapshot->genesis = genesis;
+	snapshot->tips = std::make_shared<const std::vector<TransactionNode::const_ptr>>(*tips.read_lock());
+
+	// The balances are rebuilt along with the list
+	std::unordered_map<account::ID, Amount> rebuilt;
+	if(genesis){
+		// A new genesis becomes part of the snapshot at this epoch
+		if(!snapshot->contains(*genesis))
+			util::mutable_cast(genesis->epoch) = snapshot->epoch;
+
+		// Rebuild the list in topological order (a node is only added once all of its parents have been added)
+		std::unordered_map<const TransactionNode*, size_t> remainingParents;
+		std::queue<TransactionNode::const_ptr> q; q.push(genesis);
+		while(!q.empty()){
+			auto node = q.front();
+			q.pop();
+
+			// Refresh the node's height (its parents have already been refreshed, and the genesis may have changed underneath it)
+			uint32_t height = 0;
+			if(node != genesis)
+				for(auto& parent: node->parents)
+					height = std::max<uint32_t>(parent->height() + 1, height);
+			if(node->height() != height)
+				util::mutable_cast(node->metrics)->height = height;
+
+			snapshot->log = std::make_shared<const Snapshot::Entry>(node, snapshot->log);
+			snapshot->size++;
+			applyBalances(rebuilt, *node);
+
+			auto childLock = node->children.read_lock();
+			for(size_t i = 0; i < childLock->size(); i++)
+				if(auto [remaining, _] = remainingParents.try_emplace(childLock[i].get(), childLock[i]->parents.size()); --remaining->second == 0)
+					q.push(childLock[i]);
+		}
+	}
+
+	*balances.write_lock() = std::move(rebuilt);
+	head.store(snapshot);
+}
+
+/**
+ * @brief Function which publishes a new snapshot without a (just removed) node
+ * @note Only the part of the list newer than the node is copied (tips are usually among the newest nodes), the rest is still shared with the previous snapshot
+ *
+ * @param removed - The removed node
+ */
+void Tangle::publishRemoval(const TransactionNode::const_ptr& removed) {
+	std::scoped_lock lock(mutex);
+	auto previous = head.load();
+
+	// Find the node in the list, remembering the (newer) nodes in front of it
+	std::vector<TransactionNode::const_ptr> newer;
+	const Snapshot::Entry* entry = previous ? previous->log.get() : nullptr;
+	for(; entry && entry->node != removed; entry = entry->previous.get())
+		newer.push_back(entry->node);
+	// If the node was never published, rebuild the list instead
+	if(!entry) return republish();
+
+	auto snapshot = std::make_shared<Snapshot>();
+	snapshot->epoch = previous->epoch + 1;
+	snapshot->genesis = previous->genesis;
+	snapshot->tips = std::make_shared<const std::vector<TransactionNode::const_ptr>>(*tips.read_lock());
+	snapshot->size = previous->size - 1;
+
+	// Link the newer nodes (oldest first) onto the part of the list behind the node
+	snapshot->log = entry->previous;
+	for(auto node = newer.rbegin(); node != newer.rend(); node++)
+		snapshot->log = std::make_shared<const Snapshot::Entry>(*node, snapshot->log);
+
+	head.store(snapshot);
+}
+
+/**
+ * @brief Function which applies a node's inputs and outputs to a table of account balances
+ * @note Every updated balance is computed before any are changed, so an overflow (Amount::Overflow is thrown) leaves the table untouched
+ *
+ * @param table - The table of balances to update
+ * @param node - The node to apply
+ * @param undo - Whether to take the node's effects back out of the table instead (when it is removed)
+ */
+void Tangle::applyBalances(std::unordered_map<account::ID, Amount>& table, const TransactionNode& node, bool undo /*= false*/) {
+	std::vector<std::pair<account::ID, Amount>> updated;
+	auto balance = [&](account::ID account) -> Amount& {
+		for(auto& [id, amount]: updated)
+			if(id == account) return amount;
+		auto found = table.find(account);
+		return updated.emplace_back(account, found == table.end() ? Amount(0) : found->second).second;
+	};
+
+	for(size_t i = 0; i < node.inputColumns.accounts.size(); i++)
+		if(undo) balance(node.inputColumns.accounts[i]) += Amount::fromRaw(node.inputColumns.amounts[i]);
+		else balance(node.inputColumns.accounts[i]) -= Amount::fromRaw(node.inputColumns.amounts[i]);
+	for(size_t i = 0; i < node.outputColumns.accounts.size(); i++)
+		if(undo) balance(node.outputColumns.accounts[i]) -= Amount::fromRaw(node.outputColumns.amounts[i]);
+		else balance(node.outputColumns.accounts[i]) += Amount::fromRaw(node.outputColumns.amounts[i]);
+
+	for(auto& [account, amount]: updated)
+		table[account] = amount;
+}
+
+/**
+ * @brief Function which lists every node in the snapshot
+ *
+ * @return std::vector<TransactionNode::const_ptr> - The nodes, oldest first (parents always come before their children)
+ */
+std::vector<TransactionNode::const_ptr> Tangle::Snapshot::transactions() const {
+	std::vector<TransactionNode::const_ptr> out(size);
+	size_t i = size;
+	for(const Entry* entry = log.get(); entry && i > 0; entry = entry->previous.get())
+		out[--i] = entry->node;
+	return out;
+}
+
+/**
+ * @brief Function which finds a node in the snapshot given its hash
+ *
+ * @param hash - The hash to search for
+ * @return TransactionNode::const_ptr - The discovered node or nullptr if not found
+ */
+TransactionNode::const_ptr Tangle::Snapshot::find(const Hash& hash) const {
+	for(const Entry* entry = log.get(); entry; entry = entry->previous.get()){
+		if(entry->node->hash == hash) return entry->node;
+
+		// If the node is the genesis node, its parent hashes include a list of hashes it is aliasing
+		if(entry->node->isGenesis)
+			for(auto& h: entry->node->parentHashes)
+				if(h == hash)
+					return entry->node;
+	}
+	return nullptr;
+}
+
+/**
+ * @brief Function which determines the next sequence number of an account which hasn't been spent or reserved
+ *
+ * @param account - The account to check
+ * @return uint64_t - The next sequence number
+ */
+uint64_t Tangle::nextSequence(account::ID account) const {
+	auto lock = sequences.read_lock();
+	if(auto record = lock->find(account); record != lock->end())
+		return record->second.next;
+	return 0;
+}
+
+/**
+ * @brief Function which reserves the next sequence number of an account, so that transactions created concurrently don't spend the same one
+ * @note Reserved sequence numbers which are never spent simply leave a gap, which is allowed
+ *
+ * @param account - The account to reserve a sequence number for
+ * @return uint64_t - The reserved sequence number
+ */
+uint64_t Tangle::reserveSequence(account::ID account) {
+	auto lock = sequences.write_lock();
+	return (*lock)[account].next++;
+}
+
+/**
+ * @brief Function which determines if a node spends a sequence number that another transaction in the tangle also spends
+ * @note Conflicting transactions are both kept in the tangle, but tip selection avoids building on top of them
+ *
+ * @param node - The node to check
+ * @return True if one of the node's inputs conflicts, false otherwise
+ */
+bool Tangle::isConflicted(const TransactionNode::const_ptr& node) const {
+	auto lock = sequences.read_lock();
+	for(const Transaction::Input& input: node->inputs)
+		if(auto record = lock->find(input.accountID()); record != lock->end())
+			if(auto claims = record->second.claims.find(input.sequence); claims != record->second.claims.end() && claims->second.size() > 1)
+				return true;
+	return false;
+}
+
+/**
+ * @brief Function which ensures that none of a node's inputs replay a sequence number
+ *
+ * @param table - The table of account sequence numbers to check against
+ * @param node - The node to check
+ * @return size_t - The number of table entries (account records and claims) examined
+ */
+size_t Tangle::checkSequences(const std::unordered_map<account::ID, AccountSequences>& table, const TransactionNode::const_ptr& node) {
+	size_t examined = 0;
+	for(size_t i = 0; i < node->inputs.size(); i++){
+		const Transaction::Input& input = node->inputs[i];
+		auto inputAccount = node->inputColumns.accounts[i];
+
+		// The same sequence number can't be spent twice by the same transaction
+		for(size_t j = 0; j < i; j++)
+			if(node->inputColumns.accounts[j] == inputAccount && node->inputs[j].sequence == input.sequence)
+				throw InvalidSequence(node->hash, inputAccount, input.sequence, "more than once in the same transaction.");
+
+		auto record = table.find(inputAccount);
+		if(record == table.end()) continue;
+		examined++;
+
+		// Sequence numbers from before the genesis can't be spent
+		if(input.sequence < record->second.floor)
+			throw InvalidSequence(node->hash, inputAccount, input.sequence, "which was spent before the genesis.");
+
+		// The same signed content can't spend a sequence number twice
+		// NOTE: Compares a digest of what was signed rather than the signature bytes, since ECDSA signatures are malleable (a modified copy of a signature still verifies)
+		if(auto claims = record->second.claims.find(input.sequence); claims != record->second.claims.end()){
+			auto digest = util::hash(input.signingMessage(node->outputs));
+			for(auto& claim: claims->second){
+				examined++;
+				if(claim.digest == digest)
+					throw InvalidSequence(node->hash, inputAccount, input.sequence, "replaying transaction with hash `" + claim.hash + "`.");
+			}
+		}
+	}
+	return examined;
+}
+
+/**
+ * @brief Function which marks the sequence numbers spent by a node as claimed
+ * @note A sequence number claimed with different signed content is recorded as a conflict rather than rejected
+ *
+ * @param node - The node claiming sequence numbers
+ * @return std::vector<TransactionNode::Spend> - The spends of other transactions which this node's claims made contested
+ */
+std::vector<TransactionNode::Spend> Tangle::claimSequences(const TransactionNode::const_ptr& node) {
+	std::vector<TransactionNode::Spend> newlyContested;
+	auto lock = sequences.write_lock();
+	// Check again while holding the write lock, in case a replay was added concurrently
+	sequenceEntriesExamined += checkSequences(*lock, node);
+
+	for(size_t i = 0; i < node->inputs.size(); i++){
+		const Transaction::Input& input = node->inputs[i];
+		auto& record = (*lock)[node->inputColumns.accounts[i]];
+		auto& claims = record.claims[input.sequence];
+
+		// If this claim turns the sequence number into a conflict, the original claimant's spend becomes contested
+		if(claims.size() == 1)
+			newlyContested.push_back({node->inputColumns.accounts[i], input.sequence, claims.front().hash});
+
+		claims.push_back({node->hash, util::hash(input.signingMessage(node->outputs))});
+		record.next = std::max(record.next, input.sequence + 1);
+	}
+
+	return newlyContested;
+}
+
+/**
+ * @brief Function which frees up the sequence numbers claimed by a node (when it is removed from the tangle)
+ *
+ * @param node - The node releasing its sequence numbers
+ */
+void Tangle::releaseSequences(const TransactionNode::const_ptr& node) {
+	auto lock = sequences.write_lock();
+	for(size_t i = 0; i < node->inputs.size(); i++){
+		auto record = lock->find(node->inputColumns.accounts[i]);
+		if(record == lock->end()) continue;
+
+		auto claims = record->second.claims.find(node->inputs[i].sequence);
+		if(claims == record->second.claims.end()) continue;
+
+		std::erase_if(claims->second, [&node](const AccountSequences::Claim& claim) { return claim.hash == node->hash; });
+		if(claims->second.empty())
+			record->second.claims.erase(claims);
+	}
+}
+
+/**
+ * @brief Function which marks a spend as contested in the transaction which made it, and every transaction approving that transaction
+ *
+ * @param spend - The newly contested spend
+ */
+void Tangle::markContested(const TransactionNode::Spend& spend) {
+	std::unordered_set<std::string> considered;
+	std::queue<TransactionNode::ptr> q; q.push(find(spend.hash));
 
-	// While there are nodes left in the queue, pop the front...
 	while(!q.empty()){
-		TransactionNode::ptr head = q.front();
+		auto head = q.front();
 		q.pop();
 		if(!head) continue;
 
+		// Insert the spend into the node's (sorted) set, copying it since the set may be shared with other nodes
+		{
+			auto lock = head->contested.write_lock();
+			std::vector<TransactionNode::Spend> spends = *lock ? **lock : std::vector<TransactionNode::Spend>{};
+			if(auto position = std::lower_bound(spends.begin(), spends.end(), spend); position == spends.end() || *position != spend){
+				spends.insert(position, spend);
+				*lock = std::make_shared<const std::vector<TransactionNode::Spend>>(std::move(spends));
+			}
+		}
+
+		// Add this node's children unless we have already considered them
+		auto childLock = head->children.read_lock();
+		for(size_t i = 0; i < childLock->size(); i++)
+			if(considered.insert(childLock[i]->hash).second)
+				q.push(childLock[i]);
+	}
+}
+
+/**
+ * @brief Function which determines if <node> approves of <ancestor>, either directly or through its ancestors
+ * @note Only nodes added after the ancestor (with a later epoch) can approve of it, so the search never goes further back than it
+ *
+ * @param node - The node to search back from
+ * @param ancestor - The node which may be approved
+ * @return True if the node approves of the ancestor, false otherwise
+ */
+bool Tangle::approves(const TransactionNode::const_ptr& node, const TransactionNode::const_ptr& ancestor) {
+	if(!ancestor) return false;
+	std::unordered_set<std::string> considered;
+	std::queue<TransactionNode::const_ptr> q; q.push(node);
+
+	while(!q.empty()){
+		auto head = q.front();
+		q.pop();
+
+		for(auto& parent: head->parents){
+			if(parent == ancestor) return true;
+			// Parents older than the ancestor can't approve of it
+			if(parent->epoch > ancestor->epoch && considered.insert(parent->hash).second)
+				q.push(parent);
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Function which determines the contested spends a node approves of, from the sets of its parents and its own contested spends
+ * @note When the node adds nothing new the parent's set is shared rather than copied
+ *
+ * @param node - The node to determine the contested spends of
+ * @param newlyContested - Spends which the node's claims just made contested (not yet marked in the graph), included if the node approves of the transaction which made them
+ */
+void Tangle::inheritContested(const TransactionNode::ptr& node, const std::vector<TransactionNode::Spend>& newlyContested) {
+	// Gather the (unique) sets of the parents
+	std::vector<TransactionNode::SpendSet> sets;
+	for(auto& parent: node->parents)
+		if(TransactionNode::SpendSet set = *parent->contested.read_lock(); set && std::find(sets.begin(), sets.end(), set) == sets.end())
+			sets.push_back(set);
+
+	// Gather the node's own spends which are contested
+	std::vector<TransactionNode::Spend> spends;
+	for(auto& spend: newlyContested)
+		if(approves(node, find(spend.hash)))
+			spends.push_back(spend);
+	{
+		auto lock = sequences.read_lock();
+		for(size_t i = 0; i < node->inputs.size(); i++)
+			if(auto record = lock->find(node->inputColumns.accounts[i]); record != lock->end())
+				if(auto claims = record->second.claims.find(node->inputs[i].sequence); claims != record->second.claims.end() && claims->second.size() > 1)
+					spends.push_back({node->inputColumns.accounts[i], node->inputs[i].sequence, node->hash});
+	}
+
+	// If the node only inherits a single set, share it
+	if(spends.empty() && sets.size() <= 1){
+		*node->contested.write_lock() = sets.empty() ? nullptr : sets.front();
+		return;
+	}
+
+	// Otherwise merge everything into a new set
+	for(auto& set: sets)
+		spends.insert(spends.end(), set->begin(), set->end());
+	std::sort(spends.begin(), spends.end());
+	spends.erase(std::unique(spends.begin(), spends.end()), spends.end());
+	*node->contested.write_lock() = std::make_shared<const std::vector<TransactionNode::Spend>>(std::move(spends));
+}
+
+/**
+ * @brief Function which queries the balance of a given key in the latest snapshot, only using transactions with a certain level of confidence
+ * @note Balances at no confidence are read from the table kept up to date as nodes are added and removed, rather than walking the tangle
+ *
+ * @param account - The account to calculate the balance
+ * @param confidenceThreshold - (Optional) Confidence threshold the node must be above to be considered in the calculation
+ * @return Amount - The account's balance
+ */
+Amount Tangle::queryBalance(account::ID account, float confidenceThreshold /*= 0*/) const {
+	if(confidenceThreshold >= std::numeric_limits<float>::epsilon())
+		return queryBalance(*snapshot(), account, confidenceThreshold);
+
+	auto lock = balances.read_lock();
+	auto balance = lock->find(account);
+	return balance == lock->end() ? Amount(0) : balance->second;
+}
+
+/**
+ * @brief Function which queries the balance of a given key only using transactions with a certain level of confidence
+ * 
+ * @param snapshot - The snapshot of the tangle to calculate the balance in
+ * @param account - The account to calculate the balance
+ * @param confidenceThreshold - (Optional) Confidence threshold the node must be above to be considered in the calculation
+ * @return Amount - The account's balance
+ */
+Amount Tangle::queryBalance(const Snapshot& snapshot, account::ID account, float confidenceThreshold /*= 0*/) const {
+	// Only check the transaction's confidence if the threshold is greater than 0
+	bool checkConfidence = confidenceThreshold >= std::numeric_limits<float>::epsilon();
+	// Nodes which contributed to the balance (only needed if nodes can be excluded for lack of confidence)
+	std::unordered_set<const TransactionNode*> counted;
+	Amount balance = 0;
+
+	// Walk through the snapshot, oldest first (so that parents are always considered before their children)...
+	for(const TransactionNode::const_ptr& node: snapshot.transactions()){
+		// A node only counts if it has sufficient confidence and is approved by a node which counts
+		if(checkConfidence && !node->isGenesis){
+			if(std::none_of(node->parents.begin(), node->parents.end(), [&counted](const TransactionNode::const_ptr& parent) { return counted.contains(parent.get()); }))
+				continue;
+			if(!node->isConfident(confidenceThreshold))
+				continue;
+		}
+		if(checkConfidence) counted.insert(node.get());
+
 		// Add up how this transaction takes away from the balance of interest
-		for(const Transaction::Input& input: head->inputs)
-			if(input.account() == account)
-				balance -= input.amount;
+		balance -= node->inputColumns.total(account);
 		// If the balance becomes negative except
 		if(balance < 0)
-			throw InvalidBalance(head, account, balance);
+			throw InvalidBalance(node, account, balance);
 
 		// Add up how this transaction adds to the balance of interest
-		for(const Transaction::Output& output: head->outputs)
-			if(output.account() == account)
-				balance += output.amount;
+		balance += node->outputColumns.total(account);
 		// If the balance becomes negative except
 		if(balance < 0)
-			throw InvalidBalance(head, account, balance);
-
-		// Add the children to the queue (if they have sufficient confidence and/or haven't already been considered)
-		{
-			auto childLock = head->children.read_lock();
-			for(int i = 0; i < childLock->size(); i++)
-				if(std::find(considered.begin(), considered.end(), childLock[i]->hash) == considered.end()){
-					if(confidenceThreshold < std::numeric_limits<float>::epsilon() // Only check the transaction's confidence if the threshold is greater than 0
-					  || childLock[i]->confirmationConfidence() >= confidenceThreshold)
-						q.push(childLock[i]);
-					considered.push_back(childLock[i]->hash);
-				}
-		}
+			throw InvalidBalance(node, account, balance);
 	}
 
 	return balance;
 }
 
 /**
- * @brief Function which updates the weights of nodes working backwards from a <source> node
- * 
- * @param source The node to work backwards from
+ * @brief Function which lists the accounts a transaction touches (what subscribers filter events by)
+ *
+ * @param node - The transaction
+ * @return std::vector<std::string> - The base 64 representations of the accounts of the transaction's inputs and outputs (without duplicates)
  */
-void Tangle::updateCumulativeWeights(TransactionNode::const_ptr source){
-	// Add the source node to the queue
-	std::queue<TransactionNode::const_ptr> q; q.push(source);
+std::vector<std::string> Tangle::touchedAccounts(const TransactionNode& node) {
+	std::vector<std::string> accounts;
+	for(auto& input: node.inputs)
+		accounts.push_back(input.accountBase64());
+	for(auto& output: node.outputs)
+		accounts.push_back(output.accountBase64());
+	util::removeDuplicates(accounts);
+	return accounts;
+}
+
+/**
+ * @brief Function which publishes the event for a newly committed transaction, and starts tracking its confidence if a subscriber wants to hear when it is confirmed
+ * @note Nothing is built if nobody is subscribed
+ *
+ * @param node - The newly added transaction
+ */
+void Tangle::announce(const TransactionNode::const_ptr& node) {
+	if(events.size() == 0) return;
+
+	auto accounts = touchedAccounts(*node);
+	if(events.wants(events::Type::Committed, &accounts))
+		events.publish({0, events::Type::Committed, node->hash, accounts});
+
+	if(events.wants(events::Type::Confirmed, &accounts)){
+		auto lock = watches.write_lock();
+		if(lock->size() >= EVENT_WATCH_LIMIT) lock->pop_front();
+		lock->push_back({node, node->hash, std::move(accounts)});
+	}
+}
+
+/**
+ * @brief Function which publishes the events for the transactions which were in a snapshot but no longer are (they were collapsed into a new genesis)
+ *
+ * @param before - Snapshot taken before the transactions were removed
+ */
+void Tangle::announcePruned(const Snapshot& before) {
+	if(!events.wants(events::Type::Pruned)) return;
+
+	std::unordered_set<const TransactionNode*> remaining;
+	for(auto& node: snapshot()->transactions())
+		remaining.insert(node.get());
+	for(auto& node: before.transactions())
+		if(!node->isGenesis && !remaining.contains(node.get()))
+			events.publish({0, events::Type::Pruned, node->hash, touchedAccounts(*node)});
+}
 
-	// While the queue is not empty, pop the head off...
+/**
+ * @brief Function which measures the confidence of the tracked transactions, and publishes an event for each subscriber threshold they have newly crossed
+ * @note Measuring confidence takes many random walks, so checks are rate limited to one every EVENT_CONFIRMATION_INTERVAL milliseconds (callers which arrive early or while a check is running return immediately)
+ */
+void Tangle::checkConfirmations() {
+	std::unique_lock lock(confirmationMutex, std::try_to_lock);
+	if(!lock.owns_lock()) return;
+	auto now = std::chrono::steady_clock::now();
+	if(now - lastConfirmationCheck < std::chrono::milliseconds(EVENT_CONFIRMATION_INTERVAL)) return;
+	lastConfirmationCheck = now;
+
+	if(onConfirmationCheck) onConfirmationCheck();
+
+	// Copy the watches, so that transactions can still be added while confidences are measured
+	auto watching = *watches.read_lock();
+	if(watching.empty()) return;
+	auto thresholds = events.thresholds();
+
+	// Measure the confidence of each transaction which still exists (and isn't past every threshold)
+	std::unordered_map<std::string, float> reached;
+	for(auto& watch: watching){
+		auto node = watch.node.lock();
+		if(!node || thresholds.empty() || watch.reached >= thresholds.back()) continue;
+
+		float confidence = node->confirmationConfidence();
+		for(float threshold: thresholds)
+			if(threshold > watch.reached && threshold <= confidence)
+				events.publish({0, events::Type::Confirmed, watch.hash, watch.accounts, threshold, confidence});
+		reached[watch.hash] = std::max(watch.reached, confidence);
+	}
+
+	// Record the progress, and stop tracking transactions which have been pruned or have crossed every threshold
+	auto watchLock = watches.write_lock();
+	for(auto& watch: *watchLock)
+		if(auto progress = reached.find(watch.hash); progress != reached.end())
+			watch.reached = progress->second;
+	std::erase_if(*watchLock, [&](const ConfirmationWatch& watch) {
+		return watch.node.expired() || thresholds.empty() || watch.reached >= thresholds.back();
+	});
+}
+
+/**
+ * @brief Function which updates the weights of nodes working backwards from a set of <sources>
+ * @note The new weights are calculated from a consistent view of the current weights and then published together, walks running concurrently see either the old or the new weight of each node (never a partially updated one)
+ *
+ * @param sources - The nodes to work backwards from
+ */
+void Tangle::updateCumulativeWeights(const std::vector<TransactionNode::const_ptr>& sources){
+	std::scoped_lock lock(weightMutex);
+
+	// Gather the sources and all of their ancestors (each only once, stopping at the genesis)
+	std::vector<TransactionNode::const_ptr> batch;
+	std::unordered_set<const TransactionNode*> considered;
+	std::queue<TransactionNode::const_ptr> q;
+	for(auto& source: sources)
+		q.push(source);
 	while(!q.empty()){
 		auto head = q.front();
 		q.pop();
-		if(!head) continue;
+		if(!head || !considered.insert(head.get()).second) continue;
 
-		// Update the weight of this node based on the weights of the children
-		float cumulativeWeight = head->ownWeight();
-		for(size_t i = 0, size = head->children.read_lock()->size(); i < size; i++)
-			cumulativeWeight += head->children.read_lock()[i]->cumulativeWeight;
-		util::mutable_cast(head->cumulativeWeight) = cumulativeWeight;
+		batch.push_back(head);
+		if(!head->isGenesis)
+			for(auto& parent: head->parents)
+				q.push(parent);
+	}
 
-		// Add this node's parents to the back of the queue
-		for(auto& parent: head->parents)
-			q.push(parent);
+	// Children are always higher than their parents, so working from the highest node down every node's children are calculated before it is
+	std::sort(batch.begin(), batch.end(), [](const TransactionNode::const_ptr& a, const TransactionNode::const_ptr& b) { return a->height() > b->height(); });
+
+	// The new weights of the nodes in the batch, and the current weights of the children outside of it
+	std::unordered_map<const TransactionNode*, Weight> staged;
+	// Buffer of pointers to the node's own weight and the weights of its children (reused between nodes)
+	std::vector<const Weight*> childWeights;
+	for(auto& head: batch){
+		// Gather pointers to the weights (so they can be summed by the vectorized kernel)
+		Weight own = head->ownWeight();
+		childWeights.assign(1, &own);
+		{
+			auto childLock = head->children.read_lock();
+			for(size_t i = 0; i < childLock->size(); i++){
+				auto [weight, inserted] = staged.try_emplace(childLock[i].get(), 0);
+				if(inserted) weight->second = childLock[i]->cumulativeWeight();
+				childWeights.push_back(&weight->second);
+			}
+		}
+
+		// Calculate the weight of this node based on the weights of the children
+		staged[head.get()] = kernels::gatherSum(childWeights.data(), childWeights.size());
 	}
+
+	// Publish the new weights
+	for(auto& head: batch)
+		if(Weight weight = staged[head.get()]; weight != head->cumulativeWeight())
+			util::mutable_cast(head->metrics)->cumulativeWeight = weight;
 }
@@ -11,11 +11,20 @@
 #ifndef TANGLE_HPP
 #define TANGLE_HPP
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <unordered_map>
 
 #include "monitor.hpp"
+#include "confidence.hpp"
+#include "events.hpp"
 #include "circular_buffer.hpp"
 
+#include "kernels.hpp"
 #include "transaction.hpp"
 
 // The number of tips there can be at most in a given instant of time to qualify to be converted into a genesis
@@ -23,6 +32,37 @@
 // How many levels behind the current tips a transaction needs to be before it is considered left behind
 #define LEFT_BEHIND_TIP_THRESHOLD 5
 
+// How many weight units make up the weight of a single fully weighted transaction (weights are exact integers in these units)
+#define WEIGHT_SCALE 1000
+// Difficulty after which mining harder no longer increases a transaction's weight
+#define WEIGHT_DIFFICULTY_CAP 5
+
+// Weights (and cumulative weights) are stored in scaled units, so sums are exact however deep the tangle gets
+using Weight = uint64_t;
+
+/**
+ * @brief Functions which determine the weight a transaction contributes in isolation
+ */
+namespace weight_policy {
+	// Every transaction weighs the same
+	struct Constant {
+		static Weight weight(const Transaction&) { return WEIGHT_SCALE; }
+	};
+	// Weight grows linearly with the mining difficulty, capped at a full weight (the tangle's original weighting)
+	struct Difficulty {
+		static Weight weight(const Transaction& t) { return Weight(std::min<uint8_t>(t.miningDifficulty, WEIGHT_DIFFICULTY_CAP)) * (WEIGHT_SCALE / WEIGHT_DIFFICULTY_CAP); }
+	};
+	// Weight is proportional to the expected number of hashes needed to mine the transaction (each character of difficulty is one in 64 hashes)
+	struct Work {
+		static Weight weight(const Transaction& t) { return Weight(WEIGHT_SCALE) << (6 * std::min<uint8_t>(t.miningDifficulty, WEIGHT_DIFFICULTY_CAP)); }
+	};
+}
+
+// The weight function the tangle uses (can be overridden at build time, e.g. -DTANGLE_WEIGHT_POLICY=weight_policy::Work)
+#ifndef TANGLE_WEIGHT_POLICY
+#define TANGLE_WEIGHT_POLICY weight_policy::Difficulty
+#endif
+
 // Tangle forward declaration
 struct Tangle;
 
@@ -32,14 +72,73 @@ struct TransactionNode : public Transaction, public std::enable_shared_from_this
 	using ptr = std::shared_ptr<TransactionNode>;
 	using const_ptr = std::shared_ptr<const TransactionNode>;
 
-	// Variable tracking the cumulative weight of this node
-	const float cumulativeWeight = 0;
+	/**
+	 * @brief Contiguous (structure of arrays) copy of the accounts and amounts of a list of inputs or outputs, used by the vectorized kernels
+	 */
+	struct AccountColumns {
+		std::vector<account::ID> accounts;
+		std::vector<Amount::Raw> amounts;
+
+		AccountColumns() = default;
+		template<typename OutputType>
+		AccountColumns(const std::vector<OutputType>& outputs) {
+			accounts.reserve(outputs.size());
+			amounts.reserve(outputs.size());
+			for(const OutputType& output: outputs){
+				accounts.push_back(output.accountID());
+				amounts.push_back(output.amount.raw);
+			}
+		}
+
+		// Function which sums the amounts belonging to the given <account>
+		inline Amount total(account::ID account) const { return kernels::sumMatching(accounts.data(), amounts.data(), accounts.size(), account); }
+		// Function which checks if the given <account> is referenced
+		inline bool references(account::ID account) const { return kernels::contains(accounts.data(), accounts.size(), account); }
+	};
+
+	/**
+	 * @brief A spend of one of an account's sequence numbers by a specific transaction
+	 */
+	struct Spend {
+		account::ID account;
+		uint64_t sequence;
+		// Hash of the spending transaction
+		std::string hash;
+
+		auto operator<=>(const Spend&) const = default;
+		// Function which checks if two spends are of the same sequence number (of the same account)
+		inline bool sameSequence(const Spend& other) const { return account == other.account && sequence == other.sequence; }
+	};
+	// Sorted list of spends, shared (immutably) between nodes whenever possible
+	using SpendSet = std::shared_ptr<const std::vector<Spend>>;
+
+	/**
+	 * @brief Metrics derived from the node's position in the graph, published as a block so readers never see a torn (or half updated) set of values
+	 */
+	struct Metrics {
+		// The cumulative weight of this node (its own weight plus the weights of the nodes approving it)
+		Weight cumulativeWeight = 0;
+		// The height (longest path to genesis) of the node
+		uint32_t height = 0;
+		// The confirmation confidence of this node when it was last measured (negative if it has never been measured)
+		float confidence = -1;
+	};
+
+	// The node's metrics, readers take a consistent copy without blocking the weight updates
+	monitor<Metrics, monitor_policy::SeqLock> metrics;
+	// The epoch (commit point) at which this node was added to the tangle, nodes which haven't been added yet are in no snapshot
+	const uint64_t epoch = std::numeric_limits<uint64_t>::max();
 	// Variable tracking weather or not this transaction is the genesis transaction
 	const bool isGenesis = false; // TODO: should this go in the base transaction or here?
 	// Immutable list of parents of the node
 	const std::vector<TransactionNode::const_ptr> parents;
-	// List of children of the node, thread safe access
-	monitor<std::vector<TransactionNode::ptr>> children;
+	// List of children of the node, thread safe access (critical sections are short and writes rare, so readers spin instead of sleeping)
+	monitor<std::vector<TransactionNode::ptr>, monitor_policy::Spin> children;
+	// Columns of the accounts and amounts of the inputs and outputs of the node
+	const AccountColumns inputColumns, outputColumns;
+	// The contested spends (sequence numbers spent by more than one transaction) this node approves of, either directly or through its ancestors
+	// NOTE: maintained incrementally by the tangle when the node is added or a new conflict is discovered, nullptr when there are none
+	monitor<SpendSet> contested;
 
 	TransactionNode(const std::vector<TransactionNode::const_ptr> parents, const std::vector<Input>& inputs, const std::vector<Output>& outputs, uint8_t difficulty = 3);
 
@@ -73,7 +172,7 @@ struct TransactionNode : public Transaction, public std::enable_shared_from_this
 	 */
 	inline bool isChild(TransactionNode::const_ptr& target) const { return util::mutable_cast(this)->find(target->hash) != nullptr; }
 
-	void recursiveDebugDump(std::list<std::string>& considered, size_t depth = 0) const;
+	void recursiveDebugDump(std::list<std::string>& considered, size_t depth = 0, uint64_t epoch = std::numeric_limits<uint64_t>::max()) const;
 	void recursivelyListTransactions(std::list<TransactionNode*>& transactions);
 
 
@@ -81,17 +180,30 @@ struct TransactionNode : public Transaction, public std::enable_shared_from_this
 
 
 	/**
-	 * @brief Function which calculates the weight of this transcation, based on its mining difficulty (capped at 1 when difficulty is 5)
+	 * @brief Function which calculates the weight of this transcation
 	 * 
-	 * @return float - The weight of this transaction in isolation
+	 * @tparam Policy - The weight function to use (see weight_policy)
+	 * @return Weight - The weight of this transaction in isolation (in scaled units)
 	 */
-	inline float ownWeight() const { return std::min(miningDifficulty / 5.f, 1.f); }
-
-	size_t height() const;
+	template<typename Policy = TANGLE_WEIGHT_POLICY>
+	inline Weight ownWeight() const { return Policy::weight(*this); }
+	// Function which gets the (last published) cumulative weight of this transaction (in scaled units)
+	inline Weight cumulativeWeight() const { return metrics.load().cumulativeWeight; }
+	// Function which gets the height (longest path to genesis) of the transaction
+	inline size_t height() const { return metrics.load().height; }
 	size_t depth() const;
 
 	TransactionNode::const_ptr biasedRandomWalk(double alpha = 10) const;
-	float confirmationConfidence() const;
+	ConfidenceEstimate measureConfidence(std::optional<float> threshold = {}, double indifference = CONFIDENCE_INDIFFERENCE, double error = CONFIDENCE_ERROR, size_t maxWalks = CONFIDENCE_MAX_WALKS) const;
+	// Function which determines how confident the network is in a transaction (using every walk)
+	inline float confirmationConfidence() const { return measureConfidence().estimate; }
+	// Function which determines if the network's confidence in a transaction is at least <threshold> (stopping once the walks decide)
+	// NOTE: a confidence within <indifference> below the threshold may be reported either way (ex. 0.95 may count as reaching 1 with the default margin),
+	// 	callers who can't tolerate that pass CONFIDENCE_STRICT_INDIFFERENCE
+	inline bool isConfident(float threshold, double indifference = CONFIDENCE_INDIFFERENCE) const { return measureConfidence(threshold, indifference).reached; }
+
+	bool isConsistent() const;
+	bool isCompatible(const TransactionNode& other) const;
 };
 
 /**
@@ -109,8 +221,87 @@ struct Tangle {
 		// Node which caused the invalid balance
 		TransactionNode::const_ptr node;
 		// Account with the invalid balance
-		const key::PublicKey& account;
-		InvalidBalance(TransactionNode::const_ptr node, const key::PublicKey& account, double balance) : std::runtime_error("Node with hash `" + node->hash + "` results in a balance of `" + std::to_string(balance) + "` for an account."), node(node), account(account) {}
+		const account::ID account;
+		InvalidBalance(TransactionNode::const_ptr node, account::ID account, Amount balance) : std::runtime_error("Node with hash `" + node->hash + "` results in a balance of `" + balance.toString() + "` for an account."), node(node), account(account) {}
+	};
+	/**
+	 * @brief Exception thrown when an input reuses a sequence number it isn't allowed to (replayed signed content, or a sequence number from before the genesis)
+	 */
+	struct InvalidSequence : public std::runtime_error {
+		// Account with the invalid sequence number
+		const account::ID account;
+		// The invalid sequence number
+		const uint64_t sequence;
+		InvalidSequence(const Hash& hash, account::ID account, uint64_t sequence, const std::string& reason) : std::runtime_error("Transaction with hash `" + hash + "` tried to spend sequence number `" + std::to_string(sequence) + "` of an account, " + reason), account(account), sequence(sequence) {}
+	};
+
+	/**
+	 * @brief The sequence number state of a single account
+	 */
+	struct AccountSequences {
+		/**
+		 * @brief A transaction which spent a sequence number
+		 */
+		struct Claim {
+			// Hash of the spending transaction
+			std::string hash;
+			// Digest of the signed content of the input which spent the sequence number (identical content is a replay, whatever the signature bytes are)
+			std::string digest;
+		};
+
+		// Sequence numbers below this were spent before the genesis and can never be spent again
+		uint64_t floor = 0;
+		// The next sequence number which hasn't been claimed or reserved
+		uint64_t next = 0;
+		// Map of spent sequence numbers to the transactions spending them (more than one claim is a conflict)
+		std::unordered_map<uint64_t, std::vector<Claim>> claims;
+	};
+
+	/**
+	 * @brief Immutable view of the tangle at a fixed commit point (epoch)
+	 * @note Snapshots share structure: each one is a list of the nodes added to the tangle (newest first) which links into the previous snapshot's list
+	 * @note Holding a snapshot pins its nodes in memory, but never holds up modifications to the tangle
+	 */
+	struct Snapshot {
+		using ptr = std::shared_ptr<const Snapshot>;
+
+		/**
+		 * @brief Link in the (persistent) list of nodes
+		 */
+		struct Entry {
+			TransactionNode::const_ptr node;
+			std::shared_ptr<const Entry> previous;
+
+			Entry(TransactionNode::const_ptr node, std::shared_ptr<const Entry> previous) : node(node), previous(previous) {}
+			// Unlink the list iteratively, recursively destroying a long list would overflow the stack
+			~Entry() {
+				std::shared_ptr<const Entry> next = std::move(previous);
+				while(next && next.use_count() == 1)
+					next = std::move(util::mutable_cast(next->previous));
+			}
+		};
+
+		// The commit point of this snapshot (only nodes whose epoch is at most this are part of the snapshot)
+		uint64_t epoch = 0;
+		// The genesis at the time of the snapshot
+		TransactionNode::const_ptr genesis;
+		// List of every node in the snapshot, newest first (the genesis is always last)
+		std::shared_ptr<const Entry> log;
+		// The number of nodes in the snapshot
+		size_t size = 0;
+		// The tips at the time of the snapshot
+		std::shared_ptr<const std::vector<TransactionNode::const_ptr>> tips;
+
+		/**
+		 * @brief Function which determines if a node is part of this snapshot
+		 *
+		 * @param node - The node to check
+		 * @return True if the node was added at or before the snapshot's commit point, false otherwise
+		 */
+		inline bool contains(const TransactionNode& node) const { return node.epoch <= epoch; }
+
+		std::vector<TransactionNode::const_ptr> transactions() const;
+		TransactionNode::const_ptr find(const Hash& hash) const;
 	};
 
 	// Pointer to the Genesis block
@@ -121,13 +312,53 @@ struct Tangle {
 protected:
 	// Mutex used to synchronize modifications across threads
 	std::recursive_mutex mutex;
+	// The latest snapshot of the tangle
+	std::atomic<Snapshot::ptr> head;
 
 	// Flag which determines if a transaction add should recalculate weights or not
 	bool updateWeights = true;
+	// Mutex serializing weight updates (so an update computed from older weights can't overwrite a newer one)
+	std::mutex weightMutex;
 
 	// Circular buffer queue of size 10 of candidates to be converted into the genesis
 	ModifiableQueue<std::vector<TransactionNode::const_ptr>, secure_circular_buffer_array<std::vector<TransactionNode::const_ptr>, 10>> genesisCandidates;
 
+	// Table of the sequence number state of every account, with thread safe access
+	monitor<std::unordered_map<account::ID, AccountSequences>> sequences;
+	// The balance (at no confidence) of every account in the latest snapshot, kept up to date as nodes are added and removed (so checking a new node's spends doesn't walk the tangle)
+	monitor<std::unordered_map<account::ID, Amount>> balances;
+
+	/**
+	 * @brief A transaction whose confidence is being tracked (because a subscriber wants to hear when it is confirmed)
+	 */
+	struct ConfirmationWatch {
+		std::weak_ptr<const TransactionNode> node;
+		std::string hash;
+		std::vector<std::string> accounts;
+		// The highest confidence confirmed events have been published for
+		float reached = 0;
+	};
+	// The transactions whose confidence is being tracked (oldest first)
+	monitor<std::deque<ConfirmationWatch>> watches;
+	// Mutex ensuring only one confirmation check runs at a time, and when the last one ran
+	std::mutex confirmationMutex;
+	std::chrono::steady_clock::time_point lastConfirmationCheck;
+	// Function called by every confirmation check (before the watched transactions are measured), so extensions of the tangle can act on newly confirmed transactions
+	std::function<void()> onConfirmationCheck;
+	// Number of sequence table entries (account records and the claims compared against) every sequence check so far has examined
+	mutable std::atomic<size_t> sequenceEntriesExamined = 0;
+	// Function which gets the number of sequence table entries examined so far (the benchmarks check a single check examines as many no matter how large the tangle is)
+	size_t sequenceEntries() const { return sequenceEntriesExamined; }
+
+public:
+	// Stream of events about transactions being committed, confirmed, and pruned (see events.hpp)
+	events::Hub events;
+
+	// Number of locally created transactions which were discarded before mining (because they would have been rejected)
+	mutable std::atomic<size_t> discardedBeforeMining = 0;
+	// Number of mined transactions which were rejected because of their spends or the spends they approve of (wasted mining effort)
+	std::atomic<size_t> rejectedAfterMining = 0;
+
 public:
 
 	// Upon creation generate a genesis block
@@ -136,7 +367,7 @@ public:
 		std::vector<Transaction::Input> inputs;
 		std::vector<Transaction::Output> outputs;
 		return std::make_shared<TransactionNode>(parents, inputs, outputs);
-	}()) {}
+	}()) { republish(); }
 
 	// Clean up the graph, in memory, on exit
 	~Tangle() { setGenesis(nullptr); }
@@ -168,41 +399,87 @@ public:
 	 */
 	inline TransactionNode::const_ptr biasedRandomWalk(double alpha = 10) const { return genesis->biasedRandomWalk(alpha); }
 
+	/**
+	 * @brief Function which gets the latest snapshot of the tangle
+	 * @note Snapshots are immutable, readers can take as long as they like with them without holding up modifications to the tangle
+	 *
+	 * @return Snapshot::ptr - The latest snapshot
+	 */
+	inline Snapshot::ptr snapshot() const { return head.load(); }
+
 	Hash add(const TransactionNode::ptr node);
 	void removeTip(TransactionNode::const_ptr node);
 
-	double queryBalance(const key::PublicKey& account, float confidenceThreshold = 0) const;
-	inline double queryBalance(const key::KeyPair& pair, float confidenceThreshold = 0) const { return queryBalance(pair.pub, confidenceThreshold); }
+	uint64_t nextSequence(account::ID account) const;
+	uint64_t reserveSequence(account::ID account);
+	/**
+	 * @brief Function which reserves the next sequence number of an account, so that transactions created concurrently don't spend the same one
+	 *
+	 * @param pair - The account to reserve a sequence number for
+	 * @return uint64_t - The reserved sequence number
+	 */
+	inline uint64_t reserveSequence(const key::KeyPair& pair) { return reserveSequence(account::intern(pair.pub)); }
+	bool isConflicted(const TransactionNode::const_ptr& node) const;
+	void checkSequences(const TransactionNode::const_ptr& node) const;
+	void checkBalances(const TransactionNode::const_ptr& node) const;
+
+	Amount queryBalance(const Snapshot& snapshot, account::ID account, float confidenceThreshold = 0) const;
+	Amount queryBalance(account::ID account, float confidenceThreshold = 0) const;
+	inline Amount queryBalance(const key::PublicKey& account, float confidenceThreshold = 0) const { return queryBalance(account::intern(account), confidenceThreshold); }
+	inline Amount queryBalance(const key::KeyPair& pair, float confidenceThreshold = 0) const { return queryBalance(pair.pub, confidenceThreshold); }
 
 	/**
 	 * @brief Function which prints out the tangle
 	 */
 	void debugDump() const {
-		std::cout << "Genesis: " << std::endl;
+		auto snapshot = this->snapshot();
+		std::cout << "Genesis (epoch " << snapshot->epoch << "): " << std::endl;
 		std::list<std::string> considered;
-		genesis->recursiveDebugDump(considered);
+		if(snapshot->genesis) snapshot->genesis->recursiveDebugDump(considered, 0, snapshot->epoch);
+		std::cout << "Transactions discarded before mining: " << discardedBeforeMining << ", rejected after mining: " << rejectedAfterMining << std::endl;
 	}
 
 	/**
-	 * @brief Function which lists all of the transactions in the tangle
+	 * @brief Function which lists all of the transactions in the latest snapshot of the tangle
 	 * 
-	 * @return std::list<TransactionNode*> - The listed transactions in the tangle
+	 * @return std::vector<TransactionNode::const_ptr> - The listed transactions in the tangle (parents always come before their children)
 	 */
-	std::list<TransactionNode*> listTransactions(){
-		std::list<TransactionNode*> out;
-		genesis->recursivelyListTransactions(out);
-		return out;
-	}
+	std::vector<TransactionNode::const_ptr> listTransactions() const { return snapshot()->transactions(); }
 
 protected:
-	void updateCumulativeWeights(TransactionNode::const_ptr source);
+	static size_t checkSequences(const std::unordered_map<account::ID, AccountSequences>& table, const TransactionNode::const_ptr& node);
+	std::vector<TransactionNode::Spend> claimSequences(const TransactionNode::const_ptr& node);
+	void releaseSequences(const TransactionNode::const_ptr& node);
+	void markContested(const TransactionNode::Spend& spend);
+	void inheritContested(const TransactionNode::ptr& node, const std::vector<TransactionNode::Spend>& newlyContested = {});
+	static bool approves(const TransactionNode::const_ptr& node, const TransactionNode::const_ptr& ancestor);
+
+	void unlinkTip(TransactionNode::const_ptr tip);
+	void publishRemoval(const TransactionNode::const_ptr& removed);
+	void republish();
+	static void applyBalances(std::unordered_map<account::ID, Amount>& table, const TransactionNode& node, bool undo = false);
+
+	static std::vector<std::string> touchedAccounts(const TransactionNode& node);
+	void announce(const TransactionNode::const_ptr& node);
+	void announcePruned(const Snapshot& before);
+	void checkConfirmations();
+
+	void updateCumulativeWeights(const std::vector<TransactionNode::const_ptr>& sources);
+
+	/**
+	 * @brief Update the weights of all the nodes a <source> node approves of
+	 *
+	 * @param source - The node to work backwards from
+	 */
+	inline void updateCumulativeWeights(TransactionNode::const_ptr source) { updateCumulativeWeights(std::vector<TransactionNode::const_ptr>{source}); }
 
 	/**
-	 * @brief Update the cumulative weight of each of the current tips
+	 * @brief Update the cumulative weight of each of the current tips (in a single pass)
 	 */
 	void updateCumulativeWeights(){
-		for(auto [i, tipLock] = std::make_pair(size_t(0), util::mutable_cast(tips).read_lock()); i < tipLock->size(); i++)
-			updateCumulativeWeights(tipLock[i]);
+		// Copy the tips, so that nodes can still be added while the weights are updated
+		auto current = *tips.read_lock();
+		updateCumulativeWeights(current);
 	}
 
 };
@@ -10,11 +10,34 @@
  */
 #include "transaction.hpp"
 
+#include <unordered_map>
+
 #include <cryptopp/osrng.h>
 
 #include "keys.hpp"
+#include "kernels.hpp"
+#include "monitor.hpp"
 #include "timer.h"
 
+/**
+ * @brief Function which converts the base 64 representation of an account into its ID, assigning a new ID the first time an account is seen
+ *
+ * @param base64 - The base 64 representation of the account
+ * @return account::ID - The account's ID
+ */
+account::ID account::intern(const std::string& base64){
+	// Map of every account we have seen to its ID, with thread safe access
+	static monitor<std::unordered_map<std::string, ID>> ids;
+
+	// Most of the time the account has already been seen, so only take a read lock
+	if(auto lock = ids.read_lock(); lock->contains(base64))
+		return lock->at(base64);
+
+	// Otherwise assign it the next ID (unless someone else beat us to it)
+	auto lock = ids.write_lock();
+	return lock->emplace(base64, lock->size()).first->second;
+}
+
 /**
  * @brief Construct a new Transaction from its parents, outputs, and optional difficulty
  *
@@ -111,7 +134,7 @@ void Transaction::debugDump(){
 
 	std::cout << "Inputs: [" << std::endl;
 	for(auto& i: inputs)
-		std::cout << "\t Account: " << key::hash(i.account()) << ", Amount: " << i.amount << std::endl;
+		std::cout << "\t Account: " << key::hash(i.account()) << ", Amount: " << i.amount << ", Sequence: " << i.sequence << std::endl;
 	std::cout << "]" << std::endl
 		<< "Outputs: [" << std::endl;
 	for(auto& o: outputs)
@@ -137,40 +160,97 @@ bool Transaction::validateTransactionMined() {
 
 /**
  * @brief Function which mines the transaction
+ * @note Several nonces are hashed at once (one per lane of the hashing kernel), they are checked in order so the same nonce is found as when hashing one at a time
  */
 void Transaction::mineTransaction(){
 	// Provide feedback about when we start
 	std::cout << "Started mining transaction..." << std::endl;
 	// Time how long it took to mine (and display the result to the user)
 	Timer t;
-
-	// While the transaction is not successfully mined
-	while( !validateTransactionMined() ){
-		// Increment the nonce...
-		util::mutable_cast(nonce)++;
-		// And rehash
-		util::mutable_cast(hash) = hashTransaction();
+	if(validateTransactionMined()) return;
+
+	// A hash can only start with <miningDifficulty> 'A's (base 64 zeros) if the first 6 bits per character of its digest are zero, so only those digests need to be encoded and checked
+	auto mightBeMined = [this](const kernels::Digest& digest) {
+		size_t bits = 6 * miningDifficulty;
+		if(miningTarget != 'A' || bits > 8 * digest.size()) return true;
+		for(size_t i = 0; i < bits / 8; i++)
+			if(digest[i]) return false;
+		return bits % 8 == 0 || digest[bits / 8] >> (8 - bits % 8) == 0;
+	};
+
+	auto [prefix, suffix] = hashingMessage();
+	size_t lanes = kernels::hashLanes();
+	std::vector<std::string> messages(lanes);
+	std::vector<std::string_view> views(lanes);
+	std::vector<kernels::Digest> digests(lanes);
+	while(true){
+		// Hash the next batch of nonces...
+		size_t base = nonce;
+		for(size_t i = 0; i < lanes; i++){
+			messages[i] = prefix + std::to_string(size_t(base + 1 + i)) + suffix;
+			views[i] = messages[i];
+		}
+		kernels::sha3_256(views.data(), digests.data(), lanes);
+
+		// And stop at the first one which mines the transaction
+		for(size_t i = 0; i < lanes; i++){
+			if(!mightBeMined(digests[i])) continue;
+			util::mutable_cast(nonce) = base + 1 + i;
+			util::mutable_cast(hash) = util::base64Encode(digests[i].data(), digests[i].size());
+			if(validateTransactionMined()) return;
+		}
+		util::mutable_cast(nonce) = base + lanes;
 	}
 }
 
 /**
- * @brief Function which hashes a transaction
+ * @brief Function which creates the message a transaction's hash is calculated from
+ * @note The nonce goes between the two parts, so mining only needs to create the parts once
  *
- * @return Hash - The hashed transaction
+ * @return std::pair<std::string, std::string> - The parts of the message before and after the nonce
  */
-Hash Transaction::hashTransaction() const {
-	std::stringstream hash;
-	hash << timestamp;
-	hash << nonce;
+std::pair<std::string, std::string> Transaction::hashingMessage() const {
+	std::stringstream suffix;
 	for(Input input: inputs)
-		hash << input.hashContribution();
+		suffix << input.hashContribution();
 	for(Output output: outputs)
-		hash << output.hashContribution();
+		suffix << output.hashContribution();
 
 	for(Hash& h: parentHashes)
-		hash << h;
+		suffix << h;
 
-	return util::hash(hash.str());
+	return {std::to_string(timestamp), suffix.str()};
+}
+
+/**
+ * @brief Function which hashes a transaction
+ *
+ * @return Hash - The hashed transaction
+ */
+Hash Transaction::hashTransaction() const {
+	auto [prefix, suffix] = hashingMessage();
+	auto digest = kernels::sha3_256(prefix + std::to_string(nonce) + suffix);
+	return util::base64Encode(digest.data(), digest.size());
+}
+
+/**
+ * @brief Function which (re)hashes many transactions at once, using every lane of the hashing kernel
+ *
+ * @param transactions - The transactions to hash
+ */
+void Transaction::hashTransactions(std::span<Transaction> transactions) {
+	std::vector<std::string> messages;
+	messages.reserve(transactions.size());
+	for(const Transaction& transaction: transactions){
+		auto [prefix, suffix] = transaction.hashingMessage();
+		messages.push_back(prefix + std::to_string(transaction.nonce) + suffix);
+	}
+
+	std::vector<std::string_view> views(messages.begin(), messages.end());
+	std::vector<kernels::Digest> digests(messages.size());
+	kernels::sha3_256(views.data(), digests.data(), views.size());
+	for(size_t i = 0; i < transactions.size(); i++)
+		util::mutable_cast(transactions[i].hash) = util::base64Encode(digests[i].data(), digests[i].size());
 }
 
 /**
@@ -179,12 +259,27 @@ Hash Transaction::hashTransaction() const {
  * @return True if validation succeeds, false otherwise
  */
 bool Transaction::validateTransactionTotals() const {
-	// Add up the value of the inputs and value of the outputs
-	double inputSum = 0, outputSum = 0;
+	// Gather the amounts into contiguous arrays so they can be summed by the vectorized kernels
+	std::vector<Amount::Raw> inputAmounts, outputAmounts;
+	inputAmounts.reserve(inputs.size());
+	outputAmounts.reserve(outputs.size());
 	for(const Transaction::Input& input: inputs)
-		inputSum += input.amount;
+		inputAmounts.push_back(input.amount.raw);
 	for(const Transaction::Output& output: outputs)
-		outputSum += output.amount;
+		outputAmounts.push_back(output.amount.raw);
+
+	// Negative amounts would let an input create money (or an output destroy it)
+	auto negative = [](Amount::Raw raw){ return raw < 0; };
+	if(std::any_of(inputAmounts.begin(), inputAmounts.end(), negative) || std::any_of(outputAmounts.begin(), outputAmounts.end(), negative))
+		return false;
+
+	// Add up the value of the inputs and value of the outputs
+	Amount inputSum, outputSum;
+	try {
+		inputSum = kernels::sum(inputAmounts.data(), inputAmounts.size());
+		outputSum = kernels::sum(outputAmounts.data(), outputAmounts.size());
+	// If either of the sums can't be represented the transaction is invalid
+	} catch (Amount::Overflow&) { return false; }
 
 	// Ensure the inputs are at least as large as the outputs
 	return inputSum >= outputSum;
@@ -202,7 +297,7 @@ bool Transaction::validateTransaction() const {
 
 	// Make sure all of the inputs agreed to their contribution
 	for(const Input& input: inputs)
-		good &= key::verifyMessage(input.account(), std::to_string(input.amount), input.signature);
+		good &= key::verifyMessage(input.account(), input.signingMessage(outputs), input.signature);
 
 	return good;
 }
@@ -227,6 +322,7 @@ breep::serializer& operator<<(breep::serializer& s, const Transaction& t) {
 	for(const Transaction::Input& input: t.inputs){
 		s << input._accountBase64;
 		s << input.amount;
+		s << input.sequence;
 		s << input.signature;
 	}
 
@@ -235,56 +331,72 @@ breep::serializer& operator<<(breep::serializer& s, const Transaction& t) {
 	for(const Transaction::Output& output: t.outputs){
 		s << output._accountBase64;
 		s << output.amount;
+		s << output.sequence;
 	}
 
 	return s;
 }
-breep::deserializer& operator>>(breep::deserializer& d, Transaction& t) {
-	// Read parent hashes
-	size_t parentHashesSize;
-	std::vector<std::string> parentHashes;
-	d >> parentHashesSize;
-	parentHashes.resize(parentHashesSize);
-	for(int i = 0; i < parentHashesSize; i++)
-		d >> parentHashes[i];
-
-	// Read freestanding values
-	int64_t timestamp;
-	size_t nonce;
-	uint8_t miningDifficulty;
-	char miningTarget;
-	d >> timestamp;
-	d >> nonce;
-	d >> miningDifficulty;
-	d >> miningTarget;
-
-	// Read inputs
-	size_t inputsSize;
-	std::vector<Transaction::Input> inputs;
-	d >> inputsSize;
-	inputs.resize(inputsSize);
-	for(int i = 0; i < inputsSize; i++){
-		d >> inputs[i]._accountBase64;
-		d >> inputs[i].amount;
-		d >> inputs[i].signature;
-	}
+breep::deserializer& operator>>(breep::deserializer& d, Transaction& t) { return deserializeTransactions(d, {&t, 1}); }
 
-	// Read outputs
-	size_t outputsSize;
-	std::vector<Transaction::Output> outputs;
-	d >> outputsSize;
-	outputs.resize(outputsSize);
-	for(int i = 0; i < outputsSize; i++){
-		d >> outputs[i]._accountBase64;
-		d >> outputs[i].amount;
+/**
+ * @brief Function which deserializes several consecutive transactions, rehashing them all at once once they have been read
+ *
+ * @param d - The deserializer to read from
+ * @param transactions - Where to store the transactions (as many are read as fit)
+ * @return breep::deserializer& - The deserializer for chaining
+ */
+breep::deserializer& deserializeTransactions(breep::deserializer& d, std::span<Transaction> transactions) {
+	for(Transaction& t: transactions){
+		// Read parent hashes
+		size_t parentHashesSize;
+		std::vector<std::string> parentHashes;
+		d >> parentHashesSize;
+		parentHashes.resize(parentHashesSize);
+		for(int i = 0; i < parentHashesSize; i++)
+			d >> parentHashes[i];
+
+		// Read freestanding values
+		int64_t timestamp;
+		size_t nonce;
+		uint8_t miningDifficulty;
+		char miningTarget;
+		d >> timestamp;
+		d >> nonce;
+		d >> miningDifficulty;
+		d >> miningTarget;
+
+		// Read inputs
+		size_t inputsSize;
+		std::vector<Transaction::Input> inputs;
+		d >> inputsSize;
+		inputs.resize(inputsSize);
+		for(int i = 0; i < inputsSize; i++){
+			d >> inputs[i]._accountBase64;
+			d >> inputs[i].amount;
+			d >> inputs[i].sequence;
+			d >> inputs[i].signature;
+		}
+
+		// Read outputs
+		size_t outputsSize;
+		std::vector<Transaction::Output> outputs;
+		d >> outputsSize;
+		outputs.resize(outputsSize);
+		for(int i = 0; i < outputsSize; i++){
+			d >> outputs[i]._accountBase64;
+			d >> outputs[i].amount;
+			d >> outputs[i].sequence;
+		}
+
+		// Create the transaction
+		t = Transaction(parentHashes, inputs, outputs, miningDifficulty);
+		// Update several variables behind the scenes
+		util::mutable_cast(t.timestamp) = timestamp;
+		util::mutable_cast(t.nonce) = nonce;
+		util::mutable_cast(t.miningTarget) = miningTarget;
 	}
 
-	// Create the transaction
-	t = Transaction(parentHashes, inputs, outputs, miningDifficulty);
-	// Update several variables behind the scenes
-	util::mutable_cast(t.timestamp) = timestamp;
-	util::mutable_cast(t.nonce) = nonce;
-	util::mutable_cast(t.miningTarget) = miningTarget;
-	util::mutable_cast(t.hash) = t.hashTransaction(); // Rehash since the timestamp and nonce have been overridden
+	// Rehash since the timestamps and nonces have been overridden
+	Transaction::hashTransactions(transactions);
 	return d;
 }
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <iomanip>
 #include <span>
 
+#include "amount.hpp"
 #include "keys.hpp"
 
 // A hash is an immutable string
@@ -22,10 +23,21 @@ typedef const std::string Hash;
 // Invalid hash string
 #define INVALID_HASH "Invalid"
 
+namespace account {
+	// Compact identifier for an account (only meaningful inside this process, never sent over the network)
+	using ID = uint32_t;
+
+	// Function which converts the base 64 representation of an account into its (dense) ID
+	ID intern(const std::string& base64);
+	// Function which converts an account into its (dense) ID
+	inline ID intern(const key::PublicKey& key) { return intern(key::saveBase64(key)); }
+}
+
 // Structure representing a transcation in the tangle
 struct Transaction {
-	// Mark the deserializer as a friend so it can use the copy operator
+	// Mark the deserializers as friends so they can use the copy operator
 	friend breep::deserializer& operator>>(breep::deserializer& d, Transaction& n);
+	friend breep::deserializer& deserializeTransactions(breep::deserializer& d, std::span<Transaction> transactions);
 
 	/**
 	 * @brief Exception thrown when the transaction encounters an invalid hash
@@ -49,14 +61,22 @@ struct Transaction {
 		// Mark de/serializastion as friends so they can access the raw account
 		friend breep::serializer& operator<<(breep::serializer& s, const Transaction& t);
 		friend breep::deserializer& operator>>(breep::deserializer& d, Transaction& t);
+		friend breep::deserializer& deserializeTransactions(breep::deserializer& d, std::span<Transaction> transactions);
 	protected:
 		// The base 64 representation of the key
 		std::string _accountBase64;
 	public:
+		// The base 64 representation of the account's key
+		const std::string& accountBase64() const { return _accountBase64; }
 		// The public key of the account
 		key::PublicKey account() const { return key::loadPublicBase64(_accountBase64); }
+		// The ID of the account
+		account::ID accountID() const { return account::intern(_accountBase64); }
 		// The amount of money transferred
-		double amount;
+		Amount amount;
+		// For inputs: the account's sequence number this spend uses (each sequence number can only be spent once)
+		// For genesis outputs: the next sequence number the account is allowed to spend (ignored for any other output)
+		uint64_t sequence = 0;
 
 		/**
 		 * @brief Calculates what this output contributes to the hash
@@ -66,18 +86,20 @@ struct Transaction {
 		inline Hash hashContribution() const {
 			std::stringstream contrib;
 			contrib << _accountBase64;
-			contrib << amount;
+			contrib << std::to_string(amount.raw);
+			contrib << std::to_string(sequence);
 			return contrib.str();
 		}
 
 		Output() = default;
-		Output(const key::KeyPair& pair, const double amount) : _accountBase64( key::saveBase64(pair.pub) ), amount(amount) {}
-		Output(const key::PublicKey& account, double amount) : _accountBase64( key::saveBase64(account) ), amount(amount) {}
-		Output(const key::PublicKey&& account, double amount) : Output(account, amount) {}
+		Output(const key::KeyPair& pair, const Amount amount, uint64_t sequence = 0) : _accountBase64( key::saveBase64(pair.pub) ), amount(amount), sequence(sequence) {}
+		Output(const key::PublicKey& account, Amount amount, uint64_t sequence = 0) : _accountBase64( key::saveBase64(account) ), amount(amount), sequence(sequence) {}
+		Output(const key::PublicKey&& account, Amount amount, uint64_t sequence = 0) : Output(account, amount, sequence) {}
 	};
 
 	/**
-	 * @brief A transaction input is an account, amount to take from that account, and a signed copy of the amount verifying that the sender aproves of the transaction
+	 * @brief A transaction input is an account, amount to take from that account, the account's sequence number being spent,
+	 * 	and a signature (over the account, amount, sequence number, and the transaction's outputs) verifying that the sender aproves of the transaction
 	 */
 	struct Input : public Output {
 		// Signature proving that the sender approves this transaction
@@ -91,16 +113,31 @@ struct Transaction {
 		inline Hash hashContribution() const {
 			std::stringstream contrib;
 			contrib << _accountBase64;
-			contrib << amount;
+			contrib << std::to_string(amount.raw);
+			contrib << std::to_string(sequence);
 			contrib << signature;
 			return contrib.str();
 		}
 
+		/**
+		 * @brief Creates the message this input's signature covers
+		 * @note Covering the outputs means a signature can't be replayed to send the money somewhere else
+		 *
+		 * @param outputs - The outputs of the transaction this input belongs to
+		 * @return std::string - The message to sign
+		 */
+		std::string signingMessage(const std::vector<Output>& outputs) const {
+			std::string message = _accountBase64 + ":" + std::to_string(amount.raw) + ":" + std::to_string(sequence);
+			for(const Output& output: outputs)
+				message += "|" + output.hashContribution();
+			return message;
+		}
+
 		Input() = default;
-		// Constructor automatically signs the string version of the amount
-		Input(const key::KeyPair& pair, const double amount) : Output(pair, amount), signature( key::signMessage(pair.pri, std::to_string(amount))) {}
-		Input(const key::PublicKey& account, double amount, std::string signature) : Output(account, amount), signature(signature) {}
-		Input(const key::PublicKey&& account, double amount, std::string signature) : Output(account, amount), signature(signature) {}
+		// Constructor automatically signs the input (along with the outputs it pays for)
+		Input(const key::KeyPair& pair, const Amount amount, uint64_t sequence, const std::vector<Output>& outputs) : Output(pair, amount, sequence), signature( key::signMessage(pair, signingMessage(outputs)) ) {}
+		Input(const key::PublicKey& account, Amount amount, uint64_t sequence, std::string signature) : Output(account, amount, sequence), signature(signature) {}
+		Input(const key::PublicKey&& account, Amount amount, uint64_t sequence, std::string signature) : Output(account, amount, sequence), signature(signature) {}
 	};
 
 	// Inputs to this transaction
@@ -117,7 +154,7 @@ struct Transaction {
 	Transaction(const std::span<Hash> parentHashes, const std::vector<Input>& inputs, const std::vector<Output>& outputs, uint8_t difficulty = 3);
 
 	Transaction(const Transaction& other) : timestamp(other.timestamp), inputs(other.inputs), outputs(other.outputs), parentHashes(other.parentHashes), hash(other.hash) { *this = other; }
-	Transaction(const Transaction&& other) : timestamp(other.timestamp), inputs(other.inputs), outputs(other.outputs), parentHashes(other.parentHashes), hash(other.hash) { *this = std::move(other); }
+	Transaction(Transaction&& other) : timestamp(other.timestamp), hash(other.hash) { *this = std::move(other); }
 
 	// Clean up the parent hashes so that we don't have a memory leak
 	~Transaction(){ if(parentHashes.data()) delete [] parentHashes.data(); }
@@ -130,6 +167,8 @@ struct Transaction {
 	bool validateTransactionMined();
 	void mineTransaction();
 	Hash hashTransaction() const;
+	std::pair<std::string, std::string> hashingMessage() const;
+	static void hashTransactions(std::span<Transaction> transactions);
 
 	bool validateTransactionTotals() const;
 	bool validateTransaction() const;
@@ -138,5 +177,6 @@ struct Transaction {
 // De/serialization
 breep::serializer& operator<<(breep::serializer& s, const Transaction& t);
 breep::deserializer& operator>>(breep::deserializer& d, Transaction& t);
+breep::deserializer& deserializeTransactions(breep::deserializer& d, std::span<Transaction> transactions);
 
 #endif /* end of include guard: TRANSACTION_HPP */
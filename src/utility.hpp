@@ -12,9 +12,13 @@
 #define UTILITY_HPP
 
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <istream>
+#include <limits>
 #include <ostream>
 #include <queue>
+#include <stdexcept>
 #include <string>
 #include <unordered_set>
 
@@ -22,6 +26,8 @@
 #include <cryptopp/base64.h>
 #include <cryptopp/gzip.h>
 
+#include "kernels.hpp"
+
 /**
  * @brief Extension to std::queue which allows modification of its container
  * 
@@ -68,19 +74,39 @@ namespace util {
 	}
 
 	inline std::string replace(const std::string base, const std::string_view& toFind, const std::string_view& toReplace, size_t pos = 0, size_t maxReplacements = -1);
+	/**
+	 * @brief Function which converts binary data into its (padded) base 64 representation
+	 *
+	 * @param data - The data to encode
+	 * @param size - The number of bytes of data
+	 * @param lineBreaks - Whether to break the output into lines of 72 characters, each ending with a newline (like CryptoPP's Base64Encoder)
+	 * @return std::string - The base 64 representation
+	 */
+	inline std::string base64Encode(const uint8_t* data, size_t size, bool lineBreaks = false){
+		if(!lineBreaks){
+			std::string out(kernels::base64EncodedSize(size), '\0');
+			kernels::base64Encode(data, size, out.data());
+			return out;
+		}
+
+		// Each line holds 54 bytes (a multiple of 3, so only the last line can have padding)
+		constexpr size_t LINE_BYTES = 54;
+		size_t lines = std::max<size_t>((size + LINE_BYTES - 1) / LINE_BYTES, 1);
+		std::string out(kernels::base64EncodedSize(size) + lines, '\n');
+		for(size_t i = 0, written = 0; i < size; i += LINE_BYTES)
+			written += kernels::base64Encode(data + i, std::min(LINE_BYTES, size - i), out.data() + written) + 1;
+		return out;
+	}
+
 	/**
 	 * @brief Function which hashes the specified string
 	 * 
 	 * @param in - String to hash
-	 * @return std::string - The hashed string
+	 * @return std::string - The (base 64) hashed string
 	 */
-	inline std::string hash(std::string in){
-		std::string digest;
-	    CryptoPP::SHA3_256 hash;
-
-	    CryptoPP::StringSource foo(in, true, new CryptoPP::HashFilter(hash, new CryptoPP::Base64Encoder(new CryptoPP::StringSink(digest))));
-
-	    return replace(digest, "\n", ""); // Make sure there aren't any newlines
+	inline std::string hash(std::string_view in){
+		auto digest = kernels::sha3_256(in);
+		return base64Encode(digest.data(), digest.size());
 	}
 
 	/**
@@ -94,15 +120,43 @@ namespace util {
 		CryptoPP::StringSource ss(in, true, new CryptoPP::Gzip( new CryptoPP::StringSink(compressed)));
 		return compressed;
 	}
+
+	/**
+	 * @brief Exception thrown when data decompresses to more bytes than it is allowed to
+	 */
+	struct DecompressionLimitExceeded : public std::runtime_error {
+		DecompressionLimitExceeded(size_t limit) : std::runtime_error("Decompressed data exceeds the limit of " + std::to_string(limit) + " bytes") {}
+	};
+
+	/**
+	 * @brief Sink which appends to a string, throwing once it would grow past a limit
+	 * @note The inflator flushes its (32KB) window into the sink as it goes, so a small message which inflates into a huge one is stopped as soon as it passes the limit
+	 */
+	struct LimitedStringSink : public CryptoPP::Bufferless<CryptoPP::Sink> {
+		LimitedStringSink(std::string& out, size_t limit) : out(out), limit(limit) {}
+
+		size_t Put2(const CryptoPP::byte* in, size_t length, int /*messageEnd*/, bool /*blocking*/) override {
+			if(length > limit - out.size())
+				throw DecompressionLimitExceeded(limit);
+			out.append((const char*) in, length);
+			return 0;
+		}
+
+	protected:
+		std::string& out;
+		size_t limit;
+	};
+
 	/**
 	 * @brief Function which decompresses the provided string
 	 * 
 	 * @param in - String to decompress
+	 * @param limit - The most bytes the string may decompress to (throws DecompressionLimitExceeded past it)
 	 * @return std::string - Decompressed string
 	 */
-	inline std::string decompress(std::string in){
+	inline std::string decompress(std::string in, size_t limit = std::numeric_limits<size_t>::max()){
 		std::string decompressed;
-		CryptoPP::StringSource ss(in, true, new CryptoPP::Gunzip( new CryptoPP::StringSink(decompressed)));
+		CryptoPP::StringSource ss(in, true, new CryptoPP::Gunzip( new LimitedStringSink(decompressed, limit)));
 		return decompressed;
 	}
 
@@ -199,60 +253,31 @@ namespace util {
 
 	/**
 	 * @brief Functions which determines which of two base64 strings represent a bigger number
+	 * @note Throws if a character outside the base 64 alphabet is reached before the strings differ
 	 * 
 	 * @param A - The first string
 	 * @param B - The second atring 
 	 * @return int - 1 = A bigger, 0 = equal, -1 = B bigger
 	 */
-	inline int base64Compare(std::string a, std::string b){
-		// Lambda which performs the comparison on a per string scale
-		auto base64CharCompare = [](char a, char b){
-			// Ensure both characters are valid base 64 characters
-			if( !(isalnum(a) || a == '+' || a == '/') )
-				throw std::runtime_error(std::string("Character `") + a + "` is not a valid base 64 character");
-			if( !(isalnum(b) || b == '+' || b == '/') )
-				throw std::runtime_error(std::string("Character `") + b + "` is not a valid base 64 character");
-
-			// If they are equal return 0
-			if(a == b) return 0;
-
-			// Check characters that correspond to bigger numbers first, if one of the characters falls in that range while the other doesn't it is bigger
-			if(a == '/') return 1;
-			if(b == '/') return -1;
-
-			if(a == '+') return 1;
-			if(b == '+') return -1;
-
-			// If both characters are numbers, just compare them (number size corresponds with order in ascii table)
-			if(isdigit(a) && isdigit(b)){
-				if(a > b) return 1;
-				if(b > a) return -1;
-			}
-			if(isdigit(a)) return 1;
-			if(isdigit(b)) return -1;
-
-			// If both characters are lowercase, just compare them (number size corresponds with order in ascii table)
-			if(islower(a) && islower(b)){
-				if(a > b) return 1;
-				if(b > a) return -1;
-			}
-			if(islower(a)) return 1;
-			if(islower(b)) return -1;
-
-			// If both characters are upper case directly compare them
-			// (we have already confirmed that both characters are valid, so they must be uppercase if they weren't detected earlier)
-			if(a > b) return 1;
-			return -1;
-		};
-
+	inline int base64Compare(std::string_view a, std::string_view b){
 		// Longer strings correspond to bigger numbers
 		if(a.size() > b.size()) return 1;
 		if(b.size() > a.size()) return -1;
 
-		// Compare the two equally sized strings character by character
-		for(int i = 0; i < a.size(); i++)
-			if(int compare = base64CharCompare(a[i], b[i]); compare != 0)
-				return compare;
+		// Convert the strings into the digits they represent a chunk at a time, and compare the digits
+		uint8_t digitsA[64], digitsB[64];
+		for(size_t i = 0; i < a.size(); i += sizeof(digitsA)){
+			size_t size = std::min(sizeof(digitsA), a.size() - i);
+			size_t validA = kernels::base64Digits(a.data() + i, size, digitsA);
+			size_t validB = kernels::base64Digits(b.data() + i, size, digitsB);
+			size_t valid = std::min(validA, validB);
+			if(int compare = std::memcmp(digitsA, digitsB, valid); compare != 0)
+				return compare > 0 ? 1 : -1;
+
+			// If the strings are equal up to a character that isn't valid base 64, error
+			if(valid < size)
+				throw std::runtime_error(std::string("Character `") + (validA == valid ? a : b)[i + valid] + "` is not a valid base 64 character");
+		}
 
 		return 0;
 	}
@@ -0,0 +1,87 @@
+/**
+ * @file weights_bench.cpp
+ * @author Joshua Dahl (jdahl@unr.edu)
+ * @brief Benchmark of cumulative weight updates running concurrently with biased random walks (see TransactionNode::Metrics)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <chrono>
+#include <thread>
+
+#include "bench.hpp"
+
+/**
+ * @brief Function which runs <walkers> threads performing random walks while <updaters> threads update the weights, for <duration>
+ *
+ * @param name - The name of the update strategy (printed)
+ * @param t - The tangle to walk
+ * @param walkers - The number of threads performing random walks
+ * @param updaters - The number of threads updating weights
+ * @param duration - How long to run for
+ * @param update - Function which performs one weight update, returns the number of sources it updated from
+ */
+template<typename F>
+void measure(const std::string& name, BenchTangle& t, size_t walkers, size_t updaters, std::chrono::milliseconds duration, F update) {
+	std::atomic<bool> running = true;
+	std::atomic<size_t> walks = 0, passes = 0, sources = 0;
+
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < walkers; i++)
+		threads.emplace_back([&](){
+			while(running)
+				if(t.genesis->biasedRandomWalk()) walks++;
+		});
+	for(size_t i = 0; i < updaters; i++)
+		threads.emplace_back([&](){
+			while(running){
+				sources += update();
+				passes++;
+			}
+		});
+
+	std::this_thread::sleep_for(duration);
+	running = false;
+	for(auto& thread: threads)
+		thread.join();
+
+	double seconds = std::chrono::duration<double>(duration).count();
+	std::cout << name << ": " << (walks / seconds) << " walks/s, " << (passes / seconds) << " update passes/s (" << (sources / seconds) << " sources/s), genesis weight " << (double(t.genesis->cumulativeWeight()) / WEIGHT_SCALE) << std::endl;
+}
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+	if(argc > 5){
+		std::cout << "Usage: " << argv[0] << " [<nodes> = 2000] [<tips> = 8] [<walkers> = 4] [<updaters> = 2]" << std::endl;
+		return 1;
+	}
+
+	size_t nodes = argc > 1 ? std::stoul(argv[1]) : 2000;
+	size_t tips = argc > 2 ? std::stoul(argv[2]) : 8;
+	size_t walkers = argc > 3 ? std::stoul(argv[3]) : 4;
+	size_t updaters = argc > 4 ? std::stoul(argv[4]) : 2;
+	auto duration = std::chrono::milliseconds(3000);
+
+	BenchTangle t;
+	t.grow(nodes, tips);
+	auto recent = t.latest(tips);
+	std::cout << nodes << " nodes, " << tips << " tips, " << walkers << " walkers, " << updaters << " updaters" << std::endl;
+
+	// Walks alone (the baseline the updates slow down)
+	measure("No updates", t, walkers, 0, duration, []{ return 0; });
+	// One pass per tip (what happens when each added transaction triggers its own update)
+	measure("Per tip", t, walkers, updaters, duration, [&]{
+		for(auto& tip: recent)
+			t.updateCumulativeWeights(tip);
+		return recent.size();
+	});
+	// Every tip in a single batched pass
+	measure("Batched", t, walkers, updaters, duration, [&]{
+		t.updateCumulativeWeights(recent);
+		return recent.size();
+	});
+}